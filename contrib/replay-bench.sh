@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+# replay-bench.sh: Record and replay a fixed set of listing commands
+#
+# Description:  Benchmark ipmitool's listing code paths without a BMC.
+#		A trace is recorded once against real hardware and can then
+#		be replayed on any machine by an ipmitool binary configured
+#		with --enable-intf-replay.
+#
+#		Example usage:
+#		# ./replay-bench.sh record bench.trace -I lanplus -H bmc -U admin -E
+#		# ./replay-bench.sh replay bench.trace 10
+#
+#		Set IPMITOOL to use a binary other than the one in PATH.
+#
+
+IPMITOOL=${IPMITOOL:-ipmitool}
+COMMANDS="sdr elist
+sel elist
+fru print
+sensor list"
+
+usage() {
+	echo "usage: $0 record <trace> <ipmitool options>" >&2
+	echo "       $0 replay <trace> [iterations] [replay options]" >&2
+	exit 1
+}
+
+[ $# -ge 2 ] || usage
+mode=$1
+trace=$2
+shift 2
+
+case "$mode" in
+record)
+	echo "$COMMANDS" | IPMI_RECORD="$trace" $IPMITOOL "$@" exec - >/dev/null
+	;;
+replay)
+	iterations=${1:-1}
+	opts=$2
+	i=0
+	while [ $i -lt $iterations ]; do
+		echo "$COMMANDS" | \
+			$IPMITOOL -I replay -D "$trace$opts" exec - report \
+			>/dev/null || exit 1
+		i=$((i + 1))
+	done
+	;;
+*)
+	usage
+	;;
+esac
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026 The ipmitool Project.  All Rights Reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistribution of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * Redistribution in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder, nor the names of
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ * 
+ * This software is provided "AS IS," without a warranty of any kind.
+ * ALL EXPRESS OR IMPLIED CONDITIONS, REPRESENTATIONS AND WARRANTIES,
+ * INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE OR NON-INFRINGEMENT, ARE HEREBY EXCLUDED.
+ * THE COPYRIGHT HOLDER AND ITS LICENSORS SHALL NOT BE LIABLE
+ * FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING
+ * OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.  IN NO EVENT WILL
+ * THE COPYRIGHT HOLDER OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE,
+ * PROFIT OR DATA, OR FOR DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL,
+ * INCIDENTAL OR PUNITIVE DAMAGES, HOWEVER CAUSED AND REGARDLESS OF THE
+ * THEORY OF LIABILITY, ARISING OUT OF THE USE OF OR INABILITY TO USE THIS
+ * SOFTWARE, EVEN IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGES.
+ */
+
+/*
+ * valstr-check: compare indexed val2str() lookups with a linear scan
+ *
+ * Run by 'make check'.  Every exported value-string table is looked up
+ * for a range of values, as are synthetic heap tables that are sparse,
+ * dense, full of duplicates or short enough to stay unindexed, before
+ * and after valstr_index_drop().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ipmitool/helper.h>
+#include <ipmitool/ipmi_strings.h>
+
+int verbose = 0;
+int csv_output = 0;
+
+#define CHECK_RANGE	0x20000
+#define CHECK_TABLES	8
+
+static const char *
+linear_val2str(uint32_t val, const struct valstr *vs)
+{
+	int i;
+
+	for (i = 0; vs[i].str; i++) {
+		if (vs[i].val == val)
+			return vs[i].str;
+	}
+	return NULL;
+}
+
+static int
+check_one(uint32_t val, const struct valstr *vs)
+{
+	const char *want = linear_val2str(val, vs);
+	const char *got = val2str(val, vs);
+
+	if (want)
+		return got != want;
+	return strncmp(got, "Unknown", 7) != 0;
+}
+
+static int
+check_table(const char *name, const struct valstr *vs)
+{
+	uint32_t val;
+	int bad = 0;
+	int i;
+
+	for (val = 0; val < CHECK_RANGE; val++)
+		bad += check_one(val, vs);
+	for (i = 0; vs[i].str; i++) {
+		bad += check_one(vs[i].val, vs);
+		bad += check_one(vs[i].val + 1, vs);
+		bad += check_one(vs[i].val - 1, vs);
+	}
+	bad += check_one(UINT32_MAX, vs);
+
+	if (bad)
+		printf("%-36s %d mismatches\n", name, bad);
+	return bad;
+}
+
+#define CHECK_NAME_SIZE	16
+
+/* build a heap table of @count entries with values in @base + [0, @range),
+ * every entry with its own string so duplicates can be told apart
+ */
+static struct valstr *
+make_table(size_t count, uint32_t range, uint32_t base)
+{
+	struct valstr *vs = calloc(count + 1, sizeof(*vs));
+	char *names = malloc(count * CHECK_NAME_SIZE);
+	size_t i;
+
+	if (!vs || !names) {
+		free(vs);
+		free(names);
+		return NULL;
+	}
+	for (i = 0; i < count; i++) {
+		snprintf(&names[i * CHECK_NAME_SIZE], CHECK_NAME_SIZE,
+			 "entry %zu", i);
+		vs[i].val = base + (uint32_t)rand() % range;
+		vs[i].str = &names[i * CHECK_NAME_SIZE];
+	}
+	vs[count].val = UINT32_MAX;
+	return vs;
+}
+
+static int
+check_synthetic(void)
+{
+	static const struct {
+		const char *name;
+		size_t count;
+		uint32_t range;
+		uint32_t base;
+	} kind[] = {
+		{ "sparse",     5000, CHECK_RANGE, 0 },
+		{ "dense",      3000, 2000,        7 },
+		{ "duplicates", 2000, 64,          0x100 },
+		{ "short",      10,   CHECK_RANGE, 0 },
+	};
+	struct valstr *vs[CHECK_TABLES];
+	size_t i, k;
+	int bad = 0;
+
+	srand(1);
+	for (i = 0; i < CHECK_TABLES; i++) {
+		k = i % ARRAY_SIZE(kind);
+		vs[i] = make_table(kind[k].count, kind[k].range, kind[k].base);
+		if (!vs[i]) {
+			printf("malloc failure\n");
+			return 1;
+		}
+		bad += check_table(kind[k].name, vs[i]);
+	}
+
+	/* changed tables must not be answered from a stale index */
+	for (i = 0; i < CHECK_TABLES; i++) {
+		k = i % ARRAY_SIZE(kind);
+		valstr_index_drop(vs[i]);
+		for (size_t j = 0; vs[i][j].str; j++)
+			vs[i][j].val ^= 1;
+		bad += check_table(kind[k].name, vs[i]);
+		valstr_index_drop(vs[i]);
+		free((char *)vs[i][0].str);
+		free(vs[i]);
+	}
+	return bad;
+}
+
+#define CHECK(vs) check_table(#vs, vs)
+
+int
+main(void)
+{
+	int bad = 0;
+
+	bad += CHECK(completion_code_vals);
+	bad += CHECK(entity_id_vals);
+	bad += CHECK(entity_device_type_vals);
+	bad += CHECK(ipmi_netfn_vals);
+	bad += CHECK(ipmi_channel_activity_type_vals);
+	bad += CHECK(ipmi_privlvl_vals);
+	bad += CHECK(ipmi_bit_rate_vals);
+	bad += CHECK(ipmi_set_in_progress_vals);
+	bad += CHECK(ipmi_authtype_session_vals);
+	bad += CHECK(ipmi_authtype_vals);
+	bad += CHECK(ipmi_channel_protocol_vals);
+	bad += CHECK(ipmi_channel_medium_vals);
+	bad += CHECK(ipmi_chassis_power_control_vals);
+	bad += CHECK(ipmi_chassis_restart_cause_vals);
+	bad += CHECK(ipmi_auth_algorithms);
+	bad += CHECK(ipmi_integrity_algorithms);
+	bad += CHECK(ipmi_encryption_algorithms);
+	bad += CHECK(ipmi_user_enable_status_vals);
+	bad += CHECK(picmg_frucontrol_vals);
+	bad += CHECK(picmg_clk_family_vals);
+	bad += CHECK(picmg_busres_id_vals);
+	bad += CHECK(picmg_busres_board_cmd_vals);
+	bad += CHECK(picmg_busres_shmc_cmd_vals);
+	bad += check_synthetic();
+
+	ipmi_oem_info_init();
+	bad += CHECK(ipmi_oem_info);
+	ipmi_oem_info_free();
+
+	printf("valstr-check: %s\n", bad ? "FAILED" : "passed");
+	return bad ? 1 : 0;
+}
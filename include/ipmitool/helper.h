@@ -85,6 +85,7 @@ specific_val2str(uint32_t val,
                  const struct valstr *generic);
 const char *val2str(uint32_t val, const struct valstr * vs);
 const char *oemval2str(uint32_t oem, uint32_t val, const struct oemvalstr * vs);
+void valstr_index_drop(const struct valstr *vs);
 
 int str2double(const char * str, double * double_ptr);
 int str2long(const char * str, int64_t * lng_ptr);
@@ -127,6 +128,7 @@ uint8_t ipmi_csum(uint8_t * d, int s);
 FILE * ipmi_open_file(const char * file, int rw);
 void ipmi_start_daemon(struct ipmi_intf *intf);
 uint16_t ipmi_get_oem_id(struct ipmi_intf *intf);
+uint64_t ipmi_time_usec(void);
 
 #define IS_SET(v, b) ((v) & (1 << (b)))
 
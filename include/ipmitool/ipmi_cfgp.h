@@ -37,6 +37,7 @@
 /* Forward declarations. */
 struct ipmi_cfgp;
 struct ipmi_cfgp_ctx;
+struct ipmi_intf;
 
 /*
  * Action types.
@@ -117,6 +118,44 @@ typedef int (*ipmi_cfgp_handler_t)(void *priv,
 	const struct ipmi_cfgp *p, const struct ipmi_cfgp_action *action,
 	unsigned char *data);
 
+/*
+ * Set In Progress states, common to all configuration parameter sets.
+ */
+enum {
+	CFGP_SET_COMPLETE,
+	CFGP_SET_IN_PROGRESS,
+	CFGP_COMMIT_WRITE
+};
+
+/* Set In Progress callback, returns 0 on success, >0 if the parameter set
+ * has no Set In Progress parameter and <0 on error. */
+typedef int (*ipmi_cfgp_progress_t)(void *priv, int state);
+
+/*
+ * Configuration parameter class: one parameter set of a channel,
+ * as addressed by 'config save' and 'config apply'.
+ */
+struct ipmi_cfgp_class {
+	/* Class name, the first word of a configuration file line. */
+	const char *name;
+
+	/* Parameter descriptors and their action handler. */
+	const struct ipmi_cfgp *set;
+	unsigned int count;
+	ipmi_cfgp_handler_t handler;
+
+	/* Set In Progress callback, NULL if there is none. */
+	ipmi_cfgp_progress_t progress;
+
+	/* Non-zero if the parameters are not per channel; they are
+	 * saved and applied as channel 0. */
+	int global;
+
+	/* Size of the handler private data, set up by open(). */
+	size_t priv_size;
+	int (*open)(struct ipmi_intf *intf, int channel, void *priv);
+};
+
 /*
  * Parameter selector.
  */
@@ -131,6 +170,7 @@ struct ipmi_cfgp_sel {
  */
 struct ipmi_cfgp_data {
 	struct ipmi_cfgp_data *next;
+	struct ipmi_cfgp_data *next_param;	/* next with the same param */
 	struct ipmi_cfgp_sel sel;
 	unsigned char data[];
 };
@@ -154,6 +194,12 @@ struct ipmi_cfgp_ctx {
 	/* List of parameter values. */
 	struct ipmi_cfgp_data *v;
 
+	/* Tail of the value list, for appending. */
+	struct ipmi_cfgp_data **tail;
+
+	/* Per-parameter value lists, heads and tails (2 x count). */
+	struct ipmi_cfgp_data **index;
+
 	/* Private data. */
 	void *priv;
 };
@@ -178,6 +224,10 @@ extern int ipmi_cfgp_parse_sel(struct ipmi_cfgp_ctx *ctx,
 extern int ipmi_cfgp_parse_data(struct ipmi_cfgp_ctx *ctx,
 		const struct ipmi_cfgp_sel *sel, int argc, const char **argv);
 
+/* Parse parameter data over the current BMC value, keep it if changed. */
+extern int ipmi_cfgp_parse_diff(struct ipmi_cfgp_ctx *ctx,
+		const struct ipmi_cfgp_sel *sel, int argc, const char **argv);
+
 /* Get parameter data from BMC. */
 extern int ipmi_cfgp_get(struct ipmi_cfgp_ctx *ctx,
 		const struct ipmi_cfgp_sel *sel);
@@ -190,6 +240,10 @@ extern int ipmi_cfgp_set(struct ipmi_cfgp_ctx *ctx,
 extern int ipmi_cfgp_save(struct ipmi_cfgp_ctx *ctx,
 		const struct ipmi_cfgp_sel *sel, FILE *file);
 
+/* Write all parameter data to BMC within one Set In Progress lock. */
+extern int ipmi_cfgp_write(struct ipmi_cfgp_ctx *ctx,
+		ipmi_cfgp_progress_t progress);
+
 /* Print parameter data in user-friendly format. */
 extern int ipmi_cfgp_print(struct ipmi_cfgp_ctx *ctx,
 		const struct ipmi_cfgp_sel *sel, FILE *file);
@@ -222,3 +222,8 @@ int ipmi_channel_main(struct ipmi_intf * intf, int argc, char ** argv);
 int ipmi_get_channel_auth_cap(struct ipmi_intf * intf,
                               uint8_t channel, uint8_t priv);
 int ipmi_get_channel_info(struct ipmi_intf * intf, uint8_t channel);
+
+/* Channel and user access configuration parameter classes. */
+struct ipmi_cfgp_class;
+extern const struct ipmi_cfgp_class ipmi_channel_cfgp_class;
+extern const struct ipmi_cfgp_class ipmi_user_cfgp_class;
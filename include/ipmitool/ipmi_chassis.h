@@ -50,3 +50,7 @@ int ipmi_chassis_power_status(struct ipmi_intf * intf);
 int ipmi_chassis_power_control(struct ipmi_intf * intf, uint8_t ctl);
 int ipmi_chassis_main(struct ipmi_intf * intf, int argc, char ** argv);
 int ipmi_power_main(struct ipmi_intf * intf, int argc, char ** argv);
+
+/* System boot options configuration parameter class. */
+struct ipmi_cfgp_class;
+extern const struct ipmi_cfgp_class ipmi_boot_cfgp_class;
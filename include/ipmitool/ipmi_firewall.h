@@ -32,6 +32,7 @@
 
 #pragma once
 
+#include <limits.h>
 #include <ipmitool/ipmi.h>
 
 int ipmi_firewall_main(struct ipmi_intf *, int, char **);
@@ -93,6 +94,36 @@ struct ipmi_function_params {
 	int command;
 	int subfn;
 	unsigned char force;
+	unsigned char nocache;
+};
+
+/* Support and configurable bitmaps only change with the firmware, they are
+ * cached per BMC and channel in ~/.ipmitool and keyed by the Get Device ID
+ * response. Enables are always read from the BMC.
+ */
+#define FIREWALL_CACHE_DIR ".ipmitool"
+#define FIREWALL_CACHE_MAGIC "IPMIFWC1"
+#define FIREWALL_CACHE_KEY_LEN 16
+
+struct firewall_cache_subfn {
+	unsigned char lun;
+	unsigned char netfn;
+	unsigned char command;
+	unsigned char support[MAX_SUBFN_BYTES];
+	unsigned char config[MAX_SUBFN_BYTES];
+};
+struct firewall_cache {
+	char path[PATH_MAX];
+	unsigned char key[FIREWALL_CACHE_KEY_LEN];
+	int dirty;
+	int have_netfn;
+	unsigned char lun[MAX_LUN];
+	unsigned char netfn[16];
+	unsigned char valid[MAX_LUN][MAX_NETFN_PAIR];
+	unsigned char command_mask[MAX_LUN][MAX_NETFN_PAIR][MAX_COMMAND_BYTES];
+	unsigned char config_mask[MAX_LUN][MAX_NETFN_PAIR][MAX_COMMAND_BYTES];
+	struct firewall_cache_subfn * subfn;
+	int subfn_count;
 };
 
 static inline int bit_test(const unsigned char * bf, int n) {
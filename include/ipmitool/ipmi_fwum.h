@@ -42,6 +42,8 @@
 # define KFWUM_SMALL_BUFFER     32
 /* Maximum size on KCS interface */
 # define KFWUM_BIG_BUFFER       32
+/* Size negotiated with Kontron OEM Set Channel Buffer Length */
+# define KFWUM_LARGE_BUFFER     128
 # define MAX_BUFFER_SIZE          1024*16
 
 /* 3 address + 1 size + 1 checksum + 1 command */
@@ -53,6 +55,11 @@
 # define FWUM_SAVE_FIRMWARE_NO_RESPONSE_LIMIT 6
 # define FWUM_MAX_UPLOAD_RETRY 6
 
+/* Polling of a busy IPMC: first delay, delay cap and overall limit (usec) */
+# define KFWUM_BACKOFF_MIN     50000
+# define KFWUM_BACKOFF_MAX     1000000
+# define KFWUM_BUSY_TIMEOUT    60000000
+
 # define TRACE_LOG_CHUNK_COUNT 7
 # define TRACE_LOG_CHUNK_SIZE  7
 # define TRACE_LOG_ATT_COUNT   3
@@ -220,7 +227,7 @@ struct KfwumSaveFirmwareAddressReq
 struct KfwumSaveFirmwareSequenceReq
 {
 	unsigned char sequenceNumber;
-	unsigned char txBuf[KFWUM_BIG_BUFFER];
+	unsigned char txBuf[KFWUM_LARGE_BUFFER];
 } ATTRIBUTE_PACKING;
 # ifdef HAVE_PRAGMA_PACK
 #  pragma pack(0)
@@ -33,6 +33,8 @@
 #pragma once
 
 #include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
 #include <ipmitool/ipmi.h>
 
 int ipmi_hpmfwupg_main(struct ipmi_intf *, int, char **);
@@ -78,6 +80,11 @@ int ipmi_hpmfwupg_main(struct ipmi_intf *, int, char **);
 #define HPMFWUPG_DEFAULT_INACCESS_TIMEOUT 60 /* sec */
 #define HPMFWUPG_DEFAULT_UPGRADE_TIMEOUT  60 /* sec */
 #define HPMFWUPG_MD5_SIGNATURE_LENGTH     16
+#define HPMFWUPG_BACKOFF_MIN              10000   /* usec */
+#define HPMFWUPG_BACKOFF_MAX              1000000 /* usec */
+#define HPMFWUPG_POLL_MIN                 1000000 /* usec, spec minimum */
+#define HPMFWUPG_POLL_MAX                 4000000 /* usec */
+#define HPMFWUPG_CHECKPOINT_SUFFIX        ".ckpt"
 
 /* Component IDs */
 typedef enum eHpmfwupgComponentId {
@@ -728,6 +735,24 @@ struct HpmfwupgFirmwareImage {
 # pragma pack(0)
 #endif
 
+/* Upload progress saved after every acknowledged block so that an
+ * interrupted upgrade can be resumed with "hpm upgrade <file> resume"
+ */
+struct HpmfwupgCheckpoint {
+	FILE          *fp;
+	char          *path;
+	time_t         imageMtime;
+	unsigned char  valid;
+	unsigned char  inPlace;     /* target still in the middle of an upload */
+	unsigned char  doneMask;    /* components uploaded and finished */
+	unsigned char  componentId; /* component being uploaded */
+	unsigned char  blockNumber; /* next block number to send */
+	unsigned int   offset;      /* next byte to send */
+	unsigned int   sectionOffset;
+	unsigned int   sectionLength;
+	unsigned int   totalSent;
+};
+
 #ifdef HAVE_PRAGMA_PACK
 # pragma pack(1)
 #endif
@@ -735,7 +760,13 @@ struct HpmfwupgUpgradeCtx {
 	struct HpmfwupgComponentBitMask compUpdateMask;
 	unsigned int   imageSize;
 	unsigned char* pImageData;
+	unsigned char  imageMapped;
 	unsigned char  componentId;
+	struct HpmfwupgCheckpoint ckpt;
+	unsigned int   rateLimit;   /* upload bytes per second, 0 = unlimited */
+	uint64_t       prepareUsec;
+	uint64_t       upgradeUsec;
+	uint64_t       activateUsec;
 	struct HpmfwupgGetTargetUpgCapabilitiesResp targetCap;
 	struct HpmfwupgGetGeneralPropResp genCompProp[HPMFWUPG_COMPONENT_ID_MAX];
 	struct ipm_devid_rsp devId;
@@ -761,6 +792,7 @@ typedef enum eHpmfwupgActionType {
 #define DEBUG_MODE                    0x02
 #define FORCE_MODE                    0x04
 #define COMPARE_MODE                  0x08
+#define RESUME_MODE                   0x10
 
 typedef struct _VERSIONINFO {
 	unsigned char componentId;
@@ -185,6 +185,29 @@ struct ipmi_session {
 		uint8_t last_received_sequence_number;
 		uint8_t last_received_byte_count;
 		void (*sol_input_handler)(struct ipmi_rs * rsp);
+
+		/*
+		 * While defer_ack is set, received packets are not ACKed right
+		 * away; the ACK is kept in pending_ack_* and carried by the next
+		 * outbound data packet.
+		 */
+		uint8_t defer_ack;
+		uint8_t pending_ack_sequence_number;	/* 0 = none */
+		uint8_t pending_ack_byte_count;
+		uint8_t last_acked_sequence_number;
+		uint8_t last_acked_byte_count;
+		uint64_t last_ack_usec;
+
+		/* SOL packet counters */
+		struct {
+			uint32_t tx_packets;
+			uint32_t tx_bytes;
+			uint32_t rx_packets;
+			uint32_t rx_bytes;
+			uint32_t acks;
+			uint32_t piggybacked_acks;
+			uint32_t skipped_acks;
+		} stats;
 	} sol_data;
 };
 
@@ -199,6 +222,8 @@ struct ipmi_intf_support {
 	int supported;
 };
 
+struct ipmi_stats;
+
 struct ipmi_intf {
 	char name[16];
 	char desc[128];
@@ -228,6 +253,8 @@ struct ipmi_intf {
 
 	uint8_t devnum;
 
+	struct ipmi_stats *stats; /* NULL unless IPMI_STATS is set */
+
 	int (*setup)(struct ipmi_intf * intf);
 	int (*open)(struct ipmi_intf * intf);
 	void (*close)(struct ipmi_intf * intf);
@@ -41,3 +41,4 @@
 
 int ipmi_kontronoem_main(struct ipmi_intf *, int, char **);
 int ipmi_kontronoem_set_large_buffer(struct ipmi_intf *, unsigned char size);
+int ipmi_kontronoem_try_large_buffer(struct ipmi_intf *, unsigned char size);
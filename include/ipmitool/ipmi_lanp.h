@@ -127,3 +127,7 @@ enum {
 int  ipmi_lanp_main(struct ipmi_intf *, int, char **);
 
 uint8_t find_lan_channel(struct ipmi_intf *intf, uint8_t start);
+
+/* IPv4 LAN configuration parameter class. */
+struct ipmi_cfgp_class;
+extern const struct ipmi_cfgp_class ipmi_lan_cfgp_class;
@@ -50,3 +50,7 @@ struct ipmi_lanp_priv {
 	struct ipmi_intf *intf;
 	int channel;
 };
+
+/* IPv6 LAN configuration parameter class. */
+struct ipmi_cfgp_class;
+extern const struct ipmi_cfgp_class ipmi_lan6_cfgp_class;
@@ -422,6 +422,7 @@ struct pef_serial_cfgparm_selector {
 #define PEF_SERIAL_CFGPARM_ID_TAP_ACCT_COUNT 24
 #define PEF_SERIAL_CFGPARM_ID_TAP_ACCT_INFO 25
 #define PEF_SERIAL_CFGPARM_ID_TAP_ACCT_PAGER_STRING 27
+#define PEF_SERIAL_CFGPARM_ID_TAP_SVC_SETTINGS 28
 	uint8_t ch;
 	uint8_t id;
 	uint8_t set;
@@ -647,7 +648,9 @@ struct pef_serial_cfgparm_tap_svc_settings {
 #define IPMI_CMD_GET_LAST_PROCESSED_EVT_ID 0x15
 #define IPMI_CMD_GET_SYSTEM_GUID 0x37
 #define IPMI_CMD_GET_CHANNEL_INFO 0x42
+#define IPMI_CMD_LAN_SET_CONFIG 0x01
 #define IPMI_CMD_LAN_GET_CONFIG 0x02
+#define IPMI_CMD_SERIAL_SET_CONFIG 0x10
 #define IPMI_CMD_SERIAL_GET_CONFIG 0x11
 
 struct pef_cfgparm_set_policy_table_entry
@@ -666,3 +669,7 @@ void ipmi_pef_print_2xd(const char * text, uint8_t u1, uint8_t u2);
 void ipmi_pef_print_str(const char * text, const char * val);
 
 int ipmi_pef_main(struct ipmi_intf * intf, int argc, char ** argv);
+
+/* PEF configuration parameter class. */
+struct ipmi_cfgp_class;
+extern const struct ipmi_cfgp_class ipmi_pef_cfgp_class;
@@ -798,6 +798,15 @@ struct sdr_record_list {
 
 #define SENSOR_TYPE_MAX 0x2C
 
+/* Conversion factors of a full sensor record, decoded once */
+struct sdr_conv {
+	int		m;			/* signed 10-bit M */
+	double		b;			/* B * 10^B_EXP */
+	double		r;			/* 10^R_EXP */
+	uint8_t		analog;			/* analog data format */
+	uint8_t		linearization;		/* linearization byte */
+};
+
 struct sensor_reading {
 	char		s_id[17];		/* name of the sensor */
 	struct sdr_record_full_sensor    *full;
@@ -867,6 +876,12 @@ const char *ipmi_sdr_get_thresh_status(struct sensor_reading *sr,
 const char *ipmi_sdr_get_status(int, const char *, uint8_t stat);
 double sdr_convert_sensor_tolerance(struct sdr_record_full_sensor *sensor,
 				  uint8_t val);
+void sdr_conv_init(struct sdr_conv *conv,
+		   const struct sdr_record_full_sensor *sensor);
+double sdr_conv_reading(const struct sdr_conv *conv, uint8_t val);
+void sdr_conv_table(const struct sdr_conv *conv, double table[256]);
+void sdr_convert_sensor_readings(struct sdr_record_full_sensor *sensor,
+				 const uint8_t *raw, double *out, size_t count);
 double sdr_convert_sensor_reading(struct sdr_record_full_sensor *sensor,
 				  uint8_t val);
 double sdr_convert_sensor_hysterisis(struct sdr_record_full_sensor *sensor,
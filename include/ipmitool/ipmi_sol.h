@@ -101,3 +101,7 @@ int ipmi_sol_main(struct ipmi_intf *, int, char **);
 int ipmi_get_sol_info(struct ipmi_intf *intf,
 		      uint8_t channel,
 		      struct sol_config_parameters *params);
+
+/* SOL configuration parameter class. */
+struct ipmi_cfgp_class;
+extern const struct ipmi_cfgp_class ipmi_sol_cfgp_class;
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2026 The ipmitool Project.  All Rights Reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistribution of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * Redistribution in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder, nor the names of
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ * 
+ * This software is provided "AS IS," without a warranty of any kind.
+ * ALL EXPRESS OR IMPLIED CONDITIONS, REPRESENTATIONS AND WARRANTIES,
+ * INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE OR NON-INFRINGEMENT, ARE HEREBY EXCLUDED.
+ * THE COPYRIGHT HOLDER AND ITS LICENSORS SHALL NOT BE LIABLE
+ * FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING
+ * OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.  IN NO EVENT WILL
+ * THE COPYRIGHT HOLDER OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE,
+ * PROFIT OR DATA, OR FOR DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL,
+ * INCIDENTAL OR PUNITIVE DAMAGES, HOWEVER CAUSED AND REGARDLESS OF THE
+ * THEORY OF LIABILITY, ARISING OUT OF THE USE OF OR INABILITY TO USE THIS
+ * SOFTWARE, EVEN IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGES.
+ */
+
+#pragma once
+
+#include <inttypes.h>
+
+#include <ipmitool/ipmi_intf.h>
+
+/*
+ * Latency histogram bucket upper bounds in microseconds, the last
+ * bucket collects everything above IPMI_STATS_BUCKET_LIMITS' last value
+ */
+#define IPMI_STATS_BUCKET_LIMITS { \
+	100, 250, 500, 1000, 2500, 5000, 10000, 25000, \
+	50000, 100000, 250000, 500000, 1000000, 2500000 }
+#define IPMI_STATS_BUCKETS	15
+
+#define IPMI_STATS_NETFNS	64
+#define IPMI_STATS_CMDS		256
+
+struct ipmi_stats_cmd {
+	uint64_t count;
+	uint64_t noresponse;
+	uint64_t cc_res_canceled;	/* 0xC5 */
+	uint64_t cc_cant_ret_bytes;	/* 0xCA */
+	uint64_t cc_dupl_req;		/* 0xCF */
+	uint64_t cc_other;
+	uint64_t tx_bytes;
+	uint64_t rx_bytes;
+	uint64_t usec_total;
+	uint64_t usec_max;
+};
+
+struct ipmi_stats {
+	struct ipmi_rs *(*sendrecv)(struct ipmi_intf *intf, struct ipmi_rq *req);
+	int json;
+	FILE *fp;
+	uint64_t retries;
+	uint64_t wire_tx_bytes;
+	uint64_t wire_rx_bytes;
+	uint64_t hist[IPMI_STATS_BUCKETS];
+	struct ipmi_stats_cmd *cmds[IPMI_STATS_NETFNS];
+};
+
+int ipmi_stats_start(struct ipmi_intf *intf, const char *format,
+                     const char *file);
+void ipmi_stats_stop(struct ipmi_intf *intf);
+void ipmi_stats_print(struct ipmi_intf *intf);
+
+/*
+ * Transport hooks, no-ops unless statistics are enabled
+ */
+static inline void
+ipmi_stats_retry(struct ipmi_intf *intf)
+{
+	if (intf->stats)
+		intf->stats->retries++;
+}
+
+static inline void
+ipmi_stats_wire_tx(struct ipmi_intf *intf, int len)
+{
+	if (intf->stats && len > 0)
+		intf->stats->wire_tx_bytes += len;
+}
+
+static inline void
+ipmi_stats_wire_rx(struct ipmi_intf *intf, int len)
+{
+	if (intf->stats && len > 0)
+		intf->stats->wire_rx_bytes += len;
+}
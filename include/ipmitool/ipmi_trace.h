@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026 The ipmitool Project.  All Rights Reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistribution of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * Redistribution in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder, nor the names of
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ * 
+ * This software is provided "AS IS," without a warranty of any kind.
+ * ALL EXPRESS OR IMPLIED CONDITIONS, REPRESENTATIONS AND WARRANTIES,
+ * INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE OR NON-INFRINGEMENT, ARE HEREBY EXCLUDED.
+ * THE COPYRIGHT HOLDER AND ITS LICENSORS SHALL NOT BE LIABLE
+ * FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING
+ * OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.  IN NO EVENT WILL
+ * THE COPYRIGHT HOLDER OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE,
+ * PROFIT OR DATA, OR FOR DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL,
+ * INCIDENTAL OR PUNITIVE DAMAGES, HOWEVER CAUSED AND REGARDLESS OF THE
+ * THEORY OF LIABILITY, ARISING OUT OF THE USE OF OR INABILITY TO USE THIS
+ * SOFTWARE, EVEN IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGES.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#include <ipmitool/ipmi_intf.h>
+
+/*
+ * Transaction trace file format
+ *
+ * A trace starts with the 8 byte IPMI_TRACE_MAGIC and is followed by
+ * one record per request/response pair, in the order they were sent:
+ *
+ *   offset  size  field
+ *   0       1     flags (IPMI_TRACE_F_*)
+ *   1       1     netfn
+ *   2       1     lun
+ *   3       1     cmd
+ *   4       1     completion code
+ *   5       1     target address
+ *   6       1     target channel
+ *   7       4     round trip time in microseconds
+ *   11      2     request data length
+ *   13      2     response data length
+ *   15      -     request data, then response data
+ *
+ * All multi-byte values are little-endian, like everything else in IPMI.
+ */
+#define IPMI_TRACE_MAGIC	"IPMITRC1"
+#define IPMI_TRACE_MAGIC_LEN	8
+#define IPMI_TRACE_HDR_LEN	15
+
+/* The request got no response (timeout or transport error) */
+#define IPMI_TRACE_F_NORESPONSE	0x01
+
+struct ipmi_trace_entry {
+	uint8_t flags;
+	uint8_t netfn;
+	uint8_t lun;
+	uint8_t cmd;
+	uint8_t ccode;
+	uint8_t target_addr;
+	uint8_t target_channel;
+	uint32_t usec;
+	uint16_t rq_len;
+	uint16_t rs_len;
+	const uint8_t *rq_data;
+	const uint8_t *rs_data;
+};
+
+struct ipmi_trace {
+	struct ipmi_trace_entry *entries;
+	size_t count;
+	uint8_t *buf; /* raw file contents the entries point into */
+};
+
+int ipmi_trace_record_start(struct ipmi_intf *intf, const char *file);
+void ipmi_trace_record_stop(struct ipmi_intf *intf);
+
+struct ipmi_trace *ipmi_trace_load(const char *file);
+void ipmi_trace_free(struct ipmi_trace *trace);
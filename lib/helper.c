@@ -46,6 +46,8 @@
 #include <errno.h>
 #include <assert.h>
 #include <ctype.h>
+#include <time.h>
+#include <sys/time.h>
 
 #if HAVE_CONFIG_H
 # include <config.h>
@@ -319,6 +321,134 @@ mac2str(const uint8_t *buf)
 	return buf2str_extended(buf, 6, ":");
 }
 
+/*
+ * Value-string tables that are long enough get an index built on first
+ * lookup: a direct-indexed array when the values are dense, otherwise a
+ * list of (value, position) keys sorted for binary search. Indices are
+ * kept in a small hash keyed by table address. Short tables and tables
+ * whose slot is taken by another one are simply scanned linearly.
+ */
+#define VALSTR_INDEX_SLOTS	64	/* power of two */
+#define VALSTR_INDEX_MIN	16	/* shorter tables are scanned */
+#define VALSTR_INDEX_DENSITY	4	/* max direct array size per entry */
+
+struct valstr_key {
+	uint32_t val;
+	uint32_t pos;
+};
+
+struct valstr_index {
+	const struct valstr *vs;
+	size_t count;		/* entries in the table */
+	uint32_t base;		/* lowest value in the table */
+	uint32_t span;		/* direct array size, 0 if sorted */
+	int32_t *direct;	/* position of each value, -1 if absent */
+	struct valstr_key *keys;	/* keys sorted by value, then position */
+};
+
+static struct valstr_index valstr_index_tab[VALSTR_INDEX_SLOTS];
+
+static
+inline
+struct valstr_index *valstr_index_slot(const struct valstr *vs)
+{
+	uintptr_t h = (uintptr_t)vs;
+
+	h ^= h >> 12;
+	h ^= h >> 6;
+	return &valstr_index_tab[h & (VALSTR_INDEX_SLOTS - 1)];
+}
+
+static int valstr_key_cmp(const void *a, const void *b)
+{
+	const struct valstr_key *ka = a;
+	const struct valstr_key *kb = b;
+
+	if (ka->val != kb->val)
+		return (ka->val < kb->val) ? -1 : 1;
+	return (ka->pos < kb->pos) ? -1 : (ka->pos > kb->pos);
+}
+
+/**
+ * Build the lookup index of a valstr array
+ *
+ * Short tables are not indexed and leave the slot free for a table
+ * that is.
+ *
+ * @param[out] ix The free slot to fill in
+ * @param[in]  vs The valstr array to index
+ * @return 0      The index was built and \p ix now belongs to \p vs
+ * @return -1     The table is too short or allocation failed
+ */
+static int valstr_index_build(struct valstr_index *ix, const struct valstr *vs)
+{
+	uint32_t min = UINT32_MAX;
+	uint32_t max = 0;
+	size_t count;
+	size_t i;
+
+	for (count = 0; count < VALSTR_INDEX_MIN && vs[count].str; ++count)
+		;
+	if (count < VALSTR_INDEX_MIN)
+		return -1;
+
+	for (count = 0; vs[count].str; ++count) {
+		if (vs[count].val < min)
+			min = vs[count].val;
+		if (vs[count].val > max)
+			max = vs[count].val;
+	}
+	if (count > INT32_MAX)
+		return -1;
+
+	memset(ix, 0, sizeof(*ix));
+	ix->base = min;
+	if ((uint64_t)max - min < (uint64_t)count * VALSTR_INDEX_DENSITY) {
+		ix->span = max - min + 1;
+		ix->direct = malloc(ix->span * sizeof(*ix->direct));
+		if (!ix->direct) {
+			ix->span = 0;
+			return -1;
+		}
+		for (i = 0; i < ix->span; ++i)
+			ix->direct[i] = -1;
+		/* Walk backwards so the first of duplicate values wins */
+		for (i = count; i-- > 0;)
+			ix->direct[vs[i].val - min] = i;
+	} else {
+		ix->keys = malloc(count * sizeof(*ix->keys));
+		if (!ix->keys)
+			return -1;
+		for (i = 0; i < count; ++i) {
+			ix->keys[i].val = vs[i].val;
+			ix->keys[i].pos = i;
+		}
+		qsort(ix->keys, count, sizeof(*ix->keys), valstr_key_cmp);
+	}
+	ix->vs = vs;
+	ix->count = count;
+	return 0;
+}
+
+/**
+ * Forget the lookup index of a valstr array
+ *
+ * Must be called before a dynamically allocated valstr array is
+ * modified or freed.
+ *
+ * @param[in] vs The valstr array
+ */
+void valstr_index_drop(const struct valstr *vs)
+{
+	struct valstr_index *ix = valstr_index_slot(vs);
+
+	if (ix->vs != vs)
+		return;
+	free(ix->direct);
+	free(ix->keys);
+	memset(ix, 0, sizeof(*ix));
+}
+
 /**
  * Find the index of value in a valstr array
  *
@@ -331,11 +461,39 @@ static
 inline
 off_t find_val_idx(uint32_t val, const struct valstr *vs)
 {
-	if (vs) {
-		for (off_t i = 0; vs[i].str; ++i) {
-			if (vs[i].val == val) {
-				return i;
-			}
+	struct valstr_index *ix;
+
+	if (!vs)
+		return -1;
+
+	ix = valstr_index_slot(vs);
+	if (ix->vs == vs || (!ix->vs && valstr_index_build(ix, vs) == 0)) {
+		size_t lo = 0;
+		size_t hi = ix->count;
+
+		if (ix->span) {
+			if (val - ix->base >= ix->span)
+				return -1;
+			return ix->direct[val - ix->base];
+		}
+
+		/* Lower bound, so duplicate values resolve to the first entry */
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+
+			if (ix->keys[mid].val < val)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo < ix->count && ix->keys[lo].val == val)
+			return ix->keys[lo].pos;
+		return -1;
+	}
+
+	for (off_t i = 0; vs[i].str; ++i) {
+		if (vs[i].val == val) {
+			return i;
 		}
 	}
 
@@ -354,7 +512,6 @@ inline
 const char *unknown_val_str(uint32_t val)
 {
 	static char un_str[32];
-	memset(un_str, 0, 32);
 	snprintf(un_str, 32, "Unknown (0x%02X)", val);
 
 	return un_str;
@@ -1157,3 +1314,26 @@ args2buf(int argc, char *argv[], uint8_t *out, size_t len)
 	}
 	return true;
 }
+
+/** Get the current value of a monotonic clock
+ *
+ * The value has no relation to the wall clock and is only meant
+ * for measuring intervals (command latency, poll periods, etc.)
+ *
+ * @returns The clock value in microseconds
+ */
+uint64_t
+ipmi_time_usec(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	if (!clock_gettime(CLOCK_MONOTONIC, &ts)) {
+		return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+	}
+#endif
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
@@ -59,6 +59,13 @@ ipmi_cfgp_init(struct ipmi_cfgp_ctx *ctx, const struct ipmi_cfgp *set,
 
 	memset(ctx, 0, sizeof(struct ipmi_cfgp_ctx));
 
+	ctx->index = calloc(2 * count, sizeof(struct ipmi_cfgp_data *));
+	if (count && !ctx->index) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		return -1;
+	}
+
+	ctx->tail = &ctx->v;
 	ctx->set = set;
 	ctx->count = count;
 	ctx->cmdname = cmdname;
@@ -89,6 +96,10 @@ ipmi_cfgp_uninit(struct ipmi_cfgp_ctx *ctx)
 		d = NULL;
 	}
 
+	free(ctx->index);
+	ctx->index = NULL;
+	ctx->tail = &ctx->v;
+
 	return 0;
 }
 
@@ -180,21 +191,31 @@ ipmi_cfgp_parse_sel(struct ipmi_cfgp_ctx *ctx,
 /* cfgp_add_data  adds block of data to list in the configuration
  * parameter context
  *
+ * Values are kept in insertion order and, in the same order, on a list
+ * per parameter so that actions on a single parameter do not have to
+ * walk the values of all the others.
+ *
  * @param ctx    context to add data to
  * @param data   parameter data
  */
 static void
 cfgp_add_data(struct ipmi_cfgp_ctx *ctx, struct ipmi_cfgp_data *data)
 {
-	struct ipmi_cfgp_data **pprev = &ctx->v;
+	struct ipmi_cfgp_data **head = &ctx->index[data->sel.param];
+	struct ipmi_cfgp_data **tail = &ctx->index[ctx->count + data->sel.param];
 
 	data->next = NULL;
+	data->next_param = NULL;
 
-	while (*pprev) {
-		pprev = &(*pprev)->next;
-	}
+	*ctx->tail = data;
+	ctx->tail = &data->next;
 
-	*pprev = data;
+	if (*tail) {
+		(*tail)->next_param = data;
+	} else {
+		*head = data;
+	}
+	*tail = data;
 }
 
 /* cfgp_usage     prints format for configuration parameter
@@ -320,6 +341,95 @@ ipmi_cfgp_parse_data(struct ipmi_cfgp_ctx *ctx,
 	return 0;
 }
 
+/* ipmi_cfgp_parse_diff   parse parameter data from command line over the
+ * value currently in the MC and add it to the context only if it differs
+ *
+ * Fields the command line does not cover keep their current values,
+ * so a later ipmi_cfgp_set() writes exactly the parameters that change.
+ *
+ * @param ctx        context to add data
+ * @param sel        parameter selector
+ * @param argc       number of elements in argv
+ * @param argv       array of unparsed arguments
+ *
+ * @returns          1 if the parameter changes, 0 if it already has
+ *                   the value, <0 on error
+ */
+int
+ipmi_cfgp_parse_diff(struct ipmi_cfgp_ctx *ctx,
+		const struct ipmi_cfgp_sel *sel, int argc, const char **argv)
+{
+	const struct ipmi_cfgp *p;
+	struct ipmi_cfgp_data *data;
+	struct ipmi_cfgp_action action;
+	unsigned char *cur;
+	int have_cur = 0;
+
+	if (!ctx || !sel || !argv) {
+		return -1;
+	}
+
+	if (sel->param == -1 || sel->param >= ctx->count
+		|| sel->set == -1 || sel->block == -1) {
+		lprintf(LOG_ERR, "invalid parameter selector");
+		return -1;
+	}
+
+	p = &ctx->set[sel->param];
+
+	if (p->size == 0 || p->access == CFGP_RDONLY) {
+		lprintf(LOG_ERR, "parameter '%s' is not writable", p->name);
+		return -1;
+	}
+
+	data = malloc(sizeof(struct ipmi_cfgp_data) + 2 * p->size);
+	if (!data) {
+		return -1;
+	}
+
+	memset(data, 0, sizeof(struct ipmi_cfgp_data) + 2 * p->size);
+	cur = data->data + p->size;
+
+	action.set = sel->set;
+	action.block = sel->block;
+	action.argc = 0;
+	action.argv = NULL;
+	action.file = NULL;
+
+	/* write-only or unreadable parameters are always written */
+	if (p->access != CFGP_WRONLY) {
+		action.type = CFGP_GET;
+		action.quiet = 1;
+		if (ctx->handler(ctx->priv, p, &action, cur) == 0) {
+			memcpy(data->data, cur, p->size);
+			have_cur = 1;
+		}
+	}
+
+	action.type = CFGP_PARSE;
+	action.quiet = 0;
+	action.argc = argc;
+	action.argv = argv;
+
+	if (ctx->handler(ctx->priv, p, &action, data->data) != 0) {
+		ipmi_cfgp_usage(p, 1, 1);
+		free(data);
+		data = NULL;
+		return -1;
+	}
+
+	if (have_cur && !memcmp(data->data, cur, p->size)) {
+		free(data);
+		data = NULL;
+		return 0;
+	}
+
+	data->sel = *sel;
+
+	cfgp_add_data(ctx, data);
+	return 1;
+}
+
 /* cfgp_get_param -- get parameter data from MC into data list within context
  *
  * @param ctx      context
@@ -469,12 +579,19 @@ cfgp_do_action(struct ipmi_cfgp_ctx *ctx, int action_type,
 		return -1;
 	}
 
+	if (sel->param >= ctx->count) {
+		return -1;
+	}
+
 	action.type = action_type;
 	action.argc = 0;
 	action.argv = NULL;
 	action.file = file;
 
-	for (data = ctx->v; data; data = data->next) {
+	data = (sel->param != -1) ? ctx->index[sel->param] : ctx->v;
+
+	for (; data;
+	     data = (sel->param != -1) ? data->next_param : data->next) {
 		if (sel->param != -1 && sel->param != data->sel.param) {
 			continue;
 		}
@@ -523,6 +640,49 @@ ipmi_cfgp_set(struct ipmi_cfgp_ctx *ctx, const struct ipmi_cfgp_sel *sel)
 	return cfgp_do_action(ctx, CFGP_SET, sel, NULL, CFGP_RDONLY);
 }
 
+/* ipmi_cfgp_write -- set all parameters in the context to MC
+ *
+ * The values are written between 'set in progress' and 'commit write',
+ * the lock is always released.  A parameter set without Set In Progress
+ * support is written unlocked.
+ *
+ * @param ctx       context
+ * @param progress  Set In Progress callback, may be NULL
+ * @returns         0 on success, non-zero otherwise
+ */
+int
+ipmi_cfgp_write(struct ipmi_cfgp_ctx *ctx, ipmi_cfgp_progress_t progress)
+{
+	const struct ipmi_cfgp_sel all = { -1, -1, -1 };
+	int locked = 0;
+	int ret;
+
+	if (!ctx) {
+		return -1;
+	}
+
+	if (progress) {
+		ret = progress(ctx->priv, CFGP_SET_IN_PROGRESS);
+		if (ret < 0) {
+			return ret;
+		}
+		locked = (ret == 0);
+	}
+
+	ret = ipmi_cfgp_set(ctx, &all);
+
+	if (locked) {
+		if (ret == 0 && progress(ctx->priv, CFGP_COMMIT_WRITE) < 0) {
+			ret = -1;
+		}
+		if (progress(ctx->priv, CFGP_SET_COMPLETE) < 0 && ret == 0) {
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
 int
 ipmi_cfgp_save(struct ipmi_cfgp_ctx *ctx,
 		const struct ipmi_cfgp_sel *sel, FILE *file)
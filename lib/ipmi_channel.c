@@ -44,6 +44,7 @@
 
 #include <ipmitool/ipmi.h>
 #include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_cfgp.h>
 #include <ipmitool/helper.h>
 #include <ipmitool/log.h>
 #include <ipmitool/ipmi_lanp.h>
@@ -901,6 +902,328 @@ ipmi_set_user_access(struct ipmi_intf *intf, int argc, char **argv)
 	return 0;
 }
 
+/*
+ * Channel and user access parameters for 'config save' and 'config apply'
+ */
+struct channel_cfgp_priv {
+	struct ipmi_intf *intf;
+	int channel;
+	int max_user_ids;
+};
+
+/* channel access: settings byte and privilege limit of Get Channel Access */
+static const struct ipmi_cfgp channel_cfgp[] = {
+	{ .name = "access",
+		.format = "{disabled|pre-boot|always|shared} <alerting> "
+			"<per-msg-auth> <user-level-auth> <privilege-limit>",
+		.size = 2, .access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = 0
+	},
+	{ .name = "volatile-access",
+		.format = "{disabled|pre-boot|always|shared} <alerting> "
+			"<per-msg-auth> <user-level-auth> <privilege-limit>",
+		.size = 2, .access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = 1
+	}
+};
+
+/* user access: the access byte of Get User Access, by user ID */
+static const struct ipmi_cfgp user_cfgp[] = {
+	{ .name = "access",
+		.format = "<callin> <link-auth> <ipmi-msg> <privilege-limit>",
+		.size = 1, .access = CFGP_RDWR,
+		.is_set = 1, .first_set = 1, .has_blocks = 0, .first_block = 0,
+		.specific = 0
+	}
+};
+
+static const struct valstr channel_cfgp_mode_vals[] = {
+	{ 0x00, "disabled" },
+	{ 0x01, "pre-boot" },
+	{ 0x02, "always" },
+	{ 0x03, "shared" },
+	{ 0xFF, NULL }
+};
+
+static const struct valstr channel_cfgp_priv_vals[] = {
+	{ IPMI_SESSION_PRIV_CALLBACK, "callback" },
+	{ IPMI_SESSION_PRIV_USER, "user" },
+	{ IPMI_SESSION_PRIV_OPERATOR, "operator" },
+	{ IPMI_SESSION_PRIV_ADMIN, "admin" },
+	{ IPMI_SESSION_PRIV_OEM, "oem" },
+	{ IPMI_SESSION_PRIV_NOACCESS, "no-access" },
+	{ 0xFF, NULL }
+};
+
+/* channel_cfgp_lookup - find a string in a table, -1 if it is not there */
+static int
+channel_cfgp_lookup(const char *arg, const struct valstr *vs)
+{
+	int i;
+
+	for (i = 0; vs[i].str; i++) {
+		if (!strcmp(arg, vs[i].str)) {
+			return vs[i].val;
+		}
+	}
+
+	return -1;
+}
+
+/* channel_cfgp_onoff - parse on/off, -1 if invalid */
+static int
+channel_cfgp_onoff(const char *arg)
+{
+	if (!strcmp(arg, "on")) {
+		return 1;
+	}
+	if (!strcmp(arg, "off")) {
+		return 0;
+	}
+	return -1;
+}
+
+static int
+channel_cfgp_parse(int argc, const char **argv, unsigned char *data)
+{
+	int v[5];
+	int i;
+
+	if (argc < 5) {
+		return -1;
+	}
+
+	v[0] = channel_cfgp_lookup(argv[0], channel_cfgp_mode_vals);
+	for (i = 1; i < 4; i++) {
+		v[i] = channel_cfgp_onoff(argv[i]);
+	}
+	v[4] = channel_cfgp_lookup(argv[4], channel_cfgp_priv_vals);
+	for (i = 0; i < 5; i++) {
+		if (v[i] < 0) {
+			return -1;
+		}
+	}
+
+	/* the BMC keeps 'disabled' bits */
+	data[0] = (!v[1] << 5) | (!v[2] << 4) | (!v[3] << 3) | v[0];
+	data[1] = v[4];
+	return 0;
+}
+
+static void
+channel_cfgp_save(const unsigned char *data, FILE *file)
+{
+	fprintf(file, "%s %s %s %s %s",
+		val2str(data[0] & 0x07, channel_cfgp_mode_vals),
+		(data[0] & 0x20) ? "off" : "on",
+		(data[0] & 0x10) ? "off" : "on",
+		(data[0] & 0x08) ? "off" : "on",
+		val2str(data[1] & 0x0f, channel_cfgp_priv_vals));
+}
+
+static int
+channel_cfgp_handler(void *priv, const struct ipmi_cfgp *p,
+		const struct ipmi_cfgp_action *action, unsigned char *data)
+{
+	struct channel_cfgp_priv *cp = priv;
+	struct channel_access_t ca;
+	int rc;
+
+	switch (action->type) {
+	case CFGP_PARSE:
+		return channel_cfgp_parse(action->argc, action->argv, data);
+
+	case CFGP_GET:
+		memset(&ca, 0, sizeof(ca));
+		ca.channel = cp->channel;
+		rc = _ipmi_get_channel_access(cp->intf, &ca, p->specific);
+		if (rc != 0) {
+			if (!action->quiet) {
+				lprintf(LOG_ERR, "Unable to get channel '%s': %s",
+					p->name, (rc < 0) ? "no response"
+					: val2str(rc, completion_code_vals));
+			}
+			return -1;
+		}
+		data[0] = ca.alerting | ca.per_message_auth
+			| ca.user_level_auth | ca.access_mode;
+		data[1] = ca.privilege_limit;
+		return 0;
+
+	case CFGP_SET:
+		memset(&ca, 0, sizeof(ca));
+		ca.channel = cp->channel;
+		ca.alerting = data[0] & 0x20;
+		ca.per_message_auth = data[0] & 0x10;
+		ca.user_level_auth = data[0] & 0x08;
+		ca.access_mode = data[0] & 0x07;
+		ca.privilege_limit = data[1] & 0x0f;
+		/* 1 sets the non-volatile, 2 the volatile settings */
+		rc = _ipmi_set_channel_access(cp->intf, ca,
+				p->specific + 1, p->specific + 1);
+		if (rc != 0) {
+			lprintf(LOG_ERR, "Unable to set channel '%s': %s",
+				p->name, (rc < 0) ? "no response"
+				: val2str(rc, completion_code_vals));
+			return -1;
+		}
+		return 0;
+
+	case CFGP_SAVE:
+		channel_cfgp_save(data, action->file);
+		return 0;
+
+	case CFGP_PRINT:
+		fprintf(action->file, "%-22s: ", p->name);
+		channel_cfgp_save(data, action->file);
+		fputc('\n', action->file);
+		return 0;
+
+	default:
+		return -1;
+	}
+}
+
+static int
+user_cfgp_parse(int argc, const char **argv, unsigned char *data)
+{
+	int v[4];
+	int i;
+
+	if (argc < 4) {
+		return -1;
+	}
+
+	for (i = 0; i < 3; i++) {
+		v[i] = channel_cfgp_onoff(argv[i]);
+	}
+	v[3] = channel_cfgp_lookup(argv[3], channel_cfgp_priv_vals);
+	for (i = 0; i < 4; i++) {
+		if (v[i] < 0) {
+			return -1;
+		}
+	}
+
+	data[0] = (v[0] << 6) | (v[1] << 5) | (v[2] << 4) | v[3];
+	return 0;
+}
+
+static void
+user_cfgp_save(const unsigned char *data, FILE *file)
+{
+	fprintf(file, "%s %s %s %s",
+		(data[0] & 0x40) ? "on" : "off",
+		(data[0] & 0x20) ? "on" : "off",
+		(data[0] & 0x10) ? "on" : "off",
+		val2str(data[0] & 0x0f, channel_cfgp_priv_vals));
+}
+
+static int
+user_cfgp_handler(void *priv, const struct ipmi_cfgp *p,
+		const struct ipmi_cfgp_action *action, unsigned char *data)
+{
+	struct channel_cfgp_priv *cp = priv;
+	struct user_access_t ua;
+	int rc;
+
+	switch (action->type) {
+	case CFGP_PARSE:
+		return user_cfgp_parse(action->argc, action->argv, data);
+
+	case CFGP_GET:
+		if (action->set > cp->max_user_ids) {
+			return -1;
+		}
+		memset(&ua, 0, sizeof(ua));
+		ua.channel = cp->channel;
+		ua.user_id = action->set;
+		rc = _ipmi_get_user_access(cp->intf, &ua);
+		if (rc != 0) {
+			if (!action->quiet) {
+				lprintf(LOG_ERR, "Unable to get access of user %d: %s",
+					action->set, (rc < 0) ? "no response"
+					: val2str(rc, completion_code_vals));
+			}
+			return -1;
+		}
+		data[0] = ua.callin_callback | ua.link_auth
+			| ua.ipmi_messaging | ua.privilege_limit;
+		return 0;
+
+	case CFGP_SET:
+		memset(&ua, 0, sizeof(ua));
+		ua.channel = cp->channel;
+		ua.user_id = action->set;
+		ua.callin_callback = data[0] & 0x40;
+		ua.link_auth = data[0] & 0x20;
+		ua.ipmi_messaging = data[0] & 0x10;
+		ua.privilege_limit = data[0] & 0x0f;
+		rc = _ipmi_set_user_access(cp->intf, &ua, 0);
+		if (rc != 0) {
+			lprintf(LOG_ERR, "Unable to set access of user %d: %s",
+				action->set, (rc < 0) ? "no response"
+				: val2str(rc, completion_code_vals));
+			return -1;
+		}
+		return 0;
+
+	case CFGP_SAVE:
+		user_cfgp_save(data, action->file);
+		return 0;
+
+	case CFGP_PRINT:
+		fprintf(action->file, "%-22s: ", p->name);
+		user_cfgp_save(data, action->file);
+		fputc('\n', action->file);
+		return 0;
+
+	default:
+		return -1;
+	}
+}
+
+static int
+channel_cfgp_open(struct ipmi_intf *intf, int channel, void *priv)
+{
+	struct channel_cfgp_priv *cp = priv;
+	struct user_access_t ua;
+
+	cp->intf = intf;
+	cp->channel = channel;
+
+	/* the user ID range, none if the channel has no users */
+	memset(&ua, 0, sizeof(ua));
+	ua.channel = channel;
+	ua.user_id = 1;
+	if (_ipmi_get_user_access(intf, &ua) == 0) {
+		cp->max_user_ids = ua.max_user_ids;
+	}
+
+	return 0;
+}
+
+const struct ipmi_cfgp_class ipmi_channel_cfgp_class = {
+	.name = "channel",
+	.set = channel_cfgp,
+	.count = ARRAY_SIZE(channel_cfgp),
+	.handler = channel_cfgp_handler,
+	.progress = NULL,
+	.priv_size = sizeof(struct channel_cfgp_priv),
+	.open = channel_cfgp_open
+};
+
+const struct ipmi_cfgp_class ipmi_user_cfgp_class = {
+	.name = "user",
+	.set = user_cfgp,
+	.count = ARRAY_SIZE(user_cfgp),
+	.handler = user_cfgp_handler,
+	.progress = NULL,
+	.priv_size = sizeof(struct channel_cfgp_priv),
+	.open = channel_cfgp_open
+};
+
 int
 ipmi_channel_main(struct ipmi_intf *intf, int argc, char **argv)
 {
@@ -42,6 +42,7 @@
 #include <ipmitool/ipmi.h>
 #include <ipmitool/log.h>
 #include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_cfgp.h>
 #include <ipmitool/ipmi_strings.h>
 #include <ipmitool/ipmi_chassis.h>
 #include <ipmitool/ipmi_time.h>
@@ -1896,6 +1897,185 @@ bootdev_parse_options(char *optstring, uint8_t flags[])
 	return true;
 }
 
+/*
+ * System boot options for 'config save' and 'config apply'
+ */
+struct boot_cfgp_priv {
+	struct ipmi_intf *intf;
+};
+
+static const struct ipmi_cfgp boot_cfgp[] = {
+	{ .name = "service-partition", .format = "<selector>", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_CHASSIS_BOOTPARAM_SVCPART_SELECT
+	},
+	{ .name = "service-partition-scan", .format = "<flags>", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_CHASSIS_BOOTPARAM_SVCPART_SCAN
+	},
+	{ .name = "flag-valid-clearing", .format = "<flags>", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_CHASSIS_BOOTPARAM_FLAG_VALID
+	},
+	{ .name = "boot-flags", .format = "<data>", .size = 5,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_CHASSIS_BOOTPARAM_BOOT_FLAGS
+	}
+};
+
+static int
+boot_cfgp_parse(const struct ipmi_cfgp *p, int argc, const char **argv,
+		unsigned char *data)
+{
+	if (argc == 0) {
+		return -1;
+	}
+
+	if (p->specific == IPMI_CHASSIS_BOOTPARAM_BOOT_FLAGS) {
+		if (ipmi_parse_hex(argv[0], data, p->size) != (int)p->size) {
+			return -1;
+		}
+		return 0;
+	}
+
+	return str2uchar(argv[0], &data[0]) ? -1 : 0;
+}
+
+static void
+boot_cfgp_save(const struct ipmi_cfgp *p, const unsigned char *data,
+		FILE *file)
+{
+	switch (p->specific) {
+	case IPMI_CHASSIS_BOOTPARAM_SVCPART_SELECT:
+		fprintf(file, "%d", data[0]);
+		break;
+
+	case IPMI_CHASSIS_BOOTPARAM_BOOT_FLAGS:
+		fputs(buf2str(data, p->size), file);
+		break;
+
+	default:
+		fprintf(file, "0x%02x", data[0]);
+	}
+}
+
+static int
+boot_cfgp_get(struct boot_cfgp_priv *bp, const struct ipmi_cfgp *p,
+		unsigned char *data, int quiet)
+{
+	struct ipmi_rs *rsp;
+	struct ipmi_rq req;
+	uint8_t msg_data[3];
+
+	msg_data[0] = p->specific;
+	msg_data[1] = 0;
+	msg_data[2] = 0;
+
+	memset(&req, 0, sizeof(req));
+	req.msg.netfn = IPMI_NETFN_CHASSIS;
+	req.msg.cmd = 0x9;
+	req.msg.data = msg_data;
+	req.msg.data_len = 3;
+
+	rsp = bp->intf->sendrecv(bp->intf, &req);
+	if (!rsp || rsp->ccode || rsp->data_len < 3) {
+		if (!quiet) {
+			lprintf(LOG_ERR, "Unable to get boot parameter '%s': %s",
+				p->name, !rsp ? "no response"
+				: specific_val2str(rsp->ccode,
+				                   get_bootparam_cc_vals,
+				                   completion_code_vals));
+		}
+		return -1;
+	}
+
+	memcpy(data, &rsp->data[2], __min(rsp->data_len - 2, (int)p->size));
+	return 0;
+}
+
+static int
+boot_cfgp_handler(void *priv, const struct ipmi_cfgp *p,
+		const struct ipmi_cfgp_action *action, unsigned char *data)
+{
+	struct boot_cfgp_priv *bp = priv;
+
+	switch (action->type) {
+	case CFGP_PARSE:
+		return boot_cfgp_parse(p, action->argc, action->argv, data);
+
+	case CFGP_GET:
+		return boot_cfgp_get(bp, p, data, action->quiet);
+
+	case CFGP_SET:
+		/* errors are reported by ipmi_chassis_set_bootparam() */
+		return ipmi_chassis_set_bootparam(bp->intf, p->specific,
+				data, p->size) ? -1 : 0;
+
+	case CFGP_SAVE:
+		boot_cfgp_save(p, data, action->file);
+		return 0;
+
+	case CFGP_PRINT:
+		fprintf(action->file, "%-22s: ", p->name);
+		boot_cfgp_save(p, data, action->file);
+		fputc('\n', action->file);
+		return 0;
+
+	default:
+		return -1;
+	}
+}
+
+static int
+boot_cfgp_progress(void *priv, int state)
+{
+	struct boot_cfgp_priv *bp = priv;
+	uint8_t flag = state;
+	int rc;
+
+	rc = ipmi_chassis_set_bootparam(bp->intf,
+	                                IPMI_CHASSIS_BOOTPARAM_SET_IN_PROGRESS,
+	                                &flag, 1);
+	if (rc == 0) {
+		return 0;
+	}
+
+	/* like the SOL parameters, see sol_cfgp_progress() */
+	if (rc == 0x80 || state == CFGP_COMMIT_WRITE) {
+		return 1;
+	}
+
+	lprintf(LOG_ERR, "Unable to set boot Set In Progress to %d: %s",
+		state, (rc < 0) ? "no response"
+		: specific_val2str(rc, set_bootparam_cc_vals,
+		                   completion_code_vals));
+	return -1;
+}
+
+static int
+boot_cfgp_open(struct ipmi_intf *intf, int __UNUSED__(channel), void *priv)
+{
+	struct boot_cfgp_priv *bp = priv;
+
+	bp->intf = intf;
+	return 0;
+}
+
+const struct ipmi_cfgp_class ipmi_boot_cfgp_class = {
+	.name = "boot",
+	.set = boot_cfgp,
+	.count = ARRAY_SIZE(boot_cfgp),
+	.handler = boot_cfgp_handler,
+	.progress = boot_cfgp_progress,
+	.global = 1,
+	.priv_size = sizeof(struct boot_cfgp_priv),
+	.open = boot_cfgp_open
+};
+
 int
 ipmi_chassis_main(struct ipmi_intf * intf, int argc, char ** argv)
 {
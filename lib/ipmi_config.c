@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) 2026 The ipmitool Project.  All Rights Reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistribution of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * Redistribution in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder, nor the names of
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ * 
+ * This software is provided "AS IS," without a warranty of any kind.
+ * ALL EXPRESS OR IMPLIED CONDITIONS, REPRESENTATIONS AND WARRANTIES,
+ * INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE OR NON-INFRINGEMENT, ARE HEREBY EXCLUDED.
+ * THE COPYRIGHT HOLDER AND ITS LICENSORS SHALL NOT BE LIABLE
+ * FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING
+ * OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.  IN NO EVENT WILL
+ * THE COPYRIGHT HOLDER OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE,
+ * PROFIT OR DATA, OR FOR DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL,
+ * INCIDENTAL OR PUNITIVE DAMAGES, HOWEVER CAUSED AND REGARDLESS OF THE
+ * THEORY OF LIABILITY, ARISING OUT OF THE USE OF OR INABILITY TO USE THIS
+ * SOFTWARE, EVEN IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGES.
+ */
+
+/*
+ * Channel and BMC configuration files
+ *
+ * 'config save' writes the writable parameters of a channel as lines of
+ * '<class> <channel> <parameter> [<set_sel> [<block_sel>]] <values...>'.
+ * Parameter sets that are not per channel, PEF and the system boot
+ * options, are written as channel 0.
+ * 'config apply' reads such a file back, compares every line with the
+ * value in the BMC and writes only the parameters that differ, one
+ * Set In Progress lock per parameter set and channel.  Nothing is
+ * written unless the whole file parses.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ipmitool/helper.h>
+#include <ipmitool/log.h>
+#include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_cfgp.h>
+#include <ipmitool/ipmi_config.h>
+#include <ipmitool/ipmi_channel.h>
+#include <ipmitool/ipmi_chassis.h>
+#include <ipmitool/ipmi_lanp.h>
+#include <ipmitool/ipmi_lanp6.h>
+#include <ipmitool/ipmi_pef.h>
+#include <ipmitool/ipmi_sol.h>
+
+#define CONFIG_LINE_MAX		512
+#define CONFIG_ARGS_MAX		32
+
+static const struct ipmi_cfgp_class *config_classes[] = {
+	&ipmi_lan_cfgp_class,
+	&ipmi_lan6_cfgp_class,
+	&ipmi_sol_cfgp_class,
+	&ipmi_channel_cfgp_class,
+	&ipmi_user_cfgp_class,
+	&ipmi_pef_cfgp_class,
+	&ipmi_boot_cfgp_class
+};
+
+/*
+ * One parameter set of one channel
+ */
+struct config_target {
+	struct config_target *next;
+	const struct ipmi_cfgp_class *cls;
+	int channel;
+	int total;
+	int changed;
+	char cmdname[32];
+	struct ipmi_cfgp_ctx ctx;
+	void *priv;
+};
+
+/* config_lookup_class - find a parameter class by name */
+static const struct ipmi_cfgp_class *
+config_lookup_class(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(config_classes); i++) {
+		if (!strcmp(config_classes[i]->name, name)) {
+			return config_classes[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* config_target_close - release a parameter set context */
+static void
+config_target_close(struct config_target *t)
+{
+	ipmi_cfgp_uninit(&t->ctx);
+	free(t->priv);
+	free(t);
+}
+
+/* config_target_open - set up a parameter set context for a channel */
+static struct config_target *
+config_target_open(struct ipmi_intf *intf, const struct ipmi_cfgp_class *cls,
+		int channel)
+{
+	struct config_target *t;
+
+	t = calloc(1, sizeof(*t));
+	if (t) {
+		t->priv = calloc(1, cls->priv_size);
+	}
+	if (!t || !t->priv) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		free(t);
+		return NULL;
+	}
+
+	t->cls = cls;
+	t->channel = channel;
+	snprintf(t->cmdname, sizeof(t->cmdname), "%s %d", cls->name, channel);
+
+	if (cls->open(intf, channel, t->priv)
+		|| ipmi_cfgp_init(&t->ctx, cls->set, cls->count, t->cmdname,
+		                  cls->handler, t->priv)) {
+		config_target_close(t);
+		return NULL;
+	}
+
+	return t;
+}
+
+/* config_save - write the parameters of a set as configuration lines */
+static int
+config_save(struct ipmi_intf *intf, const struct ipmi_cfgp_class *cls,
+		int channel)
+{
+	const struct ipmi_cfgp_sel all = { -1, -1, -1 };
+	struct config_target *t;
+	int ret;
+
+	if (cls->global) {
+		channel = 0;
+	}
+
+	t = config_target_open(intf, cls, channel);
+	if (!t) {
+		return -1;
+	}
+
+	ret = ipmi_cfgp_get(&t->ctx, &all);
+	if (ret == 0) {
+		if (cls->global) {
+			printf("# %s parameters\n", cls->name);
+		} else {
+			printf("# %s parameters of channel %d\n",
+				cls->name, channel);
+		}
+		ret = ipmi_cfgp_save(&t->ctx, &all, stdout);
+	}
+
+	config_target_close(t);
+	return ret;
+}
+
+/* config_apply - apply a configuration file
+ *
+ * @intf:   ipmi interface handle
+ * @name:   file name
+ *
+ * returns 0 on success, -1 on error
+ */
+static int
+config_apply(struct ipmi_intf *intf, const char *name)
+{
+	const struct ipmi_cfgp_class *cls;
+	struct config_target *targets = NULL;
+	struct config_target **tail = &targets;
+	struct config_target *t;
+	struct ipmi_cfgp_sel sel;
+	char line[CONFIG_LINE_MAX];
+	char *argv[CONFIG_ARGS_MAX];
+	char *tok;
+	FILE *fp;
+	int argc;
+	int chan;
+	int lineno = 0;
+	int ret = 0;
+	int n;
+
+	fp = ipmi_open_file_read(name);
+	if (!fp) {
+		return -1;
+	}
+
+	lprintf(LOG_NOTICE, "Comparing parameter(s)...");
+
+	while (fgets(line, sizeof(line), fp)) {
+		lineno++;
+
+		if (!strchr(line, '\n') && !feof(fp)) {
+			lprintf(LOG_ERR, "%s:%d: line is too long", name, lineno);
+			ret = -1;
+			break;
+		}
+
+		argc = 0;
+		tok = strtok(line, " \t\r\n");
+		while (tok && argc < CONFIG_ARGS_MAX) {
+			argv[argc++] = tok;
+			tok = strtok(NULL, " \t\r\n");
+		}
+
+		if (argc == 0 || argv[0][0] == '#') {
+			continue;
+		}
+
+		if (tok) {
+			lprintf(LOG_ERR, "%s:%d: too many values", name, lineno);
+			ret = -1;
+			break;
+		}
+
+		cls = config_lookup_class(argv[0]);
+		if (!cls || argc < 3) {
+			lprintf(LOG_ERR, "%s:%d: expected '<class> <channel> "
+				"<parameter> <values...>'", name, lineno);
+			ret = -1;
+			break;
+		}
+
+		if (str2int(argv[1], &chan) != 0
+			|| chan < 0 || chan > IPMI_CHANNEL_NUMBER_MAX) {
+			lprintf(LOG_ERR, "%s:%d: invalid channel: %s",
+				name, lineno, argv[1]);
+			ret = -1;
+			break;
+		}
+
+		if (cls->global && chan != 0) {
+			lprintf(LOG_ERR, "%s:%d: %s parameters take channel 0",
+				name, lineno, cls->name);
+			ret = -1;
+			break;
+		}
+
+		for (t = targets; t; t = t->next) {
+			if (t->cls == cls && t->channel == chan) {
+				break;
+			}
+		}
+		if (!t) {
+			t = config_target_open(intf, cls, chan);
+			if (!t) {
+				ret = -1;
+				break;
+			}
+			*tail = t;
+			tail = &t->next;
+		}
+
+		n = ipmi_cfgp_parse_sel(&t->ctx, argc - 2,
+			(const char **)argv + 2, &sel);
+		if (n > 0) {
+			ret = ipmi_cfgp_parse_diff(&t->ctx, &sel, argc - 2 - n,
+				(const char **)argv + 2 + n);
+		} else {
+			ret = -1;
+		}
+		if (ret < 0) {
+			lprintf(LOG_ERR, "%s:%d: invalid parameter line",
+				name, lineno);
+			break;
+		}
+
+		t->total++;
+		t->changed += ret;
+		ret = 0;
+	}
+
+	fclose(fp);
+
+	for (t = targets; t && ret == 0; t = t->next) {
+		if (t->changed == 0) {
+			printf("%s: %d parameter(s) already up to date\n",
+				t->cmdname, t->total);
+			continue;
+		}
+
+		lprintf(LOG_NOTICE, "Setting %d parameter(s) of %s...",
+			t->changed, t->cmdname);
+
+		ret = ipmi_cfgp_write(&t->ctx, t->cls->progress);
+		if (ret == 0) {
+			printf("%s: %d of %d parameter(s) changed\n",
+				t->cmdname, t->changed, t->total);
+		}
+	}
+
+	while (targets) {
+		t = targets;
+		targets = t->next;
+		config_target_close(t);
+	}
+
+	return ret;
+}
+
+static void
+config_usage(void)
+{
+	size_t i;
+
+	lprintf(LOG_NOTICE,
+"Configuration Commands:");
+	lprintf(LOG_NOTICE,
+"  save [<class> [<channel>]]");
+	lprintf(LOG_NOTICE,
+"  apply <file>");
+	lprintf(LOG_NOTICE,
+"  help [<class>]");
+	lprintf(LOG_NOTICE,
+"\nConfiguration file lines are:");
+	lprintf(LOG_NOTICE,
+"  <class> <channel> <parameter> [<set_sel> [<block_sel>]] <values...>");
+	lprintf(LOG_NOTICE,
+"\nClasses:");
+	for (i = 0; i < ARRAY_SIZE(config_classes); i++) {
+		lprintf(LOG_NOTICE, "  %s", config_classes[i]->name);
+	}
+}
+
+int
+ipmi_config_main(struct ipmi_intf *intf, int argc, char **argv)
+{
+	const struct ipmi_cfgp_class *cls = NULL;
+	size_t i;
+	int chan;
+	int ret = 0;
+
+	if (argc == 0 || !strcmp(argv[0], "help")) {
+		if (argc > 1) {
+			cls = config_lookup_class(argv[1]);
+		}
+		if (!cls) {
+			config_usage();
+			return argc ? 0 : -1;
+		}
+		printf("%s parameters:\n", cls->name);
+		ipmi_cfgp_usage(cls->set, cls->count, 1);
+		return 0;
+	}
+
+	if (!strcmp(argv[0], "apply")) {
+		if (argc != 2) {
+			config_usage();
+			return -1;
+		}
+		return config_apply(intf, argv[1]);
+	}
+
+	if (strcmp(argv[0], "save") || argc > 3) {
+		config_usage();
+		return -1;
+	}
+
+	if (argc > 1) {
+		cls = config_lookup_class(argv[1]);
+		if (!cls) {
+			lprintf(LOG_ERR, "Unknown parameter class: %s", argv[1]);
+			return -1;
+		}
+	}
+
+	if (argc > 2) {
+		if (str2int(argv[2], &chan) != 0
+			|| chan < 0 || chan > IPMI_CHANNEL_NUMBER_MAX) {
+			lprintf(LOG_ERR, "Invalid channel: %s", argv[2]);
+			return -1;
+		}
+	} else {
+		chan = find_lan_channel(intf, 1);
+		if (chan == 0) {
+			lprintf(LOG_ERR, "No LAN channel found");
+			return -1;
+		}
+	}
+
+	if (cls) {
+		return config_save(intf, cls, chan);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(config_classes); i++) {
+		if (config_save(intf, config_classes[i], chan) != 0) {
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
@@ -41,7 +41,9 @@
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <signal.h>
 #include <unistd.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <time.h>
 #include <netdb.h>
@@ -200,6 +202,7 @@ const struct dcmi_cmd dcmi_pwrmgmt_vals[] = {
 	{ 0x02, "set_limit",  "Set a power limit option" },
 	{ 0x03, "activate",   "Activate the set power limit" },
 	{ 0x04, "deactivate", "Deactivate the set power limit" },
+	{ 0x05, "stream",     "Sample power readings at a fixed interval" },
 
 	DCMI_CMD_END(0xFF)
 };
@@ -3521,6 +3524,317 @@ ipmi_dcmi_set_limit(struct ipmi_intf * intf, int argc, char **argv)
 	return rc;
 }
 
+/* Power telemetry streaming
+ *
+ * 'dcmi power stream' keeps the session open and samples the DCMI power
+ * reading and any requested Node Manager statistics once per interval.
+ * Every sample is printed as one timestamped record carrying the reading
+ * and the rolling minimum, average and maximum over the last 'window'
+ * samples, computed locally.  Ticks are scheduled from the start time so
+ * that slow responses do not make the cadence drift; ticks that cannot
+ * be kept are skipped rather than bunched up.
+ */
+#define DCMI_STREAM_INTERVAL	5	/* seconds */
+#define DCMI_STREAM_WINDOW	12	/* samples */
+#define DCMI_STREAM_MAX_WINDOW	3600
+#define DCMI_STREAM_MAX_SOURCES	16
+
+struct dcmi_stream_src {
+	char name[32];
+	struct ipmi_rq req;	/* built once, sent every tick */
+	uint8_t msg_data[6];
+	uint8_t grp_id;		/* expected first response byte */
+	uint16_t *win;		/* ring of the last readings */
+	size_t fill;
+	size_t next;
+	uint32_t sum;
+	uint64_t errors;
+};
+
+static volatile sig_atomic_t _dcmi_stream_stop;
+
+static void
+ipmi_dcmi_stream_stop(int __UNUSED__(sig))
+{
+	_dcmi_stream_stop = 1;
+}
+
+/* ipmi_dcmi_stream_add - set up a source, mode 0 is the DCMI reading */
+static struct dcmi_stream_src *
+ipmi_dcmi_stream_add(struct dcmi_stream_src *src, size_t *nsrc,
+                     size_t window, uint8_t mode, uint8_t domain,
+                     uint8_t policy_id)
+{
+	struct dcmi_stream_src *s;
+
+	if (*nsrc >= DCMI_STREAM_MAX_SOURCES) {
+		lprintf(LOG_ERR, "At most %d readings can be streamed",
+		        DCMI_STREAM_MAX_SOURCES);
+		return NULL;
+	}
+	s = &src[(*nsrc)++];
+	memset(s, 0, sizeof(*s));
+	s->win = calloc(window, sizeof(*s->win));
+	if (!s->win) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		return NULL;
+	}
+
+	if (!mode) {
+		strcpy(s->name, "dcmi");
+		s->grp_id = IPMI_DCMI;
+		s->msg_data[0] = IPMI_DCMI;
+		s->msg_data[1] = 0x01;	/* Mode Power Status */
+		s->req.msg.netfn = IPMI_NETFN_DCGRP;
+		s->req.msg.cmd = IPMI_DCMI_GETRED;
+		s->req.msg.data_len = 4;
+	} else {
+		if (mode == 0x11) {
+			snprintf(s->name, sizeof(s->name), "nm:%s:%u",
+			         val2str2(domain, nm_domain_vals), policy_id);
+		} else {
+			snprintf(s->name, sizeof(s->name), "nm:%s",
+			         val2str2(domain, nm_domain_vals));
+		}
+		s->grp_id = 0x57;
+		s->msg_data[0] = 0x57;	/* Intel manufacturer ID */
+		s->msg_data[1] = 0x01;
+		s->msg_data[2] = 0x00;
+		s->msg_data[3] = mode;
+		s->msg_data[4] = domain;
+		s->msg_data[5] = policy_id;
+		s->req.msg.netfn = IPMI_NETFN_OEM;
+		s->req.msg.cmd = IPMI_NM_GET_STATS;
+		s->req.msg.data_len = 6;
+	}
+	s->req.msg.data = s->msg_data;
+	return s;
+}
+
+/* ipmi_dcmi_stream_sample - take and print one sample of a source */
+static void
+ipmi_dcmi_stream_sample(struct ipmi_intf *intf, struct dcmi_stream_src *s,
+                        size_t window, const char *stamp)
+{
+	struct ipmi_rs *rsp;
+	uint16_t cur, min, max;
+	size_t i;
+
+	rsp = intf->sendrecv(intf, &s->req);
+	/* the reading follows the group ID or the 3 byte manufacturer ID */
+	if (!rsp || rsp->ccode
+	    || rsp->data_len < (s->grp_id == IPMI_DCMI ? 3 : 5)
+	    || rsp->data[0] != s->grp_id)
+	{
+		s->errors++;
+		if (csv_output) {
+			printf("%s,%s,,,,,%s\n", stamp, s->name,
+			       rsp ? "error" : "timeout");
+		} else {
+			printf("%s %s %s", stamp, s->name,
+			       rsp ? "error" : "timeout");
+			if (rsp && rsp->ccode)
+				printf(" ccode=0x%02x", rsp->ccode);
+			printf("\n");
+		}
+		return;
+	}
+
+	cur = (s->grp_id == IPMI_DCMI) ? ipmi16toh(rsp->data + 1)
+	                               : ipmi16toh(rsp->data + 3);
+
+	if (s->fill == window)
+		s->sum -= s->win[s->next];
+	else
+		s->fill++;
+	s->win[s->next] = cur;
+	s->sum += cur;
+	s->next = (s->next + 1) % window;
+
+	min = max = cur;
+	for (i = 0; i < s->fill; i++) {
+		min = __min(min, s->win[i]);
+		max = __max(max, s->win[i]);
+	}
+
+	printf(csv_output ? "%s,%s,%u,%u,%u,%u,\n"
+	                  : "%s %s cur=%u min=%u avg=%u max=%u\n",
+	       stamp, s->name, cur, min,
+	       (unsigned)((s->sum + s->fill / 2) / s->fill), max);
+}
+
+/* ipmi_dcmi_pwr_stream - sample power readings until stopped
+ *
+ * @intf:   ipmi interface handler
+ * @argv:   stream options
+ */
+static int
+ipmi_dcmi_pwr_stream(struct ipmi_intf *intf, char **argv)
+{
+	struct dcmi_stream_src src[DCMI_STREAM_MAX_SOURCES];
+	struct sigaction act, old_int, old_term;
+	size_t nsrc = 0, window = DCMI_STREAM_WINDOW, i;
+	uint32_t count = 0, samples = 0;
+	uint64_t interval = DCMI_STREAM_INTERVAL * 1000000ULL;
+	uint64_t start, tick = 0, missed = 0;
+	uint8_t domain = 0;
+	int dcmi = 1, rc = 0;
+	struct {
+		uint8_t mode;
+		uint8_t domain;
+		uint8_t policy_id;
+	} nm[DCMI_STREAM_MAX_SOURCES];
+	size_t nnm = 0;
+
+	for (; *argv; argv++) {
+		char *arg = *argv;
+		char *val = strchr(arg, '=');
+		uint8_t id;
+
+		if (val)
+			val++;
+		if (!strcmp(arg, "nodcmi")) {
+			dcmi = 0;
+		} else if (!strncmp(arg, "interval=", 9)) {
+			double sec = strtod(val, &arg);
+
+			if (*arg || sec < 0.1 || sec > 86400) {
+				lprintf(LOG_ERR, "Invalid interval '%s'", val);
+				return -1;
+			}
+			interval = sec * 1000000;
+		} else if (!strncmp(arg, "count=", 6)) {
+			if (str2uint(val, &count)) {
+				lprintf(LOG_ERR, "Invalid count '%s'", val);
+				return -1;
+			}
+		} else if (!strncmp(arg, "window=", 7)) {
+			uint32_t w;
+
+			if (str2uint(val, &w) || !w || w > DCMI_STREAM_MAX_WINDOW) {
+				lprintf(LOG_ERR, "Window must be 1 to %d samples",
+				        DCMI_STREAM_MAX_WINDOW);
+				return -1;
+			}
+			window = w;
+		} else if (!strncmp(arg, "nm=", 3) || !strncmp(arg, "policy=", 7)) {
+			if (nnm == ARRAY_SIZE(nm)) {
+				lprintf(LOG_ERR, "At most %d readings can be streamed",
+				        DCMI_STREAM_MAX_SOURCES);
+				return -1;
+			}
+			if (arg[0] == 'n') {
+				domain = str2val2(val, nm_domain_vals);
+				if (domain == 0xFF) {
+					print_strs(nm_domain_vals, "Domain Scope:",
+					           LOG_ERR, 0);
+					return -1;
+				}
+				nm[nnm].mode = 0x01;	/* global power */
+				id = 0;
+			} else {
+				if (str2uchar(val, &id)) {
+					lprintf(LOG_ERR, "Policy ID must be a positive "
+					        "integer (0-255)");
+					return -1;
+				}
+				nm[nnm].mode = 0x11;	/* per policy power */
+			}
+			nm[nnm].domain = domain;
+			nm[nnm].policy_id = id;
+			nnm++;
+		} else {
+			lprintf(LOG_ERR, "Invalid stream option '%s'", arg);
+			lprintf(LOG_NOTICE, "power stream [interval=<sec>] "
+			        "[count=<n>] [window=<n>] [nodcmi]");
+			lprintf(LOG_NOTICE, "             [nm=<domain>] "
+			        "[policy=<id>] ...");
+			return -1;
+		}
+	}
+
+	if (dcmi && !ipmi_dcmi_stream_add(src, &nsrc, window, 0, 0, 0)) {
+		rc = -1;
+		goto out;
+	}
+	for (i = 0; i < nnm; i++) {
+		if (!ipmi_dcmi_stream_add(src, &nsrc, window, nm[i].mode,
+		                          nm[i].domain, nm[i].policy_id))
+		{
+			rc = -1;
+			goto out;
+		}
+	}
+	if (!nsrc) {
+		lprintf(LOG_ERR, "Nothing to sample");
+		return -1;
+	}
+
+	if (csv_output)
+		printf("time,source,current,min,avg,max,error\n");
+
+	/* no SA_RESTART, a signal must cut the sleep short */
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = ipmi_dcmi_stream_stop;
+	_dcmi_stream_stop = 0;
+	sigaction(SIGINT, &act, &old_int);
+	sigaction(SIGTERM, &act, &old_term);
+
+	start = ipmi_time_usec();
+	while (!_dcmi_stream_stop && (!count || samples < count)) {
+		struct timeval tv;
+		char stamp[24];
+		uint64_t now, due;
+
+		gettimeofday(&tv, NULL);
+		snprintf(stamp, sizeof(stamp), "%lu.%03lu",
+		         (unsigned long)tv.tv_sec,
+		         (unsigned long)tv.tv_usec / 1000);
+
+		for (i = 0; i < nsrc && !_dcmi_stream_stop; i++)
+			ipmi_dcmi_stream_sample(intf, &src[i], window, stamp);
+		fflush(stdout);
+		samples++;
+		if (count && samples >= count)
+			break;
+
+		/* next tick on the fixed grid, skip the ones already past */
+		tick++;
+		now = ipmi_time_usec();
+		due = start + tick * interval;
+		if (now >= due) {
+			uint64_t behind = (now - due) / interval + 1;
+
+			tick += behind;
+			missed += behind;
+			due = start + tick * interval;
+		}
+		while (!_dcmi_stream_stop && (now = ipmi_time_usec()) < due) {
+			struct timespec ts;
+
+			ts.tv_sec = (due - now) / 1000000;
+			ts.tv_nsec = (due - now) % 1000000 * 1000;
+			nanosleep(&ts, NULL);
+		}
+	}
+
+	sigaction(SIGINT, &old_int, NULL);
+	sigaction(SIGTERM, &old_term, NULL);
+
+	for (i = 0; i < nsrc; i++) {
+		lprintf(LOG_INFO, "%s: %u samples, %" PRIu64 " failed",
+		        src[i].name, samples, src[i].errors);
+	}
+	if (missed)
+		lprintf(LOG_INFO, "%" PRIu64 " ticks missed", missed);
+
+out:
+	for (i = 0; i < nsrc; i++)
+		free(src[i].win);
+	return rc;
+}
+/* end power telemetry streaming */
+
 static int
 ipmi_dcmi_parse_power(struct ipmi_intf * intf, int argc, char **argv)
 {
@@ -3569,6 +3883,10 @@ ipmi_dcmi_parse_power(struct ipmi_intf * intf, int argc, char **argv)
 		/* deactivate */
 		rc = ipmi_dcmi_pwr_actdeact(intf, 0);
 		break;
+	case 0x05:
+		/* stream readings */
+		rc = ipmi_dcmi_pwr_stream(intf, argv + 1);
+		break;
 	default:
 		/* no valid options */
 		print_strs(dcmi_pwrmgmt_vals,
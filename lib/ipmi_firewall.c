@@ -35,12 +35,16 @@
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <ipmitool/helper.h>
 #include <ipmitool/log.h>
 #include <ipmitool/bswap.h>
 #include <ipmitool/ipmi.h>
 #include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_mc.h>
 #include <ipmitool/ipmi_firewall.h>
 #include <ipmitool/ipmi_strings.h>
 
@@ -52,7 +56,7 @@ printf_firewall_usage(void)
 	lprintf(LOG_NOTICE,
 "\tinfo [channel H] [lun L]");
 	lprintf(LOG_NOTICE,
-"\tinfo [channel H] [lun L [netfn N [command C [subfn S]]]]");
+"\tinfo [channel H] [lun L [netfn N [command C [subfn S]]]] [nocache]");
 	lprintf(LOG_NOTICE,
 "\tenable [channel H] [lun L [netfn N [command C [subfn S]]]]");
 	lprintf(LOG_NOTICE,
@@ -63,6 +67,8 @@ printf_firewall_usage(void)
 "\t\twhere H is a Channel, L is a LUN, N is a NetFn,");
 	lprintf(LOG_NOTICE,
 "\t\tC is a Command and S is a Sub-Function");
+	lprintf(LOG_NOTICE,
+"\t\tnocache bypasses the capability cache in ~/" FIREWALL_CACHE_DIR);
 }
 
 void
@@ -147,6 +153,9 @@ ipmi_firewall_parse_args(int argc, char ** argv, struct ipmi_function_params * p
 		else if (!strcmp(argv[i], "force")) {
 			p->force = 1;
 		}
+		else if (!strcmp(argv[i], "nocache")) {
+			p->nocache = 1;
+		}
 		else if (!strcmp(argv[i], "netfn") && (++i < argc)) {
 			if (str2int(argv[i], &(p->netfn)) != 0) {
 				lprintf(LOG_ERR, "Given netfn '%s' is invalid.", argv[i]);
@@ -800,6 +809,297 @@ _set_subfn_enables(struct ipmi_intf * intf,
 	return 0;
 }
 
+/* _cache_key - identify the firmware of the BMC
+ *
+ * @intf:	ipmi interface
+ * @channel:	ipmi channel
+ * @key:	a pointer to a FIREWALL_CACHE_KEY_LEN byte buffer
+ *
+ * returns 0 on success and fills key with the channel and the
+ * Get Device ID response
+ * returns -1 on error
+ */
+static int
+_cache_key(struct ipmi_intf * intf, int channel, unsigned char * key)
+{
+	struct ipmi_rs * rsp;
+	struct ipmi_rq req;
+
+	memset(&req, 0, sizeof(req));
+	req.msg.netfn = IPMI_NETFN_APP;
+	req.msg.cmd = BMC_GET_DEVICE_ID;
+
+	rsp = intf->sendrecv(intf, &req);
+	if (!rsp || rsp->ccode)
+		return -1;
+
+	memset(key, 0, FIREWALL_CACHE_KEY_LEN);
+	key[0] = (unsigned char) channel;
+	memcpy(key + 1, rsp->data, __min(rsp->data_len, FIREWALL_CACHE_KEY_LEN - 1));
+	return 0;
+}
+
+/* _cache_load - read the cache file, unless it belongs to other firmware
+ *
+ * @cache:	a pointer to a struct firewall_cache with path and key set
+ */
+static void
+_cache_load(struct firewall_cache * cache)
+{
+	struct firewall_cache_subfn sf;
+	unsigned char magic[sizeof(FIREWALL_CACHE_MAGIC) - 1];
+	unsigned char key[FIREWALL_CACHE_KEY_LEN];
+	unsigned char hdr[2 + MAX_COMMAND_BYTES * 2];
+	unsigned char count[2];
+	unsigned int i, n;
+	void * tmp;
+	FILE * fp;
+
+	fp = fopen(cache->path, "rb");
+	if (!fp)
+		return;
+
+	if (fread(magic, sizeof(magic), 1, fp) != 1
+	    || memcmp(magic, FIREWALL_CACHE_MAGIC, sizeof(magic))
+	    || fread(key, sizeof(key), 1, fp) != 1
+	    || memcmp(key, cache->key, sizeof(key))) {
+		lprintf(LOG_INFO, "Firewall cache %s is stale, refreshing", cache->path);
+		goto out;
+	}
+	if (fread(cache->lun, sizeof(cache->lun), 1, fp) != 1
+	    || fread(cache->netfn, sizeof(cache->netfn), 1, fp) != 1)
+		goto out;
+	cache->have_netfn = 1;
+
+	/* LUN/NetFn pairs: lun, pair, command mask, configurable mask */
+	if (fread(count, sizeof(count), 1, fp) != 1)
+		goto out;
+	n = count[0] | count[1] << 8;
+	for (i = 0; i < n; i++) {
+		if (fread(hdr, sizeof(hdr), 1, fp) != 1)
+			goto out;
+		if (hdr[0] >= MAX_LUN || hdr[1] >= MAX_NETFN_PAIR)
+			continue;
+		memcpy(cache->command_mask[hdr[0]][hdr[1]], hdr + 2, MAX_COMMAND_BYTES);
+		memcpy(cache->config_mask[hdr[0]][hdr[1]], hdr + 2 + MAX_COMMAND_BYTES,
+			MAX_COMMAND_BYTES);
+		cache->valid[hdr[0]][hdr[1]] = 1;
+	}
+
+	/* commands with known sub-functions */
+	if (fread(count, sizeof(count), 1, fp) != 1)
+		goto out;
+	n = count[0] | count[1] << 8;
+	for (i = 0; i < n; i++) {
+		if (fread(&sf, sizeof(sf), 1, fp) != 1)
+			goto out;
+		tmp = realloc(cache->subfn, (cache->subfn_count + 1) * sizeof(sf));
+		if (!tmp)
+			goto out;
+		cache->subfn = tmp;
+		cache->subfn[cache->subfn_count++] = sf;
+	}
+	lprintf(LOG_DEBUG, "Loaded firewall cache %s", cache->path);
+out:
+	fclose(fp);
+}
+
+/* _cache_save - write the cache file
+ *
+ * @cache:	a pointer to a struct firewall_cache
+ *
+ * the file is written aside and renamed so that readers never see
+ * a partial cache
+ */
+static void
+_cache_save(struct firewall_cache * cache)
+{
+	char tmp[PATH_MAX + sizeof(".tmp")];
+	char * dir;
+	unsigned int l, n, count = 0;
+	FILE * fp;
+
+	/* create the cache directory if needed */
+	snprintf(tmp, sizeof(tmp), "%s", cache->path);
+	dir = strrchr(tmp, '/');
+	if (dir) {
+		*dir = '\0';
+		if (mkdir(tmp, 0700) < 0 && errno != EEXIST) {
+			lperror(LOG_DEBUG, "Cannot create %s", tmp);
+			return;
+		}
+	}
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", cache->path);
+	fp = fopen(tmp, "wb");
+	if (!fp) {
+		lperror(LOG_DEBUG, "Cannot write %s", tmp);
+		return;
+	}
+	fwrite(FIREWALL_CACHE_MAGIC, sizeof(FIREWALL_CACHE_MAGIC) - 1, 1, fp);
+	fwrite(cache->key, sizeof(cache->key), 1, fp);
+	fwrite(cache->lun, sizeof(cache->lun), 1, fp);
+	fwrite(cache->netfn, sizeof(cache->netfn), 1, fp);
+
+	for (l = 0; l < MAX_LUN; l++)
+		for (n = 0; n < MAX_NETFN_PAIR; n++)
+			count += cache->valid[l][n];
+	fputc(count & 0xff, fp);
+	fputc(count >> 8, fp);
+	for (l = 0; l < MAX_LUN; l++) {
+		for (n = 0; n < MAX_NETFN_PAIR; n++) {
+			if (!cache->valid[l][n])
+				continue;
+			fputc(l, fp);
+			fputc(n, fp);
+			fwrite(cache->command_mask[l][n], MAX_COMMAND_BYTES, 1, fp);
+			fwrite(cache->config_mask[l][n], MAX_COMMAND_BYTES, 1, fp);
+		}
+	}
+
+	fputc(cache->subfn_count & 0xff, fp);
+	fputc(cache->subfn_count >> 8, fp);
+	fwrite(cache->subfn, sizeof(*cache->subfn), cache->subfn_count, fp);
+
+	if (fclose(fp) || rename(tmp, cache->path) < 0) {
+		lperror(LOG_DEBUG, "Cannot write %s", cache->path);
+		unlink(tmp);
+	}
+}
+
+/* _cache_open - set up the capability cache for the BMC behind intf
+ *
+ * @intf:	ipmi interface
+ * @p:		a pointer to a struct ipmi_function_params
+ *
+ * returns a cache, possibly empty, or NULL if caching is not possible
+ */
+static struct firewall_cache *
+_cache_open(struct ipmi_intf * intf, struct ipmi_function_params * p)
+{
+	struct firewall_cache * cache;
+	const char * home = getenv("HOME");
+	const char * host = intf->ssn_params.hostname;
+
+	if (p->nocache || !home)
+		return NULL;
+
+	cache = calloc(1, sizeof(struct firewall_cache));
+	if (!cache)
+		return NULL;
+	if (_cache_key(intf, p->channel, cache->key) < 0) {
+		free(cache);
+		return NULL;
+	}
+	snprintf(cache->path, sizeof(cache->path),
+		"%s/" FIREWALL_CACHE_DIR "/firewall-%s-ch%d.cache",
+		home, (host && !strchr(host, '/')) ? host : "local", p->channel);
+	_cache_load(cache);
+	return cache;
+}
+
+/* _cache_close - save the cache if it changed and free it
+ *
+ * @cache:	a pointer to a struct firewall_cache or NULL
+ */
+static void
+_cache_close(struct firewall_cache * cache)
+{
+	if (!cache)
+		return;
+	if (cache->dirty)
+		_cache_save(cache);
+	free(cache->subfn);
+	free(cache);
+}
+
+/* _get_command_caps - support and configurable bits, cached
+ *
+ * @intf:	ipmi interface
+ * @p:		a pointer to a struct ipmi_function_params
+ * @lnfn:	a pointer to a struct lun_netfn_support
+ * @cache:	a pointer to a struct firewall_cache or NULL
+ *
+ * returns 0 on success and fills in lnfn according to the request in p
+ * returns -1 on error
+ */
+static int
+_get_command_caps(struct ipmi_intf * intf, struct ipmi_function_params * p,
+	struct lun_netfn_support * lnfn, struct firewall_cache * cache)
+{
+	int l = p->lun, n = p->netfn >> 1;
+	unsigned int c;
+	int ret;
+
+	if (cache && cache->valid[l][n]) {
+		memcpy(lnfn->command_mask, cache->command_mask[l][n], MAX_COMMAND_BYTES);
+		memcpy(lnfn->config_mask, cache->config_mask[l][n], MAX_COMMAND_BYTES);
+		for (c=0; c<MAX_COMMAND; c++) {
+			if (!bit_test(lnfn->command_mask, c))
+				lnfn->command[c].support |= BIT_AVAILABLE;
+			if (bit_test(lnfn->config_mask, c))
+				lnfn->command[c].support |= BIT_CONFIGURABLE;
+		}
+		return 0;
+	}
+
+	ret = _get_command_support(intf, p, lnfn);
+	ret |= _get_command_configurable(intf, p, lnfn);
+	if (!ret && cache) {
+		memcpy(cache->command_mask[l][n], lnfn->command_mask, MAX_COMMAND_BYTES);
+		memcpy(cache->config_mask[l][n], lnfn->config_mask, MAX_COMMAND_BYTES);
+		cache->valid[l][n] = 1;
+		cache->dirty = 1;
+	}
+	return ret;
+}
+
+/* _get_subfn_caps - sub-function support and configurable bits, cached
+ *
+ * @intf:	ipmi interface
+ * @p:		a pointer to a struct ipmi_function_params
+ * @cmd:	a pointer to a struct command_support
+ * @cache:	a pointer to a struct firewall_cache or NULL
+ *
+ * returns 0 on success and fills in cmd according to the request in p
+ * returns -1 on error
+ */
+static int
+_get_subfn_caps(struct ipmi_intf * intf, struct ipmi_function_params * p,
+	struct command_support * cmd, struct firewall_cache * cache)
+{
+	struct firewall_cache_subfn * sf;
+	void * tmp;
+	int i, ret;
+
+	for (i = 0; cache && i < cache->subfn_count; i++) {
+		sf = &cache->subfn[i];
+		if (sf->lun == p->lun && sf->netfn == p->netfn >> 1
+		    && sf->command == p->command) {
+			memcpy(cmd->subfn_support, sf->support, MAX_SUBFN_BYTES);
+			memcpy(cmd->subfn_config, sf->config, MAX_SUBFN_BYTES);
+			return 0;
+		}
+	}
+
+	ret = _get_subfn_support(intf, p, cmd);
+	ret |= _get_subfn_configurable(intf, p, cmd);
+	if (!ret && cache) {
+		tmp = realloc(cache->subfn, (cache->subfn_count + 1) * sizeof(*sf));
+		if (tmp) {
+			cache->subfn = tmp;
+			sf = &cache->subfn[cache->subfn_count++];
+			sf->lun = p->lun;
+			sf->netfn = p->netfn >> 1;
+			sf->command = p->command;
+			memcpy(sf->support, cmd->subfn_support, MAX_SUBFN_BYTES);
+			memcpy(sf->config, cmd->subfn_config, MAX_SUBFN_BYTES);
+			cache->dirty = 1;
+		}
+	}
+	return ret;
+}
+
 /* _gather_info
  *
  * @intf:	ipmi interface
@@ -814,8 +1114,22 @@ static int _gather_info(struct ipmi_intf * intf, struct ipmi_function_params * p
 {
 	int ret, l, n;
 	unsigned char lun[MAX_LUN], netfn[16];
+	struct firewall_cache * cache;
 
-	ret = _get_netfn_support(intf, p->channel, lun, netfn);
+	cache = _cache_open(intf, p);
+	if (cache && cache->have_netfn) {
+		memcpy(lun, cache->lun, sizeof(lun));
+		memcpy(netfn, cache->netfn, sizeof(netfn));
+		ret = 0;
+	} else {
+		ret = _get_netfn_support(intf, p->channel, lun, netfn);
+		if (!ret && cache) {
+			memcpy(cache->lun, lun, sizeof(lun));
+			memcpy(cache->netfn, netfn, sizeof(netfn));
+			cache->have_netfn = 1;
+			cache->dirty = 1;
+		}
+	}
 	if (!ret) {
 		for (l=0; l<MAX_LUN; l++) {
 			if (p->lun >= 0 && p->lun != l)
@@ -834,16 +1148,15 @@ static int _gather_info(struct ipmi_intf * intf, struct ipmi_function_params * p
 		if (!((p->lun < 0 || bmc->lun[p->lun].support) &&
 		      (p->netfn < 0 || bmc->lun[p->lun].netfn[p->netfn>>1].support))) {
 			lprintf(LOG_ERR, "LUN or LUN/NetFn pair %d,%d not supported", p->lun, p->netfn);
+			_cache_close(cache);
 			return 0;
 		}
-		ret = _get_command_support(intf, p, &(bmc->lun[p->lun].netfn[p->netfn>>1]));
-		ret |= _get_command_configurable(intf, p, &(bmc->lun[p->lun].netfn[p->netfn>>1]));
+		ret = _get_command_caps(intf, p, &(bmc->lun[p->lun].netfn[p->netfn>>1]), cache);
 		ret |= _get_command_enables(intf, p, &(bmc->lun[p->lun].netfn[p->netfn>>1]));
 		if (!ret && p->command >= 0) {
-			ret = _get_subfn_support(intf, p,
-						 &(bmc->lun[p->lun].netfn[p->netfn>>1].command[p->command]));
-			ret |= _get_subfn_configurable(intf, p,
-						       &(bmc->lun[p->lun].netfn[p->netfn>>1].command[p->command]));
+			ret = _get_subfn_caps(intf, p,
+					      &(bmc->lun[p->lun].netfn[p->netfn>>1].command[p->command]),
+					      cache);
 			ret |= _get_subfn_enables(intf, p,
 						  &(bmc->lun[p->lun].netfn[p->netfn>>1].command[p->command]));
 		}
@@ -854,8 +1167,7 @@ static int _gather_info(struct ipmi_intf * intf, struct ipmi_function_params * p
 			for (n=0; n<MAX_NETFN_PAIR; n++) {
 				p->netfn = n*2;
 				if (bmc->lun[l].netfn[n].support) {
-					ret = _get_command_support(intf, p, &(bmc->lun[l].netfn[n]));
-					ret |= _get_command_configurable(intf, p, &(bmc->lun[l].netfn[n]));
+					ret = _get_command_caps(intf, p, &(bmc->lun[l].netfn[n]), cache);
 					ret |= _get_command_enables(intf, p, &(bmc->lun[l].netfn[n]));
 				}
 				if (ret)
@@ -870,8 +1182,7 @@ static int _gather_info(struct ipmi_intf * intf, struct ipmi_function_params * p
 				for (n=0; n<MAX_NETFN_PAIR; n++) {
 					p->netfn = n*2;
 					if (bmc->lun[l].netfn[n].support) {
-						ret = _get_command_support(intf, p, &(bmc->lun[l].netfn[n]));
-						ret |= _get_command_configurable(intf, p, &(bmc->lun[l].netfn[n]));
+						ret = _get_command_caps(intf, p, &(bmc->lun[l].netfn[n]), cache);
 						ret |= _get_command_enables(intf, p, &(bmc->lun[l].netfn[n]));
 					}
 					if (ret)
@@ -883,6 +1194,7 @@ static int _gather_info(struct ipmi_intf * intf, struct ipmi_function_params * p
 		p->netfn = -1;
 	}
 
+	_cache_close(cache);
 	return 0;
 }
 
@@ -899,7 +1211,7 @@ static int
 ipmi_firewall_info(struct ipmi_intf * intf, int argc, char ** argv)
 {
 	int ret = 0;
-	struct ipmi_function_params p = {0xe, -1, -1, -1, -1, 0};
+	struct ipmi_function_params p = {0xe, -1, -1, -1, -1, 0, 0};
 	struct bmc_fn_support * bmc_fn_support;
 	unsigned int l, n, c;
 
@@ -909,7 +1221,7 @@ ipmi_firewall_info(struct ipmi_intf * intf, int argc, char ** argv)
 		return 0;
 	}
 
-	bmc_fn_support = malloc(sizeof(struct bmc_fn_support));
+	bmc_fn_support = calloc(1, sizeof(struct bmc_fn_support));
 	if (!bmc_fn_support) {
 		lprintf(LOG_ERR, "malloc struct bmc_fn_support failed");
 		return -1;
@@ -1012,7 +1324,7 @@ ipmi_firewall_info(struct ipmi_intf * intf, int argc, char ** argv)
 static int
 ipmi_firewall_enable_disable(struct ipmi_intf * intf, int enable, int argc, char ** argv)
 {
-	struct ipmi_function_params p = {0xe, -1, -1, -1, -1, 0};
+	struct ipmi_function_params p = {0xe, -1, -1, -1, -1, 0, 0};
 	struct bmc_fn_support * bmc_fn_support;
 	int ret;
 	unsigned int l, n, c;
@@ -1037,7 +1349,7 @@ ipmi_firewall_enable_disable(struct ipmi_intf * intf, int enable, int argc, char
 	if (ipmi_firewall_parse_args(argc, argv, &p) < 0)
 		return -1;
 
-	bmc_fn_support = malloc(sizeof(struct bmc_fn_support));
+	bmc_fn_support = calloc(1, sizeof(struct bmc_fn_support));
 	if (!bmc_fn_support) {
 		lprintf(LOG_ERR, "malloc struct bmc_fn_support failed");
 		return -1;
@@ -1103,7 +1415,7 @@ ipmi_firewall_enable_disable(struct ipmi_intf * intf, int enable, int argc, char
 static int
 ipmi_firewall_reset(struct ipmi_intf * intf, int argc, char ** argv)
 {
-	struct ipmi_function_params p = {0xe, -1, -1, -1, -1, 0};
+	struct ipmi_function_params p = {0xe, -1, -1, -1, -1, 0, 0};
 	struct bmc_fn_support * bmc_fn_support;
 	int ret;
 	unsigned int l, n, c;
@@ -1120,7 +1432,7 @@ ipmi_firewall_reset(struct ipmi_intf * intf, int argc, char ** argv)
 	if (ipmi_firewall_parse_args(argc, argv, &p) < 0)
 		return -1;
 
-	bmc_fn_support = malloc(sizeof(struct bmc_fn_support));
+	bmc_fn_support = calloc(1, sizeof(struct bmc_fn_support));
 	if (!bmc_fn_support) {
 		lprintf(LOG_ERR, "malloc struct bmc_fn_support failed");
 		return -1;
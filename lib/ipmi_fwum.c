@@ -43,9 +43,15 @@
 #include <ipmitool/ipmi.h>
 #include <ipmitool/ipmi_fwum.h>
 #include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_kontronoem.h>
 #include <ipmitool/ipmi_mc.h>
 
 extern int verbose;
+
+/* From src/plugins/ipmi_intf.c: */
+void
+ipmi_intf_set_max_request_data_size(struct ipmi_intf * intf, uint16_t size);
+
 unsigned char firmBuf[1024*512];
 tKFWUM_SaveFirmwareInfo save_fw_nfo;
 
@@ -73,6 +79,9 @@ int KfwumFinishFirmwareImage(struct ipmi_intf *intf,
 int KfwumUploadFirmware(struct ipmi_intf *intf,
 		unsigned char *pBuffer, unsigned long totalSize);
 int KfwumStartFirmwareUpgrade(struct ipmi_intf *intf);
+int KfwumNegotiateBuffer(struct ipmi_intf *intf, tKFWUM_BoardInfo boardInfo);
+int KfwumWaitReady(struct ipmi_intf *intf);
+void KfwumBackoff(unsigned long *pDelay);
 int KfwumGetInfoFromFirmware(unsigned char *pBuf,
 		unsigned long bufSize, tKFWUM_InFirmwareInfo *pInfo);
 void KfwumFixTableVersionForOldFirmware(tKFWUM_InFirmwareInfo *pInfo);
@@ -258,6 +267,11 @@ ipmi_fwum_fwupgrade(struct ipmi_intf *intf, char *file, int action)
 	unsigned short padding;
 	unsigned long fsize = 0;
 	unsigned char not_used;
+	uint64_t start = ipmi_time_usec();
+	uint64_t upload;
+	uint16_t max_rq = intf->max_request_data_size;
+	int large;
+	int rc;
 	if (!file) {
 		lprintf(LOG_ERR, "No file given.");
 		return (-1);
@@ -283,7 +297,16 @@ ipmi_fwum_fwupgrade(struct ipmi_intf *intf, char *file, int action)
 	if (KfwumStartFirmwareImage(intf, fsize, padding) != 0) {
 		return (-1);
 	}
-	if (KfwumUploadFirmware(intf, firmBuf, fsize) != 0) {
+	large = KfwumNegotiateBuffer(intf, b_info);
+	upload = ipmi_time_usec();
+	rc = KfwumUploadFirmware(intf, firmBuf, fsize);
+	upload = ipmi_time_usec() - upload;
+	if (large) {
+		/* Restore defaults, max_rq may be 0 (interface default) */
+		ipmi_kontronoem_try_large_buffer(intf, 0);
+		intf->max_request_data_size = max_rq;
+	}
+	if (rc != 0) {
 		return (-1);
 	}
 	if (KfwumFinishFirmwareImage(intf, fw_info) != 0) {
@@ -297,6 +320,11 @@ ipmi_fwum_fwupgrade(struct ipmi_intf *intf, char *file, int action)
 			return (-1);
 		}
 	}
+	printf("Upload time                : %.1f s (%.1f KB/s)\n",
+			upload / 1000000.0,
+			upload ? fsize * 1000000.0 / upload / 1024 : 0);
+	printf("Total time                 : %.1f s\n",
+			(ipmi_time_usec() - start) / 1000000.0);
 	return 0;
 }
 
@@ -319,6 +347,11 @@ KfwumGetFileSize(const char *pFileName, unsigned long *pFileSize)
 		*pFileSize = ftell(pFileHandle);
 	}
 	fclose(pFileHandle);
+	if (*pFileSize > sizeof(firmBuf)) {
+		lprintf(LOG_ERR, "Firmware file '%s' is larger than %lu bytes.",
+				pFileName, (unsigned long)sizeof(firmBuf));
+		return (-1);
+	}
 	if (*pFileSize != 0) {
 		return 0;
 	}
@@ -719,8 +752,92 @@ KfwumStartFirmwareImage(struct ipmi_intf *intf, unsigned long length,
 	}
 	pResp = (struct KfwumStartFirmwareDownloadResp *)rsp->data;
 	printf("Bank holding new firmware  : %d\n", pResp->bank);
-	sleep(5);
-	return 0;
+	return KfwumWaitReady(intf);
+}
+
+/* KfwumBackoff  -  sleep, then double the delay for the next attempt
+ *
+ * pDelay: current delay in usec, 0 starts at KFWUM_BACKOFF_MIN
+ */
+void
+KfwumBackoff(unsigned long *pDelay)
+{
+	if (*pDelay < KFWUM_BACKOFF_MIN) {
+		*pDelay = KFWUM_BACKOFF_MIN;
+	}
+	usleep(*pDelay);
+	*pDelay *= 2;
+	if (*pDelay > KFWUM_BACKOFF_MAX) {
+		*pDelay = KFWUM_BACKOFF_MAX;
+	}
+}
+
+/* KfwumWaitReady  -  wait for the IPMC to answer FWUM commands again
+ *
+ * The IPMC prepares the bank after Start Firmware Image; poll Get
+ * Firmware Info with exponential backoff until it is answered.
+ *
+ * returns 0 on success, otherwise (-1)
+ */
+int
+KfwumWaitReady(struct ipmi_intf *intf)
+{
+	struct ipmi_rs *rsp;
+	struct ipmi_rq req;
+	unsigned long delay = 0;
+	uint64_t start = ipmi_time_usec();
+
+	memset(&req, 0, sizeof(req));
+	req.msg.netfn = IPMI_NETFN_FIRMWARE;
+	req.msg.cmd = KFWUM_CMD_ID_GET_FIRMWARE_INFO;
+	req.msg.data_len = 0;
+
+	for (;;) {
+		KfwumBackoff(&delay);
+		rsp = intf->sendrecv(intf, &req);
+		if (rsp && !rsp->ccode) {
+			return 0;
+		}
+		if (rsp && rsp->ccode != 0xc0) {
+			lprintf(LOG_ERR, "FWUM Firmware Get Info returned %x",
+					rsp->ccode);
+			return (-1);
+		}
+		if (ipmi_time_usec() - start > KFWUM_BUSY_TIMEOUT) {
+			lprintf(LOG_ERR, "Timeout waiting for the IPMC.");
+			return (-1);
+		}
+	}
+}
+
+/* KfwumNegotiateBuffer  -  switch a Kontron IPMC to a large channel buffer
+ *
+ * Only the sequence download type carries larger payloads. When the
+ * IPMC accepts Set Channel Buffer Length, Save Firmware Image requests
+ * use KFWUM_LARGE_BUFFER; otherwise the buffer size is left unchanged.
+ *
+ * returns 1 when the large buffer was set (and must be restored)
+ */
+int
+KfwumNegotiateBuffer(struct ipmi_intf *intf, tKFWUM_BoardInfo boardInfo)
+{
+	if (save_fw_nfo.downloadType != KFWUM_DOWNLOAD_TYPE_SEQUENCE
+			|| boardInfo.iana != IPMI_OEM_KONTRON
+			|| save_fw_nfo.bufferSize >= KFWUM_LARGE_BUFFER) {
+		return 0;
+	}
+	if (ipmi_kontronoem_try_large_buffer(intf, KFWUM_LARGE_BUFFER) != 0) {
+		lprintf(LOG_INFO, "Large buffer not available, using %d bytes",
+				save_fw_nfo.bufferSize);
+		return 0;
+	}
+	ipmi_intf_set_max_request_data_size(intf, KFWUM_LARGE_BUFFER);
+	save_fw_nfo.bufferSize = KFWUM_LARGE_BUFFER;
+	if (verbose) {
+		printf("Large buffer payload size  : %d\n",
+				save_fw_nfo.bufferSize);
+	}
+	return 1;
 }
 
 int
@@ -735,6 +852,8 @@ KfwumSaveFirmwareImage(struct ipmi_intf *intf, unsigned char sequenceNumber,
 	struct KfwumSaveFirmwareSequenceReq seq_req;
 	int retry = 0;
 	int no_rsp = 0;
+	unsigned long delay = 0;
+	uint64_t busy = 0;
 	do {
 		memset(&req, 0, sizeof(req));
 		req.msg.netfn = IPMI_NETFN_FIRMWARE;
@@ -774,7 +893,15 @@ KfwumSaveFirmwareImage(struct ipmi_intf *intf, unsigned char sequenceNumber,
 			} /* For other interface keep trying */
 		} else if (rsp->ccode) {
 			if (rsp->ccode == 0xc0) {
-				sleep(1);
+				if (!busy) {
+					busy = ipmi_time_usec();
+				} else if (ipmi_time_usec() - busy > KFWUM_BUSY_TIMEOUT) {
+					lprintf(LOG_ERR,
+							"FWUM Firmware Save Firmware Image: IPMC busy for too long");
+					rc = (-1);
+					break;
+				}
+				KfwumBackoff(&delay);
 			} else if ((rsp->ccode == 0xc7)
 					|| ((rsp->ccode == 0xc3)
 						&& (sequenceNumber == 0))) {
@@ -821,6 +948,8 @@ KfwumFinishFirmwareImage(struct ipmi_intf *intf, tKFWUM_InFirmwareInfo firmInfo)
 	struct ipmi_rs *rsp;
 	struct ipmi_rq req;
 	struct KfwumFinishFirmwareDownloadReq thisReq;
+	unsigned long delay = 0;
+	uint64_t start;
 
 	thisReq.versionMaj = firmInfo.versMajor;
 	thisReq.versionMinSub = ((firmInfo.versMinor <<4)
@@ -833,10 +962,20 @@ KfwumFinishFirmwareImage(struct ipmi_intf *intf, tKFWUM_InFirmwareInfo firmInfo)
 	req.msg.cmd = KFWUM_CMD_ID_FINISH_FIRMWARE_IMAGE;
 	req.msg.data = (unsigned char *)&thisReq;
 	req.msg.data_len = 4;
-	/* Infinite loop if BMC doesn't reply or replies 0xc0 every time. */
-	do {
+	/* Poll with backoff while the BMC doesn't reply or replies 0xc0. */
+	start = ipmi_time_usec();
+	for (;;) {
 		rsp = intf->sendrecv(intf, &req);
-	} while (!rsp || rsp->ccode == 0xc0);
+		if (rsp && rsp->ccode != 0xc0) {
+			break;
+		}
+		if (ipmi_time_usec() - start > KFWUM_BUSY_TIMEOUT) {
+			lprintf(LOG_ERR,
+					"Timeout in FWUM Firmware Finish Firmware Image Download Command.");
+			return (-1);
+		}
+		KfwumBackoff(&delay);
+	}
 
 	if (rsp->ccode) {
 		lprintf(LOG_ERR,
@@ -34,7 +34,9 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <time.h>
 
@@ -49,6 +51,7 @@
 #include <ipmitool/ipmi_constants.h>
 #include <ipmitool/ipmi_strings.h>
 #include <ipmitool/ipmi_raw.h>
+#include <ipmitool/helper.h>
 
 #if HAVE_CONFIG_H
 # include <config.h>
@@ -58,7 +61,10 @@ extern int verbose;
 
 
 #define GENDEV_RETRY_COUNT    5
-#define GENDEV_MAX_SIZE       16
+#define GENDEV_MAX_SIZE       64       /* Master Write-Read data limit */
+#define GENDEV_MWR_OVERHEAD   3        /* bus id, slave address, read count */
+#define GENDEV_BACKOFF_MIN    10000    /* usec, about one eeprom write cycle */
+#define GENDEV_BACKOFF_MAX    1000000  /* usec */
 
 typedef struct gendev_eeprom_info
 {
@@ -68,6 +74,18 @@ typedef struct gendev_eeprom_info
    uint8_t  address_length;
 }t_gendev_eeprom_info;
 
+typedef struct gendev_xfer
+{
+   struct ipmi_intf *intf;
+   t_gendev_eeprom_info *info;
+   uint8_t  i2cbus;
+   uint8_t  i2caddr;
+   uint32_t span_size;
+   int      rd_size;
+   int      wr_size;
+   uint32_t requests;
+}t_gendev_xfer;
+
 
 static int
 ipmi_gendev_get_eeprom_size(
@@ -179,173 +197,387 @@ ipmi_gendev_get_eeprom_size(
 
 
 
+/* ipmi_gendev_xfer_init  -  Setup block transfer parameters
+ *
+ * Transfers are sized from the interface payload limits rather than a
+ * fixed chunk: reads may cross EEPROM pages and are only bounded by the
+ * Master Write-Read response, writes are bounded by the request size
+ * and must not cross a page boundary.
+ *
+ * @intf:	ipmi interface
+ * @dev:	generic device locator
+ * @info:	eeprom geometry
+ * @xfer:	transfer context to fill in
+ *
+ * returns 0 on success
+ * returns -1 on error
+ */
 static int
-ipmi_gendev_read_file(
-                        struct ipmi_intf *intf, 
-                        struct sdr_record_generic_locator *dev, 
-                        const char *ofile
+ipmi_gendev_xfer_init(
+                        struct ipmi_intf *intf,
+                        struct sdr_record_generic_locator *dev,
+                        t_gendev_eeprom_info *info,
+                        t_gendev_xfer *xfer
                      )
 {
-   int rc = 0;
-   int eeprom_size;
-   t_gendev_eeprom_info eeprom_info;
+   int max_rq = ipmi_intf_get_max_request_data_size(intf);
+   int max_rs = ipmi_intf_get_max_response_data_size(intf) - 1;
+   int wr_size;
+
+   memset(xfer, 0, sizeof(*xfer));
+   xfer->intf = intf;
+   xfer->info = info;
+
+   /* Setup i2c bus byte: channel, bus id, private bus */
+   xfer->i2cbus = ((dev->channel_num & 0xF) << 4)
+                | ((dev->bus & 7) << 1)
+                | 1;
+   xfer->i2caddr = dev->dev_slave_addr;
+
+   /* Handle Address Span */
+   if (info->address_span != 0)
+   {
+      xfer->span_size = info->size / (info->address_span + 1);
+   }
+   else
+   {
+      xfer->span_size = info->size;
+   }
 
-   eeprom_size = ipmi_gendev_get_eeprom_size(dev, &eeprom_info);
+   xfer->rd_size = __min(max_rs, GENDEV_MAX_SIZE);
 
-   if(eeprom_size > 0)
+   wr_size = max_rq - GENDEV_MWR_OVERHEAD - info->address_length;
+   wr_size = __min(wr_size, GENDEV_MAX_SIZE - info->address_length);
+   wr_size = __min(wr_size, info->page_size);
+   xfer->wr_size = wr_size;
+
+   if (xfer->rd_size <= 0 || xfer->wr_size <= 0 || !xfer->span_size)
    {
-      FILE *fp;
-   
-      /* now write to file */
-      fp = ipmi_open_file_write(ofile);
+      lprintf(LOG_ERR, "Interface payload too small for eeprom access");
+      return -1;
+   }
 
-      if(fp)
+   lprintf(LOG_DEBUG, "Gendev transfer: read %d, write %d, span %u bytes",
+           xfer->rd_size, xfer->wr_size, xfer->span_size);
+
+   return 0;
+}
+
+
+/* ipmi_gendev_xfer_len  -  Length of the next transfer at an offset
+ *
+ * Never crosses an address span (a different slave address) nor the
+ * end of the device; writes additionally stop at the page boundary.
+ *
+ * @xfer:	transfer context
+ * @offset:	eeprom offset
+ * @write:	non-zero for a write transfer
+ *
+ * returns number of bytes to transfer
+ */
+static uint32_t
+ipmi_gendev_xfer_len(t_gendev_xfer *xfer, uint32_t offset, int write)
+{
+   uint32_t len = write ? xfer->wr_size : xfer->rd_size;
+
+   len = __min(len, xfer->span_size - (offset % xfer->span_size));
+   len = __min(len, xfer->info->size - offset);
+   if (write)
+   {
+      uint16_t page = xfer->info->page_size;
+      len = __min(len, page - (offset % page));
+   }
+
+   return len;
+}
+
+
+/* ipmi_gendev_xfer  -  Perform one eeprom read or write transfer
+ *
+ * Failed transfers are retried with an exponential back off. This also
+ * covers the internal write cycle of the eeprom, during which the device
+ * does not acknowledge its address.
+ *
+ * @xfer:	transfer context
+ * @offset:	eeprom offset
+ * @wdata:	data to write, NULL for a read
+ * @rdata:	read buffer, NULL for a write
+ * @len:	number of bytes to transfer
+ *
+ * returns 0 on success
+ * returns -1 on error
+ */
+static int
+ipmi_gendev_xfer(
+                  t_gendev_xfer *xfer,
+                  uint32_t offset,
+                  const uint8_t *wdata,
+                  uint8_t *rdata,
+                  uint32_t len
+                )
+{
+   uint8_t wrByte[GENDEV_MAX_SIZE];
+   uint8_t alen = xfer->info->address_length;
+   uint32_t addr = offset % xfer->span_size;
+   uint8_t i2caddr = xfer->i2caddr + (offset / xfer->span_size) * 2;
+   uint32_t backoff = GENDEV_BACKOFF_MIN;
+   uint8_t retryCounter;
+
+   wrByte[0] = (uint8_t) (addr >> 0);
+   if (alen > 1)
+   {
+      wrByte[1] = (uint8_t) (addr >> 8);
+   }
+   if (wdata)
+   {
+      memcpy(&wrByte[alen], wdata, len);
+   }
+
+   for (retryCounter = 0; retryCounter < GENDEV_RETRY_COUNT; retryCounter++)
+   {
+      struct ipmi_rs *rsp;
+
+      if (retryCounter)
       {
-         struct ipmi_rs *rsp;
-         int numWrite;
-         uint32_t counter;
-         uint8_t msize;
-         uint8_t channel = dev->channel_num;
-         uint8_t i2cbus = dev->bus;
-         uint8_t i2caddr = dev->dev_slave_addr;
-         uint8_t privatebus = 1;
-         uint32_t address_span_size;
-         uint8_t percentCompleted = 0;
-
-
-         /* Handle Address Span */
-         if( eeprom_info.address_span != 0)
-         {
-            address_span_size = 
-               (eeprom_info.size / (eeprom_info.address_span+1));
-         }
-         else
-         {
-            address_span_size = eeprom_info.size;
-         }
+         lprintf(LOG_INFO, "Retry at offset 0x%x", offset);
+         usleep(backoff);
+         backoff = __min(backoff * 2, GENDEV_BACKOFF_MAX);
+      }
 
-         /* Setup read/write size */
-         if( eeprom_info.page_size < GENDEV_MAX_SIZE)
-         {
-            msize = eeprom_info.page_size;
-         }
-         else
+      xfer->requests++;
+      rsp = ipmi_master_write_read(
+                  xfer->intf,
+                  xfer->i2cbus,
+                  i2caddr,
+                  wrByte,
+                  alen + (wdata ? len : 0),
+                  wdata ? 0 : len
+                  );
+      if (!rsp)
+      {
+         continue;
+      }
+      if (rdata)
+      {
+         if (rsp->data_len < (int)len)
          {
-            msize = GENDEV_MAX_SIZE;  
-               // All eeprom with page higher than 32 is on the 
-               // 16 bytes boundary
+            lprintf(LOG_INFO, "Short read at offset 0x%x", offset);
+            continue;
          }
+         memcpy(rdata, rsp->data, len);
+      }
+      return 0;
+   }
 
-         /* Setup i2c bus byte */
-         i2cbus = ((channel & 0xF) << 4) | ((i2cbus & 7) << 1) | privatebus;
+   lprintf(LOG_ERR, "Unable to perform I2C Master Write-Read at offset 0x%x",
+           offset);
+   return -1;
+}
 
-/*   
-         lprintf(LOG_ERR, "Generic device: %s", dev->id_string);
-         lprintf(LOG_ERR, "I2C Chnl: %x", channel);
-         lprintf(LOG_ERR, "I2C Bus : %x", i2cbus);
-         lprintf(LOG_ERR, "I2C Addr: %x", i2caddr);    */
 
-         for (
-               counter = 0; 
-               (counter < (eeprom_info.size)) && (rc == 0); 
-               counter+= msize
-             ) 
-         {
-            uint8_t retryCounter;
+/* ipmi_gendev_progress  -  Print percent completed
+ *
+ * @offset:	bytes done
+ * @size:	total bytes
+ */
+static void
+ipmi_gendev_progress(uint32_t offset, uint32_t size)
+{
+   static uint8_t previousCompleted = 101;
+   uint8_t percentCompleted = (uint8_t) (((uint64_t)offset * 100) / size);
 
-            for(
-                  retryCounter = 0; 
-                  retryCounter<GENDEV_RETRY_COUNT; 
-                  retryCounter ++
-               )
-            {
-               uint8_t wrByte[GENDEV_MAX_SIZE+2];
-
-               wrByte[0] =  (uint8_t) (counter>>0);
-               if(eeprom_info.address_length > 1)
-               {
-                  wrByte[1] =  (uint8_t) (counter>>8);
-               }
-            
-               i2caddr+= (((eeprom_info.size) % address_span_size) * 2);
-                                           
-               rsp = ipmi_master_write_read(
-                           intf,
-                           i2cbus,
-                           i2caddr,
-                           (uint8_t *) wrByte,
-                           eeprom_info.address_length,
-                           msize
-                           );
-
-               if (rsp) {
-                  retryCounter = GENDEV_RETRY_COUNT;
-                  rc = 0;
-               }
-               else if(retryCounter < GENDEV_RETRY_COUNT)
-               {
-                  retryCounter ++;
-                  lprintf(LOG_ERR, "Retry");
-                  sleep(1);
-                  rc = -1;
-               }
-               else
-               {
-                  lprintf(LOG_ERR, "Unable to perform I2C Master Write-Read");
-                  rc = -1;
-               }
-            }
+   if (percentCompleted != previousCompleted)
+   {
+      printf("\r%i percent completed", percentCompleted);
+      fflush(stdout);
+      previousCompleted = percentCompleted;
+   }
+}
 
-            if( rc == 0 )
-            {
-               static uint8_t previousCompleted = 101;
-               numWrite = fwrite(rsp->data, 1, msize, fp);
-               if (numWrite != msize) 
-               {
-                  lprintf(LOG_ERR, "Error writing file %s", ofile);
-                  rc = -1;
-                  break;
-               }
-
-               percentCompleted = ((counter * 100) / eeprom_info.size );
-               
-               if(percentCompleted != previousCompleted)
-               {
-                  printf("\r%i percent completed", percentCompleted);
-                  previousCompleted = percentCompleted;
-               }
 
+/* ipmi_gendev_read_block  -  Read a range of the eeprom into memory
+ *
+ * @xfer:	transfer context
+ * @offset:	first eeprom offset
+ * @buf:	destination, filled from offset 0
+ * @len:	number of bytes to read
+ * @progress:	non-zero to print percent completed
+ *
+ * returns 0 on success
+ * returns -1 on error
+ */
+static int
+ipmi_gendev_read_block(
+                        t_gendev_xfer *xfer,
+                        uint32_t offset,
+                        uint8_t *buf,
+                        uint32_t len,
+                        int progress
+                      )
+{
+   uint32_t done = 0;
 
-            }
-         }
-         if(counter == (eeprom_info.size))
-         {
-            printf("\r%%100 percent completed\n");
-         }
-         else
-         {
-            printf("\rError: %i percent completed, read not completed \n", percentCompleted);
-         }
+   while (done < len)
+   {
+      uint32_t size = __min(ipmi_gendev_xfer_len(xfer, offset + done, 0),
+                            len - done);
+
+      if (ipmi_gendev_xfer(xfer, offset + done, NULL, buf + done, size))
+      {
+         return -1;
+      }
+      done += size;
+      if (progress)
+      {
+         ipmi_gendev_progress(done, len);
+      }
+   }
+
+   return 0;
+}
+
+
+/* ipmi_gendev_report  -  Print transfer summary
+ *
+ * @xfer:	transfer context
+ * @bytes:	number of bytes moved
+ * @start:	start time in microseconds
+ */
+static void
+ipmi_gendev_report(t_gendev_xfer *xfer, uint32_t bytes, uint64_t start)
+{
+   uint64_t usec = ipmi_time_usec() - start;
+
+   printf("%u bytes in %u requests, %.1f s (%.1f KiB/s)\n",
+          bytes, xfer->requests, usec / 1000000.0,
+          usec ? (bytes * 1000000.0 / usec) / 1024 : 0.0);
+}
+
+
+/* ipmi_gendev_read_file  -  Read generic device eeprom to binary file
+ *
+ * The output file is sized up front and memory-mapped, so transfers are
+ * stored in place; a plain buffer is used if the file cannot be mapped.
+ *
+ * @intf:	ipmi interface
+ * @dev:	generic device to read
+ * @ofile:	output filename
+ *
+ * returns 0 on success
+ * returns -1 on error
+ */
+static int
+ipmi_gendev_read_file(
+                        struct ipmi_intf *intf, 
+                        struct sdr_record_generic_locator *dev, 
+                        const char *ofile
+                     )
+{
+   int rc = -1;
+   t_gendev_eeprom_info eeprom_info;
+   t_gendev_xfer xfer;
+   uint8_t *buf = NULL;
+   int mapped = 0;
+   uint64_t start;
+   FILE *fp;
+
+   if (ipmi_gendev_get_eeprom_size(dev, &eeprom_info) <= 0)
+   {
+      lprintf(LOG_ERR, "The selected generic device is not an eeprom");
+      return -1;
+   }
+
+   if (ipmi_gendev_xfer_init(intf, dev, &eeprom_info, &xfer))
+   {
+      return -1;
+   }
+
+   fp = ipmi_open_file_write(ofile);
+   if (!fp)
+   {
+      return -1;
+   }
 
+   if (ftruncate(fileno(fp), eeprom_info.size) == 0)
+   {
+      buf = mmap(NULL, eeprom_info.size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED, fileno(fp), 0);
+      if (buf == MAP_FAILED)
+      {
+         buf = NULL;
+      }
+      else
+      {
+         mapped = 1;
+      }
+   }
+   if (!buf)
+   {
+      lprintf(LOG_DEBUG, "Unable to map %s, buffering in memory", ofile);
+      buf = malloc(eeprom_info.size);
+      if (!buf)
+      {
+         lprintf(LOG_ERR, "ipmitool: malloc failure");
          fclose(fp);
+         return -1;
       }
    }
+
+   start = ipmi_time_usec();
+   if (ipmi_gendev_read_block(&xfer, 0, buf, eeprom_info.size, 1) == 0)
+   {
+      printf("\r100 percent completed\n");
+      rc = 0;
+   }
    else
    {
-      lprintf(LOG_ERR, "The selected generic device is not an eeprom");
+      printf("\rError: read not completed\n");
+   }
+
+   if (mapped)
+   {
+      if (msync(buf, eeprom_info.size, MS_SYNC) != 0)
+      {
+         lperror(LOG_ERR, "Error writing file %s", ofile);
+         rc = -1;
+      }
+      munmap(buf, eeprom_info.size);
+   }
+   else
+   {
+      if (rc == 0
+          && fwrite(buf, 1, eeprom_info.size, fp) != eeprom_info.size)
+      {
+         lprintf(LOG_ERR, "Error writing file %s", ofile);
+         rc = -1;
+      }
+      free(buf);
+   }
+
+   if (fclose(fp) != 0)
+   {
+      lperror(LOG_ERR, "Error writing file %s", ofile);
+      rc = -1;
+   }
+
+   if (rc == 0)
+   {
+      ipmi_gendev_report(&xfer, eeprom_info.size, start);
    }
 
    return rc;
 }
 
 
-/* ipmi_gendev_write_file  -  Read raw SDR from binary file
+/* ipmi_gendev_write_file  -  Write generic device eeprom from binary file
  *
- * used for writing generic locator device Eeprom type
+ * The current eeprom contents are read first and only the pages that
+ * differ from the file are written. Every written page is read back and
+ * compared.
  *
  * @intf:	ipmi interface
- * @dev:		generic device to read
- * @ofile:	output filename
+ * @dev:	generic device to write
+ * @ofile:	input filename
  *
  * returns 0 on success
  * returns -1 on error
@@ -358,165 +590,150 @@ ipmi_gendev_write_file(
                      )
 {
    int rc = 0;
-   int eeprom_size;
    t_gendev_eeprom_info eeprom_info;
+   t_gendev_xfer xfer;
+   uint8_t *image = NULL;
+   uint8_t *device = NULL;
+   int mapped = 0;
+   uint32_t fileLength;
+   uint32_t counter;
+   uint32_t pages;
+   uint32_t written = 0;
+   uint32_t lastPage = UINT32_MAX;
+   uint64_t start;
+   FILE *fp;
+
+   if (ipmi_gendev_get_eeprom_size(dev, &eeprom_info) <= 0)
+   {
+      lprintf(LOG_ERR, "The selected generic device is not an eeprom");
+      return -1;
+   }
 
-   eeprom_size = ipmi_gendev_get_eeprom_size(dev, &eeprom_info);
+   if (ipmi_gendev_xfer_init(intf, dev, &eeprom_info, &xfer))
+   {
+      return -1;
+   }
 
-   if(eeprom_size > 0)
+   fp = ipmi_open_file_read(ofile);
+   if (!fp)
    {
-      FILE *fp;
-      uint32_t fileLength = 0;
-   
-      /* now write to file */
-      fp = ipmi_open_file_read(ofile);
-      
-      if(fp)
-      {
-         /* Retrieve file length, check if it's fits the Eeprom Size */
-         fseek(fp, 0 ,SEEK_END);
-         fileLength = ftell(fp);
+      return -1;
+   }
 
-         lprintf(LOG_ERR, "File   Size: %i", fileLength);
-         lprintf(LOG_ERR, "Eeprom Size: %i", eeprom_size);
-         if(fileLength != eeprom_size)
-         {
-            lprintf(LOG_ERR, "File size does not fit Eeprom Size");
-            fclose(fp);
-            fp = NULL;
-         }
-         else
-         {
-            fseek(fp, 0 ,SEEK_SET);
-         }
-      }
-      
-      if(fp)
+   /* Retrieve file length, check if it's fits the Eeprom Size */
+   fseek(fp, 0, SEEK_END);
+   fileLength = ftell(fp);
+   fseek(fp, 0, SEEK_SET);
+
+   lprintf(LOG_INFO, "File   Size: %u", fileLength);
+   lprintf(LOG_INFO, "Eeprom Size: %u", eeprom_info.size);
+   if (fileLength != eeprom_info.size)
+   {
+      lprintf(LOG_ERR, "File size does not fit Eeprom Size");
+      fclose(fp);
+      return -1;
+   }
+
+   image = mmap(NULL, fileLength, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+   if (image == MAP_FAILED)
+   {
+      image = malloc(fileLength);
+      if (image && fread(image, 1, fileLength, fp) != fileLength)
       {
-         struct ipmi_rs *rsp;
-         int numRead;
-         uint32_t counter;
-         uint8_t msize;
-         uint8_t channel = dev->channel_num;
-         uint8_t i2cbus = dev->bus;
-         uint8_t i2caddr = dev->dev_slave_addr;
-         uint8_t privatebus = 1;
-         uint32_t address_span_size;
-         uint8_t percentCompleted = 0;
-
-
-         /* Handle Address Span */
-         if( eeprom_info.address_span != 0)
-         {
-            address_span_size = 
-               (eeprom_info.size / (eeprom_info.address_span+1));
-         }
-         else
-         {
-            address_span_size = eeprom_info.size;
-         }
+         lprintf(LOG_ERR, "Error reading file %s", ofile);
+         free(image);
+         fclose(fp);
+         return -1;
+      }
+   }
+   else
+   {
+      mapped = 1;
+   }
+   device = malloc(eeprom_info.size);
+   if (!image || !device)
+   {
+      lprintf(LOG_ERR, "ipmitool: malloc failure");
+      rc = -1;
+      goto out;
+   }
 
-         /* Setup read/write size */
-         if( eeprom_info.page_size < GENDEV_MAX_SIZE)
-         {
-            msize = eeprom_info.page_size;
-         }
-         else
-         {
-            msize = GENDEV_MAX_SIZE;  
-                     // All eeprom with page higher than 32 is on the 
-                     // 16 bytes boundary
-         }
+   start = ipmi_time_usec();
 
-         /* Setup i2c bus byte */
-         i2cbus = ((channel & 0xF) << 4) | ((i2cbus & 7) << 1) | privatebus;
+   /* Verify first, so unchanged pages are not rewritten */
+   printf("Reading current eeprom contents\n");
+   if (ipmi_gendev_read_block(&xfer, 0, device, eeprom_info.size, 1))
+   {
+      printf("\rError: read not completed\n");
+      rc = -1;
+      goto out;
+   }
+   printf("\r100 percent completed\n");
 
-/*   
-         lprintf(LOG_ERR, "Generic device: %s", dev->id_string);
-         lprintf(LOG_ERR, "I2C Chnl: %x", channel);
-         lprintf(LOG_ERR, "I2C Bus : %x", i2cbus);
-         lprintf(LOG_ERR, "I2C Addr: %x", i2caddr);    */
+   printf("Writing changed pages\n");
+   for (counter = 0; counter < eeprom_info.size && rc == 0; )
+   {
+      uint32_t size = ipmi_gendev_xfer_len(&xfer, counter, 1);
+      uint8_t check[GENDEV_MAX_SIZE];
 
-         for (
-               counter = 0; 
-               (counter < (eeprom_info.size)) && (rc == 0); 
-               counter+= msize
-             ) 
+      if (memcmp(&image[counter], &device[counter], size) != 0)
+      {
+         if (ipmi_gendev_xfer(&xfer, counter, &image[counter], NULL, size))
          {
-            uint8_t retryCounter;
-            uint8_t readByte[GENDEV_MAX_SIZE];
-
-            numRead = fread(readByte, 1, msize, fp);
-            if (numRead != msize) 
+            rc = -1;
+         }
+         else
+         {
+            /* Let the internal write cycle finish before reading back */
+            usleep(GENDEV_BACKOFF_MIN);
+            if (ipmi_gendev_read_block(&xfer, counter, check, size, 0))
             {
-               lprintf(LOG_ERR, "Error reading file %s", ofile);
                rc = -1;
-               break;
-            }
-
-            for(
-                  retryCounter = 0; 
-                  retryCounter<GENDEV_RETRY_COUNT; 
-                  retryCounter ++
-               )
-            {
-               uint8_t wrByte[GENDEV_MAX_SIZE+2];
-               wrByte[0] =  (uint8_t) (counter>>0);
-               if(eeprom_info.address_length > 1)
-               {
-                  wrByte[1] =  (uint8_t) (counter>>8);
-               }
-               memcpy(&wrByte[eeprom_info.address_length], readByte, msize);
-
-               i2caddr+= (((eeprom_info.size) % address_span_size) * 2);
-
-               rsp = ipmi_master_write_read(intf, i2cbus, i2caddr, (uint8_t *) wrByte, eeprom_info.address_length+msize, 0);
-               if (rsp) {
-                  retryCounter = GENDEV_RETRY_COUNT;
-                  rc = 0;
-               }
-               else if(retryCounter < GENDEV_RETRY_COUNT)
-               {
-                  retryCounter ++;
-                  lprintf(LOG_ERR, "Retry");
-                  sleep(1);
-                  rc = -1;
-               }
-               else
-               {
-                  lprintf(LOG_ERR, "Unable to perform I2C Master Write-Read");
-                  rc = -1;
-               }
-            }
-
-            if (!rc) {
-               static uint8_t previousCompleted = 101;
-               percentCompleted = ((counter * 100) / eeprom_info.size );
-
-               if(percentCompleted != previousCompleted)
-               {
-                  printf("\r%i percent completed", percentCompleted);
-                  previousCompleted = percentCompleted;
-               }
-
             }
          }
-         if(counter == (eeprom_info.size))
+         if (rc == 0 && memcmp(&image[counter], check, size) != 0)
          {
-            printf("\r%%100 percent completed\n");
+            lprintf(LOG_ERR, "Verify failed at offset 0x%x", counter);
+            rc = -1;
          }
-         else
+         if (counter / eeprom_info.page_size != lastPage)
          {
-            printf("\rError: %i percent completed, read not completed \n", percentCompleted);
+            lastPage = counter / eeprom_info.page_size;
+            written++;
          }
+      }
 
-         fclose(fp);
+      if (rc == 0)
+      {
+         counter += size;
+         ipmi_gendev_progress(counter, eeprom_info.size);
       }
    }
+
+   if (rc == 0)
+   {
+      printf("\r100 percent completed\n");
+      pages = (eeprom_info.size + eeprom_info.page_size - 1)
+            / eeprom_info.page_size;
+      printf("%u of %u pages written\n", written, pages);
+      ipmi_gendev_report(&xfer, eeprom_info.size, start);
+   }
    else
    {
-      lprintf(LOG_ERR, "The selected generic device is not an eeprom");
+      printf("\rError: write not completed\n");
+   }
+
+out:
+   free(device);
+   if (mapped)
+   {
+      munmap(image, fileLength);
+   }
+   else
+   {
+      free(image);
    }
+   fclose(fp);
 
    return rc;
 }
@@ -576,7 +793,7 @@ ipmi_gendev_main(struct ipmi_intf *intf, int argc, char **argv)
          }
 
          lprintf(LOG_ERR, "Gendev read file name: %s", argv[2]);
-         ipmi_gendev_read_file(intf, sdr->record.genloc, argv[2]);
+         rc = ipmi_gendev_read_file(intf, sdr->record.genloc, argv[2]);
 
       }
    } else if (!strcmp(argv[0], "write")) {
@@ -602,7 +819,7 @@ ipmi_gendev_main(struct ipmi_intf *intf, int argc, char **argv)
          }
 
          lprintf(LOG_ERR, "Gendev write file name: %s", argv[2]);
-         ipmi_gendev_write_file(intf, sdr->record.genloc, argv[2]);
+         rc = ipmi_gendev_write_file(intf, sdr->record.genloc, argv[2]);
       }
    } else {
       lprintf(LOG_ERR, "Invalid gendev command: %s", argv[0]);
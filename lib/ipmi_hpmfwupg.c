@@ -40,9 +40,14 @@
 #include <ipmitool/log.h>
 #include "../src/plugins/lan/md5.h"
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <time.h>
+#include <sys/mman.h>
 #include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #if HAVE_CONFIG_H
@@ -70,6 +75,17 @@ extern int verbose;
 
 VERSIONINFO gVersionInfo[HPMFWUPG_COMPONENT_ID_MAX];
 
+struct HpmfwupgRolloutHost {
+	char *name;
+	pid_t pid;
+	int fd;
+	int rc;
+	uint64_t startUsec;
+	uint64_t prepareUsec;
+	uint64_t upgradeUsec;
+	uint64_t activateUsec;
+};
+
 int HpmfwupgUpgrade(struct ipmi_intf *intf, char *imageFilename,
 		int activate, int, int);
 int HpmfwupgValidateImageIntegrity(struct HpmfwupgUpgradeCtx *pFwupgCtx);
@@ -116,6 +132,28 @@ int HpmfwupgGetDeviceId(struct ipmi_intf *intf,
 		struct ipm_devid_rsp *pGetDevId);
 int HpmfwupgGetBufferFromFile(char *imageFilename,
 		struct HpmfwupgUpgradeCtx *pFwupgCtx);
+void HpmfwupgFreeBuffer(struct HpmfwupgUpgradeCtx *pFwupgCtx);
+int HpmfwupgUpgradeTarget(struct ipmi_intf *intf,
+		struct HpmfwupgUpgradeCtx *pFwupgCtx, char *ckptBase,
+		int activate, int componentMask, int option);
+void HpmfwupgDisplayResult(int rc, int option);
+void HpmfwupgThrottle(uint64_t start, unsigned int sent, unsigned int rate);
+int HpmfwupgRollout(struct ipmi_intf *intf, char *hostFilename,
+		char *imageFilename, int parallel, unsigned int rate,
+		int activate, int componentMask, int option);
+int HpmfwupgRolloutHosts(char *hostFilename,
+		struct HpmfwupgRolloutHost **pHosts);
+void HpmfwupgRolloutChild(struct ipmi_intf *intf,
+		struct HpmfwupgUpgradeCtx *pFwupgCtx, char *imageFilename,
+		char *host, int fd, int activate, int componentMask, int option);
+void HpmfwupgRolloutReport(struct HpmfwupgRolloutHost *host);
+int HpmfwupgCheckpointOpen(char *imageFilename,
+		struct HpmfwupgUpgradeCtx *pFwupgCtx, int option);
+void HpmfwupgCheckpointWrite(struct HpmfwupgUpgradeCtx *pFwupgCtx);
+void HpmfwupgCheckpointClose(struct HpmfwupgUpgradeCtx *pFwupgCtx,
+		int done);
+int HpmfwupgCheckpointResume(struct ipmi_intf *intf,
+		struct HpmfwupgUpgradeCtx *pFwupgCtx);
 int HpmfwupgWaitLongDurationCmd(struct ipmi_intf *intf,
 		struct HpmfwupgUpgradeCtx *pFwupgCtx);
 struct ipmi_rs *HpmfwupgSendCmd(struct ipmi_intf *intf,
@@ -144,7 +182,10 @@ HpmGetUserInput(char *str)
 	int ret;
 
 	printf("%s", str);
-	ret = scanf("%s", userInput);
+	ret = scanf("%1s", userInput);
+	if (ret == EOF) {
+		return 0;
+	}
 	if (!ret) {
 		return 1;
 	}
@@ -497,15 +538,44 @@ HpmfwupgUpgrade(struct ipmi_intf *intf, char *imageFilename, int activate,
 			fflush(stdout);
 		}
 	}
+	if (rc == HPMFWUPG_SUCCESS) {
+		rc = HpmfwupgUpgradeTarget(intf, &fwupgCtx, imageFilename,
+				activate, componentMask, option);
+	} else {
+		HpmfwupgDisplayResult(rc, option);
+	}
+	HpmfwupgFreeBuffer(&fwupgCtx);
+	return rc;
+}
+
+/* HpmfwupgUpgradeTarget - run the preparation, upgrade and activation stages
+ * against one target with an image already loaded and validated in the
+ * context. Upload progress is checkpointed to <ckptBase>.ckpt.
+ */
+int
+HpmfwupgUpgradeTarget(struct ipmi_intf *intf,
+		struct HpmfwupgUpgradeCtx *pFwupgCtx, char *ckptBase,
+		int activate, int componentMask, int option)
+{
+	int rc = HPMFWUPG_SUCCESS;
+	uint64_t stageStart;
+	/* OPEN UPLOAD CHECKPOINT */
+	if (!(option & (VIEW_MODE | COMPARE_MODE))) {
+		HpmfwupgCheckpointOpen(ckptBase, pFwupgCtx, option);
+	}
 	/* PREPARATION STAGE */
+	printf("Performing preparation stage...");
+	fflush(stdout);
+	stageStart = ipmi_time_usec();
+	rc = HpmfwupgPreparationStage(intf, pFwupgCtx, option);
+	pFwupgCtx->prepareUsec = ipmi_time_usec() - stageStart;
 	if (rc == HPMFWUPG_SUCCESS) {
-		printf("Performing preparation stage...");
+		printf("OK\n");
 		fflush(stdout);
-		rc = HpmfwupgPreparationStage(intf, &fwupgCtx, option);
-		if (rc == HPMFWUPG_SUCCESS) {
-			printf("OK\n");
-			fflush(stdout);
-		}
+	}
+	/* RESUME FROM CHECKPOINT */
+	if (rc == HPMFWUPG_SUCCESS && pFwupgCtx->ckpt.valid) {
+		rc = HpmfwupgCheckpointResume(intf, pFwupgCtx);
 	}
 	/* UPGRADE STAGE */
 	if (rc == HPMFWUPG_SUCCESS) {
@@ -518,31 +588,43 @@ HpmfwupgUpgrade(struct ipmi_intf *intf, char *imageFilename, int activate,
 		} else {
 			lprintf(LOG_NOTICE, "\nPerforming upgrade stage:");
 		}
+		stageStart = ipmi_time_usec();
 		if (option & VIEW_MODE) {
-			rc = HpmfwupgPreUpgradeCheck(&fwupgCtx,componentMask, VIEW_MODE);
+			rc = HpmfwupgPreUpgradeCheck(pFwupgCtx,componentMask, VIEW_MODE);
 		} else {
-			rc = HpmfwupgPreUpgradeCheck(&fwupgCtx,
+			rc = HpmfwupgPreUpgradeCheck(pFwupgCtx,
 					componentMask, option);
 			if (rc == HPMFWUPG_SUCCESS) {
 				if (verbose) {
 					printf("Component update mask : 0x%02x\n",
-							fwupgCtx.compUpdateMask.ComponentBits.byte);
+							pFwupgCtx->compUpdateMask.ComponentBits.byte);
 				}
-				rc = HpmfwupgUpgradeStage(intf, &fwupgCtx, option);
+				rc = HpmfwupgUpgradeStage(intf, pFwupgCtx, option);
 			}
 		}
+		pFwupgCtx->upgradeUsec = ipmi_time_usec() - stageStart;
 	}
 	/* ACTIVATION STAGE */
 	if (rc == HPMFWUPG_SUCCESS && activate) {
 		/* check if upgrade components mask is non-zero */
-		if (fwupgCtx.compUpdateMask.ComponentBits.byte) {
+		if (pFwupgCtx->compUpdateMask.ComponentBits.byte) {
 			lprintf(LOG_NOTICE, "Performing activation stage: ");
-			rc = HpmfwupgActivationStage(intf, &fwupgCtx);
+			stageStart = ipmi_time_usec();
+			rc = HpmfwupgActivationStage(intf, pFwupgCtx);
+			pFwupgCtx->activateUsec = ipmi_time_usec() - stageStart;
 		} else {
 			lprintf(LOG_NOTICE,
 					"No components updated. Skipping activation stage.\n");
 		}
 	}
+	HpmfwupgDisplayResult(rc, option);
+	HpmfwupgCheckpointClose(pFwupgCtx, rc == HPMFWUPG_SUCCESS);
+	return rc;
+}
+
+void
+HpmfwupgDisplayResult(int rc, int option)
+{
 	if (rc == HPMFWUPG_SUCCESS) {
 		if (option & VIEW_MODE) {
 		/* Don't display anything here in case we are just viewing it */
@@ -563,10 +645,277 @@ HpmfwupgUpgrade(struct ipmi_intf *intf, char *imageFilename, int activate,
 	} else {
 		lprintf(LOG_NOTICE, "Firmware upgrade procedure failed\n");
 	}
-	if (fwupgCtx.pImageData) {
-		free(fwupgCtx.pImageData);
-		fwupgCtx.pImageData = NULL;
+}
+
+/* HpmfwupgThrottle - sleep until <sent> bytes uploaded since <start> fit
+ * within <rate> bytes per second
+ */
+void
+HpmfwupgThrottle(uint64_t start, unsigned int sent, unsigned int rate)
+{
+	uint64_t due = start + (uint64_t)sent * 1000000 / rate;
+	uint64_t now = ipmi_time_usec();
+	if (due > now) {
+		usleep(due - now);
+	}
+}
+
+/* HpmfwupgRolloutHosts - read the host list of a rollout, one host per line,
+ * blank lines and lines starting with '#' are ignored
+ */
+int
+HpmfwupgRolloutHosts(char *hostFilename, struct HpmfwupgRolloutHost **pHosts)
+{
+	struct HpmfwupgRolloutHost *hosts = NULL;
+	struct HpmfwupgRolloutHost *tmp;
+	char line[256];
+	char *host;
+	int count = 0;
+	FILE *fp;
+
+	fp = ipmi_open_file_read(hostFilename);
+	if (!fp) {
+		return -1;
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		host = strtok(line, " \t\r\n");
+		if (!host || host[0] == '#') {
+			continue;
+		}
+		/* the host names the hpm-<host>.log file of its child */
+		if (strchr(host, '/')) {
+			lprintf(LOG_ERR, "Invalid host name '%s'", host);
+			continue;
+		}
+		tmp = realloc(hosts, (count + 1) * sizeof(*hosts));
+		if (!tmp) {
+			lprintf(LOG_ERR, "ipmitool: malloc failure");
+			break;
+		}
+		hosts = tmp;
+		memset(&hosts[count], 0, sizeof(*hosts));
+		hosts[count].name = strdup(host);
+		hosts[count].fd = -1;
+		if (!hosts[count].name) {
+			lprintf(LOG_ERR, "ipmitool: malloc failure");
+			break;
+		}
+		count++;
+	}
+	fclose(fp);
+	if (!count) {
+		lprintf(LOG_ERR, "No hosts found in '%s'", hostFilename);
+	}
+	*pHosts = hosts;
+	return count;
+}
+
+/* HpmfwupgRolloutChild - upgrade one host of a rollout. Runs in a child
+ * process with its output going to hpm-<host>.log, and reports the result
+ * and stage durations to the parent through <fd>.
+ */
+void
+HpmfwupgRolloutChild(struct ipmi_intf *intf,
+		struct HpmfwupgUpgradeCtx *pFwupgCtx, char *imageFilename,
+		char *host, int fd, int activate, int componentMask, int option)
+{
+	char path[512];
+	int rc = HPMFWUPG_ERROR;
+	int nullFd;
+	int logFd;
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "hpm-%s.log", host);
+	logFd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (logFd >= 0) {
+		dup2(logFd, STDOUT_FILENO);
+		dup2(logFd, STDERR_FILENO);
+		close(logFd);
+	}
+	/* Nobody can answer prompts, they all default to "no" */
+	nullFd = open("/dev/null", O_RDONLY);
+	if (nullFd >= 0) {
+		dup2(nullFd, STDIN_FILENO);
+		close(nullFd);
+	}
+	ipmi_intf_session_set_hostname(intf, host);
+	if (intf->open(intf) < 0) {
+		lprintf(LOG_ERR, "Unable to open a session to %s", host);
+	} else {
+		rc = HpmfwupgTargetCheck(intf, 0);
+		if (rc == HPMFWUPG_SUCCESS) {
+			snprintf(path, sizeof(path), "%s.%s", imageFilename, host);
+			rc = HpmfwupgUpgradeTarget(intf, pFwupgCtx, path, activate,
+					componentMask, option);
+		}
+		intf->close(intf);
+	}
+	fp = fdopen(fd, "w");
+	if (fp) {
+		fprintf(fp, "%d %" PRIu64 " %" PRIu64 " %" PRIu64 "\n", rc,
+				pFwupgCtx->prepareUsec, pFwupgCtx->upgradeUsec,
+				pFwupgCtx->activateUsec);
+		fclose(fp);
+	}
+	fflush(stdout);
+	fflush(stderr);
+	_exit(rc == HPMFWUPG_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+void
+HpmfwupgRolloutReport(struct HpmfwupgRolloutHost *host)
+{
+	printf("%-24s %-7s prepare %7.1f s  upload %7.1f s  activate %7.1f s  total %7.1f s\n",
+			host->name,
+			host->rc == HPMFWUPG_SUCCESS ? "OK" : "FAILED",
+			host->prepareUsec / 1000000.0,
+			host->upgradeUsec / 1000000.0,
+			host->activateUsec / 1000000.0,
+			(ipmi_time_usec() - host->startUsec) / 1000000.0);
+	fflush(stdout);
+}
+
+/* HpmfwupgRollout - upgrade every host of <hostFilename> with the same image.
+ * The image is loaded and validated once, then up to <parallel> hosts are
+ * upgraded at the same time by child processes sharing the mapped image and
+ * the upload bandwidth <rate> (bytes per second, 0 = unlimited).
+ */
+int
+HpmfwupgRollout(struct ipmi_intf *intf, char *hostFilename,
+		char *imageFilename, int parallel, unsigned int rate,
+		int activate, int componentMask, int option)
+{
+	struct HpmfwupgUpgradeCtx fwupgCtx;
+	struct HpmfwupgRolloutHost *hosts = NULL;
+	struct HpmfwupgRolloutHost *host;
+	int rc = HPMFWUPG_SUCCESS;
+	int count, next = 0, running = 0, failed = 0;
+	int fds[2];
+	int status;
+	int i;
+	uint64_t start;
+	FILE *fp;
+	pid_t pid;
+
+	if (!strstr(intf->name, "lan")) {
+		lprintf(LOG_ERR, "hpm rollout requires the lan or lanplus interface");
+		return HPMFWUPG_ERROR;
+	}
+	count = HpmfwupgRolloutHosts(hostFilename, &hosts);
+	if (count <= 0) {
+		free(hosts);
+		return HPMFWUPG_ERROR;
+	}
+	memset(&fwupgCtx, 0, sizeof(fwupgCtx));
+	rc = HpmfwupgGetBufferFromFile(imageFilename, &fwupgCtx);
+	if (rc == HPMFWUPG_SUCCESS) {
+		printf("Validating firmware image integrity...");
+		fflush(stdout);
+		rc = HpmfwupgValidateImageIntegrity(&fwupgCtx);
+		if (rc == HPMFWUPG_SUCCESS) {
+			printf("OK\n");
+		}
+	}
+	if (rc != HPMFWUPG_SUCCESS) {
+		goto out;
+	}
+	if (parallel > count) {
+		parallel = count;
+	}
+	if (rate) {
+		fwupgCtx.rateLimit = __max(rate / parallel, 1);
 	}
+	/* Every host gets its own session from its own process */
+	if (intf->opened && intf->close) {
+		intf->close(intf);
+	}
+	printf("Upgrading %d hosts, %d at a time\n", count, parallel);
+	start = ipmi_time_usec();
+	while (next < count || running) {
+		while (running < parallel && next < count) {
+			host = &hosts[next++];
+			host->startUsec = ipmi_time_usec();
+			host->rc = HPMFWUPG_ERROR;
+			fflush(stdout);
+			fflush(stderr);
+			if (pipe(fds) < 0) {
+				lperror(LOG_ERR, "%s: pipe", host->name);
+				HpmfwupgRolloutReport(host);
+				continue;
+			}
+			pid = fork();
+			if (pid < 0) {
+				lperror(LOG_ERR, "%s: fork", host->name);
+				close(fds[0]);
+				close(fds[1]);
+				HpmfwupgRolloutReport(host);
+				continue;
+			}
+			if (pid == 0) {
+				close(fds[0]);
+				HpmfwupgRolloutChild(intf, &fwupgCtx, imageFilename,
+						host->name, fds[1], activate, componentMask,
+						option);
+			}
+			close(fds[1]);
+			host->pid = pid;
+			host->fd = fds[0];
+			running++;
+		}
+		if (!running) {
+			break;
+		}
+		pid = waitpid(-1, &status, 0);
+		if (pid < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			lperror(LOG_ERR, "waitpid");
+			break;
+		}
+		for (host = NULL, i = 0; i < next; i++) {
+			if (hosts[i].pid == pid && hosts[i].fd >= 0) {
+				host = &hosts[i];
+				break;
+			}
+		}
+		if (!host) {
+			continue;
+		}
+		running--;
+		fp = fdopen(host->fd, "r");
+		if (fp) {
+			if (fscanf(fp, "%d %" SCNu64 " %" SCNu64 " %" SCNu64,
+						&host->rc, &host->prepareUsec,
+						&host->upgradeUsec, &host->activateUsec) != 4) {
+				host->rc = HPMFWUPG_ERROR;
+			}
+			fclose(fp);
+		} else {
+			close(host->fd);
+		}
+		host->fd = -1;
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+			host->rc = HPMFWUPG_ERROR;
+		}
+		HpmfwupgRolloutReport(host);
+	}
+	for (i = 0; i < count; i++) {
+		if (hosts[i].rc != HPMFWUPG_SUCCESS) {
+			failed++;
+		}
+	}
+	printf("%d of %d hosts upgraded in %.1f s, logs in hpm-<host>.log\n",
+			count - failed, count, (ipmi_time_usec() - start) / 1000000.0);
+	if (failed) {
+		rc = HPMFWUPG_ERROR;
+	}
+out:
+	HpmfwupgFreeBuffer(&fwupgCtx);
+	for (i = 0; i < count; i++) {
+		free(hosts[i].name);
+	}
+	free(hosts);
 	return rc;
 }
 
@@ -1013,7 +1362,15 @@ HpmfwupgUpgradeStage(struct ipmi_intf *intf,
 	struct HpmfwupgActionRecord* pActionRecord;
 	int rc = HPMFWUPG_SUCCESS;
 	unsigned char *pImagePtr;
+	unsigned char resumeMask;
 	int flagColdReset = FALSE;
+	/* Components already uploaded, or still being uploaded, before an
+	 * interruption must not be backed up or prepared again
+	 */
+	resumeMask = pFwupgCtx->ckpt.doneMask;
+	if (pFwupgCtx->ckpt.inPlace) {
+		resumeMask |= 1 << pFwupgCtx->ckpt.componentId;
+	}
 	/* Put pointer after image header */
 	pImagePtr = (unsigned char*)
 		(pFwupgCtx->pImageData + sizeof(struct HpmfwupgImageHeader) +
@@ -1041,7 +1398,8 @@ HpmfwupgUpgradeStage(struct ipmi_intf *intf,
 					/* Affect only selected components */
 					initUpgActionCmd.req.componentsMask.ComponentBits.byte =
 						pFwupgCtx->compUpdateMask.ComponentBits.byte &
-						pActionRecord->components.ComponentBits.byte;
+						pActionRecord->components.ComponentBits.byte &
+						~resumeMask;
 					/* Action is prepare components */
 					if (initUpgActionCmd.req.componentsMask.ComponentBits.byte) {
 						initUpgActionCmd.req.upgradeAction  = HPMFWUPG_UPGRADE_ACTION_BACKUP;
@@ -1059,7 +1417,8 @@ HpmfwupgUpgradeStage(struct ipmi_intf *intf,
 					/* Affect only selected components */
 					initUpgActionCmd.req.componentsMask.ComponentBits.byte =
 						pFwupgCtx->compUpdateMask.ComponentBits.byte &
-						pActionRecord->components.ComponentBits.byte;
+						pActionRecord->components.ComponentBits.byte &
+						~resumeMask;
 					if (initUpgActionCmd.req.componentsMask.ComponentBits.byte) {
 						/* Action is prepare components */
 						initUpgActionCmd.req.upgradeAction = HPMFWUPG_UPGRADE_ACTION_PREPARE;
@@ -1112,6 +1471,13 @@ HpmFwupgActionUploadFirmware(struct HpmfwupgComponentBitMask components,
 	unsigned int totalSent = 0;
 	unsigned short bufLength = 0;
 	unsigned short bufLengthIsSet = 0;
+	unsigned short goodLength = 0;
+	unsigned short badLength = 0;
+	unsigned int bufStep;
+	int probe;
+	int resume = FALSE;
+	uint64_t uploadStart;
+	unsigned int resumedSent;
 	unsigned int firmwareLength = 0;
 
 	unsigned int displayFWLength = 0;
@@ -1150,6 +1516,18 @@ HpmFwupgActionUploadFirmware(struct HpmfwupgComponentBitMask components,
 	}
 
 	bufLength = max_rq_size - sizeof(struct HpmfwupgUploadFirmwareBlockReq);
+	badLength = bufLength + 1;
+	/* An oversized request is usually left unanswered on LAN, so only
+	 * shrink there. Other interfaces reject it with C7h/C8h, which allows
+	 * probing back up towards the largest accepted length.
+	 */
+	if (strstr(intf->name, "lan")) {
+		bufStep = 8;
+		probe = FALSE;
+	} else {
+		bufStep = 1;
+		probe = TRUE;
+	}
 
 	/* Get firmware length */
 	firmwareLength =  pFwImage->length[0];
@@ -1174,6 +1552,26 @@ HpmFwupgActionUploadFirmware(struct HpmfwupgComponentBitMask components,
 		}
 		skip = FALSE;
 	}
+	if (!skip && ((1 << componentId) & pFwupgCtx->ckpt.doneMask)) {
+		lprintf(LOG_INFO, "Component %d already uploaded, skipping",
+				componentId);
+		skip = TRUE;
+	}
+	if (!skip && pFwupgCtx->ckpt.inPlace
+			&& pFwupgCtx->ckpt.componentId == componentId) {
+		pFwupgCtx->ckpt.inPlace = FALSE;
+		if (pFwupgCtx->ckpt.sectionLength <= firmwareLength
+				&& pFwupgCtx->ckpt.sectionOffset
+					<= firmwareLength - pFwupgCtx->ckpt.sectionLength
+				&& pFwupgCtx->ckpt.offset >= pFwupgCtx->ckpt.sectionOffset
+				&& pFwupgCtx->ckpt.offset - pFwupgCtx->ckpt.sectionOffset
+					<= pFwupgCtx->ckpt.sectionLength) {
+			resume = TRUE;
+		} else {
+			lprintf(LOG_NOTICE, "Invalid checkpoint for component %d, "
+					"uploading it again", componentId);
+		}
+	}
 	if (!skip) {
 		HpmDisplayUpgrade(0,0,1,0);
 		/* Initialize parameters */
@@ -1192,7 +1590,9 @@ HpmFwupgActionUploadFirmware(struct HpmfwupgComponentBitMask components,
 			/* Action is upgrade */
 			initUpgActionCmd.req.upgradeAction = HPMFWUPG_UPGRADE_ACTION_UPGRADE;
 		}
-		rc = HpmfwupgInitiateUpgradeAction(intf, &initUpgActionCmd, pFwupgCtx);
+		if (!resume) {
+			rc = HpmfwupgInitiateUpgradeAction(intf, &initUpgActionCmd, pFwupgCtx);
+		}
 		if (rc != HPMFWUPG_SUCCESS) {
 			skip = TRUE;
 		}
@@ -1206,7 +1606,19 @@ HpmFwupgActionUploadFirmware(struct HpmfwupgComponentBitMask components,
 		lengthOfBlock = firmwareLength;
 		totalSent = 0x00;
 		displayFWLength= firmwareLength;
+		if (resume) {
+			/* Target is still waiting for the block after the last
+			 * acknowledged one
+			 */
+			pData = pDataInitial + pFwupgCtx->ckpt.offset;
+			pDataTemp = pDataInitial + pFwupgCtx->ckpt.sectionOffset;
+			lengthOfBlock = pFwupgCtx->ckpt.sectionLength;
+			totalSent = pFwupgCtx->ckpt.totalSent;
+			uploadCmd.req->blockNumber = pFwupgCtx->ckpt.blockNumber;
+		}
 		time(&start);
+		uploadStart = ipmi_time_usec();
+		resumedSent = totalSent;
 		while ((pData < (pDataTemp+lengthOfBlock)) && (rc == HPMFWUPG_SUCCESS)) {
 			if ((pData+bufLength) <= (pDataTemp+lengthOfBlock)) {
 				count = bufLength;
@@ -1224,18 +1636,23 @@ HpmFwupgActionUploadFirmware(struct HpmfwupgComponentBitMask components,
 				if (rc == HPMFWUPG_UPLOAD_BLOCK_LENGTH && !bufLengthIsSet) {
 					rc = HPMFWUPG_SUCCESS;
 					/* Retry with a smaller buffer length */
-					if (strstr(intf->name,"lan") && bufLength > 8) {
-						bufLength-= 8;
-						lprintf(LOG_INFO,
-								"Trying reduced buffer length: %d",
-								bufLength);
+					badLength = bufLength;
+					if (goodLength) {
+						/* Probe failed, go back to the last good length */
+						bufLength = goodLength;
+					} else if (bufLength > bufStep) {
+						/* Shrink faster every time the length is rejected */
+						bufLength-= bufStep;
+						bufStep*= 2;
 					} else if (bufLength) {
-						bufLength-= 1;
+						bufLength/= 2;
+					} else {
+						rc = HPMFWUPG_ERROR;
+					}
+					if (rc == HPMFWUPG_SUCCESS) {
 						lprintf(LOG_INFO,
 								"Trying reduced buffer length: %d",
 								bufLength);
-					} else {
-						rc = HPMFWUPG_ERROR;
 					}
 				} else if (rc == HPMFWUPG_UPLOAD_RETRY) {
 					rc = HPMFWUPG_SUCCESS;
@@ -1252,7 +1669,18 @@ HpmFwupgActionUploadFirmware(struct HpmfwupgComponentBitMask components,
 				}
 			} else {
 				/* success, buf length is valid */
-				bufLengthIsSet = 1;
+				if (!bufLengthIsSet) {
+					goodLength = bufLength;
+					if (probe && badLength - goodLength > 1) {
+						/* Try halfway to the smallest rejected length */
+						bufLength = goodLength + (badLength - goodLength) / 2;
+						lprintf(LOG_INFO,
+								"Trying increased buffer length: %d",
+								bufLength);
+					} else {
+						bufLengthIsSet = 1;
+					}
+				}
 				if (imageOffset + blockLength > firmwareLength ||
 						imageOffset + blockLength < blockLength) {
 					/*
@@ -1305,6 +1733,17 @@ HpmFwupgActionUploadFirmware(struct HpmfwupgComponentBitMask components,
 							displayFWLength, (end-start));
 				}
 				uploadCmd.req->blockNumber++;
+				pFwupgCtx->ckpt.componentId = componentId;
+				pFwupgCtx->ckpt.blockNumber = uploadCmd.req->blockNumber;
+				pFwupgCtx->ckpt.offset = pData - pDataInitial;
+				pFwupgCtx->ckpt.sectionOffset = pDataTemp - pDataInitial;
+				pFwupgCtx->ckpt.sectionLength = lengthOfBlock;
+				pFwupgCtx->ckpt.totalSent = totalSent;
+				HpmfwupgCheckpointWrite(pFwupgCtx);
+				if (pFwupgCtx->rateLimit) {
+					HpmfwupgThrottle(uploadStart, totalSent - resumedSent,
+							pFwupgCtx->rateLimit);
+				}
 			}
 		}
 		/* free buffer */
@@ -1333,6 +1772,14 @@ HpmFwupgActionUploadFirmware(struct HpmfwupgComponentBitMask components,
 		rc = HpmfwupgFinishFirmwareUpload(intf, &finishCmd,
 				pFwupgCtx, option);
 		*pImagePtr = pDataInitial + firmwareLength;
+		if (rc == HPMFWUPG_SUCCESS) {
+			pFwupgCtx->ckpt.doneMask |= 1 << componentId;
+			pFwupgCtx->ckpt.offset = 0;
+			pFwupgCtx->ckpt.sectionOffset = 0;
+			pFwupgCtx->ckpt.sectionLength = 0;
+			pFwupgCtx->ckpt.totalSent = 0;
+			HpmfwupgCheckpointWrite(pFwupgCtx);
+		}
 	}
 	return rc;
 }
@@ -1403,26 +1850,39 @@ HpmfwupgGetBufferFromFile(char *imageFilename,
 {
 	int rc = HPMFWUPG_ERROR;
 	int ret = 0;
+	struct stat st;
+	void *pMap;
 	FILE *pImageFile = fopen(imageFilename, "rb");
 	if (!pImageFile) {
 		lprintf(LOG_ERR, "Cannot open image file '%s'",
 				imageFilename);
 		goto ret_no_close;
 	}
-	/* Get the raw data in file */
-	ret = fseek(pImageFile, 0, SEEK_END);
-	if (ret != 0) {
-		lprintf(LOG_ERR, "Failed to seek in the image file '%s'",
+	if (fstat(fileno(pImageFile), &st) != 0) {
+		lprintf(LOG_ERR, "Failed to stat the image file '%s'",
 				imageFilename);
 		goto ret_close;
 	}
-	pFwupgCtx->imageSize  = ftell(pImageFile);
+	pFwupgCtx->imageSize = st.st_size;
+	pFwupgCtx->ckpt.imageMtime = st.st_mtime;
+	/* Map the image instead of reading it all up front. The mapping is
+	 * private, nothing is ever written back to the file.
+	 */
+	pMap = mmap(NULL, pFwupgCtx->imageSize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE, fileno(pImageFile), 0);
+	if (pMap != MAP_FAILED) {
+		pFwupgCtx->pImageData = pMap;
+		pFwupgCtx->imageMapped = TRUE;
+		rc = HPMFWUPG_SUCCESS;
+		goto ret_close;
+	}
+	lprintf(LOG_DEBUG, "Cannot map image file '%s', reading it",
+			imageFilename);
 	pFwupgCtx->pImageData = malloc(sizeof(unsigned char)*pFwupgCtx->imageSize);
 	if (!pFwupgCtx->pImageData) {
 		lprintf(LOG_ERR, "ipmitool: malloc failure");
 		goto ret_close;
 	}
-	rewind(pImageFile);
 	ret = fread(pFwupgCtx->pImageData,
 			sizeof(unsigned char),
 			pFwupgCtx->imageSize,
@@ -1443,6 +1903,155 @@ ret_no_close:
 	return rc;
 }
 
+void
+HpmfwupgFreeBuffer(struct HpmfwupgUpgradeCtx *pFwupgCtx)
+{
+	if (!pFwupgCtx->pImageData) {
+		return;
+	}
+	if (pFwupgCtx->imageMapped) {
+		munmap(pFwupgCtx->pImageData, pFwupgCtx->imageSize);
+	} else {
+		free(pFwupgCtx->pImageData);
+	}
+	pFwupgCtx->pImageData = NULL;
+	pFwupgCtx->imageMapped = FALSE;
+}
+
+/* The checkpoint is a single fixed width line rewritten in place:
+ * image size, image mtime, finished components mask, current component,
+ * next block number, next offset, section offset and length, bytes sent
+ */
+#define HPMFWUPG_CHECKPOINT_FORMAT \
+	"HPMCKPT1 %08x %016llx %02x %02x %02x %08x %08x %08x %08x\n"
+
+int
+HpmfwupgCheckpointOpen(char *imageFilename,
+		struct HpmfwupgUpgradeCtx *pFwupgCtx, int option)
+{
+	struct HpmfwupgCheckpoint *pCkpt = &pFwupgCtx->ckpt;
+	size_t len = strlen(imageFilename) + sizeof(HPMFWUPG_CHECKPOINT_SUFFIX);
+	unsigned long long mtime;
+	unsigned int size, done, comp, block;
+	FILE *fp;
+
+	pCkpt->path = malloc(len);
+	if (!pCkpt->path) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		return HPMFWUPG_ERROR;
+	}
+	snprintf(pCkpt->path, len, "%s%s", imageFilename,
+			HPMFWUPG_CHECKPOINT_SUFFIX);
+	if (option & RESUME_MODE) {
+		fp = fopen(pCkpt->path, "r");
+		if (!fp) {
+			lprintf(LOG_NOTICE, "No checkpoint '%s', "
+					"starting from the beginning", pCkpt->path);
+		} else {
+			if (fscanf(fp, HPMFWUPG_CHECKPOINT_FORMAT, &size, &mtime,
+						&done, &comp, &block, &pCkpt->offset,
+						&pCkpt->sectionOffset, &pCkpt->sectionLength,
+						&pCkpt->totalSent) == 9
+					&& size == pFwupgCtx->imageSize
+					&& mtime == (unsigned long long)pCkpt->imageMtime
+					&& comp < HPMFWUPG_COMPONENT_ID_MAX) {
+				pCkpt->valid = TRUE;
+				pCkpt->doneMask = done;
+				pCkpt->componentId = comp;
+				pCkpt->blockNumber = block;
+			} else {
+				lprintf(LOG_NOTICE, "Checkpoint '%s' does not match "
+						"the image, starting from the beginning",
+						pCkpt->path);
+			}
+			fclose(fp);
+		}
+	}
+	if (!pCkpt->valid) {
+		pCkpt->offset = 0;
+		pCkpt->sectionOffset = 0;
+		pCkpt->sectionLength = 0;
+		pCkpt->totalSent = 0;
+	}
+	pCkpt->fp = fopen(pCkpt->path, "w");
+	if (!pCkpt->fp) {
+		lperror(LOG_WARNING, "Cannot write checkpoint '%s'",
+				pCkpt->path);
+		return HPMFWUPG_ERROR;
+	}
+	HpmfwupgCheckpointWrite(pFwupgCtx);
+	return HPMFWUPG_SUCCESS;
+}
+
+void
+HpmfwupgCheckpointWrite(struct HpmfwupgUpgradeCtx *pFwupgCtx)
+{
+	struct HpmfwupgCheckpoint *pCkpt = &pFwupgCtx->ckpt;
+
+	if (!pCkpt->fp) {
+		return;
+	}
+	rewind(pCkpt->fp);
+	fprintf(pCkpt->fp, HPMFWUPG_CHECKPOINT_FORMAT,
+			pFwupgCtx->imageSize,
+			(unsigned long long)pCkpt->imageMtime,
+			pCkpt->doneMask, pCkpt->componentId, pCkpt->blockNumber,
+			pCkpt->offset, pCkpt->sectionOffset, pCkpt->sectionLength,
+			pCkpt->totalSent);
+	fflush(pCkpt->fp);
+}
+
+void
+HpmfwupgCheckpointClose(struct HpmfwupgUpgradeCtx *pFwupgCtx, int done)
+{
+	struct HpmfwupgCheckpoint *pCkpt = &pFwupgCtx->ckpt;
+
+	if (pCkpt->fp) {
+		fclose(pCkpt->fp);
+		pCkpt->fp = NULL;
+	}
+	if (done && pCkpt->path) {
+		unlink(pCkpt->path);
+	}
+	free_n(&pCkpt->path);
+}
+
+/* HpmfwupgCheckpointResume - decide whether the component that was being
+ * uploaded when the checkpoint was written can continue where it stopped.
+ * That is only possible if the target is still waiting for its next block.
+ */
+int
+HpmfwupgCheckpointResume(struct ipmi_intf *intf,
+		struct HpmfwupgUpgradeCtx *pFwupgCtx)
+{
+	struct HpmfwupgCheckpoint *pCkpt = &pFwupgCtx->ckpt;
+	struct HpmfwupgGetUpgradeStatusCtx upgStatusCmd;
+
+	if (pCkpt->doneMask) {
+		lprintf(LOG_NOTICE, "Resuming, components already uploaded: 0x%02x",
+				pCkpt->doneMask);
+	}
+	if (!pCkpt->totalSent) {
+		return HPMFWUPG_SUCCESS;
+	}
+	if (HpmfwupgGetUpgradeStatus(intf, &upgStatusCmd, pFwupgCtx, 1)
+				== HPMFWUPG_SUCCESS
+			&& upgStatusCmd.resp.cmdInProcess == HPMFWUPG_UPLOAD_FIRMWARE_BLOCK
+			&& upgStatusCmd.resp.lastCmdCompCode == 0x00) {
+		lprintf(LOG_NOTICE, "Resuming component %d at offset 0x%x",
+				pCkpt->componentId, pCkpt->offset);
+		pCkpt->inPlace = TRUE;
+	} else {
+		lprintf(LOG_NOTICE, "Target is no longer receiving component %d, "
+				"uploading it again", pCkpt->componentId);
+		pCkpt->offset = 0;
+		pCkpt->sectionOffset = 0;
+		pCkpt->sectionLength = 0;
+		pCkpt->totalSent = 0;
+	}
+	return HPMFWUPG_SUCCESS;
+}
+
 int
 HpmfwupgGetDeviceId(struct ipmi_intf *intf, struct ipm_devid_rsp *pGetDevId)
 {
@@ -2148,6 +2757,7 @@ HpmfwupgSendCmd(struct ipmi_intf *intf, struct ipmi_rq req,
 	unsigned int inaccessTimeout = 0, inaccessTimeoutCounter = 0;
 	unsigned int upgradeTimeout  = 0, upgradeTimeoutCounter  = 0;
 	unsigned int  timeoutSec1, timeoutSec2;
+	unsigned int delay = HPMFWUPG_BACKOFF_MIN;
 	unsigned char retry = 0;
 	/* If we are not in upgrade context, we use default timeout values */
 	if (pFwupgCtx) {
@@ -2241,7 +2851,8 @@ HpmfwupgSendCmd(struct ipmi_intf *intf, struct ipmi_rq req,
 					inaccessTimeoutCounter += timeoutSec2 - timeoutSec1;
 					timeoutSec1 = time(NULL);
 				}
-				usleep(100000);
+				usleep(delay);
+				delay = __min(delay * 2, HPMFWUPG_BACKOFF_MAX);
 				retry = 1;
 			} else {
 				retry = 0;
@@ -2254,7 +2865,8 @@ HpmfwupgSendCmd(struct ipmi_intf *intf, struct ipmi_rq req,
 					timeoutSec1 = time(NULL);
 					upgradeTimeoutCounter += timeoutSec2 - timeoutSec1;
 				}
-				usleep(100000);
+				usleep(delay);
+				delay = __min(delay * 2, HPMFWUPG_BACKOFF_MAX);
 				retry = 1;
 			} else {
 				retry = 0;
@@ -2285,6 +2897,7 @@ HpmfwupgWaitLongDurationCmd(struct ipmi_intf *intf,
 	int rc = HPMFWUPG_SUCCESS;
 	unsigned int upgradeTimeout = 0;
 	unsigned int  timeoutSec1, timeoutSec2;
+	unsigned int delay = HPMFWUPG_POLL_MIN;
 	struct HpmfwupgGetUpgradeStatusCtx upgStatusCmd;
 	/* If we are not in upgrade context, we use default timeout values */
 	if (pFwupgCtx) {
@@ -2322,8 +2935,11 @@ HpmfwupgWaitLongDurationCmd(struct ipmi_intf *intf,
 					upgStatusCmd.resp.lastCmdCompCode == 0xD5)
 			&& ((timeoutSec2 - timeoutSec1) < upgradeTimeout )
 			&& (rc == HPMFWUPG_SUCCESS)) {
-		/* Must wait at least 1000 ms between status requests */
-		usleep(1000000);
+		/* Must wait at least 1000 ms between status requests,
+		 * back off from there for long running commands
+		 */
+		usleep(delay);
+		delay = __min(delay * 2, HPMFWUPG_POLL_MAX);
 		timeoutSec2 = time(NULL);
 		rc = HpmfwupgGetUpgradeStatus(intf, &upgStatusCmd, pFwupgCtx, 1);
 /*
@@ -2374,7 +2990,7 @@ HpmfwupgPrintUsage(void)
 	lprintf(LOG_NOTICE,
 "");
 	lprintf(LOG_NOTICE,
-"upgrade <file> [component x...] [force] [activate]");
+"upgrade <file> [component x...] [force] [activate] [resume]");
 	lprintf(LOG_NOTICE,
 "                        - Copies components from a valid HPM.1 image to the target.");
 	lprintf(LOG_NOTICE,
@@ -2400,6 +3016,22 @@ HpmfwupgPrintUsage(void)
 	lprintf(LOG_NOTICE,
 "                          is activated.");
 	lprintf(LOG_NOTICE,
+"                          Progress is saved to <file>.ckpt; use \"resume\" to");
+	lprintf(LOG_NOTICE,
+"                          continue an interrupted upgrade from that checkpoint.");
+	lprintf(LOG_NOTICE,
+"rollout <hosts> <file> [parallel n] [rate KiB/s] [component x...] [force]");
+	lprintf(LOG_NOTICE,
+"        [activate] [resume]");
+	lprintf(LOG_NOTICE,
+"                        - Upgrades every host listed in the <hosts> file, one per line,");
+	lprintf(LOG_NOTICE,
+"                          with the same image, n hosts at a time (default 8).");
+	lprintf(LOG_NOTICE,
+"                          The upload bandwidth can be capped for the whole rollout.");
+	lprintf(LOG_NOTICE,
+"                          The output of each host goes to hpm-<host>.log.");
+	lprintf(LOG_NOTICE,
 "upgstatus               - Returns the status of the last long duration command.");
 	lprintf(LOG_NOTICE,
 "");
@@ -2500,6 +3132,10 @@ ipmi_hpmfwupg_main(struct ipmi_intf *intf, int argc, char **argv)
 			if (!strcmp(argv[i],"force")) {
 				option |= FORCE_MODE;
 			}
+			/* hpm upgrade <filename> resume */
+			if (!strcmp(argv[i],"resume")) {
+				option |= RESUME_MODE;
+			}
 			/* hpm upgrade <filename> component <comp Id> */
 			if (!strcmp(argv[i],"component")) {
 				if (i+1 < argc) {
@@ -2540,6 +3176,55 @@ ipmi_hpmfwupg_main(struct ipmi_intf *intf, int argc, char **argv)
 			rc = HpmfwupgUpgrade(intf, argv[1], activateFlag,
 					componentMask, option);
 		}
+	} else if (!strcmp(argv[0], "rollout")) {
+		int parallel = 8;
+		uint32_t rate = 0;
+		int i = 0;
+		if (argc < 3) {
+			lprintf(LOG_ERR, "Not enough parameters given.");
+			HpmfwupgPrintUsage();
+			return HPMFWUPG_ERROR;
+		}
+		for (i = 3; i < argc; i++) {
+			if (!strcmp(argv[i], "activate")) {
+				activateFlag = 1;
+			} else if (!strcmp(argv[i], "force")) {
+				option |= FORCE_MODE;
+			} else if (!strcmp(argv[i], "resume")) {
+				option |= RESUME_MODE;
+			} else if (!strcmp(argv[i], "debug")) {
+				option |= DEBUG_MODE;
+			} else if (!strcmp(argv[i], "parallel") && i+1 < argc) {
+				if (str2int(argv[++i], &parallel) != 0 || parallel < 1) {
+					lprintf(LOG_ERR, "Invalid parallel count '%s'.",
+							argv[i]);
+					return HPMFWUPG_ERROR;
+				}
+			} else if (!strcmp(argv[i], "rate") && i+1 < argc) {
+				if (str2uint(argv[++i], &rate) != 0 || rate > UINT32_MAX / 1024) {
+					lprintf(LOG_ERR, "Invalid rate '%s'.", argv[i]);
+					return HPMFWUPG_ERROR;
+				}
+			} else if (!strcmp(argv[i], "component") && i+1 < argc) {
+				if (str2int(argv[++i], &componentId) != 0
+						|| componentId < 0
+						|| componentId >= HPMFWUPG_COMPONENT_ID_MAX) {
+					lprintf(LOG_ERR,
+							"Given Component ID '%s' is invalid.",
+							argv[i]);
+					lprintf(LOG_ERR,
+							"Valid Compoment ID is: <0..7>");
+					return HPMFWUPG_ERROR;
+				}
+				componentMask |= 1 << componentId;
+			} else {
+				lprintf(LOG_ERR, "Invalid rollout option '%s'.", argv[i]);
+				HpmfwupgPrintUsage();
+				return HPMFWUPG_ERROR;
+			}
+		}
+		rc = HpmfwupgRollout(intf, argv[1], argv[2], parallel, rate * 1024,
+				activateFlag, componentMask, option);
 	} else if (!strcmp(argv[0], "compare")) {
 		int i = 0;
 		for (i=1; i< argc; i++) {
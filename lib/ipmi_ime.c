@@ -81,6 +81,7 @@
 #include <ipmitool/ipmi_ime.h>
 #include <ipmitool/log.h>
 #include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_cc.h>
 #include <ipmitool/ipmi_mc.h>
 #include <ipmitool/helper.h>
 #include <ipmitool/ipmi_strings.h>
@@ -96,9 +97,13 @@
 static const int IME_SUCCESS              = 0;
 static const int IME_ERROR                = -1;
 static const int IME_RESTART              = -2;
+static const int IME_RETRY                = -3;
+static const int IME_LENGTH               = -4;
 
 #define IME_UPGRADE_BUFFER_SIZE           22
+#define IME_UPGRADE_BUFFER_MAX            0xfe
 #define IME_RETRY_COUNT                   5
+#define IME_PROGRESS_INTERVAL             1000000 /* usec */
 
 typedef struct ImeUpdateImageCtx
 {
@@ -168,6 +173,8 @@ static int  ImeUpdateWriteArea(
                               uint8_t length, 
                               uint8_t * pBuf
                           );
+static uint8_t ImeUpdateChunkSize(struct ipmi_intf *intf);
+static void ImeShowProgress(uint32_t done, uint32_t size, uint64_t usec);
 static int  ImeUpdateCloseArea(
                               struct ipmi_intf *intf,
                               uint32_t size, 
@@ -348,7 +355,7 @@ static int ImeUpgrade(struct ipmi_intf *intf, char* imageFilename)
    int rc = IME_SUCCESS;
    tImeUpdateImageCtx imgCtx;
    tImeStatus imeStatus;
-   time_t start,end,current;
+   time_t start,end;
    
    time(&start);
 
@@ -391,23 +398,53 @@ static int ImeUpgrade(struct ipmi_intf *intf, char* imageFilename)
       uint8_t sequence = 0;
       uint32_t counter = 0;
       uint8_t retry = 0;
-      uint8_t shownPercent = 0xff;
+      uint8_t chunkSize = ImeUpdateChunkSize(intf);
+      uint64_t startUsec = ipmi_time_usec();
+      uint64_t shownUsec = 0;
 
-      while(   
-            (counter < imgCtx.size) && 
-            (rc == IME_SUCCESS) &&
-            (retry < IME_RETRY_COUNT)
-           )
+      lprintf(LOG_INFO, "Writing %u bytes in chunks of %u bytes",
+              imgCtx.size, chunkSize);
+
+      while( (counter < imgCtx.size) && (rc == IME_SUCCESS) )
       {
-         uint8_t length = IME_UPGRADE_BUFFER_SIZE;
-         uint8_t currentPercent;
+         uint8_t length = chunkSize;
+         uint64_t now;
 
-         if( (imgCtx.size - counter) < IME_UPGRADE_BUFFER_SIZE )
+         if( (imgCtx.size - counter) < chunkSize )
          {
             length = (imgCtx.size - counter);
          }
 
          rc = ImeUpdateWriteArea(intf,sequence,length,&imgCtx.pData[counter]);
+
+         /*
+         The transport limit is only an upper bound: if the ME refuses
+         (or never answers) the very first chunk, fall back to the size
+         that has always been accepted and start over.
+         */
+         if( (rc == IME_LENGTH || rc == IME_RETRY) &&
+             (counter == 0) && (chunkSize > IME_UPGRADE_BUFFER_SIZE) )
+         {
+            lprintf(LOG_INFO, "Chunk of %u bytes rejected, using %u",
+                    chunkSize, IME_UPGRADE_BUFFER_SIZE);
+            chunkSize = IME_UPGRADE_BUFFER_SIZE;
+            rc = IME_SUCCESS;
+            continue;
+         }
+
+         /* resend only the failed chunk, under the same sequence number */
+         if( (rc == IME_RETRY) && (++retry < IME_RETRY_COUNT) )
+         {
+            lprintf(LOG_INFO, "Resending chunk %u", sequence);
+            rc = IME_SUCCESS;
+            continue;
+         }
+         if( rc != IME_SUCCESS )
+         {
+            printf("\n");
+            lprintf(LOG_ERR, "Write failed at offset %u", counter);
+            break;
+         }
          
          /*
          As per the flowchart Intel Dynamic Power Node Manager 1.5 IPMI Iface
@@ -416,20 +453,16 @@ static int ImeUpgrade(struct ipmi_intf *intf, char* imageFilename)
          but this add too much time to the upgrade
          */   
          /*  ImeUpdateGetStatus(intf,&imeStatus); */
+         retry = 0;
          counter += length;
          sequence ++;
 
-
-         currentPercent = ((float)counter/imgCtx.size)*100;
-
-         if(currentPercent != shownPercent)
+         now = ipmi_time_usec();
+         if( (now - shownUsec >= IME_PROGRESS_INTERVAL) ||
+             (counter == imgCtx.size) )
          {
-            shownPercent = currentPercent;
-            printf("Percent: %02i,  ", shownPercent);
-            time(&current);
-            printf("Elapsed time %02ld:%02ld\r",((current-start)/60), ((current-start)%60));
-            fflush(stdout);
-
+            shownUsec = now;
+            ImeShowProgress(counter, imgCtx.size, now - startUsec);
          }
       }
       ImeUpdateGetStatus(intf,&imeStatus);
@@ -562,11 +595,11 @@ static int ImeUpdateWriteArea(
 {
    struct ipmi_rs * rsp;
    struct ipmi_rq req;
-   uint8_t buffer[ IME_UPGRADE_BUFFER_SIZE + 1 ];
+   uint8_t buffer[ IME_UPGRADE_BUFFER_MAX + 1 ];
 
 //   printf("ImeUpdateWriteArea %i\n", sequence);
 
-   if(length > IME_UPGRADE_BUFFER_SIZE)
+   if(length > IME_UPGRADE_BUFFER_MAX)
       return IME_ERROR;
 
    buffer[0] = sequence;
@@ -580,10 +613,25 @@ static int ImeUpdateWriteArea(
 
    rsp = intf->sendrecv(intf, &req);
    if (!rsp) {
-      lprintf(LOG_ERR, "UpdateWriteArea command failed");
-      return IME_ERROR;
+      lprintf(LOG_INFO, "UpdateWriteArea command failed");
+      return IME_RETRY;
    }
-   if (rsp->ccode) {
+   switch (rsp->ccode) {
+   case IPMI_CC_OK:
+      break;
+   case IPMI_CC_NODE_BUSY:
+   case IPMI_CC_TIMEOUT:
+   case IPMI_CC_RESP_COULD_NOT_BE_PRV:
+      lprintf(LOG_INFO, "UpdateWriteArea command failed: %s",
+         val2str(rsp->ccode, completion_code_vals));
+      return IME_RETRY;
+   case IPMI_CC_REQ_DATA_TRUNC:
+   case IPMI_CC_REQ_DATA_INV_LENGTH:
+   case IPMI_CC_REQ_DATA_FIELD_EXCEED:
+      lprintf(LOG_INFO, "UpdateWriteArea command failed: %s",
+         val2str(rsp->ccode, completion_code_vals));
+      return IME_LENGTH;
+   default:
       lprintf(LOG_ERR, "UpdateWriteArea command failed: %s",
          val2str(rsp->ccode, completion_code_vals));
       if( rsp->ccode == 0x80) // restart operation
@@ -596,6 +644,46 @@ static int ImeUpdateWriteArea(
    return IME_SUCCESS;
 }
 
+/*
+ * ImeUpdateChunkSize - largest image chunk a Write Area request can carry
+ * over this interface, one request byte is taken by the sequence number
+ */
+static uint8_t ImeUpdateChunkSize(struct ipmi_intf *intf)
+{
+   uint16_t size = ipmi_intf_get_max_request_data_size(intf);
+
+   if (size <= 1) {
+      return IME_UPGRADE_BUFFER_SIZE;
+   }
+   size -= 1;
+   if (size > IME_UPGRADE_BUFFER_MAX) {
+      size = IME_UPGRADE_BUFFER_MAX;
+   }
+   return (uint8_t)size;
+}
+
+/*
+ * ImeShowProgress - print percentage, elapsed time, throughput and ETA
+ */
+static void ImeShowProgress(uint32_t done, uint32_t size, uint64_t usec)
+{
+   unsigned long elapsed = usec / 1000000;
+   unsigned long eta = 0;
+   double rate = 0;
+
+   if (usec) {
+      rate = (double)done * 1000000 / usec;
+   }
+   if (rate > 0) {
+      eta = (unsigned long)((size - done) / rate);
+   }
+
+   printf("Percent: %02i,  ", (int)(((float)done/size)*100));
+   printf("Elapsed time %02lu:%02lu,  ", elapsed / 60, elapsed % 60);
+   printf("%.1f KB/s,  ETA %02lu:%02lu \r", rate / 1024, eta / 60, eta % 60);
+   fflush(stdout);
+}
+
 static int ImeUpdateCloseArea(
                               struct ipmi_intf *intf,
                               uint32_t size, 
@@ -62,7 +62,7 @@ static int ipmi_kontron_set_mfg_date (struct ipmi_intf *intf);
 static void ipmi_kontron_nextboot_help(void);
 static int ipmi_kontron_nextboot_set(struct ipmi_intf *intf, char **argv);
 static int ipmi_kontronoem_send_set_large_buffer(struct ipmi_intf *intf,
-		unsigned char channel, unsigned char size);
+		unsigned char channel, unsigned char size, int quiet);
 
 static char *bootdev[] = {"BIOS", "FDD", "HDD", "CDROM", "network", 0};
 
@@ -127,40 +127,46 @@ ipmi_kontron_help(void)
 	printf("Kontron Commands:  setsn setmfgdate nextboot\n");
 }
 
-int
-ipmi_kontronoem_set_large_buffer(struct ipmi_intf *intf, unsigned char size)
+static int
+kontronoem_set_large_buffer(struct ipmi_intf *intf, unsigned char size,
+		int quiet)
 {
 	uint8_t error_occurs = 0;
 	uint32_t prev_target_addr = intf->target_addr ;
 	if (intf->target_addr > 0 && (intf->target_addr != intf->my_addr)) {
 		intf->target_addr = intf->my_addr;
-		printf("Set local big buffer\n");
-		if (ipmi_kontronoem_send_set_large_buffer(intf, 0x0e, size) == 0) {
-			printf("Set local big buffer:success\n");
+		if (!quiet)
+			printf("Set local big buffer\n");
+		if (ipmi_kontronoem_send_set_large_buffer(intf, 0x0e, size,
+					quiet) == 0) {
+			if (!quiet)
+				printf("Set local big buffer:success\n");
 		} else {
 			error_occurs = 1;
 		}
 		if (error_occurs == 0) {
-			if (ipmi_kontronoem_send_set_large_buffer(intf, 0x00, size) == 0) {
-				printf("IPMB was set\n");
+			if (ipmi_kontronoem_send_set_large_buffer(intf, 0x00, size,
+						quiet) == 0) {
+				if (!quiet)
+					printf("IPMB was set\n");
 			} else {
 				/* Revert back the previous set large buffer */
 				error_occurs = 1;
-				ipmi_kontronoem_send_set_large_buffer( intf, 0x0e, 0 );
+				ipmi_kontronoem_send_set_large_buffer(intf, 0x0e, 0, quiet);
 			}
 		}
 		/* Restore target address */
 		intf->target_addr = prev_target_addr;
 	}
 	if (error_occurs == 0) {
-		if(ipmi_kontronoem_send_set_large_buffer(intf, 0x0e, size) == 0) {
+		if(ipmi_kontronoem_send_set_large_buffer(intf, 0x0e, size, quiet) == 0) {
 			/* printf("Set remote big buffer\n"); */
 		} else {
 			if (intf->target_addr > 0  && (intf->target_addr != intf->my_addr)) {
 				/* Error occurs revert back the previous set large buffer */
 				intf->target_addr = intf->my_addr;
 				/* ipmi_kontronoem_send_set_large_buffer(intf, 0x00, 0); */
-				ipmi_kontronoem_send_set_large_buffer(intf, 0x0e, 0);
+				ipmi_kontronoem_send_set_large_buffer(intf, 0x0e, 0, quiet);
 				intf->target_addr = prev_target_addr;
 			}
 		}
@@ -168,9 +174,26 @@ ipmi_kontronoem_set_large_buffer(struct ipmi_intf *intf, unsigned char size)
 	return error_occurs;
 }
 
+int
+ipmi_kontronoem_set_large_buffer(struct ipmi_intf *intf, unsigned char size)
+{
+	return kontronoem_set_large_buffer(intf, size, 0);
+}
+
+/* ipmi_kontronoem_try_large_buffer - set the channel buffer length,
+ * reporting failures at LOG_INFO only
+ *
+ * For callers that fall back to the default buffer size on error.
+ */
+int
+ipmi_kontronoem_try_large_buffer(struct ipmi_intf *intf, unsigned char size)
+{
+	return kontronoem_set_large_buffer(intf, size, 1);
+}
+
 int
 ipmi_kontronoem_send_set_large_buffer(struct ipmi_intf *intf,
-		unsigned char channel, unsigned char size)
+		unsigned char channel, unsigned char size, int quiet)
 {
 	struct ipmi_rs *rsp;
 	struct ipmi_rq req;
@@ -188,11 +211,19 @@ ipmi_kontronoem_send_set_large_buffer(struct ipmi_intf *intf,
 	req.msg.lun = 0x00;
 	rsp = intf->sendrecv(intf, &req);
 	if (!rsp)  {
-		printf("Cannot send large buffer command\n");
+		if (quiet)
+			lprintf(LOG_INFO, "Cannot send large buffer command");
+		else
+			printf("Cannot send large buffer command\n");
 		return(-1);
 	} else if (rsp->ccode)  {
-		printf("Invalid length for the selected interface (%s) %d\n",
-				val2str(rsp->ccode, completion_code_vals), rsp->ccode);
+		if (quiet)
+			lprintf(LOG_INFO,
+					"Invalid length for the selected interface (%s) %d",
+					val2str(rsp->ccode, completion_code_vals), rsp->ccode);
+		else
+			printf("Invalid length for the selected interface (%s) %d\n",
+					val2str(rsp->ccode, completion_code_vals), rsp->ccode);
 		return(-1);
 	}
 	return 0;
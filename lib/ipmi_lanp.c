@@ -51,7 +51,9 @@
 #include <ipmitool/helper.h>
 #include <ipmitool/ipmi_constants.h>
 #include <ipmitool/ipmi_strings.h>
+#include <ipmitool/ipmi_cfgp.h>
 #include <ipmitool/ipmi_lanp.h>
+#include <ipmitool/ipmi_lanp6.h>
 #include <ipmitool/ipmi_channel.h>
 #include <ipmitool/ipmi_user.h>
 
@@ -245,7 +247,7 @@ get_lan_param_select(struct ipmi_intf *intf, uint8_t chan, int param, int select
 			specific_val2str(rsp->ccode,
 			                 get_lan_cc_vals,
 			                 completion_code_vals));
-		return NULL;
+		return rc;
 	}
 
 	p->data = rsp->data + 1;
@@ -272,6 +274,348 @@ get_lan_param(struct ipmi_intf *intf, uint8_t chan, int param)
 	return get_lan_param_select(intf, chan, param, 0);
 }
 
+/*
+ * LAN configuration snapshot
+ *
+ * A snapshot holds the result of every Get LAN Configuration Parameters
+ * request needed for a report, taken in a single pass: data, 'not
+ * supported' or the failing completion code.  Reports are rendered from
+ * the snapshot only, and a snapshot can be written to and read back
+ * from a text file so configurations can be compared offline.
+ */
+#define LAN_SNAP_MAX_DEST	16	/* destination selector is 4 bits */
+#define LAN_SNAP_MAX_ENTRIES	(ARRAY_SIZE(ipmi_lan_params) + 2 * LAN_SNAP_MAX_DEST)
+#define LAN_SNAP_HEADER		"# ipmitool lan snapshot 1"
+
+enum {
+	LAN_SNAP_OK,
+	LAN_SNAP_UNSUPPORTED,
+	LAN_SNAP_FAILED
+};
+
+struct lan_snap_entry {
+	struct lan_param lp;	/* lp.data is NULL unless LAN_SNAP_OK */
+	uint8_t select;
+	uint8_t state;
+	uint8_t ccode;
+};
+
+struct lan_snapshot {
+	uint8_t chan;
+	size_t count;
+	struct lan_snap_entry entry[LAN_SNAP_MAX_ENTRIES];
+};
+
+/* Parameters rendered by 'lan print' */
+static const int lan_print_params[] = {
+	IPMI_LANP_SET_IN_PROGRESS, IPMI_LANP_AUTH_TYPE,
+	IPMI_LANP_AUTH_TYPE_ENABLE, IPMI_LANP_IP_ADDR_SRC, IPMI_LANP_IP_ADDR,
+	IPMI_LANP_SUBNET_MASK, IPMI_LANP_MAC_ADDR, IPMI_LANP_SNMP_STRING,
+	IPMI_LANP_IP_HEADER, IPMI_LANP_BMC_ARP, IPMI_LANP_GRAT_ARP,
+	IPMI_LANP_DEF_GATEWAY_IP, IPMI_LANP_DEF_GATEWAY_MAC,
+	IPMI_LANP_BAK_GATEWAY_IP, IPMI_LANP_BAK_GATEWAY_MAC, IPMI_LANP_VLAN_ID,
+	IPMI_LANP_VLAN_PRIORITY, IPMI_LANP_RMCP_CIPHER_SUPPORT,
+	IPMI_LANP_RMCP_CIPHERS, IPMI_LANP_RMCP_PRIV_LEVELS,
+	IPMI_LANP_BAD_PASS_THRESH,
+};
+
+/* lan_snap_free - release a snapshot and its parameter data */
+static void
+lan_snap_free(struct lan_snapshot *snap)
+{
+	size_t i;
+
+	if (!snap)
+		return;
+	for (i = 0; i < snap->count; i++)
+		free(snap->entry[i].lp.data);
+	free(snap);
+}
+
+/* lan_snap_new - allocate an empty snapshot of a channel */
+static struct lan_snapshot *
+lan_snap_new(uint8_t chan)
+{
+	struct lan_snapshot *snap = calloc(1, sizeof(*snap));
+
+	if (!snap) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		return NULL;
+	}
+	snap->chan = chan;
+	return snap;
+}
+
+/* lan_snap_add - append an entry, data is copied and NUL terminated */
+static struct lan_snap_entry *
+lan_snap_add(struct lan_snapshot *snap, int param, uint8_t select,
+             uint8_t state, uint8_t ccode, const uint8_t *data, int len)
+{
+	struct lan_snap_entry *e;
+	int i;
+
+	if (snap->count >= LAN_SNAP_MAX_ENTRIES)
+		return NULL;
+	for (i = 0; ipmi_lan_params[i].cmd != (-1); i++) {
+		if (ipmi_lan_params[i].cmd == param)
+			break;
+	}
+	if (ipmi_lan_params[i].cmd == (-1))
+		return NULL;
+
+	e = &snap->entry[snap->count];
+	memset(e, 0, sizeof(*e));
+	e->lp = ipmi_lan_params[i];
+	e->lp.data = NULL;
+	e->lp.data_len = 0;
+	e->select = select;
+	e->state = state;
+	e->ccode = ccode;
+	if (state == LAN_SNAP_OK) {
+		e->lp.data = malloc(len + 1);
+		if (!e->lp.data) {
+			lprintf(LOG_ERR, "ipmitool: malloc failure");
+			return NULL;
+		}
+		memcpy(e->lp.data, data, len);
+		e->lp.data[len] = '\0';
+		e->lp.data_len = len;
+	}
+	snap->count++;
+	return e;
+}
+
+/* lan_snap_fetch - read one parameter into the snapshot
+ *
+ * returns -1 if the BMC did not answer, 0 otherwise
+ */
+static int
+lan_snap_fetch(struct ipmi_intf *intf, struct lan_snapshot *snap,
+               int param, uint8_t select)
+{
+	struct ipmi_rs *rsp;
+	struct ipmi_rq req;
+	uint8_t msg_data[4];
+	uint8_t state = LAN_SNAP_OK;
+
+	msg_data[0] = snap->chan;
+	msg_data[1] = param;
+	msg_data[2] = select;
+	msg_data[3] = 0;
+
+	memset(&req, 0, sizeof(req));
+	req.msg.netfn    = IPMI_NETFN_TRANSPORT;
+	req.msg.cmd      = IPMI_LAN_GET_CONFIG;
+	req.msg.data     = msg_data;
+	req.msg.data_len = 4;
+
+	rsp = intf->sendrecv(intf, &req);
+	if (!rsp) {
+		lprintf(LOG_ERR, "Get LAN Parameter %d command failed", param);
+		return -1;
+	}
+
+	switch (rsp->ccode) {
+	case 0x00:
+		if (rsp->data_len < 1)
+			state = LAN_SNAP_FAILED;
+		break;
+	case 0x80: /* parameter not supported */
+	case 0xc9: /* parameter out of range */
+	case 0xcc: /* invalid data field in request */
+		state = LAN_SNAP_UNSUPPORTED;
+		break;
+	default:
+		lprintf(LOG_INFO, "Get LAN Parameter %d command failed: %s",
+		        param, specific_val2str(rsp->ccode, get_lan_cc_vals,
+		                                completion_code_vals));
+		state = LAN_SNAP_FAILED;
+		break;
+	}
+
+	/* skip the parameter revision byte */
+	lan_snap_add(snap, param, select, state, rsp->ccode,
+	             rsp->data + 1, rsp->data_len - 1);
+	return 0;
+}
+
+/* lan_snap_get - look up a parameter in a snapshot
+ *
+ * Same contract as get_lan_param_select(): NULL if the read failed,
+ * data NULL if the parameter is not supported.
+ */
+static const struct lan_param *
+lan_snap_get(const struct lan_snapshot *snap, int param, uint8_t select)
+{
+	size_t i;
+
+	for (i = 0; i < snap->count; i++) {
+		const struct lan_snap_entry *e = &snap->entry[i];
+
+		if (e->lp.cmd == param && e->select == select)
+			return (e->state == LAN_SNAP_FAILED) ? NULL : &e->lp;
+	}
+	return NULL;
+}
+
+/* lan_snap_read - take a snapshot of a LAN channel
+ *
+ * With @params NULL all known parameters are read, otherwise only the
+ * listed ones.  With @dests set every alert destination is read too.
+ *
+ * @intf:    ipmi interface handle
+ * @chan:    ipmi channel
+ * @params:  parameters to read or NULL
+ * @nparams: number of parameters
+ * @dests:   read all alert destinations
+ */
+static struct lan_snapshot *
+lan_snap_read(struct ipmi_intf *intf, uint8_t chan,
+              const int *params, size_t nparams, int dests)
+{
+	struct lan_snapshot *snap = lan_snap_new(chan);
+	const struct lan_param *p;
+	size_t i;
+	int ndest;
+
+	if (!snap)
+		return NULL;
+
+	for (i = 0; params ? i < nparams : ipmi_lan_params[i].cmd != (-1); i++) {
+		int param = params ? params[i] : ipmi_lan_params[i].cmd;
+
+		/* destinations are read below, one per set selector */
+		if (!params && (param == IPMI_LANP_DEST_TYPE
+		                || param == IPMI_LANP_DEST_ADDR))
+			continue;
+		if (lan_snap_fetch(intf, snap, param, 0))
+			goto fail;
+	}
+	if (!dests)
+		return snap;
+
+	p = lan_snap_get(snap, IPMI_LANP_NUM_DEST, 0);
+	if (!p) {
+		if (lan_snap_fetch(intf, snap, IPMI_LANP_NUM_DEST, 0))
+			goto fail;
+		p = lan_snap_get(snap, IPMI_LANP_NUM_DEST, 0);
+	}
+	ndest = (p && p->data) ? (p->data[0] & 0xf) : -1;
+	for (i = 0; (int)i <= ndest; i++) {
+		if (lan_snap_fetch(intf, snap, IPMI_LANP_DEST_TYPE, i)
+		    || lan_snap_fetch(intf, snap, IPMI_LANP_DEST_ADDR, i))
+			goto fail;
+	}
+	return snap;
+
+fail:
+	lan_snap_free(snap);
+	return NULL;
+}
+
+/* lan_snap_save - write a snapshot as text
+ *
+ * One line per parameter, in the order read, so that two snapshots of
+ * the same kind of BMC can be compared with diff(1).
+ */
+static int
+lan_snap_save(const struct lan_snapshot *snap, FILE *fp)
+{
+	size_t i;
+	int j;
+
+	fprintf(fp, "%s\nchannel %u\n", LAN_SNAP_HEADER, snap->chan);
+	for (i = 0; i < snap->count; i++) {
+		const struct lan_snap_entry *e = &snap->entry[i];
+
+		fprintf(fp, "param %d select %u ", e->lp.cmd, e->select);
+		switch (e->state) {
+		case LAN_SNAP_OK:
+			fprintf(fp, "ok ");
+			for (j = 0; j < e->lp.data_len; j++)
+				fprintf(fp, "%02x", e->lp.data[j]);
+			break;
+		case LAN_SNAP_UNSUPPORTED:
+			fprintf(fp, "unsupported");
+			break;
+		default:
+			fprintf(fp, "failed %02x", e->ccode);
+			break;
+		}
+		fprintf(fp, " # %.*s\n", (int)sizeof(e->lp.desc), e->lp.desc);
+	}
+	return ferror(fp) ? -1 : 0;
+}
+
+/* lan_snap_load - read a snapshot written by lan_snap_save() */
+static struct lan_snapshot *
+lan_snap_load(const char *file)
+{
+	struct lan_snapshot *snap = NULL;
+	char line[512];
+	unsigned int chan;
+	int lineno = 0;
+	FILE *fp;
+
+	fp = ipmi_open_file_read(file);
+	if (!fp)
+		return NULL;
+
+	if (!fgets(line, sizeof(line), fp)
+	    || strncmp(line, LAN_SNAP_HEADER, strlen(LAN_SNAP_HEADER))
+	    || !fgets(line, sizeof(line), fp)
+	    || sscanf(line, "channel %u", &chan) != 1 || chan > 0xf)
+	{
+		lprintf(LOG_ERR, "%s is not a LAN configuration snapshot", file);
+		goto out;
+	}
+	lineno = 2;
+
+	snap = lan_snap_new(chan);
+	if (!snap)
+		goto out;
+
+	while (fgets(line, sizeof(line), fp)) {
+		uint8_t data[IPMI_BUF_SIZE];
+		unsigned int param, select, ccode = 0;
+		char state[16], value[2 * IPMI_BUF_SIZE + 1];
+		int n, len = 0;
+
+		lineno++;
+		value[0] = '\0';
+		n = sscanf(line, "param %u select %u %15s %2048[0-9a-fA-F]",
+		           &param, &select, state, value);
+		if (n < 3 || param > 0xff || select > 0xff)
+			goto bad;
+
+		if (!strcmp(state, "ok")) {
+			len = ipmi_parse_hex(value, data, sizeof(data));
+			if (len < 0 || len > (int)sizeof(data))
+				goto bad;
+			n = LAN_SNAP_OK;
+		} else if (!strcmp(state, "unsupported")) {
+			n = LAN_SNAP_UNSUPPORTED;
+		} else if (!strcmp(state, "failed") && n == 4
+		           && sscanf(value, "%x", &ccode) == 1)
+		{
+			n = LAN_SNAP_FAILED;
+		} else {
+			goto bad;
+		}
+		if (!lan_snap_add(snap, param, select, n, ccode, data, len))
+			goto bad;
+	}
+	goto out;
+
+bad:
+	lprintf(LOG_ERR, "%s:%d: invalid snapshot line", file, lineno);
+	lan_snap_free(snap);
+	snap = NULL;
+out:
+	fclose(fp);
+	return snap;
+}
+
 /* set_lan_param_wait - Wait for Set LAN Parameter command to complete
  *
  * On some systems this can take unusually long so we wait for the write
@@ -629,29 +973,18 @@ static char priv_level_to_char(unsigned char priv_level)
 }
 
 
+/* ipmi_lan_print_snap - render 'lan print' from a snapshot */
 static int
-ipmi_lan_print(struct ipmi_intf *intf, uint8_t chan)
+ipmi_lan_print_snap(const struct lan_snapshot *snap)
 {
-	struct lan_param *p;
+	const struct lan_param *p;
 
-	if (chan < 1 || chan > IPMI_CHANNEL_NUMBER_MAX) {
-		lprintf(LOG_ERR, "Invalid Channel %d", chan);
-		return -1;
-	}
-
-	/* find type of channel and only accept 802.3 LAN */
-	if (!is_lan_channel(intf, chan)) {
-		lprintf(LOG_ERR, "Channel %d is not a LAN channel", chan);
-		return -1;
-	}
-
-	p = get_lan_param(intf, chan, IPMI_LANP_SET_IN_PROGRESS);
+	p = lan_snap_get(snap, IPMI_LANP_SET_IN_PROGRESS, 0);
 	if (!p)
 		return -1;
 	if (p->data) {
 		printf("%-24s: ", p->desc);
-		p->data[0] &= 3;
-		switch (p->data[0]) {
+		switch (p->data[0] & 3) {
 		case 0:
 			printf("Set Complete\n");
 			break;
@@ -669,7 +1002,7 @@ ipmi_lan_print(struct ipmi_intf *intf, uint8_t chan)
 		}
 	}
 
-	p = get_lan_param(intf, chan, IPMI_LANP_AUTH_TYPE);
+	p = lan_snap_get(snap, IPMI_LANP_AUTH_TYPE, 0);
 	if (!p)
 		return -1;
 	if (p->data) {
@@ -681,7 +1014,7 @@ ipmi_lan_print(struct ipmi_intf *intf, uint8_t chan)
 		       (p->data[0] & 1<<IPMI_SESSION_AUTHTYPE_OEM) ? "OEM " : "");
 	}
 
-	p = get_lan_param(intf, chan, IPMI_LANP_AUTH_TYPE_ENABLE);
+	p = lan_snap_get(snap, IPMI_LANP_AUTH_TYPE_ENABLE, 0);
 	if (!p)
 		return -1;
 	if (p->data) {
@@ -717,13 +1050,12 @@ ipmi_lan_print(struct ipmi_intf *intf, uint8_t chan)
 		       (p->data[4] & 1<<IPMI_SESSION_AUTHTYPE_OEM) ? "OEM " : "");
 	}
 
-	p = get_lan_param(intf, chan, IPMI_LANP_IP_ADDR_SRC);
+	p = lan_snap_get(snap, IPMI_LANP_IP_ADDR_SRC, 0);
 	if (!p)
 		return -1;
 	if (p->data) {
 		printf("%-24s: ", p->desc);
-		p->data[0] &= 0xf;
-		switch (p->data[0]) {
+		switch (p->data[0] & 0xf) {
 		case 0:
 			printf("Unspecified\n");
 			break;
@@ -742,79 +1074,79 @@ ipmi_lan_print(struct ipmi_intf *intf, uint8_t chan)
 		}
 	}
 
-	p = get_lan_param(intf, chan, IPMI_LANP_IP_ADDR);
+	p = lan_snap_get(snap, IPMI_LANP_IP_ADDR, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: %d.%d.%d.%d\n", p->desc,
 		       p->data[0], p->data[1], p->data[2], p->data[3]);
 
-	p = get_lan_param(intf, chan, IPMI_LANP_SUBNET_MASK);
+	p = lan_snap_get(snap, IPMI_LANP_SUBNET_MASK, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: %d.%d.%d.%d\n", p->desc,
 		       p->data[0], p->data[1], p->data[2], p->data[3]);
 
-	p = get_lan_param(intf, chan, IPMI_LANP_MAC_ADDR);
+	p = lan_snap_get(snap, IPMI_LANP_MAC_ADDR, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: %s\n", p->desc, mac2str(p->data));
 
-	p = get_lan_param(intf, chan, IPMI_LANP_SNMP_STRING);
+	p = lan_snap_get(snap, IPMI_LANP_SNMP_STRING, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: %s\n", p->desc, p->data);
 
-	p = get_lan_param(intf, chan, IPMI_LANP_IP_HEADER);
+	p = lan_snap_get(snap, IPMI_LANP_IP_HEADER, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: TTL=0x%02x Flags=0x%02x Precedence=0x%02x TOS=0x%02x\n",
 		       p->desc, p->data[0], p->data[1] & 0xe0, p->data[2] & 0xe0, p->data[2] & 0x1e);
 
-	p = get_lan_param(intf, chan, IPMI_LANP_BMC_ARP);
+	p = lan_snap_get(snap, IPMI_LANP_BMC_ARP, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: ARP Responses %sabled, Gratuitous ARP %sabled\n", p->desc,
 		       (p->data[0] & 2) ? "En" : "Dis", (p->data[0] & 1) ? "En" : "Dis");
 
-	p = get_lan_param(intf, chan, IPMI_LANP_GRAT_ARP);
+	p = lan_snap_get(snap, IPMI_LANP_GRAT_ARP, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: %.1f seconds\n", p->desc, (float)((p->data[0] + 1) / 2));
 
-	p = get_lan_param(intf, chan, IPMI_LANP_DEF_GATEWAY_IP);
+	p = lan_snap_get(snap, IPMI_LANP_DEF_GATEWAY_IP, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: %d.%d.%d.%d\n", p->desc,
 		       p->data[0], p->data[1], p->data[2], p->data[3]);
 
-	p = get_lan_param(intf, chan, IPMI_LANP_DEF_GATEWAY_MAC);
+	p = lan_snap_get(snap, IPMI_LANP_DEF_GATEWAY_MAC, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: %s\n", p->desc, mac2str(p->data));
 
-	p = get_lan_param(intf, chan, IPMI_LANP_BAK_GATEWAY_IP);
+	p = lan_snap_get(snap, IPMI_LANP_BAK_GATEWAY_IP, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: %d.%d.%d.%d\n", p->desc,
 		       p->data[0], p->data[1], p->data[2], p->data[3]);
 
-	p = get_lan_param(intf, chan, IPMI_LANP_BAK_GATEWAY_MAC);
+	p = lan_snap_get(snap, IPMI_LANP_BAK_GATEWAY_MAC, 0);
 	if (!p)
 		return -1;
 	if (p->data)
 		printf("%-24s: %s\n", p->desc, mac2str(p->data));
 
-	p = get_lan_param(intf, chan, IPMI_LANP_VLAN_ID);
+	p = lan_snap_get(snap, IPMI_LANP_VLAN_ID, 0);
 	if (p && p->data) {
 		int id = ((p->data[1] & 0x0f) << 8) + p->data[0];
 		if (p->data[1] & 0x80)
@@ -823,18 +1155,18 @@ ipmi_lan_print(struct ipmi_intf *intf, uint8_t chan)
 			printf("%-24s: Disabled\n", p->desc);
 	}
 
-	p = get_lan_param(intf, chan, IPMI_LANP_VLAN_PRIORITY);
+	p = lan_snap_get(snap, IPMI_LANP_VLAN_PRIORITY, 0);
 	if (p && p->data)
 		printf("%-24s: %d\n", p->desc, p->data[0] & 0x07);
 
 	/* Determine supported Cipher Suites -- Requires two calls */
-	p = get_lan_param(intf, chan, IPMI_LANP_RMCP_CIPHER_SUPPORT);
+	p = lan_snap_get(snap, IPMI_LANP_RMCP_CIPHER_SUPPORT, 0);
 	if (!p)
 		return -1;
 	else if (p->data)
 	{
 		unsigned char cipher_suite_count = p->data[0];
-		p = get_lan_param(intf, chan, IPMI_LANP_RMCP_CIPHERS);
+		p = lan_snap_get(snap, IPMI_LANP_RMCP_CIPHERS, 0);
 		if (!p)
 			return -1;
 
@@ -861,7 +1193,7 @@ ipmi_lan_print(struct ipmi_intf *intf, uint8_t chan)
 
 	/* RMCP+ Messaging Cipher Suite Privilege Levels */
 	/* These are the privilege levels for the 15 fixed cipher suites */
-	p = get_lan_param(intf, chan, IPMI_LANP_RMCP_PRIV_LEVELS);
+	p = lan_snap_get(snap, IPMI_LANP_RMCP_PRIV_LEVELS, 0);
 	if (!p)
 		return -1;
 	if (p->data && 9 == p->data_len)
@@ -895,7 +1227,7 @@ ipmi_lan_print(struct ipmi_intf *intf, uint8_t chan)
 		printf("%-24s: Not Available\n", p->desc);
 
 	/* Bad Password Threshold */
-	p = get_lan_param(intf, chan, IPMI_LANP_BAD_PASS_THRESH);
+	p = lan_snap_get(snap, IPMI_LANP_BAD_PASS_THRESH, 0);
 	if (!p)
 		return -1;
 	if (p->data && 6 == p->data_len) {
@@ -915,6 +1247,27 @@ ipmi_lan_print(struct ipmi_intf *intf, uint8_t chan)
 	return 0;
 }
 
+static int
+ipmi_lan_print(struct ipmi_intf *intf, uint8_t chan)
+{
+	struct lan_snapshot *snap;
+	int rc;
+
+	/* the caller made sure this is an 802.3 LAN channel */
+	if (chan < 1 || chan > IPMI_CHANNEL_NUMBER_MAX) {
+		lprintf(LOG_ERR, "Invalid Channel %d", chan);
+		return -1;
+	}
+
+	snap = lan_snap_read(intf, chan, lan_print_params,
+	                     ARRAY_SIZE(lan_print_params), 0);
+	if (!snap)
+		return -1;
+	rc = ipmi_lan_print_snap(snap);
+	lan_snap_free(snap);
+	return rc;
+}
+
 /* Configure Authentication Types */
 /* TODO - probably some code duplication going on ??? */
 static int
@@ -1760,24 +2113,25 @@ is_alert_destination(struct ipmi_intf *intf, uint8_t channel, uint8_t alert)
 		return 0;
 }
 
+/* ipmi_lan_alert_print_snap - render one alert destination of a snapshot */
 static int
-ipmi_lan_alert_print(struct ipmi_intf *intf, uint8_t channel, uint8_t alert)
+ipmi_lan_alert_print_snap(const struct lan_snapshot *snap, uint8_t alert)
 {
 # define PTYPE_LEN	4
 # define PADDR_LEN	13
-	struct lan_param *lp_ptr = NULL;
+	const struct lan_param *lp_ptr = NULL;
 	int isack = 0;
 	uint8_t ptype[PTYPE_LEN];
 	uint8_t paddr[PADDR_LEN];
 
-	lp_ptr = get_lan_param_select(intf, channel, IPMI_LANP_DEST_TYPE, alert);
+	lp_ptr = lan_snap_get(snap, IPMI_LANP_DEST_TYPE, alert);
 	if (!lp_ptr || !lp_ptr->data
 			|| lp_ptr->data_len < PTYPE_LEN) {
 		return (-1);
 	}
 	memcpy(ptype, lp_ptr->data, PTYPE_LEN);
 
-	lp_ptr = get_lan_param_select(intf, channel, IPMI_LANP_DEST_ADDR, alert);
+	lp_ptr = lan_snap_get(snap, IPMI_LANP_DEST_ADDR, alert);
 	if (!lp_ptr || !lp_ptr->data || lp_ptr->data_len < PADDR_LEN) {
 		return (-1);
 	}
@@ -1835,12 +2189,29 @@ ipmi_lan_alert_print(struct ipmi_intf *intf, uint8_t channel, uint8_t alert)
 }
 
 static int
-ipmi_lan_alert_print_all(struct ipmi_intf *intf, uint8_t channel)
+ipmi_lan_alert_print(struct ipmi_intf *intf, uint8_t channel, uint8_t alert)
+{
+	struct lan_snapshot *snap = lan_snap_new(channel);
+	int rc = -1;
+
+	if (snap
+	    && !lan_snap_fetch(intf, snap, IPMI_LANP_DEST_TYPE, alert)
+	    && !lan_snap_fetch(intf, snap, IPMI_LANP_DEST_ADDR, alert))
+	{
+		rc = ipmi_lan_alert_print_snap(snap, alert);
+	}
+	lan_snap_free(snap);
+	return rc;
+}
+
+/* ipmi_lan_alert_print_all_snap - render all alert destinations */
+static int
+ipmi_lan_alert_print_all_snap(const struct lan_snapshot *snap)
 {
 	int j, ndest;
-	struct lan_param *p;
+	const struct lan_param *p;
 
-	p = get_lan_param(intf, channel, IPMI_LANP_NUM_DEST);
+	p = lan_snap_get(snap, IPMI_LANP_NUM_DEST, 0);
 	if (!p)
 		return -1;
 	if (!p->data)
@@ -1848,12 +2219,93 @@ ipmi_lan_alert_print_all(struct ipmi_intf *intf, uint8_t channel)
 	ndest = p->data[0] & 0xf;
 
 	for (j=0; j<=ndest; j++) {
-		ipmi_lan_alert_print(intf, channel, j);
+		ipmi_lan_alert_print_snap(snap, j);
 	}
 
 	return 0;
 }
 
+static int
+ipmi_lan_alert_print_all(struct ipmi_intf *intf, uint8_t channel)
+{
+	static const int params[] = { IPMI_LANP_NUM_DEST };
+	struct lan_snapshot *snap;
+	int rc;
+
+	snap = lan_snap_read(intf, channel, params, ARRAY_SIZE(params), 1);
+	if (!snap)
+		return -1;
+	rc = ipmi_lan_alert_print_all_snap(snap);
+	lan_snap_free(snap);
+	return rc;
+}
+
+/* ipmi_lan_snapshot - save a snapshot of a channel or print a saved one
+ *
+ * snapshot save [<channel>] [<file>]
+ * snapshot print <file>
+ */
+static int
+ipmi_lan_snapshot(struct ipmi_intf *intf, int argc, char **argv)
+{
+	struct lan_snapshot *snap;
+	uint8_t chan;
+	FILE *fp = stdout;
+	int rc;
+
+	if (argc >= 2 && !strcmp(argv[0], "print")) {
+		snap = lan_snap_load(argv[1]);
+		if (!snap)
+			return -1;
+		printf("%-24s: %d\n", "Channel", snap->chan);
+		rc = ipmi_lan_print_snap(snap);
+		if (!rc && lan_snap_get(snap, IPMI_LANP_NUM_DEST, 0)) {
+			printf("\n");
+			ipmi_lan_alert_print_all_snap(snap);
+		}
+		lan_snap_free(snap);
+		return rc;
+	}
+
+	if (argc < 1 || strcmp(argv[0], "save") || argc > 3) {
+		lprintf(LOG_NOTICE, "lan snapshot save [<channel>] [<file>]");
+		lprintf(LOG_NOTICE, "lan snapshot print <file>");
+		return -1;
+	}
+
+	if (argc >= 2) {
+		if (str2uchar(argv[1], &chan) != 0) {
+			lprintf(LOG_ERR, "Invalid channel: %s", argv[1]);
+			return -1;
+		}
+	} else {
+		chan = find_lan_channel(intf, 1);
+	}
+	if (!is_lan_channel(intf, chan)) {
+		lprintf(LOG_ERR, "Invalid channel: %d", chan);
+		return -1;
+	}
+
+	snap = lan_snap_read(intf, chan, NULL, 0, 1);
+	if (!snap)
+		return -1;
+
+	if (argc == 3 && strcmp(argv[2], "-")) {
+		fp = ipmi_open_file_write(argv[2]);
+		if (!fp) {
+			lan_snap_free(snap);
+			return -1;
+		}
+	}
+	rc = lan_snap_save(snap, fp);
+	if (fp != stdout && fclose(fp))
+		rc = -1;
+	if (rc)
+		lprintf(LOG_ERR, "Unable to write LAN snapshot");
+	lan_snap_free(snap);
+	return rc;
+}
+
 static int
 ipmi_lan_alert_set(struct ipmi_intf *intf, uint8_t chan, uint8_t alert,
 		   int argc, char **argv)
@@ -2468,6 +2920,514 @@ print_lan_set_vlan_usage(void)
 "lan set <channel> vlan priority <priority>");
 }
 
+/*
+ * LAN configuration parameters for 'config save' and 'config apply'
+ */
+static const struct ipmi_cfgp lan_cfgp[] = {
+	{ .name = "ipsrc", .format = "{none|static|dhcp|bios}", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_IP_ADDR_SRC
+	},
+	{ .name = "ipaddr", .format = "<x.x.x.x>", .size = 4,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_IP_ADDR
+	},
+	{ .name = "netmask", .format = "<x.x.x.x>", .size = 4,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_SUBNET_MASK
+	},
+	{ .name = "macaddr", .format = "<xx:xx:xx:xx:xx:xx>", .size = 6,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_MAC_ADDR
+	},
+	{ .name = "defgw_ipaddr", .format = "<x.x.x.x>", .size = 4,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_DEF_GATEWAY_IP
+	},
+	{ .name = "defgw_macaddr", .format = "<xx:xx:xx:xx:xx:xx>", .size = 6,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_DEF_GATEWAY_MAC
+	},
+	{ .name = "bakgw_ipaddr", .format = "<x.x.x.x>", .size = 4,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_BAK_GATEWAY_IP
+	},
+	{ .name = "bakgw_macaddr", .format = "<xx:xx:xx:xx:xx:xx>", .size = 6,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_BAK_GATEWAY_MAC
+	},
+	{ .name = "ip_header", .format = "<ttl> <flags> <tos>", .size = 3,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_IP_HEADER
+	},
+	{ .name = "arp_control", .format = "<on|off responses> <on|off gratuitous>",
+		.size = 1, .access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_BMC_ARP
+	},
+	{ .name = "arp_interval", .format = "<500ms units>", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_GRAT_ARP
+	},
+	{ .name = "snmp", .format = "<community string>", .size = 18,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_SNMP_STRING
+	},
+	{ .name = "vlan_id", .format = "{off|<id>}", .size = 2,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_VLAN_ID
+	},
+	{ .name = "vlan_priority", .format = "<priority>", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_VLAN_PRIORITY
+	},
+	{ .name = "auth", .format = "<callback> <user> <operator> <admin> <oem>",
+		.size = 5, .access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_AUTH_TYPE_ENABLE
+	},
+	{ .name = "cipher_privs", .format = "<privlevels>", .size = 9,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_RMCP_PRIV_LEVELS
+	},
+	{ .name = "bad_pass_thresh",
+		.format = "<thresh_num> <1|0> <reset_interval> <lockout_interval>",
+		.size = 6, .access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = IPMI_LANP_BAD_PASS_THRESH
+	}
+};
+
+static const struct valstr lan_cfgp_ipsrc_vals[] = {
+	{ 0, "none" },
+	{ 1, "static" },
+	{ 2, "dhcp" },
+	{ 3, "bios" },
+	{ 4, "other" },
+	{ 0xff, NULL }
+};
+
+/* auth type bits in each privilege level byte of parameter 2 */
+static const struct valstr lan_cfgp_auth_vals[] = {
+	{ 1 << IPMI_SESSION_AUTHTYPE_NONE, "none" },
+	{ 1 << IPMI_SESSION_AUTHTYPE_MD2, "md2" },
+	{ 1 << IPMI_SESSION_AUTHTYPE_MD5, "md5" },
+	{ 1 << IPMI_SESSION_AUTHTYPE_PASSWORD, "password" },
+	{ 1 << IPMI_SESSION_AUTHTYPE_OEM, "oem" },
+	{ 0x00, NULL }
+};
+
+/* lan_cfgp_onoff - parse an on/off flag, -1 if invalid */
+static int
+lan_cfgp_onoff(const char *arg)
+{
+	if (!strcmp(arg, "on")) {
+		return 1;
+	}
+	if (!strcmp(arg, "off")) {
+		return 0;
+	}
+	return -1;
+}
+
+/* lan_cfgp_parse_auth - parse a comma separated list of auth types,
+ * '-' for none enabled
+ */
+static int
+lan_cfgp_parse_auth(const char *arg, unsigned char *mask)
+{
+	char buf[64];
+	char *tok;
+	int i;
+
+	*mask = 0;
+	if (!strcmp(arg, "-")) {
+		return 0;
+	}
+
+	if (strlen(arg) >= sizeof(buf)) {
+		return -1;
+	}
+	strcpy(buf, arg);
+
+	for (tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+		for (i = 0; lan_cfgp_auth_vals[i].str; i++) {
+			if (!strcmp(tok, lan_cfgp_auth_vals[i].str)) {
+				break;
+			}
+		}
+		if (!lan_cfgp_auth_vals[i].str) {
+			lprintf(LOG_ERR, "Invalid authentication type: %s", tok);
+			return -1;
+		}
+		*mask |= lan_cfgp_auth_vals[i].val;
+	}
+
+	return 0;
+}
+
+static int
+lan_cfgp_parse(const struct ipmi_cfgp *p, int argc, const char **argv,
+		unsigned char *data)
+{
+	uint8_t buf[9];
+	uint16_t id;
+	int on[2];
+	int i;
+
+	if (argc == 0) {
+		return -1;
+	}
+
+	switch (p->specific) {
+	case IPMI_LANP_IP_ADDR_SRC:
+		for (i = 0; lan_cfgp_ipsrc_vals[i].str; i++) {
+			if (!strcmp(argv[0], lan_cfgp_ipsrc_vals[i].str)) {
+				break;
+			}
+		}
+		if (!lan_cfgp_ipsrc_vals[i].str) {
+			return -1;
+		}
+		data[0] = (data[0] & 0xf0) | lan_cfgp_ipsrc_vals[i].val;
+		break;
+
+	case IPMI_LANP_IP_ADDR:
+	case IPMI_LANP_SUBNET_MASK:
+	case IPMI_LANP_DEF_GATEWAY_IP:
+	case IPMI_LANP_BAK_GATEWAY_IP:
+		if (inet_pton(AF_INET, argv[0], data) != 1) {
+			return -1;
+		}
+		break;
+
+	case IPMI_LANP_MAC_ADDR:
+	case IPMI_LANP_DEF_GATEWAY_MAC:
+	case IPMI_LANP_BAK_GATEWAY_MAC:
+		return str2mac(argv[0], data);
+
+	case IPMI_LANP_IP_HEADER:
+		if (argc < 3) {
+			return -1;
+		}
+		for (i = 0; i < 3; i++) {
+			if (str2uchar(argv[i], &data[i])) {
+				return -1;
+			}
+		}
+		break;
+
+	case IPMI_LANP_BMC_ARP:
+		if (argc < 2) {
+			return -1;
+		}
+		on[0] = lan_cfgp_onoff(argv[0]);
+		on[1] = lan_cfgp_onoff(argv[1]);
+		if (on[0] < 0 || on[1] < 0) {
+			return -1;
+		}
+		data[0] = (data[0] & ~0x3) | (on[0] << 1) | on[1];
+		break;
+
+	case IPMI_LANP_GRAT_ARP:
+		return str2uchar(argv[0], &data[0]);
+
+	case IPMI_LANP_SNMP_STRING:
+		/* an empty community is saved as "" */
+		if (!strcmp(argv[0], "\"\"")) {
+			memset(data, 0, p->size);
+			break;
+		}
+		if (strlen(argv[0]) > p->size) {
+			return -1;
+		}
+		memset(data, 0, p->size);
+		memcpy(data, argv[0], strlen(argv[0]));
+		break;
+
+	case IPMI_LANP_VLAN_ID:
+		if (!strcmp(argv[0], "off")) {
+			data[1] &= ~0x80;
+			break;
+		}
+		if (str2ushort(argv[0], &id) || !IPMI_LANP_IS_VLAN_VALID(id)) {
+			return -1;
+		}
+		data[0] = id & 0xff;
+		data[1] = 0x80 | ((id >> 8) & 0x0f);
+		break;
+
+	case IPMI_LANP_VLAN_PRIORITY:
+		if (str2uchar(argv[0], &data[0]) || data[0] > 7) {
+			return -1;
+		}
+		break;
+
+	case IPMI_LANP_AUTH_TYPE_ENABLE:
+		if (argc < 5) {
+			return -1;
+		}
+		for (i = 0; i < 5; i++) {
+			if (lan_cfgp_parse_auth(argv[i], &data[i])) {
+				return -1;
+			}
+		}
+		break;
+
+	case IPMI_LANP_RMCP_PRIV_LEVELS:
+		if (get_cmdline_cipher_suite_priv_data((char *)argv[0], buf)) {
+			return -1;
+		}
+		/* the 16th nibble is not covered by the string, keep it */
+		buf[8] |= data[8] & 0xf0;
+		memcpy(data, buf, sizeof(buf));
+		break;
+
+	case IPMI_LANP_BAD_PASS_THRESH:
+		if (argc < 4) {
+			return -1;
+		}
+		return get_cmdline_bad_pass_thresh((char **)argv, data);
+
+	default:
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+lan_cfgp_save(const struct ipmi_cfgp *p, const unsigned char *data,
+		FILE *file)
+{
+	char addr[INET_ADDRSTRLEN];
+	const char *sep;
+	int i;
+	int j;
+
+	switch (p->specific) {
+	case IPMI_LANP_IP_ADDR_SRC:
+		fputs(val2str(data[0] & 0x0f, lan_cfgp_ipsrc_vals), file);
+		break;
+
+	case IPMI_LANP_IP_ADDR:
+	case IPMI_LANP_SUBNET_MASK:
+	case IPMI_LANP_DEF_GATEWAY_IP:
+	case IPMI_LANP_BAK_GATEWAY_IP:
+		fputs(inet_ntop(AF_INET, data, addr, sizeof(addr)), file);
+		break;
+
+	case IPMI_LANP_MAC_ADDR:
+	case IPMI_LANP_DEF_GATEWAY_MAC:
+	case IPMI_LANP_BAK_GATEWAY_MAC:
+		fputs(mac2str(data), file);
+		break;
+
+	case IPMI_LANP_IP_HEADER:
+		fprintf(file, "0x%02x 0x%02x 0x%02x", data[0], data[1], data[2]);
+		break;
+
+	case IPMI_LANP_BMC_ARP:
+		fprintf(file, "%s %s", (data[0] & 0x2) ? "on" : "off",
+			(data[0] & 0x1) ? "on" : "off");
+		break;
+
+	case IPMI_LANP_SNMP_STRING:
+		if (data[0]) {
+			fprintf(file, "%.*s", (int)p->size, (const char *)data);
+		} else {
+			fputs("\"\"", file);
+		}
+		break;
+
+	case IPMI_LANP_VLAN_ID:
+		if (data[1] & 0x80) {
+			fprintf(file, "%d", ((data[1] & 0x0f) << 8) | data[0]);
+		} else {
+			fputs("off", file);
+		}
+		break;
+
+	case IPMI_LANP_AUTH_TYPE_ENABLE:
+		for (i = 0; i < 5; i++) {
+			if (i) {
+				fputc(' ', file);
+			}
+			if (!(data[i] & 0x37)) {
+				fputc('-', file);
+				continue;
+			}
+			sep = "";
+			for (j = 0; lan_cfgp_auth_vals[j].str; j++) {
+				if (data[i] & lan_cfgp_auth_vals[j].val) {
+					fprintf(file, "%s%s", sep,
+						lan_cfgp_auth_vals[j].str);
+					sep = ",";
+				}
+			}
+		}
+		break;
+
+	case IPMI_LANP_RMCP_PRIV_LEVELS:
+		for (i = 0; i < 15; i++) {
+			fputc(priv_level_to_char((data[1 + i / 2] >> (4 * (i % 2)))
+					& 0x0f), file);
+		}
+		break;
+
+	case IPMI_LANP_BAD_PASS_THRESH:
+		fprintf(file, "%d %d %d %d", data[1], data[0] & 0x1,
+			data[2] | (data[3] << 8), data[4] | (data[5] << 8));
+		break;
+
+	default:
+		fprintf(file, "%d", data[0]);
+	}
+
+	return 0;
+}
+
+/* lan_cfgp_send - write a LAN parameter, returns the completion code
+ * or -1 if there is no response
+ */
+static int
+lan_cfgp_send(struct ipmi_lanp_priv *lp, int param,
+		const unsigned char *data, int len)
+{
+	struct ipmi_rs *rsp;
+	struct ipmi_rq req;
+	uint8_t msg_data[32];
+
+	msg_data[0] = lp->channel;
+	msg_data[1] = param;
+	memcpy(&msg_data[2], data, len);
+
+	memset(&req, 0, sizeof(req));
+	req.msg.netfn = IPMI_NETFN_TRANSPORT;
+	req.msg.cmd = IPMI_LAN_SET_CONFIG;
+	req.msg.data = msg_data;
+	req.msg.data_len = len + 2;
+
+	rsp = lp->intf->sendrecv(lp->intf, &req);
+	if (!rsp) {
+		return -1;
+	}
+
+	return rsp->ccode;
+}
+
+static int
+lan_cfgp_handler(void *priv, const struct ipmi_cfgp *p,
+		const struct ipmi_cfgp_action *action, unsigned char *data)
+{
+	struct ipmi_lanp_priv *lp = priv;
+	struct lan_param *lpar;
+	int rc;
+
+	switch (action->type) {
+	case CFGP_PARSE:
+		return lan_cfgp_parse(p, action->argc, action->argv, data);
+
+	case CFGP_GET:
+		lpar = get_lan_param(lp->intf, lp->channel, p->specific);
+		if (!lpar || !lpar->data || lpar->data_len <= 0) {
+			if (!action->quiet) {
+				lprintf(LOG_ERR, "Unable to get LAN parameter '%s'",
+					p->name);
+			}
+			return -1;
+		}
+		memcpy(data, lpar->data, __min((unsigned int)lpar->data_len,
+			p->size));
+		return 0;
+
+	case CFGP_SET:
+		rc = lan_cfgp_send(lp, p->specific, data, p->size);
+		if (rc != 0) {
+			lprintf(LOG_ERR, "Unable to set LAN parameter '%s': %s",
+				p->name, (rc < 0) ? "no response"
+				: specific_val2str(rc, set_lan_cc_vals,
+				                   completion_code_vals));
+			return -1;
+		}
+		return 0;
+
+	case CFGP_SAVE:
+		return lan_cfgp_save(p, data, action->file);
+
+	case CFGP_PRINT:
+		fprintf(action->file, "%-16s: ", p->name);
+		lan_cfgp_save(p, data, action->file);
+		fputc('\n', action->file);
+		return 0;
+
+	default:
+		return -1;
+	}
+}
+
+static int
+lan_cfgp_progress(void *priv, int state)
+{
+	unsigned char val = state;
+	int rc;
+
+	rc = lan_cfgp_send(priv, IPMI_LANP_SET_IN_PROGRESS, &val, 1);
+	if (rc == 0x80) {
+		/* Set In Progress is optional */
+		return 1;
+	}
+	if (rc != 0) {
+		lprintf(LOG_ERR, "Unable to set LAN Set In Progress to %d: %s",
+			state, (rc < 0) ? "no response"
+			: specific_val2str(rc, set_lan_cc_vals,
+			                   completion_code_vals));
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+lan_cfgp_open(struct ipmi_intf *intf, int channel, void *priv)
+{
+	struct ipmi_lanp_priv *lp = priv;
+
+	if (!is_lan_channel(intf, channel)) {
+		lprintf(LOG_ERR, "Channel %d is not a LAN channel", channel);
+		return -1;
+	}
+
+	lp->intf = intf;
+	lp->channel = channel;
+
+	return 0;
+}
+
+const struct ipmi_cfgp_class ipmi_lan_cfgp_class = {
+	.name = "lan",
+	.set = lan_cfgp,
+	.count = ARRAY_SIZE(lan_cfgp),
+	.handler = lan_cfgp_handler,
+	.progress = lan_cfgp_progress,
+	.priv_size = sizeof(struct ipmi_lanp_priv),
+	.open = lan_cfgp_open
+};
+
 /*
  * print_lan_usage
  */
@@ -2485,6 +3445,10 @@ print_lan_usage(void)
 	lprintf(LOG_NOTICE,
 "		   alert set <channel number> <alert destination> <command> <parameter>");
 	lprintf(LOG_NOTICE,
+"		   snapshot save [<channel number>] [<file>]");
+	lprintf(LOG_NOTICE,
+"		   snapshot print <file>");
+	lprintf(LOG_NOTICE,
 "		   stats get [<channel number>]");
 	lprintf(LOG_NOTICE,
 "		   stats clear [<channel number>]");
@@ -2528,6 +3492,8 @@ ipmi_lanp_main(struct ipmi_intf *intf, int argc, char **argv)
 		rc = ipmi_lan_set(intf, argc-1, &(argv[1]));
 	} else if (!strcmp(argv[0], "alert")) {
 		rc = ipmi_lan_alert(intf, argc-1, &(argv[1]));
+	} else if (!strcmp(argv[0], "snapshot")) {
+		rc = ipmi_lan_snapshot(intf, argc-1, &(argv[1]));
 	} else if (!strcmp(argv[0], "stats")) {
 		if (argc < 2) {
 			print_lan_usage();
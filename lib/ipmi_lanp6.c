@@ -53,6 +53,7 @@ enum {
 	LANP_CMD_COMMIT,
 	LANP_CMD_DISCARD,
 	LANP_CMD_HELP,
+	LANP_CMD_APPLY,
 	LANP_CMD_ANY = 0xFF
 };
 
@@ -189,6 +190,7 @@ const struct valstr ip6_command_vals[] = {
 	{ LANP_CMD_COMMIT,	"commit" },
 	{ LANP_CMD_DISCARD,	"discard" },
 	{ LANP_CMD_HELP,	"help" },
+	{ LANP_CMD_APPLY,	"apply" },
 	{ LANP_CMD_ANY,		NULL }
 };
 
@@ -739,7 +741,7 @@ lanp_save_cfgp(const struct ipmi_cfgp *p, const unsigned char *data, FILE *file)
 		break;
 
 	case IPMI_LANP_IP6_FLOW_LABEL:
-		fprintf(file, "0x%xd", (data[0] << 16 ) | (data[1] << 8) | data[2]);
+		fprintf(file, "0x%x", (data[0] << 16 ) | (data[1] << 8) | data[2]);
 		break;
 
 	case IPMI_LANP_IP6_STATUS:
@@ -1012,6 +1014,9 @@ static void lanp_print_usage(int cmd)
 	if (cmd == LANP_CMD_ANY || cmd == LANP_CMD_PRINT) {
 		printf("  print <channel> [<parameter> [<set_sel> [<block_sel>]]]\n");
 	}
+	if (cmd == LANP_CMD_ANY || cmd == LANP_CMD_APPLY) {
+		printf("  apply <channel> <file>\n");
+	}
 	if (cmd == LANP_CMD_ANY || cmd == LANP_CMD_LOCK) {
 		printf("  lock <channel>\n");
 	}
@@ -1061,6 +1066,139 @@ lanp_commit(struct ipmi_lanp_priv *lp)
 	return ret;
 }
 
+static int
+lanp_progress(void *priv, int state)
+{
+	unsigned char byte = state;
+
+	return ipmi_set_lanp(priv, 0, &byte);
+}
+
+static int
+lanp_open(struct ipmi_intf *intf, int channel, void *priv)
+{
+	struct ipmi_lanp_priv *lp = priv;
+
+	lp->intf = intf;
+	lp->channel = channel;
+
+	return 0;
+}
+
+/*
+ * IPv6 LAN parameters for 'config save' and 'config apply'.
+ */
+const struct ipmi_cfgp_class ipmi_lan6_cfgp_class = {
+	.name = "lan6",
+	.set = lan_cfgp,
+	.count = ARRAY_SIZE(lan_cfgp),
+	.handler = lanp_ip6_cfgp,
+	.progress = lanp_progress,
+	.priv_size = sizeof(struct ipmi_lanp_priv),
+	.open = lanp_open
+};
+
+/*
+ * Apply a file written by 'lan6 save', or holding plain
+ * '<parameter> [<set_sel> [<block_sel>]] <values...>' lines, to a channel.
+ * Every parameter is compared with the value in the BMC and only the
+ * ones that differ are written, all within one set-in-progress lock.
+ */
+static int
+lanp_apply(struct ipmi_cfgp_ctx *ctx, const char *name)
+{
+	struct ipmi_cfgp_sel sel;
+	char line[512];
+	char *argv[32];
+	char *tok;
+	FILE *fp;
+	int argc;
+	int lineno = 0;
+	int total = 0;
+	int changed = 0;
+	int ret = 0;
+	int n;
+
+	fp = ipmi_open_file_read(name);
+	if (!fp) {
+		return -1;
+	}
+
+	lprintf(LOG_NOTICE, "Comparing parameter(s)...");
+
+	while (fgets(line, sizeof(line), fp)) {
+		lineno++;
+		argc = 0;
+		for (tok = strtok(line, " \t\r\n"); tok && argc < (int)ARRAY_SIZE(argv);
+		     tok = strtok(NULL, " \t\r\n")) {
+			argv[argc++] = tok;
+		}
+
+		if (argc == 0 || argv[0][0] == '#' || !strcmp(argv[0], "exit")) {
+			continue;
+		}
+
+		n = 0;
+		if (!strcmp(argv[0], "lan6")) {
+			if (argc > 1 && (!strcmp(argv[1], "lock")
+					|| !strcmp(argv[1], "commit")
+					|| !strcmp(argv[1], "discard"))) {
+				continue;
+			}
+			if (argc < 3 || strcmp(argv[1], "set")) {
+				lprintf(LOG_ERR, "%s:%d: unexpected command",
+					name, lineno);
+				ret = -1;
+				break;
+			}
+			/* the channel comes from the command line */
+			n = 3;
+			if (n < argc && !strcasecmp(argv[n], "nolock")) {
+				n++;
+			}
+		}
+
+		ret = ipmi_cfgp_parse_sel(ctx, argc - n,
+			(const char **)argv + n, &sel);
+		if (ret > 0) {
+			n += ret;
+			ret = ipmi_cfgp_parse_diff(ctx, &sel, argc - n,
+				(const char **)argv + n);
+		} else if (ret == 0) {
+			ret = -1;
+		}
+		if (ret < 0) {
+			lprintf(LOG_ERR, "%s:%d: invalid parameter line",
+				name, lineno);
+			break;
+		}
+
+		total++;
+		changed += ret;
+		ret = 0;
+	}
+
+	fclose(fp);
+
+	if (ret != 0) {
+		return ret;
+	}
+
+	if (changed == 0) {
+		printf("%d parameter(s) already up to date\n", total);
+		return 0;
+	}
+
+	lprintf(LOG_NOTICE, "Setting %d parameter(s)...", changed);
+
+	ret = ipmi_cfgp_write(ctx, lanp_progress);
+	if (ret == 0) {
+		printf("%d of %d parameter(s) changed\n", changed, total);
+	}
+
+	return ret;
+}
+
 int
 ipmi_lan6_main(struct ipmi_intf *intf, int argc, char **argv)
 {
@@ -1158,9 +1296,22 @@ ipmi_lan6_main(struct ipmi_intf *intf, int argc, char **argv)
 	 * initialize configuration context and parse parameter selection
 	 */
 
-	ipmi_cfgp_init(&ctx, lan_cfgp,
-	               ARRAY_SIZE(lan_cfgp), "lan6 set nolock",
-	               lanp_ip6_cfgp, &lp);
+	if (ipmi_cfgp_init(&ctx, lan_cfgp,
+	                   ARRAY_SIZE(lan_cfgp), "lan6 set nolock",
+	                   lanp_ip6_cfgp, &lp)) {
+		return -1;
+	}
+
+	if (cmd == LANP_CMD_APPLY) {
+		if (argc != 1) {
+			lanp_print_usage(cmd);
+			ret = -1;
+		} else {
+			ret = lanp_apply(&ctx, argv[0]);
+		}
+		ipmi_cfgp_uninit(&ctx);
+		return ret;
+	}
 
 	ret = ipmi_cfgp_parse_sel(&ctx, argc, (const char **)argv, &sel);
 	if (ret == -1) {
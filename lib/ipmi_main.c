@@ -73,6 +73,8 @@
 #include <ipmitool/ipmi_kontronoem.h>
 #include <ipmitool/ipmi_vita.h>
 #include <ipmitool/ipmi_quantaoem.h>
+#include <ipmitool/ipmi_trace.h>
+#include <ipmitool/ipmi_stats.h>
 
 #ifdef HAVE_CONFIG_H
 # include <config.h>
@@ -852,6 +854,21 @@ ipmi_main(int argc, char ** argv,
 		goto out_free;
 	}
 
+	/* record all transactions if requested */
+	if (getenv("IPMI_RECORD")
+	    && ipmi_trace_record_start(ipmi_main_intf, getenv("IPMI_RECORD")))
+	{
+		goto out_free;
+	}
+
+	/* collect per command statistics if requested */
+	if (getenv("IPMI_STATS")
+	    && ipmi_stats_start(ipmi_main_intf, getenv("IPMI_STATS"),
+	                        getenv("IPMI_STATS_FILE")))
+	{
+		goto out_free;
+	}
+
 	/* load the IANA PEN registry */
 	ipmi_oem_info_init();
 
@@ -1039,6 +1056,11 @@ ipmi_main(int argc, char ** argv,
 		ipmi_main_intf->close(ipmi_main_intf);
 
 	out_free:
+	if (ipmi_main_intf) {
+		ipmi_stats_stop(ipmi_main_intf);
+		ipmi_trace_record_stop(ipmi_main_intf);
+	}
+
 	log_halt();
 
 	if (intfname) {
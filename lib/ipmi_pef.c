@@ -30,6 +30,7 @@
  * EVEN IF DELL HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <time.h>
@@ -37,6 +38,7 @@
 #include <ipmitool/bswap.h>
 #include <ipmitool/helper.h>
 #include <ipmitool/ipmi.h>
+#include <ipmitool/ipmi_cfgp.h>
 #include <ipmitool/ipmi_channel.h>
 #include <ipmitool/ipmi_intf.h>
 #include <ipmitool/ipmi_mc.h>
@@ -903,6 +905,638 @@ _ipmi_set_pef_policy_entry(struct ipmi_intf *intf, uint8_t policy_id,
 	return 0;
 }
 
+/*
+// in-memory copy of the PEF configuration: event filter and alert policy
+// tables, PEF control parameters, alert strings and the alert destinations
+// of the LAN and serial channels
+*/
+#define PEF_SNAP_MAX_ENTRIES 128	/* 7 bit filter, policy and string IDs */
+#define PEF_SNAP_MAX_CHAN 16
+#define PEF_SNAP_LAST_CHAN 0x0b		/* 0x0c-0x0f are reserved or aliases */
+#define PEF_SNAP_MAX_DEST 16		/* 4 bit destination selectors */
+#define PEF_SNAP_BLOCK 16		/* strings are read in 16 byte blocks */
+#define PEF_SNAP_STRING_BLOCKS 8
+#define PEF_SNAP_DIAL_BLOCKS 6
+#define PEF_SNAP_HEADER "# ipmitool pef snapshot 2"
+#define PEF_SNAP_FILTERS 0x1
+#define PEF_SNAP_POLICIES 0x2
+#define PEF_SNAP_CONTROL 0x4
+#define PEF_SNAP_STRINGS 0x8
+#define PEF_SNAP_DESTS 0x10
+#define PEF_SNAP_ALL 0x1f
+
+enum {
+	PEF_SNAP_UNREAD = 0,
+	PEF_SNAP_OK,
+	PEF_SNAP_FAILED
+};
+
+/* snapshot line kinds, in pef_snap_kinds order */
+enum {
+	PEF_SNAP_K_FILTER = 0,
+	PEF_SNAP_K_POLICY,
+	PEF_SNAP_K_CONTROL,
+	PEF_SNAP_K_ACTION,
+	PEF_SNAP_K_STARTUP_DELAY,
+	PEF_SNAP_K_ALERT_STARTUP_DELAY,
+	PEF_SNAP_K_SYSTEM_GUID,
+	PEF_SNAP_K_STRING_KEY,
+	PEF_SNAP_K_STRING,
+	PEF_SNAP_K_LAN_DEST_TYPE,
+	PEF_SNAP_K_LAN_DEST_ADDR,
+	PEF_SNAP_K_SERIAL_DEST,
+	PEF_SNAP_K_DIAL_STRING,
+	PEF_SNAP_K_TAP_ACCOUNT,
+	PEF_SNAP_K_TAP_SERVICE,
+	PEF_SNAP_NKINDS
+};
+#define PEF_SNAP_NPARAMS (PEF_SNAP_K_SYSTEM_GUID - PEF_SNAP_K_CONTROL + 1)
+
+/* "<name> [<channel>] [<selector>] <hex>" lines of a saved snapshot */
+static const struct {
+	const char *name;
+	uint8_t medium;		/* 0 for PEF, else the channel medium */
+	uint8_t id;
+	uint8_t set;		/* has a set selector */
+	uint8_t string;		/* NUL terminated, written in blocks */
+	uint8_t len;		/* data length, maximum for a string */
+} pef_snap_kinds[PEF_SNAP_NKINDS] = {
+	{ "filter", 0, PEF_CFGPARM_ID_PEF_FILTER_TABLE_ENTRY, 1, 0,
+	  sizeof(struct pef_table_entry) },
+	{ "policy", 0, PEF_CFGPARM_ID_PEF_ALERT_POLICY_TABLE_ENTRY, 1, 0,
+	  sizeof(struct pef_policy_entry) },
+	{ "control", 0, PEF_CFGPARM_ID_PEF_CONTROL, 0, 0, 1 },
+	{ "action", 0, PEF_CFGPARM_ID_PEF_ACTION, 0, 0, 1 },
+	{ "startup_delay", 0, PEF_CFGPARM_ID_PEF_STARTUP_DELAY, 0, 0, 1 },
+	{ "alert_startup_delay", 0, PEF_CFGPARM_ID_PEF_ALERT_STARTUP_DELAY,
+	  0, 0, 1 },
+	{ "system_guid", 0, PEF_CFGPARM_ID_SYSTEM_GUID, 0, 0, 17 },
+	{ "string_key", 0, PEF_CFGPARM_ID_PEF_ALERT_STRING_KEY, 1, 0, 2 },
+	{ "string", 0, PEF_CFGPARM_ID_PEF_ALERT_STRING_TABLE_ENTRY, 1, 1,
+	  PEF_SNAP_STRING_BLOCKS * PEF_SNAP_BLOCK },
+	{ "lan_dest_type", PEF_CH_MEDIUM_TYPE_LAN,
+	  PEF_LAN_CFGPARM_ID_DESTTYPE, 1, 0,
+	  sizeof(struct pef_lan_cfgparm_dest_type) - 1 },
+	{ "lan_dest_addr", PEF_CH_MEDIUM_TYPE_LAN,
+	  PEF_LAN_CFGPARM_ID_DESTADDR, 1, 0,
+	  sizeof(struct pef_lan_cfgparm_dest_info) - 1 },
+	{ "serial_dest", PEF_CH_MEDIUM_TYPE_SERIAL,
+	  PEF_SERIAL_CFGPARM_ID_DESTINFO, 1, 0,
+	  sizeof(struct pef_serial_cfgparm_dest_info) - 1 },
+	{ "dial_string", PEF_CH_MEDIUM_TYPE_SERIAL,
+	  PEF_SERIAL_CFGPARM_ID_DEST_DIAL_STRING, 1, 1,
+	  PEF_SNAP_DIAL_BLOCKS * PEF_SNAP_BLOCK },
+	{ "tap_account", PEF_CH_MEDIUM_TYPE_SERIAL,
+	  PEF_SERIAL_CFGPARM_ID_TAP_ACCT_INFO, 1, 0,
+	  sizeof(struct pef_serial_cfgparm_tap_acct_info) - 1 },
+	{ "tap_service", PEF_CH_MEDIUM_TYPE_SERIAL,
+	  PEF_SERIAL_CFGPARM_ID_TAP_SVC_SETTINGS, 1, 0,
+	  sizeof(struct pef_serial_cfgparm_tap_svc_settings) - 1 },
+};
+
+/* alert destinations of a LAN or serial channel, indexed by selector */
+struct pef_snap_dests {
+	uint8_t state;
+	uint8_t medium;
+	uint8_t ndests;
+	uint8_t ndials;
+	uint8_t ntaps;
+	uint16_t svc_read;	/* TAP service settings read, by selector */
+	/* per entry: 0 or the error of the read */
+	int dest_rc[PEF_SNAP_MAX_DEST];
+	int addr_rc[PEF_SNAP_MAX_DEST];
+	int dial_rc[PEF_SNAP_MAX_DEST];
+	int tap_rc[PEF_SNAP_MAX_DEST];
+	int svc_rc[PEF_SNAP_MAX_DEST];
+	struct pef_lan_cfgparm_dest_type lan_type[PEF_SNAP_MAX_DEST];
+	struct pef_lan_cfgparm_dest_info lan_addr[PEF_SNAP_MAX_DEST];
+	struct pef_serial_cfgparm_dest_info serial[PEF_SNAP_MAX_DEST];
+	char dial[PEF_SNAP_MAX_DEST][PEF_SNAP_DIAL_BLOCKS * PEF_SNAP_BLOCK + 1];
+	struct pef_serial_cfgparm_tap_acct_info tap[PEF_SNAP_MAX_DEST];
+	struct pef_serial_cfgparm_tap_svc_settings svc[PEF_SNAP_MAX_DEST];
+};
+
+struct pef_snapshot {
+	uint8_t nfilters;
+	uint8_t npolicies;
+	uint8_t nstrings;
+	/* per entry, indexed by ID - 1: 0 or the error of the read */
+	int filter_rc[PEF_SNAP_MAX_ENTRIES];
+	int policy_rc[PEF_SNAP_MAX_ENTRIES];
+	struct pef_cfgparm_filter_table_entry filter[PEF_SNAP_MAX_ENTRIES];
+	struct pef_cfgparm_policy_table_entry policy[PEF_SNAP_MAX_ENTRIES];
+	/* control parameters, in pef_snap_kinds order */
+	int param_rc[PEF_SNAP_NPARAMS];
+	uint8_t param[PEF_SNAP_NPARAMS][17];
+	/* alert strings, indexed by selector; 0 is the volatile string */
+	int string_rc[PEF_SNAP_MAX_ENTRIES];
+	uint8_t string_key[PEF_SNAP_MAX_ENTRIES][3];
+	char string[PEF_SNAP_MAX_ENTRIES][PEF_SNAP_STRING_BLOCKS * PEF_SNAP_BLOCK + 1];
+	/* per channel, read on first use */
+	uint8_t chan_state[PEF_SNAP_MAX_CHAN];
+	struct channel_info_t chan[PEF_SNAP_MAX_CHAN];
+	uint8_t community_state[PEF_SNAP_MAX_CHAN];
+	char community[PEF_SNAP_MAX_CHAN][19];
+	struct pef_snap_dests dests[PEF_SNAP_MAX_CHAN];
+};
+
+/* pef_snap_get - read a PEF parameter, or a LAN or serial parameter of a
+ * channel, without reporting errors
+ *
+ * @medium - 0 for PEF, else PEF_CH_MEDIUM_TYPE_LAN or _SERIAL
+ * @data - receives the parameter data following the revision byte,
+ *         zero padded to @len
+ *
+ * returns - negative number means error, positive is a ccode.
+ */
+static int
+pef_snap_get(struct ipmi_intf *intf, uint8_t medium, uint8_t ch,
+		uint8_t id, uint8_t set, uint8_t block, void *data, int len)
+{
+	struct ipmi_rs *rsp;
+	struct ipmi_rq req;
+	uint8_t rqdata[4];
+	int n = 0;
+
+	memset(&req, 0, sizeof(req));
+	if (medium) {
+		req.msg.netfn = IPMI_NETFN_TRANSPORT;
+		req.msg.cmd = (medium == PEF_CH_MEDIUM_TYPE_LAN)
+			? IPMI_CMD_LAN_GET_CONFIG : IPMI_CMD_SERIAL_GET_CONFIG;
+		rqdata[n++] = ch;
+	} else {
+		req.msg.netfn = IPMI_NETFN_SE;
+		req.msg.cmd = IPMI_CMD_GET_PEF_CONFIG_PARMS;
+	}
+	rqdata[n++] = id;
+	rqdata[n++] = set;
+	rqdata[n++] = block;
+	req.msg.data = rqdata;
+	req.msg.data_len = n;
+
+	rsp = intf->sendrecv(intf, &req);
+	if (!rsp) {
+		return (-1);
+	} else if (rsp->ccode) {
+		return rsp->ccode;
+	} else if (rsp->data_len < 2) {
+		return (-1);
+	}
+	memset(data, 0, len);
+	memcpy(data, &rsp->data[1], __min(rsp->data_len - 1, len));
+	return 0;
+}
+
+/* pef_snap_set - write a PEF parameter, or a LAN or serial parameter of a
+ * channel; @data starts with the set selector of parameters that have one
+ *
+ * returns - negative number means error, positive is a ccode.
+ */
+static int
+pef_snap_set(struct ipmi_intf *intf, uint8_t medium, uint8_t ch,
+		uint8_t id, const void *data, int len)
+{
+	struct ipmi_rs *rsp;
+	struct ipmi_rq req;
+	uint8_t rqdata[2 + 32];
+	int n = 0;
+
+	if (len > 32) {
+		return (-1);
+	}
+	memset(&req, 0, sizeof(req));
+	if (medium) {
+		req.msg.netfn = IPMI_NETFN_TRANSPORT;
+		req.msg.cmd = (medium == PEF_CH_MEDIUM_TYPE_LAN)
+			? IPMI_CMD_LAN_SET_CONFIG : IPMI_CMD_SERIAL_SET_CONFIG;
+		rqdata[n++] = ch;
+	} else {
+		req.msg.netfn = IPMI_NETFN_SE;
+		req.msg.cmd = IPMI_CMD_SET_PEF_CONFIG_PARMS;
+	}
+	rqdata[n++] = id;
+	memcpy(&rqdata[n], data, len);
+	req.msg.data = rqdata;
+	req.msg.data_len = n + len;
+
+	rsp = intf->sendrecv(intf, &req);
+	if (!rsp) {
+		return (-1);
+	} else if (rsp->ccode) {
+		return rsp->ccode;
+	}
+	return 0;
+}
+
+/* pef_snap_progress - Sets the Set In Progress parameter of PEF, or of the
+ * LAN or serial parameters of a channel.
+ *
+ * @state - 0 set complete, 1 set in progress, 2 commit write
+ *
+ * returns - negative number means error, positive is a ccode.
+ */
+static int
+pef_snap_progress(struct ipmi_intf *intf, uint8_t medium, uint8_t ch,
+		uint8_t state)
+{
+	return pef_snap_set(intf, medium, ch, PEF_CFGPARM_ID_SET_IN_PROGRESS,
+			&state, 1);
+}
+
+/* pef_snap_get_string - read a string parameter block by block, up to the
+ * block that holds its terminating NUL
+ */
+static int
+pef_snap_get_string(struct ipmi_intf *intf, uint8_t medium, uint8_t ch,
+		uint8_t id, uint8_t set, char *str, int blocks)
+{
+	uint8_t buf[2 + PEF_SNAP_BLOCK];
+	int block;
+	int rc;
+
+	memset(str, 0, blocks * PEF_SNAP_BLOCK + 1);
+	for (block = 1; block <= blocks; block++) {
+		rc = pef_snap_get(intf, medium, ch, id, set, block,
+				buf, sizeof(buf));
+		if (rc != 0) {
+			return rc;
+		} else if ((buf[0] & 0x7f) != set || buf[1] != block) {
+			return (-1);
+		}
+		memcpy(&str[(block - 1) * PEF_SNAP_BLOCK], &buf[2],
+		       PEF_SNAP_BLOCK);
+		if (memchr(&buf[2], '\0', PEF_SNAP_BLOCK)) {
+			break;
+		}
+	}
+	return 0;
+}
+
+/* pef_snap_channel - channel info of a policy channel, read once */
+static const struct channel_info_t *
+pef_snap_channel(struct ipmi_intf *intf, struct pef_snapshot *snap,
+		uint8_t ch)
+{
+	ch &= PEF_SNAP_MAX_CHAN - 1;
+	if (snap->chan_state[ch] == PEF_SNAP_UNREAD) {
+		snap->chan[ch].channel = ch;
+		if (eval_ccode(_ipmi_get_channel_info(intf, &snap->chan[ch])) != 0) {
+			snap->chan_state[ch] = PEF_SNAP_FAILED;
+		} else {
+			snap->chan_state[ch] = PEF_SNAP_OK;
+		}
+	}
+	return (snap->chan_state[ch] == PEF_SNAP_OK) ? &snap->chan[ch] : NULL;
+}
+
+/* pef_snap_community - PET community of a LAN channel, read once */
+static const char *
+pef_snap_community(struct ipmi_intf *intf, struct pef_snapshot *snap,
+		uint8_t ch)
+{
+	struct ipmi_rs *rsp;
+	struct ipmi_rq req;
+	struct pef_lan_cfgparm_selector lsel;
+
+	ch &= PEF_SNAP_MAX_CHAN - 1;
+	if (snap->community_state[ch] == PEF_SNAP_UNREAD) {
+		memset(&lsel, 0, sizeof(lsel));
+		lsel.id = PEF_LAN_CFGPARM_ID_PET_COMMUNITY;
+		lsel.ch = ch;
+		memset(&req, 0, sizeof(req));
+		req.msg.netfn = IPMI_NETFN_TRANSPORT;
+		req.msg.cmd = IPMI_CMD_LAN_GET_CONFIG;
+		req.msg.data = (uint8_t *)&lsel;
+		req.msg.data_len = sizeof(lsel);
+		rsp = ipmi_pef_msg_exchange(intf, &req, "PET community");
+		if (!rsp || rsp->data_len < 2) {
+			snap->community_state[ch] = PEF_SNAP_FAILED;
+		} else {
+			memcpy(snap->community[ch], &rsp->data[1],
+			       __min(rsp->data_len - 1,
+			             (int)sizeof(snap->community[ch]) - 1));
+			snap->community_state[ch] = PEF_SNAP_OK;
+		}
+	}
+	return (snap->community_state[ch] == PEF_SNAP_OK)
+		? snap->community[ch] : NULL;
+}
+
+/* pef_snap_lan_dests - read the alert destination table of a LAN channel */
+static int
+pef_snap_lan_dests(struct ipmi_intf *intf, struct pef_snap_dests *d,
+		uint8_t ch)
+{
+	uint8_t i;
+
+	if (pef_snap_get(intf, PEF_CH_MEDIUM_TYPE_LAN, ch,
+			PEF_LAN_CFGPARM_ID_DEST_COUNT, 0, 0,
+			&d->ndests, 1) != 0) {
+		return (-1);
+	}
+	d->ndests &= PEF_LAN_DEST_TABLE_SIZE_MASK;
+	for (i = 0; i <= d->ndests; i++) {
+		d->dest_rc[i] = pef_snap_get(intf, PEF_CH_MEDIUM_TYPE_LAN, ch,
+				PEF_LAN_CFGPARM_ID_DESTTYPE, i, 0,
+				&d->lan_type[i], sizeof(d->lan_type[i]));
+		if (d->dest_rc[i] == 0 && (d->lan_type[i].dest
+				& PEF_LAN_DEST_TYPE_ID_MASK) != i) {
+			d->dest_rc[i] = (-1);
+		}
+		d->addr_rc[i] = pef_snap_get(intf, PEF_CH_MEDIUM_TYPE_LAN, ch,
+				PEF_LAN_CFGPARM_ID_DESTADDR, i, 0,
+				&d->lan_addr[i], sizeof(d->lan_addr[i]));
+		if (d->addr_rc[i] == 0 && (d->lan_addr[i].dest
+				& PEF_LAN_DEST_MASK) != i) {
+			d->addr_rc[i] = (-1);
+		}
+	}
+	return 0;
+}
+
+/* pef_snap_serial_dests - read the alert destination table of a serial
+ * channel, with the dial strings and TAP accounts the destinations use
+ */
+static int
+pef_snap_serial_dests(struct ipmi_intf *intf, struct pef_snap_dests *d,
+		uint8_t ch)
+{
+	uint8_t i;
+	uint8_t svc;
+
+	if (pef_snap_get(intf, PEF_CH_MEDIUM_TYPE_SERIAL, ch,
+			PEF_SERIAL_CFGPARM_ID_DEST_COUNT, 0, 0,
+			&d->ndests, 1) != 0) {
+		return (-1);
+	}
+	d->ndests &= PEF_SERIAL_DEST_TABLE_SIZE_MASK;
+	for (i = 0; i <= d->ndests; i++) {
+		d->dest_rc[i] = pef_snap_get(intf, PEF_CH_MEDIUM_TYPE_SERIAL,
+				ch, PEF_SERIAL_CFGPARM_ID_DESTINFO, i, 0,
+				&d->serial[i], sizeof(d->serial[i]));
+		if (d->dest_rc[i] == 0 && (d->serial[i].dest
+				& PEF_SERIAL_DEST_MASK) != i) {
+			d->dest_rc[i] = (-1);
+		}
+	}
+
+	/* dial strings and TAP accounts are optional */
+	if (pef_snap_get(intf, PEF_CH_MEDIUM_TYPE_SERIAL, ch,
+			PEF_SERIAL_CFGPARM_ID_DEST_DIAL_STRING_COUNT, 0, 0,
+			&d->ndials, 1) != 0) {
+		d->ndials = 0;
+	}
+	d->ndials &= PEF_SERIAL_DIAL_STRING_COUNT_MASK;
+	for (i = 1; i <= d->ndials; i++) {
+		d->dial_rc[i] = pef_snap_get_string(intf,
+				PEF_CH_MEDIUM_TYPE_SERIAL, ch,
+				PEF_SERIAL_CFGPARM_ID_DEST_DIAL_STRING, i,
+				d->dial[i], PEF_SNAP_DIAL_BLOCKS);
+	}
+
+	if (pef_snap_get(intf, PEF_CH_MEDIUM_TYPE_SERIAL, ch,
+			PEF_SERIAL_CFGPARM_ID_TAP_ACCT_COUNT, 0, 0,
+			&d->ntaps, 1) != 0) {
+		d->ntaps = 0;
+	}
+	d->ntaps &= PEF_SERIAL_TAP_ACCT_COUNT_MASK;
+	for (i = 1; i <= d->ntaps; i++) {
+		d->tap_rc[i] = pef_snap_get(intf, PEF_CH_MEDIUM_TYPE_SERIAL,
+				ch, PEF_SERIAL_CFGPARM_ID_TAP_ACCT_INFO, i, 0,
+				&d->tap[i], sizeof(d->tap[i]));
+		if (d->tap_rc[i] != 0) {
+			continue;
+		} else if (d->tap[i].data1 != i) {
+			d->tap_rc[i] = (-1);
+			continue;
+		}
+		svc = d->tap[i].data2
+			& PEF_SERIAL_TAP_ACCT_INFO_SVC_SETTINGS_ID_MASK;
+		if (d->svc_read & (1 << svc)) {
+			continue;
+		}
+		d->svc_read |= 1 << svc;
+		d->svc_rc[svc] = pef_snap_get(intf, PEF_CH_MEDIUM_TYPE_SERIAL,
+				ch, PEF_SERIAL_CFGPARM_ID_TAP_SVC_SETTINGS, svc, 0,
+				&d->svc[svc], sizeof(d->svc[svc]));
+		if (d->svc_rc[svc] == 0 && d->svc[svc].data1 != svc) {
+			d->svc_rc[svc] = (-1);
+		}
+	}
+	return 0;
+}
+
+/* pef_snap_dests - alert destinations of a LAN or serial channel, read
+ * once; NULL if the channel has none or they can't be read
+ */
+static const struct pef_snap_dests *
+pef_snap_dests(struct ipmi_intf *intf, struct pef_snapshot *snap,
+		uint8_t ch)
+{
+	const struct channel_info_t *chinfo;
+	struct pef_snap_dests *d;
+	int rc = (-1);
+
+	ch &= PEF_SNAP_MAX_CHAN - 1;
+	d = &snap->dests[ch];
+	if (d->state == PEF_SNAP_UNREAD) {
+		chinfo = pef_snap_channel(intf, snap, ch);
+		d->medium = chinfo ? chinfo->medium : 0;
+		if (d->medium == PEF_CH_MEDIUM_TYPE_LAN) {
+			rc = pef_snap_lan_dests(intf, d, ch);
+		} else if (d->medium == PEF_CH_MEDIUM_TYPE_SERIAL) {
+			rc = pef_snap_serial_dests(intf, d, ch);
+		}
+		d->state = (rc == 0) ? PEF_SNAP_OK : PEF_SNAP_FAILED;
+	}
+	return (d->state == PEF_SNAP_OK) ? d : NULL;
+}
+
+/* pef_snap_read - read the parts of the PEF configuration in one pass
+ *
+ * @what - PEF_SNAP_* flags, PEF_SNAP_ALL for everything a snapshot holds
+ *
+ * returns - snapshot to be freed by the caller, NULL on error.
+ */
+static struct pef_snapshot *
+pef_snap_read(struct ipmi_intf *intf, int what)
+{
+	struct pef_capabilities pcap;
+	struct pef_snapshot *snap;
+	int rc;
+	uint8_t i;
+
+	snap = calloc(1, sizeof(*snap));
+	if (!snap) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		return NULL;
+	}
+
+	if (what & PEF_SNAP_FILTERS) {
+		rc = _ipmi_get_pef_capabilities(intf, &pcap);
+		if (eval_ccode(rc) != 0) {
+			goto fail;
+		} else if (pcap.event_filter_count == 0) {
+			lprintf(LOG_ERR, "PEF Event Filtering isn't supported.");
+			goto fail;
+		}
+		snap->nfilters = __min(pcap.event_filter_count,
+		                       PEF_SNAP_MAX_ENTRIES - 1);
+		for (i = 1; i <= snap->nfilters; i++) {
+			snap->filter_rc[i - 1] = _ipmi_get_pef_filter_entry(intf,
+					i, &snap->filter[i - 1]);
+		}
+	}
+
+	if (what & PEF_SNAP_POLICIES) {
+		rc = _ipmi_get_pef_policy_table_size(intf, &snap->npolicies);
+		if (eval_ccode(rc) != 0) {
+			goto fail;
+		} else if (snap->npolicies == 0) {
+			lprintf(LOG_ERR, "PEF Alert Policy isn't supported.");
+			goto fail;
+		}
+		for (i = 1; i <= snap->npolicies; i++) {
+			snap->policy_rc[i - 1] = _ipmi_get_pef_policy_entry(intf,
+					i, &snap->policy[i - 1]);
+		}
+	}
+
+	if (what & PEF_SNAP_CONTROL) {
+		for (i = 0; i < PEF_SNAP_NPARAMS; i++) {
+			snap->param_rc[i] = pef_snap_get(intf, 0, 0,
+					pef_snap_kinds[PEF_SNAP_K_CONTROL + i].id,
+					0, 0, snap->param[i],
+					pef_snap_kinds[PEF_SNAP_K_CONTROL + i].len);
+		}
+	}
+
+	/* alert strings are optional */
+	if ((what & PEF_SNAP_STRINGS) && pef_snap_get(intf, 0, 0,
+			PEF_CFGPARM_ID_PEF_ALERT_STRING_TABLE_SIZE, 0, 0,
+			&snap->nstrings, 1) == 0) {
+		snap->nstrings &= PEF_SNAP_MAX_ENTRIES - 1;
+		for (i = 1; i <= snap->nstrings; i++) {
+			rc = pef_snap_get(intf, 0, 0,
+					PEF_CFGPARM_ID_PEF_ALERT_STRING_KEY, i, 0,
+					snap->string_key[i],
+					sizeof(snap->string_key[i]));
+			if (rc == 0 && (snap->string_key[i][0] & 0x7f) != i) {
+				rc = (-1);
+			}
+			if (rc == 0) {
+				rc = pef_snap_get_string(intf, 0, 0,
+						PEF_CFGPARM_ID_PEF_ALERT_STRING_TABLE_ENTRY,
+						i, snap->string[i],
+						PEF_SNAP_STRING_BLOCKS);
+			}
+			snap->string_rc[i] = rc;
+		}
+	}
+
+	if (what & PEF_SNAP_DESTS) {
+		/* channels that don't exist are skipped quietly */
+		for (i = 0; i <= PEF_SNAP_LAST_CHAN; i++) {
+			snap->chan[i].channel = i;
+			if (_ipmi_get_channel_info(intf, &snap->chan[i]) != 0) {
+				snap->chan_state[i] = PEF_SNAP_FAILED;
+				continue;
+			}
+			snap->chan_state[i] = PEF_SNAP_OK;
+			if (snap->chan[i].medium == PEF_CH_MEDIUM_TYPE_LAN) {
+				pef_snap_community(intf, snap, i);
+			}
+			if (snap->chan[i].medium == PEF_CH_MEDIUM_TYPE_LAN
+			    || snap->chan[i].medium == PEF_CH_MEDIUM_TYPE_SERIAL) {
+				pef_snap_dests(intf, snap, i);
+			}
+		}
+	}
+	return snap;
+
+fail:
+	free(snap);
+	return NULL;
+}
+
+/* pef_snap_lookup - data of one snapshot line as the BMC takes it,
+ * following the set selector; NULL if the snapshot doesn't hold it
+ */
+static const uint8_t *
+pef_snap_lookup(const struct pef_snapshot *snap, int kind, uint8_t ch,
+		uint8_t set, int *len)
+{
+	const struct pef_snap_dests *d;
+	const uint8_t *p = NULL;
+
+	d = &snap->dests[ch & (PEF_SNAP_MAX_CHAN - 1)];
+	*len = pef_snap_kinds[kind].len;
+	if (pef_snap_kinds[kind].set && set == 0) {
+		/* selector 0 is volatile */
+		return NULL;
+	} else if (pef_snap_kinds[kind].medium
+	           && (d->state != PEF_SNAP_OK
+	               || d->medium != pef_snap_kinds[kind].medium
+	               || set >= PEF_SNAP_MAX_DEST)) {
+		return NULL;
+	}
+
+	switch (kind) {
+	case PEF_SNAP_K_FILTER:
+		if (set <= snap->nfilters && snap->filter_rc[set - 1] == 0)
+			p = (const uint8_t *)&snap->filter[set - 1].entry;
+		break;
+	case PEF_SNAP_K_POLICY:
+		if (set <= snap->npolicies && snap->policy_rc[set - 1] == 0)
+			p = (const uint8_t *)&snap->policy[set - 1].entry;
+		break;
+	case PEF_SNAP_K_CONTROL:
+	case PEF_SNAP_K_ACTION:
+	case PEF_SNAP_K_STARTUP_DELAY:
+	case PEF_SNAP_K_ALERT_STARTUP_DELAY:
+	case PEF_SNAP_K_SYSTEM_GUID:
+		if (snap->param_rc[kind - PEF_SNAP_K_CONTROL] == 0)
+			p = snap->param[kind - PEF_SNAP_K_CONTROL];
+		break;
+	case PEF_SNAP_K_STRING_KEY:
+		if (set <= snap->nstrings && snap->string_rc[set] == 0)
+			p = &snap->string_key[set][1];
+		break;
+	case PEF_SNAP_K_STRING:
+		if (set <= snap->nstrings && snap->string_rc[set] == 0)
+			p = (const uint8_t *)snap->string[set];
+		break;
+	case PEF_SNAP_K_LAN_DEST_TYPE:
+		if (set <= d->ndests && d->dest_rc[set] == 0)
+			p = &d->lan_type[set].dest_type;
+		break;
+	case PEF_SNAP_K_LAN_DEST_ADDR:
+		if (set <= d->ndests && d->addr_rc[set] == 0)
+			p = &d->lan_addr[set].addr_type;
+		break;
+	case PEF_SNAP_K_SERIAL_DEST:
+		if (set <= d->ndests && d->dest_rc[set] == 0)
+			p = &d->serial[set].dest_type;
+		break;
+	case PEF_SNAP_K_DIAL_STRING:
+		if (set <= d->ndials && d->dial_rc[set] == 0)
+			p = (const uint8_t *)d->dial[set];
+		break;
+	case PEF_SNAP_K_TAP_ACCOUNT:
+		if (set <= d->ntaps && d->tap_rc[set] == 0)
+			p = &d->tap[set].data2;
+		break;
+	case PEF_SNAP_K_TAP_SERVICE:
+		if ((d->svc_read & (1 << set)) && d->svc_rc[set] == 0)
+			p = &d->svc[set].confirmation_flags;
+		break;
+	}
+	if (p && pef_snap_kinds[kind].string) {
+		*len = __min((int)strlen((const char *)p) + 1, *len);
+	}
+	return p;
+}
+
 static void
 ipmi_pef_print_oem_lan_dest(struct ipmi_intf *intf,
                             uint8_t dest)
@@ -953,72 +1587,44 @@ ipmi_pef_print_oem_lan_dest(struct ipmi_intf *intf,
 	ipmi_pef_print_str("IPv6 Address", address);
 }
 
-/* TODO - rewrite */
+/* ipmi_pef_print_lan_dest - print a LAN alert destination of the snapshot */
 static void
-ipmi_pef_print_lan_dest(struct ipmi_intf * intf, uint8_t ch, uint8_t dest)
-{	/*
-	// print LAN alert destination info
-	*/
-	struct ipmi_rs * rsp;
-	struct ipmi_rq req;
-	struct pef_lan_cfgparm_selector lsel;
-	struct pef_lan_cfgparm_dest_type * ptype;
-	struct pef_lan_cfgparm_dest_info * pinfo;
+ipmi_pef_print_lan_dest(struct ipmi_intf *intf, struct pef_snapshot *snap,
+		uint8_t ch, uint8_t dest)
+{
+	const struct pef_snap_dests *d;
+	const struct pef_lan_cfgparm_dest_type *ptype;
+	const struct pef_lan_cfgparm_dest_info *pinfo;
+	const char *community;
 	char buf[32];
-	uint8_t dsttype, timeout, retries;
+	uint8_t dsttype;
 
-	memset(&lsel, 0, sizeof(lsel));
-	lsel.id = PEF_LAN_CFGPARM_ID_DEST_COUNT;
-	lsel.ch = ch;
-	memset(&req, 0, sizeof(req));
-	req.msg.netfn = IPMI_NETFN_TRANSPORT;
-	req.msg.cmd = IPMI_CMD_LAN_GET_CONFIG;
-	req.msg.data = (uint8_t *)&lsel;
-	req.msg.data_len = sizeof(lsel);
-	rsp = ipmi_pef_msg_exchange(intf, &req, "Alert destination count");
-	if (!rsp) {
-		lprintf(LOG_ERR, " **Error retrieving %s",
-			"Alert destination count");
-		return;
-	}
-
-	lsel.id = PEF_LAN_CFGPARM_ID_DESTTYPE;
-	lsel.set = dest;
-	rsp = ipmi_pef_msg_exchange(intf, &req, "Alert destination type");
-	if (!rsp || rsp->data[1] != lsel.set) {
+	d = pef_snap_dests(intf, snap, ch);
+	if (!d || dest > d->ndests || d->dest_rc[dest] != 0) {
 		lprintf(LOG_ERR, " **Error retrieving %s",
 			"Alert destination type");
 		return;
 	}
-	ptype = (struct pef_lan_cfgparm_dest_type *)&rsp->data[1];
+	ptype = &d->lan_type[dest];
 	dsttype = (ptype->dest_type & PEF_LAN_DEST_TYPE_MASK);
-	timeout = ptype->alert_timeout;
-	retries = (ptype->retries & PEF_LAN_RETRIES_MASK);
 	ipmi_pef_print_str("Alert destination type", 
 				ipmi_pef_bit_desc(&pef_b2s_lan_desttype, dsttype));
 	if (dsttype == PEF_LAN_DEST_TYPE_PET) {
-		lsel.id = PEF_LAN_CFGPARM_ID_PET_COMMUNITY;
-		lsel.set = 0;
-		rsp = ipmi_pef_msg_exchange(intf, &req, "PET community");
-		if (!rsp)
+		community = pef_snap_community(intf, snap, ch);
+		if (!community)
 			lprintf(LOG_ERR, " **Error retrieving %s",
 				"PET community");
-		else {
-			rsp->data[19] = '\0';
-			ipmi_pef_print_str("PET Community", (const char *)&rsp->data[1]);
-		}
+		else
+			ipmi_pef_print_str("PET Community", community);
 	}
-	ipmi_pef_print_dec("ACK timeout/retry (secs)", timeout);
-	ipmi_pef_print_dec("Retries", retries);
+	ipmi_pef_print_dec("ACK timeout/retry (secs)", ptype->alert_timeout);
+	ipmi_pef_print_dec("Retries", (ptype->retries & PEF_LAN_RETRIES_MASK));
 
-	lsel.id = PEF_LAN_CFGPARM_ID_DESTADDR;
-	lsel.set = dest;
-	rsp = ipmi_pef_msg_exchange(intf, &req, "Alert destination info");
-	if (!rsp || rsp->data[1] != lsel.set)
+	if (d->addr_rc[dest] != 0)
 		lprintf(LOG_ERR, " **Error retrieving %s",
 			"Alert destination info");
 	else {
-		pinfo = (struct pef_lan_cfgparm_dest_info *)&rsp->data[1];
+		pinfo = &d->lan_addr[dest];
 		sprintf(buf, "%u.%u.%u.%u", 
 					pinfo->ip[0], pinfo->ip[1], pinfo->ip[2], pinfo->ip[3]);
 		ipmi_pef_print_str("IP address", buf);
@@ -1028,100 +1634,49 @@ ipmi_pef_print_lan_dest(struct ipmi_intf * intf, uint8_t ch, uint8_t dest)
 }
 
 static void
-ipmi_pef_print_serial_dest_dial(struct ipmi_intf *intf, char *label,
-		struct pef_serial_cfgparm_selector *ssel)
+ipmi_pef_print_serial_dest_dial(const struct pef_snap_dests *d,
+		const char *label, uint8_t id)
 {	/*
 	// print a dial string
 	*/
-#define BLOCK_SIZE 16
-	struct ipmi_rs * rsp;
-	struct ipmi_rq req;
-	struct pef_serial_cfgparm_selector tmp;
-	char * p, strval[(6 * BLOCK_SIZE) + 1];
-
-	memset(&tmp, 0, sizeof(tmp));
-	tmp.id = PEF_SERIAL_CFGPARM_ID_DEST_DIAL_STRING_COUNT;
-	memset(&req, 0, sizeof(req));
-	req.msg.netfn = IPMI_NETFN_TRANSPORT;
-	req.msg.cmd = IPMI_CMD_SERIAL_GET_CONFIG;
-	req.msg.data = (uint8_t *)&tmp;
-	req.msg.data_len = sizeof(tmp);
-	rsp = ipmi_pef_msg_exchange(intf, &req, "Dial string count");
-	if (!rsp || (rsp->data[1] & PEF_SERIAL_DIAL_STRING_COUNT_MASK) == 0)
+	if (d->ndials == 0)
 		return;	/* sssh, not supported */
 
-	memcpy(&tmp, ssel, sizeof(tmp));
-	tmp.id = PEF_SERIAL_CFGPARM_ID_DEST_DIAL_STRING;
-	tmp.block = 1;
-	memset(strval, 0, sizeof(strval));
-	p = strval;
-	for (;;) {
-		rsp = ipmi_pef_msg_exchange(intf, &req, label);
-		if (!rsp
-		|| (rsp->data[1] != ssel->id)
-		|| (rsp->data[2] != tmp.block)) {
-			lprintf(LOG_ERR, " **Error retrieving %s", label);
-			return;
-		}
-		memcpy(p, &rsp->data[3], BLOCK_SIZE);
-		if (strchr(p, '\0') <= (p + BLOCK_SIZE))
-			break;
-		if ((p += BLOCK_SIZE) >= &strval[sizeof(strval)-1])
-			break;
-		tmp.block++;
+	if (id == 0 || id > d->ndials || d->dial_rc[id] != 0) {
+		lprintf(LOG_ERR, " **Error retrieving %s", label);
+		return;
 	}
-
-	ipmi_pef_print_str(label, strval);
-#undef BLOCK_SIZE
+	ipmi_pef_print_str(label, d->dial[id]);
 }
 
 static void
-ipmi_pef_print_serial_dest_tap(struct ipmi_intf *intf,
-		struct pef_serial_cfgparm_selector *ssel)
+ipmi_pef_print_serial_dest_tap(const struct pef_snap_dests *d, uint8_t acct)
 {	/*
 	// print TAP destination info
 	*/
-	struct ipmi_rs * rsp;
-	struct ipmi_rq req;
-	struct pef_serial_cfgparm_selector tmp;
-	struct pef_serial_cfgparm_tap_svc_settings * pset;
 	uint8_t dialstr_id, setting_id;
 
-	memset(&tmp, 0, sizeof(tmp));
-	tmp.id = PEF_SERIAL_CFGPARM_ID_TAP_ACCT_COUNT;
-	memset(&req, 0, sizeof(req));
-	req.msg.netfn = IPMI_NETFN_TRANSPORT;
-	req.msg.cmd = IPMI_CMD_SERIAL_GET_CONFIG;
-	req.msg.data = (uint8_t *)&tmp;
-	req.msg.data_len = sizeof(tmp);
-	rsp = ipmi_pef_msg_exchange(intf, &req, "Number of TAP accounts");
-	if (!rsp || (rsp->data[1] & PEF_SERIAL_TAP_ACCT_COUNT_MASK) == 0)
+	if (d->ntaps == 0)
 		return;	/* sssh, not supported */
 
-	memcpy(&tmp, ssel, sizeof(tmp));
-	tmp.id = PEF_SERIAL_CFGPARM_ID_TAP_ACCT_INFO;
-	rsp = ipmi_pef_msg_exchange(intf, &req, "TAP account info");
-	if (!rsp || (rsp->data[1] != tmp.set)) {
+	if (acct == 0 || acct > d->ntaps || d->tap_rc[acct] != 0) {
 		lprintf(LOG_ERR, " **Error retrieving %s",
 			"TAP account info");
 		return;
 	}
-	dialstr_id = (rsp->data[2] & PEF_SERIAL_TAP_ACCT_INFO_DIAL_STRING_ID_MASK);
+	dialstr_id = (d->tap[acct].data2 & PEF_SERIAL_TAP_ACCT_INFO_DIAL_STRING_ID_MASK);
 	dialstr_id >>= PEF_SERIAL_TAP_ACCT_INFO_DIAL_STRING_ID_SHIFT;
-	setting_id = (rsp->data[2] & PEF_SERIAL_TAP_ACCT_INFO_SVC_SETTINGS_ID_MASK);
-	tmp.set = dialstr_id;
-	ipmi_pef_print_serial_dest_dial(intf, "TAP Dial string", &tmp);
+	setting_id = (d->tap[acct].data2 & PEF_SERIAL_TAP_ACCT_INFO_SVC_SETTINGS_ID_MASK);
+	ipmi_pef_print_serial_dest_dial(d, "TAP Dial string", dialstr_id);
 
-	tmp.set = setting_id;
-	rsp = ipmi_pef_msg_exchange(intf, &req, "TAP service settings");
-	if (!rsp || (rsp->data[1] != tmp.set)) {
+	if (!(d->svc_read & (1 << setting_id)) || d->svc_rc[setting_id] != 0) {
 		lprintf(LOG_ERR, " **Error retrieving %s",
 			"TAP service settings");
 		return;
 	}
-	pset = (struct pef_serial_cfgparm_tap_svc_settings *)&rsp->data[1];
 	ipmi_pef_print_str("TAP confirmation",  
-		ipmi_pef_bit_desc(&pef_b2s_tap_svc_confirm, pset->confirmation_flags));
+		ipmi_pef_bit_desc(&pef_b2s_tap_svc_confirm,
+			d->svc[setting_id].confirmation_flags));
 
 	/* TODO : additional TAP settings? */
 }
@@ -1140,46 +1695,33 @@ ipmi_pef_print_serial_dest_callback(struct ipmi_intf *intf,
 */
 
 static void
-ipmi_pef_print_serial_dest(struct ipmi_intf *intf, uint8_t ch, uint8_t dest)
+ipmi_pef_print_serial_dest(struct ipmi_intf *intf, struct pef_snapshot *snap,
+		uint8_t ch, uint8_t dest)
 {	/*
 	// print Serial/PPP alert destination info
 	*/
-	struct ipmi_rs * rsp;
-	struct ipmi_rq req;
-	struct pef_serial_cfgparm_selector ssel;
-	uint8_t tbl_size, wrk;
-	struct pef_serial_cfgparm_dest_info * pinfo;
+	const struct pef_snap_dests *d;
+	const struct pef_serial_cfgparm_dest_info *pinfo;
+	uint8_t wrk;
 
-	memset(&ssel, 0, sizeof(ssel));
-	ssel.id = PEF_SERIAL_CFGPARM_ID_DEST_COUNT;
-	ssel.ch = ch;
-	memset(&req, 0, sizeof(req));
-	req.msg.netfn = IPMI_NETFN_TRANSPORT;
-	req.msg.cmd = IPMI_CMD_SERIAL_GET_CONFIG;
-	req.msg.data = (uint8_t *)&ssel;
-	req.msg.data_len = sizeof(ssel);
-	rsp = ipmi_pef_msg_exchange(intf, &req, "Alert destination count");
-	if (!rsp) {
+	d = pef_snap_dests(intf, snap, ch);
+	if (!d) {
 		lprintf(LOG_ERR, " **Error retrieving %s",
 			"Alert destination count");
 		return;
 	}
-	tbl_size = (rsp->data[1] & PEF_SERIAL_DEST_TABLE_SIZE_MASK);
-	if (!dest || tbl_size == 0)	/* Page alerting not supported */
+	if (!dest || d->ndests == 0)	/* Page alerting not supported */
 		return;
-	if (dest > tbl_size) {
-		ipmi_pef_print_oem_lan_dest(intf, dest - tbl_size);
+	if (dest > d->ndests) {
+		ipmi_pef_print_oem_lan_dest(intf, dest - d->ndests);
 		return;
 	}
 
-	ssel.id = PEF_SERIAL_CFGPARM_ID_DESTINFO;
-	ssel.set = dest;
-	rsp = ipmi_pef_msg_exchange(intf, &req, "Alert destination info");
-	if (!rsp || rsp->data[1] != ssel.set)
+	if (d->dest_rc[dest] != 0)
 		lprintf(LOG_ERR, " **Error retrieving %s",
 			"Alert destination info");
 	else {
-		pinfo = (struct pef_serial_cfgparm_dest_info *)rsp->data;
+		pinfo = &d->serial[dest];
 		wrk = (pinfo->dest_type & PEF_SERIAL_DEST_TYPE_MASK);
 		ipmi_pef_print_str("Alert destination type", 
 					ipmi_pef_bit_desc(&pef_b2s_serial_desttype, wrk));
@@ -1189,10 +1731,13 @@ ipmi_pef_print_serial_dest(struct ipmi_intf *intf, uint8_t ch, uint8_t dest)
 					(pinfo->retries & PEF_SERIAL_RETRIES_MASK));
 		switch (wrk) {
 			case PEF_SERIAL_DEST_TYPE_DIAL:
-				ipmi_pef_print_serial_dest_dial(intf, "Serial dial string", &ssel);
+				ipmi_pef_print_serial_dest_dial(d, "Serial dial string",
+					(pinfo->data5 & PEF_SERIAL_DIALPAGE_STRING_ID_MASK)
+					>> PEF_SERIAL_DIALPAGE_STRING_ID_SHIFT);
 				break;
 			case PEF_SERIAL_DEST_TYPE_TAP:
-				ipmi_pef_print_serial_dest_tap(intf, &ssel);
+				ipmi_pef_print_serial_dest_tap(d,
+					(pinfo->data5 & PEF_SERIAL_TAP_PAGE_SERVICE_ID_MASK));
 				break;
 			case PEF_SERIAL_DEST_TYPE_PPP:
 				/* ipmi_pef_print_serial_dest_ppp(intf, &ssel); */
@@ -1546,30 +2091,25 @@ ipmi_pef2_get_status(struct ipmi_intf *intf)
 static int
 ipmi_pef2_list_filters(struct ipmi_intf *intf)
 {
-	struct pef_capabilities pcap;
-	struct pef_cfgparm_filter_table_entry filter_entry;
-	int rc;
+	struct pef_snapshot *snap;
 	uint8_t i;
 
-	rc = _ipmi_get_pef_capabilities(intf, &pcap);
-	if (eval_ccode(rc) != 0) {
-		return (-1);
-	} else if (pcap.event_filter_count == 0) {
-		lprintf(LOG_ERR, "PEF Event Filtering isn't supported.");
+	snap = pef_snap_read(intf, PEF_SNAP_FILTERS);
+	if (!snap) {
 		return (-1);
 	}
 
-	for (i = 1; i <= pcap.event_filter_count; i++) {
+	for (i = 1; i <= snap->nfilters; i++) {
 		first_field = 1;
-		rc = _ipmi_get_pef_filter_entry(intf, i, &filter_entry);
-		if (eval_ccode(rc) != 0) {
+		if (eval_ccode(snap->filter_rc[i - 1]) != 0) {
 			lprintf(LOG_ERR, "Failed to get PEF Event Filter Entry %i.",
 					i);
 			continue;
 		}
-		ipmi_pef_print_filter_entry(&filter_entry);
+		ipmi_pef_print_filter_entry(&snap->filter[i - 1]);
 		printf("\n");
 	}
+	free(snap);
 	return 0;
 }
 
@@ -1577,27 +2117,23 @@ ipmi_pef2_list_filters(struct ipmi_intf *intf)
 static int
 ipmi_pef2_list_policies(struct ipmi_intf *intf)
 {
-	struct channel_info_t channel_info;
+	const struct channel_info_t *chinfo;
 	struct pef_cfgparm_policy_table_entry entry;
-	int rc;
+	struct pef_snapshot *snap;
 	uint8_t dest;
 	uint8_t i;
-	uint8_t policy_table_size;
 
-	rc = _ipmi_get_pef_policy_table_size(intf, &policy_table_size);
-	if (eval_ccode(rc) != 0) {
-		return (-1);
-	} else if (policy_table_size == 0) {
-		lprintf(LOG_ERR, "PEF Alert Policy isn't supported.");
+	snap = pef_snap_read(intf, PEF_SNAP_POLICIES);
+	if (!snap) {
 		return (-1);
 	}
 
-	for (i = 1; i <= policy_table_size; i++) {
+	for (i = 1; i <= snap->npolicies; i++) {
 		first_field = 1;
-		rc = _ipmi_get_pef_policy_entry(intf, i, &entry);
-		if (eval_ccode(rc) != 0) {
+		if (eval_ccode(snap->policy_rc[i - 1]) != 0) {
 			continue;
 		}
+		entry = snap->policy[i - 1];
 
 		ipmi_pef_print_dec("Alert policy table entry",
 				   (entry.data1 & PEF_POLICY_TABLE_ID_MASK));
@@ -1612,26 +2148,26 @@ ipmi_pef2_list_policies(struct ipmi_intf *intf)
 		if (entry.entry.alert_string_key & PEF_POLICY_EVENT_SPECIFIC) {
 			ipmi_pef_print_str("Event-specific", "true");
 		}
-		channel_info.channel = ((entry.entry.chan_dest &
-					PEF_POLICY_CHANNEL_MASK) >>
-					PEF_POLICY_CHANNEL_SHIFT);
-		rc = _ipmi_get_channel_info(intf, &channel_info);
-		if (eval_ccode(rc) != 0) {
+		chinfo = pef_snap_channel(intf, snap,
+				(entry.entry.chan_dest &
+				 PEF_POLICY_CHANNEL_MASK) >>
+				PEF_POLICY_CHANNEL_SHIFT);
+		if (!chinfo) {
 			continue;
 		}
-		ipmi_pef_print_dec("Channel number", channel_info.channel);
+		ipmi_pef_print_dec("Channel number", chinfo->channel);
 		ipmi_pef_print_str("Channel medium",
 				   ipmi_pef_bit_desc(&pef_b2s_ch_medium,
-					   channel_info.medium));
+					   chinfo->medium));
 		dest = entry.entry.chan_dest & PEF_POLICY_DESTINATION_MASK;
-		switch (channel_info.medium) {
+		switch (chinfo->medium) {
 		case PEF_CH_MEDIUM_TYPE_LAN:
-			ipmi_pef_print_lan_dest(intf, channel_info.channel,
+			ipmi_pef_print_lan_dest(intf, snap, chinfo->channel,
 					dest);
 			break;
 		case PEF_CH_MEDIUM_TYPE_SERIAL:
-			ipmi_pef_print_serial_dest(intf, channel_info.channel,
-					dest);
+			ipmi_pef_print_serial_dest(intf, snap,
+					chinfo->channel, dest);
 			break;
 		default:
 			ipmi_pef_print_dest(dest);
@@ -1639,9 +2175,540 @@ ipmi_pef2_list_policies(struct ipmi_intf *intf)
 		}
 		printf("\n");
 	}
+	free(snap);
 	return 0;
 }
 
+/* ipmi_pef2_snapshot_save - write the snapshot as text, one line per
+ * entry or parameter, see pef_snap_kinds
+ */
+static int
+ipmi_pef2_snapshot_save(const struct pef_snapshot *snap, FILE *fp)
+{
+	const uint8_t *p;
+	int kind, ch, set, last, len;
+
+	fprintf(fp, "%s\n", PEF_SNAP_HEADER);
+	for (kind = 0; kind < PEF_SNAP_NKINDS; kind++) {
+		last = 0;
+		if (pef_snap_kinds[kind].set) {
+			last = pef_snap_kinds[kind].medium
+				? PEF_SNAP_MAX_DEST - 1 : PEF_SNAP_MAX_ENTRIES - 1;
+		}
+		for (ch = 0; ch <= (pef_snap_kinds[kind].medium
+		                    ? PEF_SNAP_LAST_CHAN : 0); ch++) {
+			for (set = 0; set <= last; set++) {
+				p = pef_snap_lookup(snap, kind, ch, set, &len);
+				if (!p) {
+					continue;
+				}
+				fprintf(fp, "%s", pef_snap_kinds[kind].name);
+				if (pef_snap_kinds[kind].medium) {
+					fprintf(fp, " %d", ch);
+				}
+				if (pef_snap_kinds[kind].set) {
+					fprintf(fp, " %d", set);
+				}
+				fprintf(fp, " %s\n", buf2str(p, len));
+			}
+		}
+	}
+	return ferror(fp) ? (-1) : 0;
+}
+
+/* pef_snap_json_str - print a string as a JSON string literal */
+static void
+pef_snap_json_str(const char *str)
+{
+	putchar('"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\') {
+			putchar('\\');
+		}
+		if ((unsigned char)*str < 0x20) {
+			printf("\\u%04x", *str);
+		} else {
+			putchar(*str);
+		}
+	}
+	putchar('"');
+}
+
+/* ipmi_pef2_snapshot_json_dests - print the alert destinations, dial
+ * strings and TAP accounts of a channel as JSON members
+ */
+static void
+ipmi_pef2_snapshot_json_dests(const struct pef_snapshot *snap, uint8_t ch)
+{
+	const struct pef_snap_dests *d = &snap->dests[ch];
+	const struct pef_lan_cfgparm_dest_type *t;
+	const struct pef_lan_cfgparm_dest_info *a;
+	const struct pef_serial_cfgparm_dest_info *s;
+	const char *sep = "";
+	uint8_t svc;
+	uint8_t i;
+
+	printf(",\"destinations\":[");
+	for (i = 1; i <= d->ndests; i++) {
+		if (d->dest_rc[i] != 0) {
+			continue;
+		}
+		if (d->medium == PEF_CH_MEDIUM_TYPE_LAN) {
+			t = &d->lan_type[i];
+			printf("%s{\"id\":%u,\"type\":%u,\"acknowledged\":%s,"
+			       "\"timeout\":%u,\"retries\":%u",
+			       sep, i, t->dest_type & PEF_LAN_DEST_TYPE_MASK,
+			       (t->dest_type & PEF_LAN_DEST_TYPE_ACK)
+			       ? "true" : "false",
+			       t->alert_timeout,
+			       t->retries & PEF_LAN_RETRIES_MASK);
+			if (d->addr_rc[i] == 0) {
+				a = &d->lan_addr[i];
+				printf(",\"gateway\":\"%s\",\"ip\":\"%u.%u.%u.%u\","
+				       "\"mac\":\"%s\"",
+				       (a->gateway & PEF_LAN_DEST_GATEWAY_USE_BACKUP)
+				       ? "backup" : "default",
+				       a->ip[0], a->ip[1], a->ip[2], a->ip[3],
+				       mac2str(a->mac));
+			}
+		} else {
+			s = &d->serial[i];
+			printf("%s{\"id\":%u,\"type\":%u,\"acknowledged\":%s,"
+			       "\"timeout\":%u,\"retries\":%u,\"data\":%u",
+			       sep, i, s->dest_type & PEF_SERIAL_DEST_TYPE_MASK,
+			       (s->dest_type & PEF_SERIAL_DEST_TYPE_ACK)
+			       ? "true" : "false",
+			       s->alert_timeout,
+			       s->retries & PEF_SERIAL_RETRIES_MASK, s->data5);
+		}
+		printf("}");
+		sep = ",";
+	}
+	printf("]");
+	if (d->medium != PEF_CH_MEDIUM_TYPE_SERIAL) {
+		return;
+	}
+
+	printf(",\"dial_strings\":[");
+	sep = "";
+	for (i = 1; i <= d->ndials; i++) {
+		if (d->dial_rc[i] != 0) {
+			continue;
+		}
+		printf("%s{\"id\":%u,\"text\":", sep, i);
+		pef_snap_json_str(d->dial[i]);
+		printf("}");
+		sep = ",";
+	}
+	printf("],\"tap_accounts\":[");
+	sep = "";
+	for (i = 1; i <= d->ntaps; i++) {
+		if (d->tap_rc[i] != 0) {
+			continue;
+		}
+		svc = d->tap[i].data2
+			& PEF_SERIAL_TAP_ACCT_INFO_SVC_SETTINGS_ID_MASK;
+		printf("%s{\"id\":%u,\"dial_string\":%u,\"service\":%u",
+		       sep, i,
+		       (d->tap[i].data2
+		        & PEF_SERIAL_TAP_ACCT_INFO_DIAL_STRING_ID_MASK)
+		       >> PEF_SERIAL_TAP_ACCT_INFO_DIAL_STRING_ID_SHIFT, svc);
+		if ((d->svc_read & (1 << svc)) && d->svc_rc[svc] == 0) {
+			printf(",\"confirmation\":%u,\"service_settings\":\"%s\"",
+			       d->svc[svc].confirmation_flags,
+			       buf2str(&d->svc[svc].confirmation_flags,
+			               sizeof(d->svc[svc]) - 1));
+		}
+		printf("}");
+		sep = ",";
+	}
+	printf("]");
+}
+
+/* ipmi_pef2_snapshot_json - print the snapshot as a JSON document */
+static void
+ipmi_pef2_snapshot_json(const struct pef_snapshot *snap)
+{
+	const struct pef_table_entry *f;
+	const struct pef_policy_entry *p;
+	const char *sep = "";
+	uint8_t i;
+
+	printf("{\"filters\":[");
+	for (i = 1; i <= snap->nfilters; i++) {
+		if (snap->filter_rc[i - 1] != 0) {
+			continue;
+		}
+		f = &snap->filter[i - 1].entry;
+		printf("%s{\"id\":%u,\"enabled\":%s,\"action\":%u,"
+		       "\"policy\":%u,\"severity\":%u,\"generator\":%u,"
+		       "\"sensor_type\":%u,\"sensor_number\":%u,"
+		       "\"event_trigger\":%u,\"data\":\"%s\"}",
+		       sep, i, (f->config & PEF_CONFIG_ENABLED) ? "true" : "false",
+		       f->action, f->policy_number & PEF_POLICY_NUMBER_MASK,
+		       f->severity, f->generator_ID_addr, f->sensor_type,
+		       f->sensor_number, f->event_trigger,
+		       buf2str((const uint8_t *)f, sizeof(*f)));
+		sep = ",";
+	}
+	printf("],\"policies\":[");
+	sep = "";
+	for (i = 1; i <= snap->npolicies; i++) {
+		if (snap->policy_rc[i - 1] != 0) {
+			continue;
+		}
+		p = &snap->policy[i - 1].entry;
+		printf("%s{\"id\":%u,\"policy_set\":%u,\"enabled\":%s,"
+		       "\"rule\":%u,\"channel\":%u,\"destination\":%u,"
+		       "\"event_specific\":%s,\"alert_string_key\":%u}",
+		       sep, i,
+		       (p->policy & PEF_POLICY_ID_MASK) >> PEF_POLICY_ID_SHIFT,
+		       (p->policy & PEF_POLICY_ENABLED) ? "true" : "false",
+		       p->policy & PEF_POLICY_FLAGS_MASK,
+		       (p->chan_dest & PEF_POLICY_CHANNEL_MASK)
+		       >> PEF_POLICY_CHANNEL_SHIFT,
+		       p->chan_dest & PEF_POLICY_DESTINATION_MASK,
+		       (p->alert_string_key & PEF_POLICY_EVENT_SPECIFIC)
+		       ? "true" : "false",
+		       p->alert_string_key & ~PEF_POLICY_EVENT_SPECIFIC);
+		sep = ",";
+	}
+
+	printf("],\"control\":{");
+	sep = "";
+	for (i = 0; i < PEF_SNAP_NPARAMS; i++) {
+		if (snap->param_rc[i] != 0) {
+			continue;
+		}
+		printf("%s\"%s\":", sep,
+		       pef_snap_kinds[PEF_SNAP_K_CONTROL + i].name);
+		if (pef_snap_kinds[PEF_SNAP_K_CONTROL + i].len == 1) {
+			printf("%u", snap->param[i][0]);
+		} else {
+			printf("\"%s\"", buf2str(snap->param[i],
+				pef_snap_kinds[PEF_SNAP_K_CONTROL + i].len));
+		}
+		sep = ",";
+	}
+	printf("},\"alert_strings\":[");
+	sep = "";
+	for (i = 1; i <= snap->nstrings; i++) {
+		if (snap->string_rc[i] != 0) {
+			continue;
+		}
+		printf("%s{\"id\":%u,\"filter\":%u,\"string_set\":%u,\"text\":",
+		       sep, i, snap->string_key[i][1] & 0x7f,
+		       snap->string_key[i][2] & 0x7f);
+		pef_snap_json_str(snap->string[i]);
+		printf("}");
+		sep = ",";
+	}
+	printf("],\"channels\":[");
+	sep = "";
+	for (i = 0; i <= PEF_SNAP_LAST_CHAN; i++) {
+		if (snap->dests[i].state != PEF_SNAP_OK) {
+			continue;
+		}
+		printf("%s{\"channel\":%u,\"medium\":\"%s\"", sep, i,
+		       (snap->dests[i].medium == PEF_CH_MEDIUM_TYPE_LAN)
+		       ? "lan" : "serial");
+		if (snap->community_state[i] == PEF_SNAP_OK) {
+			printf(",\"community\":");
+			pef_snap_json_str(snap->community[i]);
+		}
+		ipmi_pef2_snapshot_json_dests(snap, i);
+		printf("}");
+		sep = ",";
+	}
+	printf("]}\n");
+}
+
+/* a line of a saved snapshot, see pef_snap_kinds */
+struct pef_snap_item {
+	int lineno;
+	uint8_t kind;
+	uint8_t ch;
+	uint8_t set;
+	int len;
+	uint8_t data[PEF_SNAP_STRING_BLOCKS * PEF_SNAP_BLOCK + 1];
+};
+
+/* pef_snap_parse - parse a snapshot line into @it
+ *
+ * returns - 0 on success, -1 on error.
+ */
+static int
+pef_snap_parse(char *line, struct pef_snap_item *it)
+{
+	char *tok;
+	int kind;
+	int max;
+
+	memset(it, 0, sizeof(*it));
+	tok = strtok(line, " \t\r\n");
+	for (kind = 0; kind < PEF_SNAP_NKINDS; kind++) {
+		if (tok && !strcmp(tok, pef_snap_kinds[kind].name)) {
+			break;
+		}
+	}
+	if (kind == PEF_SNAP_NKINDS) {
+		return (-1);
+	}
+	it->kind = kind;
+	if (pef_snap_kinds[kind].medium) {
+		tok = strtok(NULL, " \t\r\n");
+		if (!tok || str2uchar(tok, &it->ch) != 0
+		    || it->ch > PEF_SNAP_LAST_CHAN) {
+			return (-1);
+		}
+	}
+	if (pef_snap_kinds[kind].set) {
+		max = pef_snap_kinds[kind].medium
+			? PEF_SNAP_MAX_DEST : PEF_SNAP_MAX_ENTRIES;
+		tok = strtok(NULL, " \t\r\n");
+		if (!tok || str2uchar(tok, &it->set) != 0
+		    || it->set == 0 || it->set >= max) {
+			return (-1);
+		}
+	}
+	tok = strtok(NULL, " \t\r\n");
+	if (!tok || strtok(NULL, " \t\r\n")) {
+		return (-1);
+	}
+	it->len = ipmi_parse_hex(tok, it->data, sizeof(it->data) - 1);
+	if (!pef_snap_kinds[kind].string) {
+		return (it->len == pef_snap_kinds[kind].len) ? 0 : (-1);
+	} else if (it->len < 1 || it->len > pef_snap_kinds[kind].len) {
+		return (-1);
+	}
+	/* strings compare and write up to their NUL, as pef_snap_lookup */
+	it->len = __min((int)strlen((char *)it->data) + 1,
+	                pef_snap_kinds[kind].len);
+	return 0;
+}
+
+/* pef_snap_write - write a snapshot line to the BMC, string parameters
+ * one block at a time
+ *
+ * returns - negative number means error, positive is a ccode.
+ */
+static int
+pef_snap_write(struct ipmi_intf *intf, const struct pef_snap_item *it)
+{
+	uint8_t medium = pef_snap_kinds[it->kind].medium;
+	uint8_t id = pef_snap_kinds[it->kind].id;
+	uint8_t data[2 + PEF_SNAP_BLOCK];
+	int off;
+	int rc;
+
+	if (!pef_snap_kinds[it->kind].string) {
+		uint8_t buf[1 + sizeof(struct pef_table_entry)];
+
+		if (!pef_snap_kinds[it->kind].set) {
+			return pef_snap_set(intf, medium, it->ch, id,
+					it->data, it->len);
+		}
+		buf[0] = it->set;
+		memcpy(&buf[1], it->data, it->len);
+		return pef_snap_set(intf, medium, it->ch, id, buf, 1 + it->len);
+	}
+
+	for (off = 0; off < it->len; off += PEF_SNAP_BLOCK) {
+		data[0] = it->set;
+		data[1] = off / PEF_SNAP_BLOCK + 1;
+		memset(&data[2], 0, PEF_SNAP_BLOCK);
+		memcpy(&data[2], &it->data[off],
+		       __min(it->len - off, PEF_SNAP_BLOCK));
+		rc = pef_snap_set(intf, medium, it->ch, id, data, sizeof(data));
+		if (rc != 0) {
+			return rc;
+		}
+	}
+	return 0;
+}
+
+/* ipmi_pef2_snapshot_restore - write the lines of a saved snapshot that
+ * differ from the BMC; PEF parameters inside one set-in-progress window,
+ * then the alert destinations inside one window per channel
+ */
+static int
+ipmi_pef2_snapshot_restore(struct ipmi_intf *intf, const char *file)
+{
+	struct pef_snapshot *cur;
+	struct pef_snap_item *items = NULL;
+	struct pef_snap_item *it;
+	const uint8_t *p;
+	char line[512];
+	char *tok;
+	size_t nitems = 0;
+	size_t i;
+	uint8_t medium;
+	uint8_t chan;
+	int lineno = 0;
+	int changed = 0;
+	int locked;
+	int len;
+	int ch;
+	int rc = 0;
+	FILE *fp;
+
+	fp = ipmi_open_file_read(file);
+	if (!fp) {
+		return (-1);
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		lineno++;
+		tok = line + strspn(line, " \t\r\n");
+		if (*tok == '\0' || *tok == '#') {
+			continue;
+		}
+		it = realloc(items, (nitems + 1) * sizeof(*items));
+		if (!it) {
+			lprintf(LOG_ERR, "ipmitool: malloc failure");
+			rc = (-1);
+			break;
+		}
+		items = it;
+		it = &items[nitems];
+		if (pef_snap_parse(line, it) != 0) {
+			lprintf(LOG_ERR, "%s:%d: invalid PEF snapshot line",
+				file, lineno);
+			rc = (-1);
+			break;
+		}
+		it->lineno = lineno;
+		nitems++;
+	}
+	fclose(fp);
+	if (rc != 0) {
+		free(items);
+		return rc;
+	}
+
+	cur = pef_snap_read(intf, PEF_SNAP_ALL);
+	if (!cur) {
+		free(items);
+		return (-1);
+	}
+	for (i = 0; i < nitems && rc == 0; i++) {
+		it = &items[i];
+		medium = pef_snap_kinds[it->kind].medium;
+		if (medium && (cur->dests[it->ch].state != PEF_SNAP_OK
+		               || cur->dests[it->ch].medium != medium)) {
+			lprintf(LOG_ERR, "%s:%d: channel %u has no %s alert destinations",
+				file, it->lineno, it->ch,
+				(medium == PEF_CH_MEDIUM_TYPE_LAN) ? "LAN" : "serial");
+			rc = (-1);
+		}
+	}
+
+	/* window -1 is PEF, the others are channels */
+	for (ch = -1; ch <= PEF_SNAP_LAST_CHAN && rc == 0; ch++) {
+		chan = (ch < 0) ? 0 : ch;
+		medium = (ch < 0) ? 0 : cur->dests[chan].medium;
+		locked = 0;
+		for (i = 0; i < nitems; i++) {
+			it = &items[i];
+			if ((ch < 0) != (pef_snap_kinds[it->kind].medium == 0)
+			    || (ch >= 0 && it->ch != ch)) {
+				continue;
+			}
+			p = pef_snap_lookup(cur, it->kind, it->ch, it->set, &len);
+			if (p && len == it->len && !memcmp(p, it->data, len)) {
+				continue;
+			}
+			if (!locked) {
+				/* not every BMC implements Set In Progress */
+				rc = pef_snap_progress(intf, medium, chan, 1);
+				if (rc == 0x80) {
+					locked = (-1);
+					rc = 0;
+				} else if (eval_ccode(rc) != 0) {
+					rc = (-1);
+					break;
+				} else {
+					locked = 1;
+				}
+			}
+			rc = pef_snap_write(intf, it);
+			if (eval_ccode(rc) != 0) {
+				lprintf(LOG_ERR, "%s:%d: failed to set %s.",
+					file, it->lineno,
+					pef_snap_kinds[it->kind].name);
+				rc = (-1);
+				break;
+			}
+			changed++;
+		}
+		if (locked > 0) {
+			/* set complete without a commit write is a rollback */
+			if (rc == 0) {
+				rc = pef_snap_progress(intf, medium, chan, 2);
+				if (eval_ccode(rc) != 0) {
+					if (ch < 0)
+						lprintf(LOG_ERR, "Failed to commit PEF configuration.");
+					else
+						lprintf(LOG_ERR, "Failed to commit alert destinations of channel %d.",
+								ch);
+					rc = (-1);
+				}
+			}
+			pef_snap_progress(intf, medium, chan, 0);
+		}
+	}
+	free(cur);
+	free(items);
+
+	if (rc == 0) {
+		printf("%d PEF snapshot entries changed\n", changed);
+	}
+	return rc;
+}
+
+/* ipmi_pef2_snapshot - save, export or restore the PEF configuration */
+static int
+ipmi_pef2_snapshot(struct ipmi_intf *intf, int argc, char **argv)
+{
+	struct pef_snapshot *snap;
+	FILE *fp = stdout;
+	int rc = 0;
+
+	if (argc == 2 && !strcmp(argv[0], "restore")) {
+		return ipmi_pef2_snapshot_restore(intf, argv[1]);
+	}
+	if (argc < 1 || argc > 2
+	    || (strcmp(argv[0], "save") && strcmp(argv[0], "json"))
+	    || (argc == 2 && strcmp(argv[0], "save"))) {
+		lprintf(LOG_ERR, "usage: pef snapshot save [<file>]|json|restore <file>");
+		return (-1);
+	}
+
+	snap = pef_snap_read(intf, PEF_SNAP_ALL);
+	if (!snap) {
+		return (-1);
+	}
+	if (!strcmp(argv[0], "json")) {
+		ipmi_pef2_snapshot_json(snap);
+	} else {
+		if (argc == 2) {
+			fp = ipmi_open_file_write(argv[1]);
+			if (!fp) {
+				free(snap);
+				return (-1);
+			}
+		}
+		rc = ipmi_pef2_snapshot_save(snap, fp);
+		if (fp != stdout && fclose(fp)) {
+			rc = (-1);
+		}
+		if (rc != 0) {
+			lprintf(LOG_ERR, "Unable to write PEF snapshot");
+		}
+	}
+	free(snap);
+	return rc;
+}
+
 void
 ipmi_pef2_policy_help(void)
 {
@@ -1659,6 +2726,272 @@ ipmi_pef2_policy_help(void)
 "       pef policy delete <id = 1..n>");
 }
 
+/*
+ * PEF parameters for 'config save' and 'config apply'
+ *
+ * The tables are sized by the BMC when the class is opened; alert strings
+ * are kept as their 16 byte blocks, up to the one holding the NUL.
+ */
+struct pef_cfgp_priv {
+	struct ipmi_intf *intf;
+	uint8_t nfilters;
+	uint8_t npolicies;
+	uint8_t nstrings;
+	int string_end;		/* the last block read ends its string */
+};
+
+static const struct ipmi_cfgp pef_cfgp[] = {
+	{ .name = "control", .format = "<flags>", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = PEF_CFGPARM_ID_PEF_CONTROL
+	},
+	{ .name = "action", .format = "<flags>", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = PEF_CFGPARM_ID_PEF_ACTION
+	},
+	{ .name = "startup-delay", .format = "<seconds>", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = PEF_CFGPARM_ID_PEF_STARTUP_DELAY
+	},
+	{ .name = "alert-startup-delay", .format = "<seconds>", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = PEF_CFGPARM_ID_PEF_ALERT_STARTUP_DELAY
+	},
+	{ .name = "filter", .format = "<data>",
+		.size = sizeof(struct pef_table_entry), .access = CFGP_RDWR,
+		.is_set = 1, .first_set = 1, .has_blocks = 0, .first_block = 0,
+		.specific = PEF_CFGPARM_ID_PEF_FILTER_TABLE_ENTRY
+	},
+	{ .name = "policy", .format = "<data>",
+		.size = sizeof(struct pef_policy_entry), .access = CFGP_RDWR,
+		.is_set = 1, .first_set = 1, .has_blocks = 0, .first_block = 0,
+		.specific = PEF_CFGPARM_ID_PEF_ALERT_POLICY_TABLE_ENTRY
+	},
+	{ .name = "system-guid", .format = "<data>", .size = 17,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = PEF_CFGPARM_ID_SYSTEM_GUID
+	},
+	{ .name = "string-key", .format = "<data>", .size = 2,
+		.access = CFGP_RDWR,
+		.is_set = 1, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = PEF_CFGPARM_ID_PEF_ALERT_STRING_KEY
+	},
+	{ .name = "string", .format = "<data>", .size = PEF_SNAP_BLOCK,
+		.access = CFGP_RDWR,
+		.is_set = 1, .first_set = 0, .has_blocks = 1, .first_block = 1,
+		.specific = PEF_CFGPARM_ID_PEF_ALERT_STRING_TABLE_ENTRY
+	}
+};
+
+static int
+pef_cfgp_parse(const struct ipmi_cfgp *p, int argc, const char **argv,
+		unsigned char *data)
+{
+	if (argc == 0) {
+		return -1;
+	}
+
+	switch (p->specific) {
+	case PEF_CFGPARM_ID_PEF_CONTROL:
+	case PEF_CFGPARM_ID_PEF_ACTION:
+	case PEF_CFGPARM_ID_PEF_STARTUP_DELAY:
+	case PEF_CFGPARM_ID_PEF_ALERT_STARTUP_DELAY:
+		return str2uchar(argv[0], &data[0]) ? -1 : 0;
+
+	default:
+		if (ipmi_parse_hex(argv[0], data, p->size) != (int)p->size) {
+			return -1;
+		}
+		return 0;
+	}
+}
+
+static void
+pef_cfgp_save(const struct ipmi_cfgp *p, const unsigned char *data,
+		FILE *file)
+{
+	switch (p->specific) {
+	case PEF_CFGPARM_ID_PEF_CONTROL:
+	case PEF_CFGPARM_ID_PEF_ACTION:
+		fprintf(file, "0x%02x", data[0]);
+		break;
+
+	case PEF_CFGPARM_ID_PEF_STARTUP_DELAY:
+	case PEF_CFGPARM_ID_PEF_ALERT_STARTUP_DELAY:
+		fprintf(file, "%d", data[0]);
+		break;
+
+	default:
+		fputs(buf2str(data, p->size), file);
+	}
+}
+
+/* pef_cfgp_count - number of sets of a table parameter */
+static int
+pef_cfgp_count(const struct pef_cfgp_priv *pp, const struct ipmi_cfgp *p)
+{
+	switch (p->specific) {
+	case PEF_CFGPARM_ID_PEF_FILTER_TABLE_ENTRY:
+		return pp->nfilters;
+	case PEF_CFGPARM_ID_PEF_ALERT_POLICY_TABLE_ENTRY:
+		return pp->npolicies;
+	case PEF_CFGPARM_ID_PEF_ALERT_STRING_KEY:
+	case PEF_CFGPARM_ID_PEF_ALERT_STRING_TABLE_ENTRY:
+		/* string 0 is the volatile string */
+		return pp->nstrings;
+	default:
+		return 0;
+	}
+}
+
+static int
+pef_cfgp_get(struct pef_cfgp_priv *pp, const struct ipmi_cfgp *p,
+		const struct ipmi_cfgp_action *action, unsigned char *data)
+{
+	uint8_t buf[2 + sizeof(struct pef_table_entry)];
+	int skip = p->is_set + p->has_blocks;
+	int rc;
+
+	if (p->is_set && action->set > pef_cfgp_count(pp, p)) {
+		return -1;
+	}
+	if (p->has_blocks && action->block > p->first_block
+		&& (pp->string_end || action->block > PEF_SNAP_STRING_BLOCKS)) {
+		return -1;
+	}
+
+	/* the data of table parameters follows their selectors */
+	rc = pef_snap_get(pp->intf, 0, 0, p->specific, action->set,
+			action->block, buf, skip + p->size);
+	if (rc != 0) {
+		if (!action->quiet) {
+			lprintf(LOG_ERR, "Unable to get PEF parameter '%s': %s",
+				p->name, (rc < 0) ? "no response"
+				: val2str(rc, completion_code_vals));
+		}
+		return -1;
+	}
+
+	memcpy(data, &buf[skip], p->size);
+	if (p->has_blocks) {
+		pp->string_end = (memchr(data, 0, p->size) != NULL);
+	}
+	return 0;
+}
+
+static int
+pef_cfgp_handler(void *priv, const struct ipmi_cfgp *p,
+		const struct ipmi_cfgp_action *action, unsigned char *data)
+{
+	struct pef_cfgp_priv *pp = priv;
+	uint8_t buf[2 + sizeof(struct pef_table_entry)];
+	int n = 0;
+	int rc;
+
+	switch (action->type) {
+	case CFGP_PARSE:
+		return pef_cfgp_parse(p, action->argc, action->argv, data);
+
+	case CFGP_GET:
+		return pef_cfgp_get(pp, p, action, data);
+
+	case CFGP_SET:
+		if (p->is_set) {
+			buf[n++] = action->set;
+		}
+		if (p->has_blocks) {
+			buf[n++] = action->block;
+		}
+		memcpy(&buf[n], data, p->size);
+		rc = pef_snap_set(pp->intf, 0, 0, p->specific, buf, n + p->size);
+		if (rc != 0) {
+			lprintf(LOG_ERR, "Unable to set PEF parameter '%s': %s",
+				p->name, (rc < 0) ? "no response"
+				: val2str(rc, completion_code_vals));
+			return -1;
+		}
+		return 0;
+
+	case CFGP_SAVE:
+		pef_cfgp_save(p, data, action->file);
+		return 0;
+
+	case CFGP_PRINT:
+		fprintf(action->file, "%-22s: ", p->name);
+		pef_cfgp_save(p, data, action->file);
+		fputc('\n', action->file);
+		return 0;
+
+	default:
+		return -1;
+	}
+}
+
+static int
+pef_cfgp_progress(void *priv, int state)
+{
+	struct pef_cfgp_priv *pp = priv;
+	int rc;
+
+	rc = pef_snap_progress(pp->intf, 0, 0, state);
+	if (rc == 0) {
+		return 0;
+	}
+
+	/* like the SOL parameters, see sol_cfgp_progress() */
+	if (rc == 0x80 || state == CFGP_COMMIT_WRITE) {
+		return 1;
+	}
+
+	lprintf(LOG_ERR, "Unable to set PEF Set In Progress to %d: %s",
+		state, (rc < 0) ? "no response"
+		: val2str(rc, completion_code_vals));
+	return -1;
+}
+
+static int
+pef_cfgp_open(struct ipmi_intf *intf, int __UNUSED__(channel), void *priv)
+{
+	struct pef_cfgp_priv *pp = priv;
+
+	pp->intf = intf;
+
+	/* a table the BMC doesn't have is left empty */
+	if (pef_snap_get(intf, 0, 0, PEF_CFGPARM_ID_PEF_FILTER_TABLE_SIZE,
+			0, 0, &pp->nfilters, 1) != 0) {
+		pp->nfilters = 0;
+	}
+	if (pef_snap_get(intf, 0, 0, PEF_CFGPARM_ID_PEF_ALERT_POLICY_TABLE_SIZE,
+			0, 0, &pp->npolicies, 1) != 0) {
+		pp->npolicies = 0;
+	}
+	if (pef_snap_get(intf, 0, 0, PEF_CFGPARM_ID_PEF_ALERT_STRING_TABLE_SIZE,
+			0, 0, &pp->nstrings, 1) != 0) {
+		pp->nstrings = 0;
+	}
+	pp->nfilters &= PEF_SNAP_MAX_ENTRIES - 1;
+	pp->npolicies &= PEF_SNAP_MAX_ENTRIES - 1;
+	pp->nstrings &= PEF_SNAP_MAX_ENTRIES - 1;
+
+	return 0;
+}
+
+const struct ipmi_cfgp_class ipmi_pef_cfgp_class = {
+	.name = "pef",
+	.set = pef_cfgp,
+	.count = ARRAY_SIZE(pef_cfgp),
+	.handler = pef_cfgp_handler,
+	.progress = pef_cfgp_progress,
+	.global = 1,
+	.priv_size = sizeof(struct pef_cfgp_priv),
+	.open = pef_cfgp_open
+};
+
 /* ipmi_pef2_policy_enable - Enable/Disable specific PEF policy
  *
  * @enable - enable(1) or disable(0) PEF Alert Policy
@@ -1797,6 +3130,12 @@ ipmi_pef2_help(void)
 	lprintf(LOG_NOTICE,
 "       pef pet ack <params>");
 	lprintf(LOG_NOTICE,
+"       pef snapshot save [<file>]");
+	lprintf(LOG_NOTICE,
+"       pef snapshot json");
+	lprintf(LOG_NOTICE,
+"       pef snapshot restore <file>");
+	lprintf(LOG_NOTICE,
 "       pef status");
 	lprintf(LOG_NOTICE,
 "       pef timer get");
@@ -1833,6 +3172,8 @@ int ipmi_pef_main(struct ipmi_intf *intf, int argc, char **argv)
 		rc = 1;
 	} else if (!strcmp(argv[0], "policy")) {
 		rc = ipmi_pef2_policy(intf, (argc - 1), ++argv);
+	} else if (!strcmp(argv[0], "snapshot")) {
+		rc = ipmi_pef2_snapshot(intf, (argc - 1), ++argv);
 	} else if (!strcmp(argv[0], "status")) {
 		rc = ipmi_pef2_get_status(intf);
 	} else if (!strcmp(argv[0], "timer")) {
@@ -30,10 +30,14 @@
  * EVEN IF DELL HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGES.
  */
 
+#include <stdlib.h>
+#include <string.h>
 
 #include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_cc.h>
 #include <ipmitool/ipmi_picmg.h>
 #include <ipmitool/ipmi_fru.h>		/* for access to link descriptor defines */
+#include <ipmitool/ipmi_sdr.h>
 #include <ipmitool/ipmi_strings.h>
 #include <ipmitool/log.h>
 
@@ -179,6 +183,8 @@ ipmi_picmg_help (void)
 	lprintf(LOG_NOTICE, " clk set              - set clk state");
 	lprintf(LOG_NOTICE,
 			" busres summary       - display brief bused resource status info");
+	lprintf(LOG_NOTICE,
+			" inventory [json]     - port, LED and power state of all IPMCs");
 }
 
 
@@ -1876,6 +1882,613 @@ ipmi_picmg_clk_set(struct ipmi_intf * intf, int argc, char ** argv)
 }
 
 
+/* shelf model gathered by 'picmg inventory' */
+#define PICMG_INV_MAX_LED	32
+
+struct picmg_inv_led {
+	uint8_t id;
+	uint8_t flags;		/* LED state flags from Get FRU LED State */
+	uint8_t func;		/* effective function: 0 off, 0xff on, else blink */
+	uint8_t color;		/* effective color */
+};
+
+struct picmg_inv_fru {
+	uint8_t id;
+	int power_rc;
+	uint8_t power_level;
+	uint8_t power_dynamic;
+	uint16_t power_draw;	/* in 0.1 W units, 0 if unknown */
+	int nleds;
+	struct picmg_inv_led led[PICMG_INV_MAX_LED];
+};
+
+struct picmg_inv_link {
+	uint8_t iface;		/* E-Keying interface, 0xff for AMC channels */
+	uint8_t chan;
+	uint8_t port;
+	uint8_t type;
+	uint8_t ext;
+	uint8_t grouping;
+	uint8_t state;
+};
+
+struct picmg_inv_ipmc {
+	uint8_t addr;
+	uint8_t channel;
+	char name[17];
+	int present;
+	uint8_t version;
+	uint8_t max_fru;
+	int nfrus;
+	struct picmg_inv_fru *fru;
+	int nlinks;
+	int maxlinks;
+	struct picmg_inv_link *link;
+};
+
+struct picmg_shelf {
+	int count;
+	int size;
+	struct picmg_inv_ipmc *ipmc;
+};
+
+/* picmg_inv_send - send a PICMG request to the current target
+ *
+ * @intf:	ipmi interface
+ * @cmd:	PICMG command
+ * @data:	request data, data[0] must hold the PICMG identifier
+ * @len:	request data length
+ *
+ * returns the raw response so callers can check the completion code
+ */
+static struct ipmi_rs *
+picmg_inv_send(struct ipmi_intf *intf, uint8_t cmd, uint8_t *data, int len)
+{
+	struct ipmi_rq req;
+
+	memset(&req, 0, sizeof(req));
+	req.msg.netfn = IPMI_NETFN_PICMG;
+	req.msg.cmd = cmd;
+	req.msg.data = data;
+	req.msg.data_len = len;
+
+	return intf->sendrecv(intf, &req);
+}
+
+/* picmg_inv_add_ipmc - add an IPMC to the shelf model once */
+static struct picmg_inv_ipmc *
+picmg_inv_add_ipmc(struct picmg_shelf *shelf, uint8_t addr, uint8_t channel)
+{
+	struct picmg_inv_ipmc *ipmc;
+	int i;
+
+	for (i = 0; i < shelf->count; i++) {
+		if (shelf->ipmc[i].addr == addr
+				&& shelf->ipmc[i].channel == channel) {
+			return &shelf->ipmc[i];
+		}
+	}
+
+	if (shelf->count == shelf->size) {
+		int size = shelf->size ? shelf->size * 2 : 8;
+
+		ipmc = realloc(shelf->ipmc, size * sizeof(*ipmc));
+		if (!ipmc) {
+			lprintf(LOG_ERR, "ipmitool: malloc failure");
+			return NULL;
+		}
+		shelf->ipmc = ipmc;
+		shelf->size = size;
+	}
+
+	ipmc = &shelf->ipmc[shelf->count++];
+	memset(ipmc, 0, sizeof(*ipmc));
+	ipmc->addr = addr;
+	ipmc->channel = channel;
+
+	return ipmc;
+}
+
+/* picmg_inv_free - release the shelf model */
+static void
+picmg_inv_free(struct picmg_shelf *shelf)
+{
+	int i;
+
+	for (i = 0; i < shelf->count; i++) {
+		free(shelf->ipmc[i].fru);
+		free(shelf->ipmc[i].link);
+	}
+	free(shelf->ipmc);
+	memset(shelf, 0, sizeof(*shelf));
+}
+
+/* picmg_inv_discover - list the local IPMC and every MC device locator
+ * found in the SDR repository
+ */
+static int
+picmg_inv_discover(struct ipmi_intf *intf, struct picmg_shelf *shelf)
+{
+	struct sdr_get_rs *header;
+	struct ipmi_sdr_iterator *itr;
+	struct picmg_inv_ipmc *ipmc;
+
+	ipmc = picmg_inv_add_ipmc(shelf, intf->target_addr,
+			intf->target_channel);
+	if (!ipmc) {
+		return -1;
+	}
+	snprintf(ipmc->name, sizeof(ipmc->name), "local");
+
+	itr = ipmi_sdr_start(intf, 0);
+	if (!itr) {
+		lprintf(LOG_WARN, "Unable to open SDR repository, "
+				"inventory limited to the local IPMC");
+		return 0;
+	}
+
+	while ((header = ipmi_sdr_get_next_header(intf, itr))) {
+		struct sdr_record_mc_locator *mc;
+		int len;
+
+		if (header->type != SDR_RECORD_TYPE_MC_DEVICE_LOCATOR) {
+			continue;
+		}
+		mc = (struct sdr_record_mc_locator *)
+			ipmi_sdr_get_record(intf, header, itr);
+		if (!mc) {
+			continue;
+		}
+		ipmc = picmg_inv_add_ipmc(shelf, mc->dev_slave_addr,
+				mc->channel_num);
+		if (ipmc) {
+			len = __min(mc->id_code & 0x1f, (int)sizeof(mc->id_string));
+			snprintf(ipmc->name, sizeof(ipmc->name), "%.*s",
+					len, (const char *)mc->id_string);
+		}
+		free_n(&mc);
+	}
+	ipmi_sdr_end(itr);
+
+	return 0;
+}
+
+/* picmg_inv_read_fru - read power level and LED states of one FRU */
+static void
+picmg_inv_read_fru(struct ipmi_intf *intf, struct picmg_inv_fru *fru)
+{
+	struct ipmi_rs *rsp;
+	uint8_t msg_data[3];
+	uint8_t mask;
+	int count;
+	int led;
+
+	/* steady state power draw levels */
+	msg_data[0] = 0x00;
+	msg_data[1] = fru->id;
+	msg_data[2] = 0x00;
+	rsp = picmg_inv_send(intf, PICMG_GET_POWER_LEVEL_CMD, msg_data, 3);
+	if (!rsp || rsp->ccode || rsp->data_len < 4) {
+		fru->power_rc = -1;
+	} else {
+		fru->power_level = rsp->data[1] & 0x0f;
+		fru->power_dynamic = (rsp->data[1] & 0x80) ? 1 : 0;
+		if (fru->power_level
+				&& rsp->data_len >= 4 + fru->power_level) {
+			fru->power_draw = rsp->data[3 + fru->power_level]
+				* rsp->data[3];
+		}
+	}
+
+	/* LED properties, then the state of every LED present */
+	rsp = picmg_inv_send(intf, PICMG_GET_FRU_LED_PROPERTIES_CMD,
+			msg_data, 2);
+	if (!rsp || rsp->ccode || rsp->data_len < 3) {
+		return;
+	}
+	mask = rsp->data[1] & 0x0f;
+	count = rsp->data[2];
+
+	for (led = 0; led < 4 + count && led <= 0xfe; led++) {
+		struct picmg_inv_led *l;
+
+		if (led < 4 && !(mask & (1 << led))) {
+			continue;
+		}
+		if (fru->nleds == PICMG_INV_MAX_LED) {
+			break;
+		}
+		msg_data[2] = led;
+		rsp = picmg_inv_send(intf, PICMG_GET_FRU_LED_STATE_CMD,
+				msg_data, 3);
+		if (!rsp || rsp->ccode || rsp->data_len < 5) {
+			continue;
+		}
+		l = &fru->led[fru->nleds++];
+		l->id = led;
+		l->flags = rsp->data[1];
+		l->func = rsp->data[2];
+		l->color = rsp->data[4];
+		if ((l->flags & 0x02) && rsp->data_len >= 8) {
+			l->func = rsp->data[5];
+			l->color = rsp->data[7];
+		}
+	}
+}
+
+/* picmg_inv_add_link - append a link descriptor to the IPMC */
+static int
+picmg_inv_add_link(struct picmg_inv_ipmc *ipmc,
+		const struct picmg_inv_link *link)
+{
+	if (ipmc->nlinks == ipmc->maxlinks) {
+		int size = ipmc->maxlinks ? ipmc->maxlinks * 2 : 16;
+		struct picmg_inv_link *p;
+
+		p = realloc(ipmc->link, size * sizeof(*p));
+		if (!p) {
+			lprintf(LOG_ERR, "ipmitool: malloc failure");
+			return -1;
+		}
+		ipmc->link = p;
+		ipmc->maxlinks = size;
+	}
+	ipmc->link[ipmc->nlinks++] = *link;
+
+	return 0;
+}
+
+/* picmg_inv_read_ports - read the E-Keying port state of every channel
+ *
+ * ATCA IPMCs are queried for each interface and channel, AMC modules
+ * for each AMC channel.  The scan stops early when the IPMC does not
+ * answer or does not implement the command.
+ */
+static void
+picmg_inv_read_ports(struct ipmi_intf *intf, struct picmg_inv_ipmc *ipmc)
+{
+	struct picmg_inv_link link;
+	struct ipmi_rs *rsp;
+	uint8_t msg_data[2];
+	int amc = (ipmc->version & 0x0f) == PICMG_AMC_MAJOR_VERSION;
+	int iface;
+	int chan;
+	int i;
+
+	for (iface = 0; iface <= PICMG_EKEY_MAX_INTERFACE; iface++) {
+		int first = amc ? 0 : 1;
+		int last = PICMG_EKEY_MAX_CHANNEL;
+
+		if (amc && iface) {
+			break;
+		}
+		if (iface == FRU_PICMGEXT_DESIGN_IF_FABRIC) {
+			last = PICMG_EKEY_MAX_FABRIC_CHANNEL;
+		}
+
+		for (chan = first; chan <= last; chan++) {
+			msg_data[0] = 0x00;
+			if (amc) {
+				msg_data[1] = chan;
+				rsp = picmg_inv_send(intf,
+						PICMG_AMC_GET_PORT_STATE_CMD,
+						msg_data, 2);
+			} else {
+				msg_data[1] = (iface << 6) | (chan & 0x3f);
+				rsp = picmg_inv_send(intf,
+						PICMG_GET_PORT_STATE_CMD, msg_data, 2);
+			}
+			if (!rsp || rsp->ccode == IPMI_CC_INV_CMD) {
+				return;
+			}
+			if (rsp->ccode) {
+				continue;
+			}
+
+			for (i = 0; i < PICMG_MAX_LINK_PER_CHANNEL; i++) {
+				const uint8_t *d;
+
+				memset(&link, 0, sizeof(link));
+				link.chan = chan;
+				if (amc) {
+					if (rsp->data_len < 5 + i * 4) {
+						break;
+					}
+					d = &rsp->data[1 + i * 4];
+					link.iface = 0xff;
+					link.port = d[0] & 0x0f;
+					link.type = (d[0] >> 4) | ((d[1] & 0x0f) << 4);
+					link.ext = d[1] >> 4;
+					link.grouping = d[2];
+					link.state = d[3];
+				} else {
+					if (rsp->data_len < 6 + i * 5) {
+						break;
+					}
+					d = &rsp->data[1 + i * 5];
+					link.iface = iface;
+					link.port = d[1] & 0x0f;
+					link.type = (d[1] >> 4) | ((d[2] & 0x0f) << 4);
+					link.ext = d[2] >> 4;
+					link.grouping = d[3];
+					link.state = d[4];
+				}
+				if (picmg_inv_add_link(ipmc, &link) < 0) {
+					return;
+				}
+			}
+		}
+	}
+}
+
+/* picmg_inv_read_ipmc - bridge to one IPMC and read all of its FRUs */
+static int
+picmg_inv_read_ipmc(struct ipmi_intf *intf, struct picmg_inv_ipmc *ipmc)
+{
+	struct ipmi_rs *rsp;
+	uint8_t msg_data = 0;
+	int i;
+
+	rsp = picmg_inv_send(intf, PICMG_GET_PICMG_PROPERTIES_CMD,
+			&msg_data, 1);
+	if (!rsp || rsp->ccode || rsp->data_len < 4) {
+		lprintf(LOG_INFO, "IPMC 0x%02x: no PICMG properties, skipped",
+				ipmc->addr);
+		return -1;
+	}
+	ipmc->present = 1;
+	ipmc->version = rsp->data[1];
+	ipmc->max_fru = rsp->data[2];
+
+	ipmc->fru = calloc(ipmc->max_fru + 1, sizeof(*ipmc->fru));
+	if (!ipmc->fru) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		return -1;
+	}
+	for (i = 0; i <= ipmc->max_fru; i++) {
+		ipmc->fru[i].id = i;
+		picmg_inv_read_fru(intf, &ipmc->fru[i]);
+	}
+	ipmc->nfrus = ipmc->max_fru + 1;
+
+	picmg_inv_read_ports(intf, ipmc);
+
+	return 0;
+}
+
+/* picmg_inv_read - gather the whole shelf, bridging to each IPMC once */
+static int
+picmg_inv_read(struct ipmi_intf *intf, struct picmg_shelf *shelf)
+{
+	uint32_t save_addr = intf->target_addr;
+	uint8_t save_channel = intf->target_channel;
+	int found = 0;
+	int i;
+
+	if (picmg_inv_discover(intf, shelf) < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < shelf->count; i++) {
+		intf->target_addr = shelf->ipmc[i].addr;
+		intf->target_channel = shelf->ipmc[i].channel;
+		if (picmg_inv_read_ipmc(intf, &shelf->ipmc[i]) == 0) {
+			found++;
+		}
+	}
+
+	intf->target_addr = save_addr;
+	intf->target_channel = save_channel;
+
+	if (!found) {
+		lprintf(LOG_ERR, "No PICMG IPMC found");
+		return -1;
+	}
+	return 0;
+}
+
+static const char *
+picmg_inv_led_func(uint8_t func)
+{
+	if (func == 0x00) {
+		return "off";
+	} else if (func == 0xff) {
+		return "on";
+	}
+	return "blink";
+}
+
+static const char *
+picmg_inv_iface_str(uint8_t iface)
+{
+	switch (iface) {
+	case FRU_PICMGEXT_DESIGN_IF_BASE:
+		return "base";
+	case FRU_PICMGEXT_DESIGN_IF_FABRIC:
+		return "fabric";
+	case FRU_PICMGEXT_DESIGN_IF_UPDATE_CHANNEL:
+		return "update";
+	case 0xff:
+		return "amc";
+	default:
+		return "reserved";
+	}
+}
+
+/* picmg_inv_print - print the shelf model as text */
+static void
+picmg_inv_print(const struct picmg_shelf *shelf)
+{
+	int i;
+	int f;
+	int l;
+
+	for (i = 0; i < shelf->count; i++) {
+		const struct picmg_inv_ipmc *ipmc = &shelf->ipmc[i];
+
+		if (!ipmc->present) {
+			continue;
+		}
+		printf("IPMC 0x%02x channel %d \"%s\" PICMG %d.%d, %d FRU(s)\n",
+				ipmc->addr, ipmc->channel, ipmc->name,
+				ipmc->version & 0x0f, ipmc->version >> 4,
+				ipmc->nfrus);
+
+		for (f = 0; f < ipmc->nfrus; f++) {
+			const struct picmg_inv_fru *fru = &ipmc->fru[f];
+
+			printf("  FRU %-3d power: ", fru->id);
+			if (fru->power_rc) {
+				printf("n/a");
+			} else {
+				printf("level %d%s", fru->power_level,
+						fru->power_dynamic ? " (dynamic)" : "");
+				if (fru->power_draw) {
+					printf(", %d.%d W", fru->power_draw / 10,
+							fru->power_draw % 10);
+				}
+			}
+			printf("\n");
+			for (l = 0; l < fru->nleds; l++) {
+				const struct picmg_inv_led *led = &fru->led[l];
+
+				printf("          LED %-3d %-5s %-8s%s%s\n", led->id,
+						picmg_inv_led_func(led->func),
+						picmg_led_color_str(led->color),
+						(led->flags & 0x02) ? " override" : "",
+						(led->flags & 0x04) ? " lamptest" : "");
+			}
+		}
+
+		if (!ipmc->nlinks) {
+			continue;
+		}
+		printf("  %-8s %-4s %-4s %-5s %-4s %-5s %s\n", "Intf", "Chan",
+				"Port", "Type", "Ext", "Group", "State");
+		for (l = 0; l < ipmc->nlinks; l++) {
+			const struct picmg_inv_link *link = &ipmc->link[l];
+
+			printf("  %-8s %-4d 0x%-2x 0x%02x  0x%-2x 0x%02x  %s\n",
+					picmg_inv_iface_str(link->iface), link->chan,
+					link->port, link->type, link->ext,
+					link->grouping,
+					link->state ? "enabled" : "disabled");
+		}
+	}
+}
+
+/* picmg_inv_print_json - print the shelf model as JSON */
+static void
+picmg_inv_print_json(const struct picmg_shelf *shelf)
+{
+	const char *sep = "";
+	const char *name;
+	int i;
+	int f;
+	int l;
+
+	printf("{\"ipmcs\":[");
+	for (i = 0; i < shelf->count; i++) {
+		const struct picmg_inv_ipmc *ipmc = &shelf->ipmc[i];
+
+		if (!ipmc->present) {
+			continue;
+		}
+		printf("%s\n {\"address\":%d,\"channel\":%d,\"name\":\"", sep,
+				ipmc->addr, ipmc->channel);
+		/* the SDR ID string may hold any byte */
+		for (name = ipmc->name; *name; name++) {
+			if (*name == '"' || *name == '\\') {
+				putchar('\\');
+			}
+			if ((unsigned char)*name < 0x20) {
+				printf("\\u%04x", *name);
+			} else {
+				putchar(*name);
+			}
+		}
+		printf("\",\"version\":\"%d.%d\",\"frus\":[",
+				ipmc->version & 0x0f, ipmc->version >> 4);
+		sep = ",";
+
+		for (f = 0; f < ipmc->nfrus; f++) {
+			const struct picmg_inv_fru *fru = &ipmc->fru[f];
+
+			printf("%s\n  {\"id\":%d,", f ? "," : "", fru->id);
+			if (fru->power_rc) {
+				printf("\"power\":null,");
+			} else {
+				printf("\"power\":{\"level\":%d,\"dynamic\":%s,"
+						"\"watts\":%d.%d},",
+						fru->power_level,
+						fru->power_dynamic ? "true" : "false",
+						fru->power_draw / 10, fru->power_draw % 10);
+			}
+			printf("\"leds\":[");
+			for (l = 0; l < fru->nleds; l++) {
+				const struct picmg_inv_led *led = &fru->led[l];
+
+				printf("%s{\"id\":%d,\"function\":\"%s\","
+						"\"color\":\"%s\",\"override\":%s,"
+						"\"lamptest\":%s}",
+						l ? "," : "", led->id,
+						picmg_inv_led_func(led->func),
+						picmg_led_color_str(led->color),
+						(led->flags & 0x02) ? "true" : "false",
+						(led->flags & 0x04) ? "true" : "false");
+			}
+			printf("]}");
+		}
+		printf("],\n  \"ports\":[");
+		for (l = 0; l < ipmc->nlinks; l++) {
+			const struct picmg_inv_link *link = &ipmc->link[l];
+
+			printf("%s\n   {\"interface\":\"%s\",\"channel\":%d,"
+					"\"port\":%d,\"type\":%d,\"ext\":%d,"
+					"\"grouping\":%d,\"enabled\":%s}",
+					l ? "," : "",
+					picmg_inv_iface_str(link->iface), link->chan,
+					link->port, link->type, link->ext,
+					link->grouping, link->state ? "true" : "false");
+		}
+		printf("]}");
+	}
+	printf("\n]}\n");
+}
+
+/* ipmi_picmg_inventory - gather port states, LED states and power levels
+ * of every FRU on every IPMC found in the SDR repository
+ *
+ * usage: picmg inventory [json]
+ */
+static int
+ipmi_picmg_inventory(struct ipmi_intf *intf, int argc, char **argv)
+{
+	struct picmg_shelf shelf;
+	int json = 0;
+	int rc;
+
+	if (argc > 0) {
+		if (strcmp(argv[0], "json")) {
+			lprintf(LOG_NOTICE, "usage: inventory [json]");
+			return -1;
+		}
+		json = 1;
+	}
+
+	memset(&shelf, 0, sizeof(shelf));
+	rc = picmg_inv_read(intf, &shelf);
+	if (rc == 0) {
+		if (json) {
+			picmg_inv_print_json(&shelf);
+		} else {
+			picmg_inv_print(&shelf);
+		}
+	}
+	picmg_inv_free(&shelf);
+
+	return rc;
+}
 
 int
 ipmi_picmg_main (struct ipmi_intf * intf, int argc, char ** argv)
@@ -1898,6 +2511,9 @@ ipmi_picmg_main (struct ipmi_intf * intf, int argc, char ** argv)
 	if (!strcmp(argv[0], "addrinfo")) {
 		rc = ipmi_picmg_getaddr(intf, argc-1, &argv[1]);
 	}
+	else if (!strcmp(argv[0], "inventory")) {
+		rc = ipmi_picmg_inventory(intf, argc-1, &argv[1]);
+	}
 	else if (!strcmp(argv[0], "busres")) {
 		if (argc > 1) {
 			if (!strcmp(argv[1], "summary")) {
@@ -33,6 +33,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <inttypes.h>
 
 #include <ipmitool/ipmi.h>
 #include <ipmitool/log.h>
@@ -42,6 +43,8 @@
 #include <ipmitool/ipmi_strings.h>
 
 #define IPMI_I2C_MASTER_MAX_SIZE	0x40 /* 64 bytes */
+#define RAW_DATA_MAX			256
+#define RAW_STREAM_LINE_SIZE		4096
 
 static int is_valid_param(const char *input_param, uint8_t *uchr_ptr,
 		const char *label);
@@ -311,36 +314,39 @@ void
 ipmi_raw_help()
 {
 	lprintf(LOG_NOTICE, "RAW Commands:  raw <netfn> <cmd> [data]");
+	lprintf(LOG_NOTICE, "               raw stream");
 	print_valstr(ipmi_netfn_vals, "Network Function Codes", LOG_NOTICE);
 	lprintf(LOG_NOTICE, "(can also use raw hex values)");
 } /* ipmi_raw_help() */
 
-int
-ipmi_raw_main(struct ipmi_intf * intf, int argc, char ** argv)
+/* ipmi_raw_parse_req() - fill in a raw request from command arguments
+ *
+ * @argc:	number of arguments
+ * @argv:	<netfn> <cmd> [data] arguments
+ * @req:	request to fill in
+ * @data:	data buffer of RAW_DATA_MAX bytes to attach to @req
+ * @lun:	target LUN
+ *
+ * returns   0  on success
+ * returns (-1) if any of the arguments is invalid
+ */
+static int
+ipmi_raw_parse_req(int argc, char **argv, struct ipmi_rq *req,
+		   uint8_t *data, uint8_t lun)
 {
-	struct ipmi_rs * rsp;
-	struct ipmi_rq req;
-	uint8_t netfn, cmd, lun;
+	uint8_t netfn, cmd;
 	uint16_t netfn_tmp = 0;
 	int i;
-	uint8_t data[256];
 
-	if (argc == 1 && !strcmp(argv[0], "help")) {
-		ipmi_raw_help();
-		return 0;
-	}
-	else if (argc < 2) {
+	if (argc < 2) {
 		lprintf(LOG_ERR, "Not enough parameters given.");
-		ipmi_raw_help();
 		return (-1);
 	}
-	else if (argc > sizeof(data))
-	{
+	else if (argc - 2 > RAW_DATA_MAX) {
 		lprintf(LOG_NOTICE, "Raw command input limit (256 bytes) exceeded");
-		return -1;
+		return (-1);
 	}
 
-	lun = intf->target_lun;
 	netfn_tmp = str2val(argv[0], ipmi_netfn_vals);
 	if (netfn_tmp == 0xff) {
 		if (is_valid_param(argv[0], &netfn, "netfn") != 0)
@@ -356,12 +362,12 @@ ipmi_raw_main(struct ipmi_intf * intf, int argc, char ** argv)
 	if (is_valid_param(argv[1], &cmd, "command") != 0)
 		return (-1);
 
-	memset(data, 0, sizeof(data));
-	memset(&req, 0, sizeof(req));
-	req.msg.netfn = netfn;
-	req.msg.lun = lun;
-	req.msg.cmd = cmd;
-	req.msg.data = data;
+	memset(data, 0, RAW_DATA_MAX);
+	memset(req, 0, sizeof(*req));
+	req->msg.netfn = netfn;
+	req->msg.lun = lun;
+	req->msg.cmd = cmd;
+	req->msg.data = data;
 
 	for (i=2; i<argc; i++) {
 		uint8_t val = 0;
@@ -369,9 +375,190 @@ ipmi_raw_main(struct ipmi_intf * intf, int argc, char ** argv)
 		if (is_valid_param(argv[i], &val, "data") != 0)
 			return (-1);
 
-		req.msg.data[i-2] = val;
-		req.msg.data_len++;
+		req->msg.data[i-2] = val;
+		req->msg.data_len++;
+	}
+
+	return 0;
+}
+
+static int
+raw_latency_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* ipmi_raw_stream_stats() - print latency percentiles of a stream session
+ *
+ * @lat:	per-request latencies in microseconds, sorted in place
+ * @count:	number of entries in @lat
+ * @failed:	number of requests that got no response or were invalid
+ */
+static void
+ipmi_raw_stream_stats(uint64_t *lat, size_t count, size_t failed)
+{
+	static const unsigned int pct[] = { 50, 90, 99 };
+	size_t i;
+
+	lprintf(LOG_NOTICE, "raw stream: %zu requests, %zu failed",
+		count + failed, failed);
+	if (!count)
+		return;
+
+	qsort(lat, count, sizeof(*lat), raw_latency_cmp);
+	for (i = 0; i < ARRAY_SIZE(pct); i++) {
+		uint64_t v = lat[(count - 1) * pct[i] / 100];
+
+		lprintf(LOG_NOTICE, "raw stream: p%u latency %" PRIu64
+			".%03" PRIu64 " ms", pct[i], v / 1000, v % 1000);
 	}
+	lprintf(LOG_NOTICE, "raw stream: max latency %" PRIu64
+		".%03" PRIu64 " ms", lat[count - 1] / 1000,
+		lat[count - 1] % 1000);
+}
+
+/* ipmi_raw_stream() - execute raw requests read from stdin
+ *
+ * Every input line has the form "<id> <netfn> <cmd> [data]", with the
+ * same value syntax as the raw command.  <id> is an arbitrary token
+ * that is echoed back as the first field of the matching response line:
+ *
+ *   <id> <ccode> [data]      - response received, hex bytes
+ *   <id> error               - request could not be parsed
+ *   <id> noresponse          - no response from the BMC
+ *
+ * All requests share the session established for the first one.
+ * Latency percentiles are printed to stderr at end of input.
+ *
+ * returns   0  if every request received a response
+ * returns (-1) otherwise
+ */
+static int
+ipmi_raw_stream(struct ipmi_intf *intf)
+{
+	char buf[RAW_STREAM_LINE_SIZE];
+	char *argv[RAW_DATA_MAX + 3];
+	uint8_t data[RAW_DATA_MAX];
+	uint64_t *lat = NULL;
+	size_t count = 0;
+	size_t alloc = 0;
+	size_t failed = 0;
+	struct ipmi_rs *rsp;
+	struct ipmi_rq req;
+	uint64_t start;
+	int argc, i;
+	char *tok;
+
+	while (fgets(buf, sizeof(buf), stdin)) {
+		size_t len = strlen(buf);
+		int toolong = 0;
+
+		/* a line that did not fit is discarded, not split in two */
+		if (len && buf[len - 1] != '\n') {
+			int c = getchar();
+
+			if (c != '\n' && c != EOF) {
+				toolong = 1;
+				while ((c = getchar()) != '\n' && c != EOF)
+					;
+			}
+		}
+
+		argc = 0;
+		for (tok = strtok(buf, " \t\r\n"); tok;
+		     tok = strtok(NULL, " \t\r\n"))
+		{
+			if (argc == (int)ARRAY_SIZE(argv)) {
+				toolong = 1;
+				break;
+			}
+			argv[argc++] = tok;
+		}
+
+		/* skip blank lines and comments */
+		if (!argc || argv[0][0] == '#')
+			continue;
+
+		if (toolong) {
+			lprintf(LOG_ERR, "raw stream: request %s is too long",
+				argv[0]);
+			printf("%s error\n", argv[0]);
+			fflush(stdout);
+			failed++;
+			continue;
+		}
+
+		if (ipmi_raw_parse_req(argc - 1, &argv[1], &req, data,
+				       intf->target_lun))
+		{
+			printf("%s error\n", argv[0]);
+			fflush(stdout);
+			failed++;
+			continue;
+		}
+
+		start = ipmi_time_usec();
+		rsp = intf->sendrecv(intf, &req);
+		if (!rsp) {
+			printf("%s noresponse\n", argv[0]);
+			fflush(stdout);
+			failed++;
+			continue;
+		}
+
+		if (count == alloc) {
+			uint64_t *tmp;
+
+			alloc = alloc ? alloc * 2 : 1024;
+			tmp = realloc(lat, alloc * sizeof(*lat));
+			if (!tmp) {
+				lprintf(LOG_ERR, "ipmitool: malloc failure");
+				free(lat);
+				return (-1);
+			}
+			lat = tmp;
+		}
+		lat[count++] = ipmi_time_usec() - start;
+
+		printf("%s %2.2x", argv[0], rsp->ccode);
+		for (i = 0; i < rsp->data_len; i++)
+			printf(" %2.2x", rsp->data[i]);
+		printf("\n");
+		fflush(stdout);
+	}
+
+	ipmi_raw_stream_stats(lat, count, failed);
+	free(lat);
+
+	return failed ? (-1) : 0;
+}
+
+int
+ipmi_raw_main(struct ipmi_intf * intf, int argc, char ** argv)
+{
+	struct ipmi_rs * rsp;
+	struct ipmi_rq req;
+	int i;
+	uint8_t data[RAW_DATA_MAX];
+
+	if (argc == 1 && !strcmp(argv[0], "help")) {
+		ipmi_raw_help();
+		return 0;
+	}
+	else if (argc == 1 && !strcmp(argv[0], "stream")) {
+		return ipmi_raw_stream(intf);
+	}
+	else if (argc < 2) {
+		lprintf(LOG_ERR, "Not enough parameters given.");
+		ipmi_raw_help();
+		return (-1);
+	}
+
+	if (ipmi_raw_parse_req(argc, argv, &req, data, intf->target_lun))
+		return (-1);
 
 	lprintf(LOG_INFO, 
            "RAW REQ (channel=0x%x netfn=0x%x lun=0x%x cmd=0x%x data_len=%d)",
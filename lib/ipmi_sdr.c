@@ -350,43 +350,40 @@ sdr_sensor_has_analog_reading(struct ipmi_intf *intf,
 	return 1;
 }
 
-/* sdr_convert_sensor_reading  -  convert raw sensor reading
- *
- * @sensor:	sensor record
- * @val:	raw sensor reading
+/* sdr_pow10  -  10^exp for the 4-bit signed SDR exponents
  *
- * returns floating-point sensor reading
+ * The table is filled from pow() on first use so results stay
+ * bit-identical to computing pow(10, exp) for every reading.
  */
-double
-sdr_convert_sensor_reading(struct sdr_record_full_sensor *sensor, uint8_t val)
+static double
+sdr_pow10(int exp)
 {
-	int m, b, k1, k2;
-	double result;
+	static double pow10_tab[16];
+	static int pow10_init;
 
-	m = __TO_M(sensor->mtol);
-	b = __TO_B(sensor->bacc);
-	k1 = __TO_B_EXP(sensor->bacc);
-	k2 = __TO_R_EXP(sensor->bacc);
+	if (!pow10_init) {
+		int i;
 
-	switch (sensor->cmn.unit.analog) {
-	case 0:
-		result = (double) (((m * val) +
-				    (b * pow(10, k1))) * pow(10, k2));
-		break;
-	case 1:
-		if (val & 0x80)
-			val++;
-		/* fall through */
-	case 2:
-		result = (double) (((m * (int8_t) val) +
-				    (b * pow(10, k1))) * pow(10, k2));
-		break;
-	default:
-		/* Oops! This isn't an analog sensor. */
-		return 0.0;
+		for (i = 0; i < 16; i++)
+			pow10_tab[i] = pow(10, i - 8);
+		pow10_init = 1;
 	}
+	if (exp < -8 || exp > 7)
+		return pow(10, exp);
+	return pow10_tab[exp + 8];
+}
 
-	switch (sensor->linearization & 0x7f) {
+/* sdr_linearize  -  apply the linearization formula of a sensor
+ *
+ * @result:	linear reading
+ * @linearization:	SDR linearization byte
+ *
+ * returns linearized reading
+ */
+static double
+sdr_linearize(double result, uint8_t linearization)
+{
+	switch (linearization & 0x7f) {
 	case SDR_SENSOR_L_LN:
 		result = log(result);
 		break;
@@ -426,6 +423,117 @@ sdr_convert_sensor_reading(struct sdr_record_full_sensor *sensor, uint8_t val)
 	}
 	return result;
 }
+
+/* sdr_conv_init  -  decode the conversion factors of a full sensor record
+ *
+ * Sensors with non-linear readings get new factors with every reading
+ * (see ipmi_sensor_get_sensor_reading_factors), so re-initialize after
+ * those have been updated.
+ *
+ * @conv:	conversion factors to fill in
+ * @sensor:	sensor record
+ */
+void
+sdr_conv_init(struct sdr_conv *conv, const struct sdr_record_full_sensor *sensor)
+{
+	conv->m = __TO_M(sensor->mtol);
+	conv->b = __TO_B(sensor->bacc) * sdr_pow10(__TO_B_EXP(sensor->bacc));
+	conv->r = sdr_pow10(__TO_R_EXP(sensor->bacc));
+	conv->analog = sensor->cmn.unit.analog;
+	conv->linearization = sensor->linearization;
+}
+
+/* sdr_conv_reading  -  convert raw sensor reading with decoded factors
+ *
+ * @conv:	conversion factors
+ * @val:	raw sensor reading
+ *
+ * returns floating-point sensor reading
+ */
+double
+sdr_conv_reading(const struct sdr_conv *conv, uint8_t val)
+{
+	double result;
+
+	switch (conv->analog) {
+	case 0:
+		result = (double) (((conv->m * val) + conv->b) * conv->r);
+		break;
+	case 1:
+		if (val & 0x80)
+			val++;
+		/* fall through */
+	case 2:
+		result = (double) (((conv->m * (int8_t) val) + conv->b) * conv->r);
+		break;
+	default:
+		/* Oops! This isn't an analog sensor. */
+		return 0.0;
+	}
+
+	return sdr_linearize(result, conv->linearization);
+}
+
+/* sdr_conv_table  -  convert every possible raw reading
+ *
+ * @conv:	conversion factors
+ * @table:	filled with the reading of each raw value 0..255
+ */
+void
+sdr_conv_table(const struct sdr_conv *conv, double table[256])
+{
+	int i;
+
+	for (i = 0; i < 256; i++)
+		table[i] = sdr_conv_reading(conv, i);
+}
+
+/* sdr_convert_sensor_readings  -  convert an array of raw sensor readings
+ *
+ * Raw readings are 8 bits wide, so large batches go through a table of
+ * all 256 readings built once and are then converted by a plain lookup.
+ *
+ * @sensor:	sensor record
+ * @raw:	raw sensor readings
+ * @out:	floating-point sensor readings
+ * @count:	number of readings
+ */
+void
+sdr_convert_sensor_readings(struct sdr_record_full_sensor *sensor,
+			    const uint8_t *raw, double *out, size_t count)
+{
+	struct sdr_conv conv;
+	double table[256];
+	size_t i;
+
+	sdr_conv_init(&conv, sensor);
+
+	if (count < ARRAY_SIZE(table)) {
+		for (i = 0; i < count; i++)
+			out[i] = sdr_conv_reading(&conv, raw[i]);
+		return;
+	}
+
+	sdr_conv_table(&conv, table);
+	for (i = 0; i < count; i++)
+		out[i] = table[raw[i]];
+}
+
+/* sdr_convert_sensor_reading  -  convert raw sensor reading
+ *
+ * @sensor:	sensor record
+ * @val:	raw sensor reading
+ *
+ * returns floating-point sensor reading
+ */
+double
+sdr_convert_sensor_reading(struct sdr_record_full_sensor *sensor, uint8_t val)
+{
+	struct sdr_conv conv;
+
+	sdr_conv_init(&conv, sensor);
+	return sdr_conv_reading(&conv, val);
+}
 /* sdr_convert_sensor_hysterisis  -  convert raw sensor hysterisis
  *
  * Even though spec says histerisis should be computed using Mx+B
@@ -442,68 +550,31 @@ sdr_convert_sensor_reading(struct sdr_record_full_sensor *sensor, uint8_t val)
 double
 sdr_convert_sensor_hysterisis(struct sdr_record_full_sensor *sensor, uint8_t val)
 {
-	int m, k2;
+	int m;
+	double k2;
 	double result;
 
 	m = __TO_M(sensor->mtol);
 
-	k2 = __TO_R_EXP(sensor->bacc);
+	k2 = sdr_pow10(__TO_R_EXP(sensor->bacc));
 
 	switch (sensor->cmn.unit.analog) {
 	case 0:
-		result = (double) (((m * val)) * pow(10, k2));
+		result = (double) (((m * val)) * k2);
 		break;
 	case 1:
 		if (val & 0x80)
 			val++;
 		/* fall through */
 	case 2:
-		result = (double) (((m * (int8_t) val) ) * pow(10, k2));
+		result = (double) (((m * (int8_t) val) ) * k2);
 		break;
 	default:
 		/* Oops! This isn't an analog sensor. */
 		return 0.0;
 	}
 
-	switch (sensor->linearization & 0x7f) {
-	case SDR_SENSOR_L_LN:
-		result = log(result);
-		break;
-	case SDR_SENSOR_L_LOG10:
-		result = log10(result);
-		break;
-	case SDR_SENSOR_L_LOG2:
-		result = (double) (log(result) / log(2.0));
-		break;
-	case SDR_SENSOR_L_E:
-		result = exp(result);
-		break;
-	case SDR_SENSOR_L_EXP10:
-		result = pow(10.0, result);
-		break;
-	case SDR_SENSOR_L_EXP2:
-		result = pow(2.0, result);
-		break;
-	case SDR_SENSOR_L_1_X:
-		result = pow(result, -1.0);	/*1/x w/o exception */
-		break;
-	case SDR_SENSOR_L_SQR:
-		result = pow(result, 2.0);
-		break;
-	case SDR_SENSOR_L_CUBE:
-		result = pow(result, 3.0);
-		break;
-	case SDR_SENSOR_L_SQRT:
-		result = sqrt(result);
-		break;
-	case SDR_SENSOR_L_CUBERT:
-		result = cbrt(result);
-		break;
-	case SDR_SENSOR_L_LINEAR:
-	default:
-		break;
-	}
-	return result;
+	return sdr_linearize(result, sensor->linearization);
 }
 
 
@@ -517,68 +588,31 @@ sdr_convert_sensor_hysterisis(struct sdr_record_full_sensor *sensor, uint8_t val
 double
 sdr_convert_sensor_tolerance(struct sdr_record_full_sensor *sensor, uint8_t val)
 {
-	int m,   k2;
+	int m;
+	double k2;
 	double result;
 
 	m = __TO_M(sensor->mtol);
-	k2 = __TO_R_EXP(sensor->bacc);
+	k2 = sdr_pow10(__TO_R_EXP(sensor->bacc));
 
 	switch (sensor->cmn.unit.analog) {
 	case 0:
                 /* as suggested in section 30.4.1 of IPMI 1.5 spec */
-		result = (double) ((((m * (double)val/2)) ) * pow(10, k2));
+		result = (double) ((((m * (double)val/2)) ) * k2);
 		break;
 	case 1:
 		if (val & 0x80)
 			val++;
 		/* fall through */
 	case 2:
-		result = (double) (((m * ((double)((int8_t) val)/2))) * pow(10, k2));
+		result = (double) (((m * ((double)((int8_t) val)/2))) * k2);
 		break;
 	default:
 		/* Oops! This isn't an analog sensor. */
 		return 0.0;
 	}
 
-	switch (sensor->linearization & 0x7f) {
-	case SDR_SENSOR_L_LN:
-		result = log(result);
-		break;
-	case SDR_SENSOR_L_LOG10:
-		result = log10(result);
-		break;
-	case SDR_SENSOR_L_LOG2:
-		result = (double) (log(result) / log(2.0));
-		break;
-	case SDR_SENSOR_L_E:
-		result = exp(result);
-		break;
-	case SDR_SENSOR_L_EXP10:
-		result = pow(10.0, result);
-		break;
-	case SDR_SENSOR_L_EXP2:
-		result = pow(2.0, result);
-		break;
-	case SDR_SENSOR_L_1_X:
-		result = pow(result, -1.0);	/*1/x w/o exception */
-		break;
-	case SDR_SENSOR_L_SQR:
-		result = pow(result, 2.0);
-		break;
-	case SDR_SENSOR_L_CUBE:
-		result = pow(result, 3.0);
-		break;
-	case SDR_SENSOR_L_SQRT:
-		result = sqrt(result);
-		break;
-	case SDR_SENSOR_L_CUBERT:
-		result = cbrt(result);
-		break;
-	case SDR_SENSOR_L_LINEAR:
-	default:
-		break;
-	}
-	return result;
+	return sdr_linearize(result, sensor->linearization);
 }
 
 /* sdr_convert_sensor_value_to_raw  -  convert sensor reading back to raw
@@ -592,23 +626,20 @@ uint8_t
 sdr_convert_sensor_value_to_raw(struct sdr_record_full_sensor * sensor,
 				double val)
 {
-	int m, b, k1, k2;
+	struct sdr_conv conv;
 	double result;
 
 	/* only works for analog sensors */
 	if (UNITS_ARE_DISCRETE((&sensor->cmn)))
 		return 0;
 
-	m = __TO_M(sensor->mtol);
-	b = __TO_B(sensor->bacc);
-	k1 = __TO_B_EXP(sensor->bacc);
-	k2 = __TO_R_EXP(sensor->bacc);
+	sdr_conv_init(&conv, sensor);
 
 	/* don't divide by zero */
-	if (m == 0)
+	if (conv.m == 0)
 		return 0;
 
-	result = (((val / pow(10, k2)) - (b * pow(10, k1))) / m);
+	result = (((val / conv.r) - conv.b) / conv.m);
 
 	if ((result - (int) result) >= .5)
 		return (uint8_t) ceil(result);
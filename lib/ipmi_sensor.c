@@ -801,8 +801,9 @@ ipmi_sensor_set_threshold(struct ipmi_intf *intf, int argc, char **argv)
 			lprintf(LOG_ERR, "Sensor data record not found!");
 				return -1;
 		}
+		sdr_convert_sensor_readings(sdr->record.full, &rsp->data[1],
+					    &val[1], 6);
 		for(i=1;i<=6;i++) {
-			val[i] = sdr_convert_sensor_reading(sdr->record.full, rsp->data[i]);
 			if(val[i] < 0)
 				val[i] = 0;
 		}
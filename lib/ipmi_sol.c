@@ -36,11 +36,16 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <sys/select.h>
 #include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <signal.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
 
 #if defined(HAVE_CONFIG_H)
 # include <config.h>
@@ -56,6 +61,7 @@
 #include <ipmitool/log.h>
 #include <ipmitool/ipmi.h>
 #include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_cfgp.h>
 #include <ipmitool/ipmi_sol.h>
 #include <ipmitool/ipmi_strings.h>
 #include <ipmitool/bswap.h>
@@ -73,6 +79,20 @@
 
 #define MAX_SOL_RETRY 6
 
+/* default time user input is held to share a packet with more input */
+#define SOL_COALESCE_USEC                       5000
+/* retry interval after a failed keepalive */
+#define SOL_KEEPALIVE_RETRY_USEC                500000
+/* bytes of console output buffered for the log file */
+#define SOL_LOG_RING_SIZE                       (256 * 1024)
+/* stop reading SOL packets while the log buffer is this full (percent) */
+#define SOL_LOG_HIGH_WATER                      75
+/* sol capture defaults */
+#define SOL_CAPTURE_MAX_SIZE                    (16 * 1024 * 1024)
+#define SOL_CAPTURE_KEEP                        4
+#define SOL_CAPTURE_BACKOFF_MIN                 1000000
+#define SOL_CAPTURE_BACKOFF_MAX                 60000000
+
 const struct valstr sol_parameter_vals[] = {
 	{ SOL_PARAMETER_SET_IN_PROGRESS,           "Set In Progress (0)" },
 	{ SOL_PARAMETER_SOL_ENABLE,                "Enable (1)" },
@@ -87,11 +107,60 @@ const struct valstr sol_parameter_vals[] = {
 };
 
 
-static struct timeval _start_keepalive;
+/*
+ * Console output is copied to the log file through a ring buffer which
+ * is drained whenever the file is writable, so a slow log never delays
+ * reading (and acknowledging) SOL packets. Output that does not fit is
+ * dropped and counted.
+ */
+struct sol_log {
+	int      fd;
+	uint8_t  *buf;
+	size_t   cap;       /* ring buffer size */
+	size_t   head;      /* offset of the oldest queued byte */
+	size_t   len;       /* number of queued bytes */
+	uint64_t dropped;
+	char     *path;
+	uint64_t size;      /* current file size */
+	uint64_t max_size;  /* rotate the file beyond this size, 0 = never */
+	int      keep;      /* number of rotated files kept */
+	int      stamp;     /* prefix every line with a timestamp */
+	int      bol;       /* next byte starts a line */
+};
+
+/* sol capture settings, shared by all sessions */
+struct sol_capture_opts {
+	const char *dir;
+	size_t     buffer;
+	uint64_t   max_size;
+	int        keep;
+	int        instance;
+};
+
+struct sol_capture_host {
+	char     *name;
+	pid_t    pid;
+	uint64_t started;   /* usec */
+	uint64_t due;       /* usec, next (re)start */
+	uint32_t backoff;   /* usec */
+};
+
 static struct termios _saved_tio;
 static int            _in_raw_mode = 0;
 static int            _disable_keepalive = 0;
 static int            _use_sol_for_keepalive = 0;
+static int            _sol_quiet = 0;
+static struct sol_log _sol_log = { .fd = -1 };
+static uint32_t       _sol_coalesce_usec = SOL_COALESCE_USEC;
+
+/* User input waiting to be sent, see sol_flush_input() */
+static struct {
+	uint8_t  data[IPMI_BUF_SIZE];
+	int      len;
+	int      max;       /* payload size accepted by the BMC */
+	uint64_t due;       /* usec, send no later than this */
+} _sol_out;
+static volatile sig_atomic_t _sol_capture_stop = 0;
 
 extern int verbose;
 
@@ -1144,6 +1213,357 @@ ipmi_sol_set_param(struct ipmi_intf * intf,
 
 
 
+/*
+ * SOL configuration parameters for 'config save' and 'config apply'
+ */
+struct sol_cfgp_priv {
+	struct ipmi_intf *intf;
+	int channel;
+};
+
+static const struct ipmi_cfgp sol_cfgp[] = {
+	{ .name = "enabled", .format = "{true|false}", .size = 1,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = SOL_PARAMETER_SOL_ENABLE
+	},
+	{ .name = "security",
+		.format = "<force-encryption> <force-authentication> <privilege-level>",
+		.size = 1, .access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = SOL_PARAMETER_SOL_AUTHENTICATION
+	},
+	{ .name = "character-interval",
+		.format = "<character-accumulate-level> <character-send-threshold>",
+		.size = 2, .access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = SOL_PARAMETER_CHARACTER_INTERVAL
+	},
+	{ .name = "retry", .format = "<retry-count> <retry-interval>", .size = 2,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = SOL_PARAMETER_SOL_RETRY
+	},
+	{ .name = "non-volatile-bit-rate",
+		.format = "{serial|9.6|19.2|38.4|57.6|115.2}",
+		.size = 1, .access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = SOL_PARAMETER_SOL_NON_VOLATILE_BIT_RATE
+	},
+	{ .name = "volatile-bit-rate",
+		.format = "{serial|9.6|19.2|38.4|57.6|115.2}",
+		.size = 1, .access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = SOL_PARAMETER_SOL_VOLATILE_BIT_RATE
+	},
+	{ .name = "port", .format = "<port>", .size = 2,
+		.access = CFGP_RDWR,
+		.is_set = 0, .first_set = 0, .has_blocks = 0, .first_block = 0,
+		.specific = SOL_PARAMETER_SOL_PAYLOAD_PORT
+	}
+};
+
+static const struct valstr sol_cfgp_bit_rate_vals[] = {
+	{ 0x00, "serial" },
+	{ 0x06, "9.6" },
+	{ 0x07, "19.2" },
+	{ 0x08, "38.4" },
+	{ 0x09, "57.6" },
+	{ 0x0A, "115.2" },
+	{ 0xFF, NULL }
+};
+
+static const struct valstr sol_cfgp_priv_vals[] = {
+	{ 0x02, "user" },
+	{ 0x03, "operator" },
+	{ 0x04, "admin" },
+	{ 0x05, "oem" },
+	{ 0xFF, NULL }
+};
+
+/* sol_cfgp_lookup - find a string in a table, -1 if it is not there */
+static int
+sol_cfgp_lookup(const char *arg, const struct valstr *vs)
+{
+	int i;
+
+	for (i = 0; vs[i].str; i++) {
+		if (!strcmp(arg, vs[i].str)) {
+			return vs[i].val;
+		}
+	}
+
+	return -1;
+}
+
+/* sol_cfgp_bool - parse true/false, -1 if invalid */
+static int
+sol_cfgp_bool(const char *arg)
+{
+	if (!strcmp(arg, "true")) {
+		return 1;
+	}
+	if (!strcmp(arg, "false")) {
+		return 0;
+	}
+	return -1;
+}
+
+static int
+sol_cfgp_parse(const struct ipmi_cfgp *p, int argc, const char **argv,
+		unsigned char *data)
+{
+	uint16_t port;
+	int v[3];
+
+	if (argc == 0) {
+		return -1;
+	}
+
+	switch (p->specific) {
+	case SOL_PARAMETER_SOL_ENABLE:
+		v[0] = sol_cfgp_bool(argv[0]);
+		if (v[0] < 0) {
+			return -1;
+		}
+		data[0] = (data[0] & ~0x01) | v[0];
+		break;
+
+	case SOL_PARAMETER_SOL_AUTHENTICATION:
+		if (argc < 3) {
+			return -1;
+		}
+		v[0] = sol_cfgp_bool(argv[0]);
+		v[1] = sol_cfgp_bool(argv[1]);
+		v[2] = sol_cfgp_lookup(argv[2], sol_cfgp_priv_vals);
+		if (v[0] < 0 || v[1] < 0 || v[2] < 0) {
+			return -1;
+		}
+		data[0] = (v[0] << 7) | (v[1] << 6) | (data[0] & 0x30) | v[2];
+		break;
+
+	case SOL_PARAMETER_CHARACTER_INTERVAL:
+	case SOL_PARAMETER_SOL_RETRY:
+		if (argc < 2
+			|| str2uchar(argv[0], &data[0])
+			|| str2uchar(argv[1], &data[1])) {
+			return -1;
+		}
+		if (p->specific == SOL_PARAMETER_SOL_RETRY && data[0] > 7) {
+			return -1;
+		}
+		break;
+
+	case SOL_PARAMETER_SOL_NON_VOLATILE_BIT_RATE:
+	case SOL_PARAMETER_SOL_VOLATILE_BIT_RATE:
+		v[0] = sol_cfgp_lookup(argv[0], sol_cfgp_bit_rate_vals);
+		if (v[0] < 0) {
+			return -1;
+		}
+		data[0] = (data[0] & 0xf0) | v[0];
+		break;
+
+	case SOL_PARAMETER_SOL_PAYLOAD_PORT:
+		if (str2ushort(argv[0], &port)) {
+			return -1;
+		}
+		data[0] = port & 0xff;
+		data[1] = port >> 8;
+		break;
+
+	default:
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+sol_cfgp_save(const struct ipmi_cfgp *p, const unsigned char *data,
+		FILE *file)
+{
+	switch (p->specific) {
+	case SOL_PARAMETER_SOL_ENABLE:
+		fputs((data[0] & 0x01) ? "true" : "false", file);
+		break;
+
+	case SOL_PARAMETER_SOL_AUTHENTICATION:
+		fprintf(file, "%s %s %s",
+			(data[0] & 0x80) ? "true" : "false",
+			(data[0] & 0x40) ? "true" : "false",
+			val2str(data[0] & 0x0f, sol_cfgp_priv_vals));
+		break;
+
+	case SOL_PARAMETER_CHARACTER_INTERVAL:
+		fprintf(file, "%d %d", data[0], data[1]);
+		break;
+
+	case SOL_PARAMETER_SOL_RETRY:
+		fprintf(file, "%d %d", data[0] & 0x07, data[1]);
+		break;
+
+	case SOL_PARAMETER_SOL_NON_VOLATILE_BIT_RATE:
+	case SOL_PARAMETER_SOL_VOLATILE_BIT_RATE:
+		fputs(val2str(data[0] & 0x0f, sol_cfgp_bit_rate_vals), file);
+		break;
+
+	case SOL_PARAMETER_SOL_PAYLOAD_PORT:
+		fprintf(file, "%d", data[0] | (data[1] << 8));
+		break;
+
+	default:
+		fprintf(file, "%d", data[0]);
+	}
+
+	return 0;
+}
+
+/* sol_cfgp_send - write a SOL parameter, returns the completion code
+ * or -1 if there is no response
+ */
+static int
+sol_cfgp_send(struct sol_cfgp_priv *sp, int param,
+		const unsigned char *data, int len)
+{
+	struct ipmi_rs *rsp;
+	struct ipmi_rq req;
+	uint8_t msg_data[4];
+
+	msg_data[0] = sp->channel;
+	msg_data[1] = param;
+	memcpy(&msg_data[2], data, len);
+
+	memset(&req, 0, sizeof(req));
+	req.msg.netfn = IPMI_NETFN_TRANSPORT;
+	req.msg.cmd = IPMI_SET_SOL_CONFIG_PARAMETERS;
+	req.msg.data = msg_data;
+	req.msg.data_len = len + 2;
+
+	rsp = sp->intf->sendrecv(sp->intf, &req);
+	if (!rsp) {
+		return -1;
+	}
+
+	return rsp->ccode;
+}
+
+static int
+sol_cfgp_get(struct sol_cfgp_priv *sp, const struct ipmi_cfgp *p,
+		unsigned char *data, int quiet)
+{
+	struct ipmi_rs *rsp;
+	struct ipmi_rq req;
+	uint8_t msg_data[4];
+
+	msg_data[0] = sp->channel;
+	msg_data[1] = p->specific;
+	msg_data[2] = 0;
+	msg_data[3] = 0;
+
+	memset(&req, 0, sizeof(req));
+	req.msg.netfn = IPMI_NETFN_TRANSPORT;
+	req.msg.cmd = IPMI_GET_SOL_CONFIG_PARAMETERS;
+	req.msg.data = msg_data;
+	req.msg.data_len = 4;
+
+	rsp = sp->intf->sendrecv(sp->intf, &req);
+	if (!rsp || rsp->ccode || rsp->data_len < 2) {
+		if (!quiet) {
+			lprintf(LOG_ERR, "Unable to get SOL parameter '%s': %s",
+				p->name, !rsp ? "no response"
+				: val2str(rsp->ccode, completion_code_vals));
+		}
+		return -1;
+	}
+
+	memcpy(data, &rsp->data[1], __min(rsp->data_len - 1, (int)p->size));
+	return 0;
+}
+
+static int
+sol_cfgp_handler(void *priv, const struct ipmi_cfgp *p,
+		const struct ipmi_cfgp_action *action, unsigned char *data)
+{
+	int rc;
+
+	switch (action->type) {
+	case CFGP_PARSE:
+		return sol_cfgp_parse(p, action->argc, action->argv, data);
+
+	case CFGP_GET:
+		return sol_cfgp_get(priv, p, data, action->quiet);
+
+	case CFGP_SET:
+		rc = sol_cfgp_send(priv, p->specific, data, p->size);
+		if (rc != 0) {
+			lprintf(LOG_ERR, "Unable to set SOL parameter '%s': %s",
+				p->name, (rc < 0) ? "no response"
+				: val2str(rc, completion_code_vals));
+			return -1;
+		}
+		return 0;
+
+	case CFGP_SAVE:
+		return sol_cfgp_save(p, data, action->file);
+
+	case CFGP_PRINT:
+		fprintf(action->file, "%-22s: ", p->name);
+		sol_cfgp_save(p, data, action->file);
+		fputc('\n', action->file);
+		return 0;
+
+	default:
+		return -1;
+	}
+}
+
+static int
+sol_cfgp_progress(void *priv, int state)
+{
+	unsigned char val = state;
+	int rc;
+
+	rc = sol_cfgp_send(priv, SOL_PARAMETER_SET_IN_PROGRESS, &val, 1);
+	if (rc == 0) {
+		return 0;
+	}
+
+	/*
+	 * Set In Progress is optional, and so is the commit write
+	 * of a BMC that has it.
+	 */
+	if (rc == 0x80 || state == CFGP_COMMIT_WRITE) {
+		return 1;
+	}
+
+	lprintf(LOG_ERR, "Unable to set SOL Set In Progress to %d: %s",
+		state, (rc < 0) ? "no response"
+		: val2str(rc, completion_code_vals));
+	return -1;
+}
+
+static int
+sol_cfgp_open(struct ipmi_intf *intf, int channel, void *priv)
+{
+	struct sol_cfgp_priv *sp = priv;
+
+	sp->intf = intf;
+	sp->channel = channel;
+
+	return 0;
+}
+
+const struct ipmi_cfgp_class ipmi_sol_cfgp_class = {
+	.name = "sol",
+	.set = sol_cfgp,
+	.count = ARRAY_SIZE(sol_cfgp),
+	.handler = sol_cfgp_handler,
+	.progress = sol_cfgp_progress,
+	.priv_size = sizeof(struct sol_cfgp_priv),
+	.open = sol_cfgp_open
+};
+
+
 void
 leave_raw_mode(void)
 {
@@ -1248,130 +1668,529 @@ printSolEscapeSequences(struct ipmi_intf * intf)
 
 
 /*
- * output
+ * sol_write_all
+ *
+ * Write a whole buffer to a file descriptor, waiting for it to become
+ * writable if it is non-blocking.
  *
- * Send the specified data to stdout
+ * return   0 on success
+ *         -1 on error
  */
-static void
-output(struct ipmi_rs * rsp)
+static int
+sol_write_all(int fd, const uint8_t * buf, size_t len)
 {
-	/* Add checks to make sure it is actually SOL data, in general I see
-	 * outside code mostly trying to guard against this happening, but
-	 * some places fail to do so, so I do so here to make sure nothing gets
-	 * through.  If non-sol data comes through here, there is probably 
-	 * a packet that won't get processed somewhere else, but the alternative
-	 * of outputting corrupt data is worse.  Generally I see the get device
-	 * id response make it here somehow.  I assume it is a heartbeat and the
-	 * other code will retry if it cares about the response and misses it.
-	 */
-	if (rsp &&
-	    (rsp->session.authtype    == IPMI_SESSION_AUTHTYPE_RMCP_PLUS) &&
-	    (rsp->session.payloadtype == IPMI_PAYLOAD_TYPE_SOL))
-	{
-		int i;
+	while (len) {
+		ssize_t n = write(fd, buf, len);
 
-		for (i = 0; i < rsp->data_len; ++i)
-			putc(rsp->data[i], stdout);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				struct pollfd pfd = { fd, POLLOUT, 0 };
 
-		fflush(stdout);
+				poll(&pfd, 1, -1);
+				continue;
+			}
+			return -1;
+		}
+		buf += n;
+		len -= n;
 	}
+	return 0;
 }
 
 
 
 /*
- * ipmi_sol_deactivate
+ * sol_log_open
+ *
+ * Open the console log file and allocate its ring buffer of @cap bytes.
+ * The file is rotated once it grows beyond @max_size, keeping @keep old
+ * files; with @stamp set every line gets a timestamp prefix.
  */
 static int
-ipmi_sol_deactivate(struct ipmi_intf * intf, int instance)
+sol_log_open(const char * file, size_t cap, uint64_t max_size, int keep,
+             int stamp)
 {
-	struct ipmi_rs * rsp;
-	struct ipmi_rq   req;
-	uint8_t          data[6];
+	struct stat st;
 
-	if ((instance <= 0) || (instance > 15)) {
-		lprintf(LOG_ERR, "Error: Instance must range from 1 to 15");
+	_sol_log.fd = open(file, O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK,
+	                   0644);
+	if (_sol_log.fd < 0) {
+		lperror(LOG_ERR, "Unable to open log file %s", file);
 		return -1;
 	}
+	_sol_log.buf = malloc(cap);
+	_sol_log.path = strdup(file);
+	if (!_sol_log.buf || !_sol_log.path) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		close(_sol_log.fd);
+		_sol_log.fd = -1;
+		free_n(&_sol_log.buf);
+		free_n(&_sol_log.path);
+		return -1;
+	}
+	_sol_log.cap = cap;
+	_sol_log.head = 0;
+	_sol_log.len = 0;
+	_sol_log.dropped = 0;
+	_sol_log.size = (fstat(_sol_log.fd, &st) == 0) ? st.st_size : 0;
+	_sol_log.max_size = max_size;
+	_sol_log.keep = keep;
+	_sol_log.stamp = stamp;
+	_sol_log.bol = 1;
+	return 0;
+}
 
-	memset(&req, 0, sizeof(req));
-	req.msg.netfn    = IPMI_NETFN_APP;
-	req.msg.cmd      = IPMI_DEACTIVATE_PAYLOAD;
-	req.msg.data_len = 6;
-	req.msg.data     = data;
-
-	memset(data, 0, sizeof(data));
-	data[0] = IPMI_PAYLOAD_TYPE_SOL;  /* payload type      */
-	data[1] = instance;               /* payload instance. */
 
-	/* Lots of important data */
-	data[2] = 0;
-	data[3] = 0;
-	data[4] = 0;
-	data[5] = 0;
 
-	rsp = intf->sendrecv(intf, &req);
+/*
+ * sol_log_put
+ *
+ * Append bytes to the log ring buffer
+ */
+static void
+sol_log_put(const uint8_t * data, size_t len)
+{
+	size_t tail, chunk;
 
-	if (NULL != rsp) {
-		switch (rsp->ccode) {
-			case 0x00:
-				return 0;
-			case 0x80:
-				lprintf(LOG_ERR, "Info: SOL payload already de-activated");
-				break;
-			case 0x81:
-				lprintf(LOG_ERR, "Info: SOL payload type disabled");
-				break;
-			default:
-				lprintf(LOG_ERR, "Error de-activating SOL payload: %s",
-					val2str(rsp->ccode, completion_code_vals));
-				break;
-		}
-	} else {
-		lprintf(LOG_ERR, "Error: No response de-activating SOL payload");
+	if (len > _sol_log.cap - _sol_log.len) {
+		_sol_log.dropped += len - (_sol_log.cap - _sol_log.len);
+		len = _sol_log.cap - _sol_log.len;
 	}
 
-	return -1;
+	tail = (_sol_log.head + _sol_log.len) % _sol_log.cap;
+	chunk = __min(len, _sol_log.cap - tail);
+	memcpy(_sol_log.buf + tail, data, chunk);
+	memcpy(_sol_log.buf, data + chunk, len - chunk);
+	_sol_log.len += len;
 }
 
 
 
 /*
- * processSolUserInput
- *
- * Act on user input into the SOL session.  The only reason this
- * is complicated is that we have to process escape sequences.
+ * sol_log_stamp
  *
- * return   0 on success
- *          1 if we should exit
- *        < 0 on error (BMC probably closed the session)
+ * Append the current time as a line prefix
  */
-static int
-processSolUserInput(
-					struct ipmi_intf * intf,
-					uint8_t    * input,
-					uint16_t   buffer_length)
+static void
+sol_log_stamp(void)
 {
-	static int escape_pending = 0;
-	static int last_was_cr    = 1;
-	struct ipmi_v2_payload v2_payload;
-	int  length               = 0;
-	int  retval               = 0;
-	char ch;
-	int  i;
+	struct timeval tv;
+	struct tm tm;
+	char stamp[40];
+	size_t n;
+
+	gettimeofday(&tv, NULL);
+	localtime_r(&tv.tv_sec, &tm);
+	n = strftime(stamp, sizeof(stamp), "[%Y-%m-%d %H:%M:%S", &tm);
+	n += snprintf(stamp + n, sizeof(stamp) - n, ".%03ld] ",
+	              (long)tv.tv_usec / 1000);
+	sol_log_put((uint8_t *)stamp, n);
+}
 
-	memset(&v2_payload, 0, sizeof(v2_payload));
 
-	/*
-	 * Our first order of business is to check the input for escape
-	 * sequences to act on.
-	 */
-	for (i = 0; i < buffer_length; ++i)
-	{
-		ch = input[i];
 
-		if (escape_pending){
-			escape_pending = 0;
+/*
+ * sol_log_queue
+ *
+ * Append console output to the log ring buffer
+ */
+static void
+sol_log_queue(const uint8_t * data, size_t len)
+{
+	if (_sol_log.fd < 0)
+		return;
+
+	if (!_sol_log.stamp) {
+		sol_log_put(data, len);
+		return;
+	}
+
+	while (len) {
+		const uint8_t *nl = memchr(data, '\n', len);
+		size_t chunk = nl ? (size_t)(nl - data) + 1 : len;
+
+		if (_sol_log.bol)
+			sol_log_stamp();
+		sol_log_put(data, chunk);
+		_sol_log.bol = (nl != NULL);
+		data += chunk;
+		len -= chunk;
+	}
+}
+
+
+
+/*
+ * sol_log_note
+ *
+ * Add a line of our own to a timestamped log
+ */
+static void
+sol_log_note(const char * note)
+{
+	char line[128];
+	int n;
+
+	if (_sol_log.fd < 0)
+		return;
+
+	if (!_sol_log.bol)
+		sol_log_queue((uint8_t *)"\n", 1);
+	n = snprintf(line, sizeof(line), "--- %s ---\n", note);
+	sol_log_queue((uint8_t *)line, __min((size_t)n, sizeof(line) - 1));
+}
+
+
+
+/*
+ * sol_log_rotate
+ *
+ * Move the log file to <file>.1, shifting older files up to <file>.<keep>
+ */
+static int
+sol_log_rotate(void)
+{
+	size_t len = strlen(_sol_log.path) + 16;
+	char *from = malloc(len);
+	char *to = malloc(len);
+	int i;
+
+	if (!from || !to) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		free(from);
+		free(to);
+		return -1;
+	}
+
+	close(_sol_log.fd);
+	for (i = _sol_log.keep; i > 1; i--) {
+		snprintf(from, len, "%s.%d", _sol_log.path, i - 1);
+		snprintf(to, len, "%s.%d", _sol_log.path, i);
+		rename(from, to);
+	}
+	if (_sol_log.keep > 0) {
+		snprintf(to, len, "%s.1", _sol_log.path);
+		rename(_sol_log.path, to);
+	} else {
+		unlink(_sol_log.path);
+	}
+	free(from);
+	free(to);
+
+	_sol_log.size = 0;
+	_sol_log.fd = open(_sol_log.path,
+	                   O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK, 0644);
+	if (_sol_log.fd < 0) {
+		lperror(LOG_ERR, "Unable to open log file %s", _sol_log.path);
+		return -1;
+	}
+	return 0;
+}
+
+
+
+/*
+ * sol_log_flush
+ *
+ * Write out as much of the log ring buffer as the file accepts.
+ * With @wait set, the whole buffer is written.
+ *
+ * return   0 on success
+ *         -1 on error, the log is closed
+ */
+static int
+sol_log_flush(int wait)
+{
+	if (_sol_log.fd < 0)
+		return 0;
+
+	if (wait) {
+		int flags = fcntl(_sol_log.fd, F_GETFL);
+
+		if (flags >= 0)
+			fcntl(_sol_log.fd, F_SETFL, flags & ~O_NONBLOCK);
+	}
+
+	while (_sol_log.len) {
+		struct iovec iov[2];
+		size_t first = __min(_sol_log.len, _sol_log.cap - _sol_log.head);
+		ssize_t n;
+
+		iov[0].iov_base = _sol_log.buf + _sol_log.head;
+		iov[0].iov_len = first;
+		iov[1].iov_base = _sol_log.buf;
+		iov[1].iov_len = _sol_log.len - first;
+
+		n = writev(_sol_log.fd, iov, iov[1].iov_len ? 2 : 1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			lperror(LOG_ERR, "Error writing SOL log");
+			close(_sol_log.fd);
+			_sol_log.fd = -1;
+			return -1;
+		}
+		_sol_log.head = (_sol_log.head + n) % _sol_log.cap;
+		_sol_log.len -= n;
+		_sol_log.size += n;
+
+		/* rotate at the end of a line, unless it is very long */
+		if (_sol_log.max_size && _sol_log.size >= _sol_log.max_size
+		    && (_sol_log.buf[(_sol_log.head + _sol_log.cap - 1)
+		                     % _sol_log.cap] == '\n'
+		        || _sol_log.size >= 2 * _sol_log.max_size)
+		    && sol_log_rotate() != 0)
+		{
+			return -1;
+		}
+	}
+	if (!_sol_log.len)
+		_sol_log.head = 0;
+	return 0;
+}
+
+
+
+/*
+ * sol_log_close
+ */
+static void
+sol_log_close(void)
+{
+	if (!_sol_log.buf)
+		return;
+
+	sol_log_flush(1);
+	if (_sol_log.fd >= 0)
+		close(_sol_log.fd);
+	_sol_log.fd = -1;
+	free_n(&_sol_log.buf);
+	free_n(&_sol_log.path);
+
+	if (_sol_log.dropped)
+		lprintf(LOG_WARN, "SOL log: %llu bytes dropped",
+		        (unsigned long long)_sol_log.dropped);
+}
+
+
+
+/*
+ * output
+ *
+ * Send the specified data to stdout, and queue it for the log file
+ */
+static void
+output(struct ipmi_rs * rsp)
+{
+	/* Add checks to make sure it is actually SOL data, in general I see
+	 * outside code mostly trying to guard against this happening, but
+	 * some places fail to do so, so I do so here to make sure nothing gets
+	 * through.  If non-sol data comes through here, there is probably 
+	 * a packet that won't get processed somewhere else, but the alternative
+	 * of outputting corrupt data is worse.  Generally I see the get device
+	 * id response make it here somehow.  I assume it is a heartbeat and the
+	 * other code will retry if it cares about the response and misses it.
+	 */
+	if (rsp &&
+	    (rsp->session.authtype    == IPMI_SESSION_AUTHTYPE_RMCP_PLUS) &&
+	    (rsp->session.payloadtype == IPMI_PAYLOAD_TYPE_SOL))
+	{
+		if (!_sol_quiet) {
+			/* keep ordering with escape messages printed via stdio */
+			fflush(stdout);
+			if (sol_write_all(STDOUT_FILENO, rsp->data,
+			                  rsp->data_len) < 0)
+			{
+				lperror(LOG_ERR, "Error writing SOL output");
+			}
+		}
+		sol_log_queue(rsp->data, rsp->data_len);
+	}
+}
+
+
+
+/*
+ * ipmi_sol_deactivate
+ */
+static int
+ipmi_sol_deactivate(struct ipmi_intf * intf, int instance)
+{
+	struct ipmi_rs * rsp;
+	struct ipmi_rq   req;
+	uint8_t          data[6];
+
+	if ((instance <= 0) || (instance > 15)) {
+		lprintf(LOG_ERR, "Error: Instance must range from 1 to 15");
+		return -1;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.msg.netfn    = IPMI_NETFN_APP;
+	req.msg.cmd      = IPMI_DEACTIVATE_PAYLOAD;
+	req.msg.data_len = 6;
+	req.msg.data     = data;
+
+	memset(data, 0, sizeof(data));
+	data[0] = IPMI_PAYLOAD_TYPE_SOL;  /* payload type      */
+	data[1] = instance;               /* payload instance. */
+
+	/* Lots of important data */
+	data[2] = 0;
+	data[3] = 0;
+	data[4] = 0;
+	data[5] = 0;
+
+	rsp = intf->sendrecv(intf, &req);
+
+	if (NULL != rsp) {
+		switch (rsp->ccode) {
+			case 0x00:
+				return 0;
+			case 0x80:
+				lprintf(LOG_ERR, "Info: SOL payload already de-activated");
+				break;
+			case 0x81:
+				lprintf(LOG_ERR, "Info: SOL payload type disabled");
+				break;
+			default:
+				lprintf(LOG_ERR, "Error de-activating SOL payload: %s",
+					val2str(rsp->ccode, completion_code_vals));
+				break;
+		}
+	} else {
+		lprintf(LOG_ERR, "Error: No response de-activating SOL payload");
+	}
+
+	return -1;
+}
+
+
+
+/*
+ * sol_flush_input
+ *
+ * Send the queued user input to the BMC, along with any ACK we still
+ * owe it.
+ *
+ * return   0 on success
+ *        < 0 on error (BMC probably closed the session)
+ */
+static int
+sol_flush_input(struct ipmi_intf * intf)
+{
+	struct ipmi_v2_payload v2_payload;
+	struct ipmi_rs * rsp = NULL;
+	int try = 0;
+
+	if (!_sol_out.len)
+		return 0;
+
+	memset(&v2_payload, 0, sizeof(v2_payload));
+	memcpy(v2_payload.payload.sol_packet.data, _sol_out.data, _sol_out.len);
+
+	while (try < intf->ssn_params.retry) {
+
+		v2_payload.payload.sol_packet.character_count = _sol_out.len;
+
+		rsp = intf->send_sol(intf, &v2_payload);
+
+		if (rsp)
+		{
+			break;
+		}
+
+		usleep(5000);
+		try++;
+	}
+
+	_sol_out.len = 0;
+	_sol_out.due = 0;
+
+	if (! rsp)
+	{
+		lprintf(LOG_ERR, "Error sending SOL data: FAIL");
+		return -1;
+	}
+
+	/* If the sequence number is set we know we have new data */
+	if ((rsp->session.authtype == IPMI_SESSION_AUTHTYPE_RMCP_PLUS) &&
+	    (rsp->session.payloadtype == IPMI_PAYLOAD_TYPE_SOL)        &&
+	    (rsp->payload.sol_packet.packet_sequence_number))
+		output(rsp);
+
+	return 0;
+}
+
+
+
+/*
+ * sol_queue_input
+ *
+ * Queue one character of user input, sending the queue once it holds
+ * a full payload.
+ *
+ * return   0 on success
+ *        < 0 on error (BMC probably closed the session)
+ */
+static int
+sol_queue_input(struct ipmi_intf * intf, uint8_t ch)
+{
+	if (!_sol_out.len && _sol_coalesce_usec) {
+		_sol_out.due = ipmi_time_usec() + _sol_coalesce_usec;
+		/* let the lanplus code carry ACKs on this data */
+		intf->session->sol_data.defer_ack = 1;
+	}
+
+	_sol_out.data[_sol_out.len++] = ch;
+
+	if (_sol_out.len >= _sol_out.max)
+		return sol_flush_input(intf);
+
+	return 0;
+}
+
+
+
+/*
+ * processSolUserInput
+ *
+ * Act on user input into the SOL session.  The only reason this
+ * is complicated is that we have to process escape sequences.
+ *
+ * Input is queued rather than sent right away, so keystrokes arriving
+ * within the coalescing delay share one packet.
+ *
+ * return   0 on success
+ *          1 if we should exit
+ *        < 0 on error (BMC probably closed the session)
+ */
+static int
+processSolUserInput(
+					struct ipmi_intf * intf,
+					uint8_t    * input,
+					uint16_t   buffer_length)
+{
+	static int escape_pending = 0;
+	static int last_was_cr    = 1;
+	int  retval               = 0;
+	char ch;
+	int  i;
+
+	/*
+	 * Our first order of business is to check the input for escape
+	 * sequences to act on.
+	 */
+	for (i = 0; i < buffer_length && retval >= 0; ++i)
+	{
+		ch = input[i];
+
+		if (escape_pending){
+			escape_pending = 0;
 
 			/*
 			 * Process a possible escape sequence.
@@ -1398,7 +2217,11 @@ processSolUserInput(
 			case 'B':
 				printf("%cB [send break]\n",
 				       intf->ssn_params.sol_escape_char);
-				sendBreak(intf);
+				/* keep the break in order with queued input */
+				if (sol_flush_input(intf) < 0)
+					retval = -1;
+				else
+					sendBreak(intf);
 				continue;
 
 			case '?':
@@ -1406,10 +2229,15 @@ processSolUserInput(
 				continue;
 
 			default:
-				if (ch != intf->ssn_params.sol_escape_char)
-					v2_payload.payload.sol_packet.data[length++] =
-						intf->ssn_params.sol_escape_char;
-				v2_payload.payload.sol_packet.data[length++] = ch;
+				if (ch != intf->ssn_params.sol_escape_char &&
+				    sol_queue_input(intf,
+				                    intf->ssn_params.sol_escape_char) < 0)
+				{
+					retval = -1;
+					continue;
+				}
+				if (sol_queue_input(intf, ch) < 0)
+					retval = -1;
 			}
 		}
 
@@ -1420,7 +2248,8 @@ processSolUserInput(
 				continue;
 			}
 
-			v2_payload.payload.sol_packet.data[length++] =	ch;
+			if (sol_queue_input(intf, ch) < 0)
+				retval = -1;
 		}
 
 
@@ -1432,92 +2261,126 @@ processSolUserInput(
 
 
 	/*
-	 * If there is anything left to process we dispatch it to the BMC,
-	 * send intf->session->sol_data.max_outbound_payload_size bytes
-	 * at a time.
+	 * Anything still queued is sent once the coalescing delay expires,
+	 * right away if coalescing is off or we are about to exit.
 	 */
-	if (length)
-	{
-		struct ipmi_rs * rsp = NULL;
-		int try = 0;
-
-		while (try < intf->ssn_params.retry) {
-
-			v2_payload.payload.sol_packet.character_count = length;
-
-			rsp = intf->send_sol(intf, &v2_payload);
+	if (retval == 0 && !_sol_coalesce_usec)
+		retval = sol_flush_input(intf);
+	else if (retval == 1 && sol_flush_input(intf) < 0)
+		retval = -1;
 
-			if (rsp)
-			{
-				break;
-			}
+	return retval;
+}
 
-			usleep(5000);
-			try++;
-		}
 
-		if (! rsp)
-		{
-			lprintf(LOG_ERR, "Error sending SOL data: FAIL");
-			retval = -1;
-		}
 
-		/* If the sequence number is set we know we have new data */
-		if (retval == 0)
-			if ((rsp->session.authtype == IPMI_SESSION_AUTHTYPE_RMCP_PLUS) &&
-			    (rsp->session.payloadtype == IPMI_PAYLOAD_TYPE_SOL)        &&
-			    (rsp->payload.sol_packet.packet_sequence_number))
-				output(rsp);
-	}
+/*
+ * ipmi_sol_report
+ *
+ * Print SOL packet counters in verbose mode
+ */
+static void
+ipmi_sol_report(struct ipmi_intf * intf)
+{
+	if (!verbose)
+		return;
 
-	return retval;
+	lprintf(LOG_NOTICE, "SOL sent %u bytes in %u packets (%.3f packets/byte)",
+	        intf->session->sol_data.stats.tx_bytes,
+	        intf->session->sol_data.stats.tx_packets,
+	        intf->session->sol_data.stats.tx_bytes
+	        ? (double)intf->session->sol_data.stats.tx_packets
+	          / intf->session->sol_data.stats.tx_bytes
+	        : 0.0);
+	lprintf(LOG_NOTICE, "SOL received %u bytes in %u packets (%.3f packets/byte)",
+	        intf->session->sol_data.stats.rx_bytes,
+	        intf->session->sol_data.stats.rx_packets,
+	        intf->session->sol_data.stats.rx_bytes
+	        ? (double)intf->session->sol_data.stats.rx_packets
+	          / intf->session->sol_data.stats.rx_bytes
+	        : 0.0);
+	lprintf(LOG_NOTICE, "SOL ACKs: %u sent, %u carried on data, %u duplicates not ACKed",
+	        intf->session->sol_data.stats.acks,
+	        intf->session->sol_data.stats.piggybacked_acks,
+	        intf->session->sol_data.stats.skipped_acks);
 }
 
 static int
 ipmi_sol_keepalive_using_sol(struct ipmi_intf * intf)
 {
 	struct ipmi_v2_payload v2_payload;
-	struct timeval end;
 
-	if (_disable_keepalive)
-		return 0;
-
-	gettimeofday(&end, 0);
-
-	if (end.tv_sec - _start_keepalive.tv_sec > SOL_KEEPALIVE_TIMEOUT) {
-		memset(&v2_payload, 0, sizeof(v2_payload));
-		v2_payload.payload.sol_packet.character_count = 0;
-		if (!intf->send_sol(intf, &v2_payload))
-			return -1;
-		/* good return, reset start time */
-		gettimeofday(&_start_keepalive, 0);
-	}
+	memset(&v2_payload, 0, sizeof(v2_payload));
+	v2_payload.payload.sol_packet.character_count = 0;
+	if (!intf->send_sol(intf, &v2_payload))
+		return -1;
 	return 0;
 }
 
 static int
 ipmi_sol_keepalive_using_getdeviceid(struct ipmi_intf * intf)
 {
-	struct timeval  end;
+	if (intf->keepalive(intf) != 0)
+		return -1;
+	return 0;
+}
 
-	if (_disable_keepalive)
-		return 0;
+/*
+ * ipmi_sol_keepalive
+ *
+ * Send a keepalive if it is due at @next, and schedule the next one.
+ * @failed is set once MAX_SOL_RETRY retries went unanswered.
+ *
+ * return   milliseconds until the next keepalive is due
+ */
+static int
+ipmi_sol_keepalive(struct ipmi_intf * intf, uint64_t * next, int * retries,
+                   int * failed)
+{
+	uint64_t now = ipmi_time_usec();
+	int ret;
 
-	gettimeofday(&end, 0);
+	if (now >= *next) {
+		/* Send periodic keepalive packet */
+		if (_use_sol_for_keepalive == 0)
+			ret = ipmi_sol_keepalive_using_getdeviceid(intf);
+		else
+			ret = ipmi_sol_keepalive_using_sol(intf);
 
-	if (end.tv_sec - _start_keepalive.tv_sec > SOL_KEEPALIVE_TIMEOUT) {
-		if (intf->keepalive(intf) != 0)
-         		return -1;
-		/* good return, reset start time */
-		gettimeofday(&_start_keepalive, 0);
-   	}
-	return 0;
+		now = ipmi_time_usec();
+		if (ret != 0) {
+			/*
+			 * Retrying the keep Alive before declaring a communication
+			 * lost state with the IPMC. Helpful when the payload is
+			 * reset and brings down the connection temporarily. Otherwise,
+			 * if we send getDevice Id to check the status of IPMC during
+			 * this down time when the connection is restarting, SOL will
+			 * exit even though the IPMC is available and the session is open.
+			 */
+			if (*retries == MAX_SOL_RETRY) {
+				/* no response to Get Device ID keepalive message */
+				*failed = 1;
+				return 0;
+			}
+			(*retries)++;
+			*next = now + SOL_KEEPALIVE_RETRY_USEC;
+		} else {
+			/* if the keep Alive is successful reset retries to zero */
+			*retries = 0;
+			*next = now + SOL_KEEPALIVE_TIMEOUT * 1000000ULL;
+		}
+	}
+	return (*next - now + 999) / 1000;
 }
 
 
 
 /*
  * ipmi_sol_red_pill
+ *
+ * Relay between the terminal and the SOL session until either side
+ * closes it. Keepalives are sent when they are due rather than being
+ * checked on every wakeup, so poll() only returns for actual I/O.
  */
 static int
 ipmi_sol_red_pill(struct ipmi_intf * intf, int instance)
@@ -1526,12 +2389,16 @@ ipmi_sol_red_pill(struct ipmi_intf * intf, int instance)
 	int    numRead;
 	int    bShouldExit       = 0;
 	int    bBmcClosedSession = 0;
-	fd_set read_fds;
-	struct timeval tv;
+	struct pollfd pfds[3];
+	int    nfds;
+	int    timeout;
 	int    retval;
+	int    result = 0;
 	int    buffer_size = intf->session->sol_data.max_inbound_payload_size;
 	int    keepAliveRet = 0;
 	int    retrySol = 0;
+	int    keepalive;
+	uint64_t next_keepalive;
 
 	/* Subtract SOL header from max_inbound_payload_size */
 	if (buffer_size > 4)
@@ -1543,156 +2410,173 @@ ipmi_sol_red_pill(struct ipmi_intf * intf, int instance)
 		return -1;
 	}
 
-	/* Initialize keepalive start time */
-	gettimeofday(&_start_keepalive, 0);
+	keepalive = !_disable_keepalive && !ipmi_oem_active(intf, "i82571spt");
+	next_keepalive = ipmi_time_usec() + SOL_KEEPALIVE_TIMEOUT * 1000000ULL;
+
+	_sol_out.len = 0;
+	_sol_out.max = __min(buffer_size, (int)sizeof(_sol_out.data));
 
 	enter_raw_mode();
 
 	while (! bShouldExit)
 	{
-		FD_ZERO(&read_fds);
-		FD_SET(0, &read_fds);
-		FD_SET(intf->fd, &read_fds);
+		timeout = -1;
 
-		if (!ipmi_oem_active(intf,"i82571spt"))
+		if (keepalive)
 		{
-			/* Send periodic keepalive packet */
-			if(_use_sol_for_keepalive == 0)
-			{
-				keepAliveRet = ipmi_sol_keepalive_using_getdeviceid(intf);
-			}
-			else
-			{
-				keepAliveRet = ipmi_sol_keepalive_using_sol(intf);
-			}
-		
-			if (keepAliveRet != 0)
-			{
-				/*
-				 * Retrying the keep Alive before declaring a communication
-				 * lost state with the IPMC. Helpful when the payload is
-				 * reset and brings down the connection temporarily. Otherwise,
-				 * if we send getDevice Id to check the status of IPMC during
-				 * this down time when the connection is restarting, SOL will
-				 * exit even though the IPMC is available and the session is open.
-				 */
-				if (retrySol == MAX_SOL_RETRY)
-				{
-					/* no response to Get Device ID keepalive message */
-					bShouldExit = 1;
-					continue;
-				}
-				else
-				{
-					retrySol++;
-				}
-			}
-			else
+			timeout = ipmi_sol_keepalive(intf, &next_keepalive,
+			                             &retrySol, &keepAliveRet);
+			if (keepAliveRet)
 			{
-				/* if the keep Alive is successful reset retries to zero */
-				retrySol = 0;
+				bShouldExit = 1;
+				continue;
 			}
-		} /* !oem="i82571spt" */
-		/* Wait up to half a second */
-		tv.tv_sec =  0;
-		tv.tv_usec = 500000;
+		}
+
+		/* Wake up in time to send coalesced input */
+		if (_sol_out.len)
+		{
+			uint64_t now = ipmi_time_usec();
+			int wait = (_sol_out.due > now)
+			           ? (int)((_sol_out.due - now + 999) / 1000) : 0;
 
-		retval = select(intf->fd + 1, &read_fds, NULL, NULL, &tv);
+			if (timeout < 0 || wait < timeout)
+				timeout = wait;
+		}
 
-		if (retval)
+		pfds[0].fd = fileno(stdin);
+		pfds[0].events = POLLIN;
+		pfds[1].fd = intf->fd;
+		pfds[1].events = POLLIN;
+		nfds = 2;
+		if (_sol_log.fd >= 0 && _sol_log.len)
 		{
-			if (retval == -1)
-			{
-				/* ERROR */
-				perror("select");
-				return -1;
-			}
+			pfds[2].fd = _sol_log.fd;
+			pfds[2].events = POLLOUT;
+			nfds = 3;
+		}
 
+		retval = poll(pfds, nfds, timeout);
 
-			/*
-			 * Process input from the user
-			 */
-			if (FD_ISSET(0, &read_fds))
-	 		{
-				memset(buffer, 0, buffer_size);
-				numRead = read(fileno(stdin),
-							   buffer,
-							   buffer_size);
-
-				if (numRead > 0)
-				{
-					int rc = processSolUserInput(intf, (uint8_t *)buffer, numRead);
-
-					if (rc)
-					{
-						if (rc < 0)
-							bShouldExit = bBmcClosedSession = 1;
-						else
-							bShouldExit = 1;
-					}
-				}
-				else
+		if (retval < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			lperror(LOG_ERR, "poll");
+			result = -1;
+			break;
+		}
+		if (retval == 0)
+			continue;
+
+		/*
+		 * Process input from the BMC first, packets are acknowledged
+		 * as they are received
+		 */
+		if (pfds[1].revents & (POLLIN | POLLERR | POLLHUP))
+		{
+			struct ipmi_rs * rs =intf->recv_sol(intf);
+			if (rs) {
+				output(rs);
+				/* queued input carries the ACK we owe */
+				if (intf->session->sol_data.pending_ack_sequence_number
+				    && sol_flush_input(intf) < 0)
 				{
-					bShouldExit = 1;
+					bShouldExit = bBmcClosedSession = 1;
 				}
+			} else {
+				bShouldExit = bBmcClosedSession = 1;
 			}
+		}
 
+		/*
+		 * Process input from the user
+		 */
+		if (!bShouldExit && (pfds[0].revents & (POLLIN | POLLHUP)))
+		{
+			numRead = read(fileno(stdin),
+						   buffer,
+						   buffer_size);
 
-			/*
-			 * Process input from the BMC
-			 */
-			else if (FD_ISSET(intf->fd, &read_fds))
+			if (numRead > 0)
 			{
-				struct ipmi_rs * rs =intf->recv_sol(intf);
-				if (rs) {
-					output(rs);
-				} else {
-					bShouldExit = bBmcClosedSession = 1;
-				}
- 			}
-
+				int rc = processSolUserInput(intf, (uint8_t *)buffer, numRead);
 
-			/*
-			 * ERROR in select
-			 */
- 			else
+				if (rc)
+				{
+					if (rc < 0)
+						bShouldExit = bBmcClosedSession = 1;
+					else
+						bShouldExit = 1;
+				}
+			}
+			else
 			{
-				lprintf(LOG_ERR, "Error: Select returned with nothing to read");
 				bShouldExit = 1;
 			}
 		}
+		else if (pfds[0].revents & (POLLERR | POLLNVAL))
+		{
+			lprintf(LOG_ERR, "Error: poll returned error on terminal");
+			bShouldExit = 1;
+		}
+
+		/*
+		 * Send coalesced input whose time has come
+		 */
+		if (!bShouldExit && _sol_out.len && ipmi_time_usec() >= _sol_out.due
+		    && sol_flush_input(intf) < 0)
+		{
+			bShouldExit = bBmcClosedSession = 1;
+		}
+
+		/*
+		 * Drain the log ring buffer
+		 */
+		if (nfds > 2 && pfds[2].revents)
+			sol_log_flush(0);
 	}
 
+	/* Input typed just before the end of the session */
+	if (!bBmcClosedSession && !keepAliveRet)
+		sol_flush_input(intf);
+
 	leave_raw_mode();
+	free(buffer);
+	intf->session->sol_data.defer_ack = 0;
+	ipmi_sol_report(intf);
 
 	if (keepAliveRet != 0)
 	{
 		lprintf(LOG_ERR, "Error: No response to keepalive - Terminating session");
 		/* attempt to clean up anyway */
 		ipmi_sol_deactivate(intf, instance);
+		sol_log_close();
 		exit(1);
 	}
 
 	if (bBmcClosedSession)
 	{
 		lprintf(LOG_ERR, "SOL session closed by BMC");
+		sol_log_close();
 		exit(1);
 	}
 	else
 		ipmi_sol_deactivate(intf, instance);
 
-	return 0;
+	return result;
 }
 
 
 
 
 /*
- * ipmi_sol_activate
+ * ipmi_sol_payload_activate
+ *
+ * Activate the SOL payload on an open lanplus session
  */
 static int
-ipmi_sol_activate(struct ipmi_intf * intf, int looptest, int interval,
-		int instance)
+ipmi_sol_payload_activate(struct ipmi_intf * intf, int instance)
 {
 	struct ipmi_rs * rsp;
 	struct ipmi_rq   req;
@@ -1725,6 +2609,12 @@ ipmi_sol_activate(struct ipmi_intf * intf, int looptest, int interval,
 	 */
 	intf->session->sol_data.sol_input_handler = output;
 
+	intf->session->sol_data.defer_ack = 0;
+	intf->session->sol_data.pending_ack_sequence_number = 0;
+	intf->session->sol_data.last_acked_sequence_number = 0;
+	memset(&intf->session->sol_data.stats, 0,
+	       sizeof(intf->session->sol_data.stats));
+
 
 	memset(&req, 0, sizeof(req));
 	req.msg.netfn    = IPMI_NETFN_APP;
@@ -1834,6 +2724,21 @@ ipmi_sol_activate(struct ipmi_intf * intf, int looptest, int interval,
 		}
 	}
 
+	return 0;
+}
+
+
+
+/*
+ * ipmi_sol_activate
+ */
+static int
+ipmi_sol_activate(struct ipmi_intf * intf, int looptest, int interval,
+		int instance)
+{
+	if (ipmi_sol_payload_activate(intf, instance))
+		return -1;
+
 	printf("[SOL Session operational.  Use %c? for help]\n",
 	       intf->ssn_params.sol_escape_char);
 
@@ -1861,6 +2766,342 @@ ipmi_sol_activate(struct ipmi_intf * intf, int looptest, int interval,
 
 
 
+/*
+ * ipmi_sol_capture_stop
+ */
+static void
+ipmi_sol_capture_stop(int sig)
+{
+	(void)sig;
+	_sol_capture_stop = 1;
+}
+
+
+
+/*
+ * ipmi_sol_capture_loop
+ *
+ * Record an active SOL session into the log until the BMC closes it or
+ * capture is stopped. Packets are only read while the log buffer is
+ * below its high water mark; the BMC retries unacknowledged packets,
+ * which pushes back on the console instead of losing data here.
+ *
+ * return   0 when stopped
+ *         -1 when the session was lost
+ */
+static int
+ipmi_sol_capture_loop(struct ipmi_intf * intf)
+{
+	uint64_t next_keepalive;
+	struct pollfd pfds[2];
+	int keepalive = !_disable_keepalive && !ipmi_oem_active(intf, "i82571spt");
+	int retrySol = 0;
+	int failed = 0;
+
+	next_keepalive = ipmi_time_usec() + SOL_KEEPALIVE_TIMEOUT * 1000000ULL;
+
+	while (!_sol_capture_stop) {
+		int timeout = -1;
+		int bmc = -1;
+		int log = -1;
+		int nfds = 0;
+		int retval;
+
+		if (keepalive) {
+			timeout = ipmi_sol_keepalive(intf, &next_keepalive,
+			                             &retrySol, &failed);
+			if (failed) {
+				lprintf(LOG_ERR, "Error: No response to keepalive");
+				return -1;
+			}
+		}
+
+		if (_sol_log.len * 100 < _sol_log.cap * SOL_LOG_HIGH_WATER) {
+			pfds[nfds].fd = intf->fd;
+			pfds[nfds].events = POLLIN;
+			bmc = nfds++;
+		}
+		if (_sol_log.len) {
+			pfds[nfds].fd = _sol_log.fd;
+			pfds[nfds].events = POLLOUT;
+			log = nfds++;
+		}
+
+		retval = poll(pfds, nfds, timeout);
+		if (retval < 0) {
+			if (errno == EINTR)
+				continue;
+			lperror(LOG_ERR, "poll");
+			return -1;
+		}
+
+		if (bmc >= 0 && pfds[bmc].revents) {
+			struct ipmi_rs * rs = intf->recv_sol(intf);
+
+			if (!rs) {
+				lprintf(LOG_ERR, "SOL session closed by BMC");
+				return -1;
+			}
+			output(rs);
+		}
+
+		if (log >= 0 && pfds[log].revents && sol_log_flush(0) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+
+/*
+ * ipmi_sol_capture_session
+ *
+ * Capture the console of one host. Runs in a child process with its
+ * diagnostics going to <dir>/<host>.err and never returns.
+ */
+static void
+ipmi_sol_capture_session(struct ipmi_intf * intf,
+                         struct sol_capture_opts * opts, const char * host)
+{
+	char path[PATH_MAX];
+	int  rc = -1;
+	int  fd;
+
+	snprintf(path, sizeof(path), "%s/%s.err", opts->dir, host);
+	fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (fd >= 0) {
+		dup2(fd, STDOUT_FILENO);
+		dup2(fd, STDERR_FILENO);
+		close(fd);
+	}
+	fd = open("/dev/null", O_RDONLY);
+	if (fd >= 0) {
+		dup2(fd, STDIN_FILENO);
+		close(fd);
+	}
+
+	snprintf(path, sizeof(path), "%s/%s.log", opts->dir, host);
+	if (sol_log_open(path, opts->buffer, opts->max_size, opts->keep, 1))
+		_exit(EXIT_FAILURE);
+	_sol_quiet = 1;
+
+	ipmi_intf_session_set_hostname(intf, (char *)host);
+	if (intf->open(intf) < 0) {
+		lprintf(LOG_ERR, "Unable to open a session to %s", host);
+	} else {
+		if (ipmi_sol_payload_activate(intf, opts->instance) == 0) {
+			sol_log_note("SOL session opened");
+			rc = ipmi_sol_capture_loop(intf);
+			if (rc == 0)
+				ipmi_sol_deactivate(intf, opts->instance);
+			sol_log_note("SOL session closed");
+		}
+		intf->close(intf);
+	}
+
+	sol_log_close();
+	fflush(stdout);
+	fflush(stderr);
+	_exit(rc ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+
+
+/*
+ * ipmi_sol_capture_hosts
+ *
+ * Read the host list, one host per line, blank lines and lines starting
+ * with '#' are ignored
+ *
+ * return   number of hosts, < 1 on error
+ */
+static int
+ipmi_sol_capture_hosts(const char * file, struct sol_capture_host ** phosts)
+{
+	struct sol_capture_host *hosts = NULL;
+	struct sol_capture_host *tmp;
+	char line[256];
+	char *host;
+	int count = 0;
+	FILE *fp;
+
+	*phosts = NULL;
+	fp = ipmi_open_file_read(file);
+	if (!fp)
+		return -1;
+
+	while (fgets(line, sizeof(line), fp)) {
+		host = strtok(line, " \t\r\n");
+		if (!host || host[0] == '#')
+			continue;
+		if (strchr(host, '/')) {
+			lprintf(LOG_ERR, "Invalid host name '%s'", host);
+			continue;
+		}
+		tmp = realloc(hosts, (count + 1) * sizeof(*hosts));
+		if (!tmp) {
+			lprintf(LOG_ERR, "ipmitool: malloc failure");
+			break;
+		}
+		hosts = tmp;
+		memset(&hosts[count], 0, sizeof(*hosts));
+		hosts[count].name = strdup(host);
+		if (!hosts[count].name) {
+			lprintf(LOG_ERR, "ipmitool: malloc failure");
+			break;
+		}
+		count++;
+	}
+	fclose(fp);
+
+	if (!count)
+		lprintf(LOG_ERR, "No hosts found in '%s'", file);
+	*phosts = hosts;
+	return count;
+}
+
+
+
+/*
+ * ipmi_sol_capture
+ *
+ * Record the serial consoles of all hosts listed in @file until
+ * interrupted. Every host is captured by its own child process with its
+ * own RMCP+ session; sessions that end are restarted with an exponential
+ * back off, reset once a session stayed up for the maximum back off.
+ */
+static int
+ipmi_sol_capture(struct ipmi_intf * intf, const char * file,
+                 struct sol_capture_opts * opts)
+{
+	struct sol_capture_host *hosts;
+	struct sigaction act;
+	struct stat st;
+	int count, running = 0;
+	int status;
+	int i;
+	pid_t pid;
+
+	if (strcmp(intf->name, "lanplus")) {
+		lprintf(LOG_ERR, "Error: This command is only available over the "
+			   "lanplus interface");
+		return -1;
+	}
+	if (stat(opts->dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+		lprintf(LOG_ERR, "Capture directory '%s' does not exist", opts->dir);
+		return -1;
+	}
+
+	count = ipmi_sol_capture_hosts(file, &hosts);
+	if (count <= 0) {
+		free(hosts);
+		return -1;
+	}
+
+	/* Every host gets its own session from its own process */
+	if (intf->opened && intf->close)
+		intf->close(intf);
+
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = ipmi_sol_capture_stop;
+	sigaction(SIGINT, &act, NULL);
+	sigaction(SIGTERM, &act, NULL);
+
+	printf("Capturing %d consoles to %s, interrupt to stop\n",
+	       count, opts->dir);
+	fflush(stdout);
+
+	while (!_sol_capture_stop) {
+		uint64_t now = ipmi_time_usec();
+		uint64_t wait = 0;
+
+		for (i = 0; i < count; i++) {
+			struct sol_capture_host *host = &hosts[i];
+
+			if (host->pid)
+				continue;
+			if (host->due > now) {
+				if (!wait || host->due - now < wait)
+					wait = host->due - now;
+				continue;
+			}
+			fflush(stdout);
+			fflush(stderr);
+			pid = fork();
+			if (pid < 0) {
+				lperror(LOG_ERR, "%s: fork", host->name);
+				host->due = now + SOL_CAPTURE_BACKOFF_MIN;
+				continue;
+			}
+			if (pid == 0)
+				ipmi_sol_capture_session(intf, opts, host->name);
+			host->pid = pid;
+			host->started = now;
+			running++;
+		}
+
+		if (!running) {
+			usleep(__min(wait, 250000));
+			continue;
+		}
+		pid = waitpid(-1, &status, wait ? WNOHANG : 0);
+		if (pid == 0) {
+			usleep(__min(wait, 250000));
+			continue;
+		}
+		if (pid < 0) {
+			if (errno == EINTR)
+				continue;
+			lperror(LOG_ERR, "waitpid");
+			break;
+		}
+
+		for (i = 0; i < count; i++) {
+			struct sol_capture_host *host = &hosts[i];
+
+			if (host->pid != pid)
+				continue;
+			now = ipmi_time_usec();
+			if (now - host->started >= SOL_CAPTURE_BACKOFF_MAX)
+				host->backoff = SOL_CAPTURE_BACKOFF_MIN;
+			else
+				host->backoff = __min(__max(host->backoff * 2,
+				                            SOL_CAPTURE_BACKOFF_MIN),
+				                      SOL_CAPTURE_BACKOFF_MAX);
+			host->due = now + host->backoff;
+			host->pid = 0;
+			running--;
+			printf("%s: session ended, restarting in %u s\n",
+			       host->name, host->backoff / 1000000);
+			fflush(stdout);
+			break;
+		}
+	}
+
+	printf("Stopping %d capture sessions\n", running);
+	for (i = 0; i < count; i++) {
+		if (hosts[i].pid)
+			kill(hosts[i].pid, SIGTERM);
+	}
+	while (running > 0) {
+		pid = waitpid(-1, &status, 0);
+		if (pid < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		running--;
+	}
+
+	for (i = 0; i < count; i++)
+		free(hosts[i].name);
+	free(hosts);
+	return 0;
+}
+
+
+
 /*
  * print_sol_usage
  */
@@ -1871,6 +3112,10 @@ print_sol_usage(void)
 	lprintf(LOG_NOTICE, "              set <parameter> <value> [channel]");
 	lprintf(LOG_NOTICE, "              payload <enable|disable|status> [channel] [userid]");
 	lprintf(LOG_NOTICE, "              activate [<usesolkeepalive|nokeepalive>] [instance=<number>]");
+	lprintf(LOG_NOTICE, "                       [log=<file>] [coalesce=<ms>]");
+	lprintf(LOG_NOTICE, "              capture <host file> [dir=<directory>] [size=<bytes>]");
+	lprintf(LOG_NOTICE, "                      [keep=<files>] [buffer=<bytes>] [instance=<number>]");
+	lprintf(LOG_NOTICE, "                      [usesolkeepalive|nokeepalive]");
 	lprintf(LOG_NOTICE, "              deactivate [instance=<number>]");
 	lprintf(LOG_NOTICE, "              looptest [<loop times> [<loop interval(in ms)> [<instance>]]]");
 }
@@ -1989,6 +3234,7 @@ ipmi_sol_main(struct ipmi_intf * intf, int argc, char ** argv)
 		/* Activate */
 		int i;
 		uint8_t instance = 1;
+		const char *logfile = NULL;
 		for (i = 1; i < argc; i++) {
 			if (!strcmp(argv[i], "usesolkeepalive")) {
 				_use_sol_for_keepalive = 1;
@@ -2000,12 +3246,76 @@ ipmi_sol_main(struct ipmi_intf * intf, int argc, char ** argv)
 					print_sol_usage();
 					return -1;
 				}
+			} else if (!strncmp(argv[i], "log=", 4) && argv[i][4]) {
+				logfile = argv[i] + 4;
+			} else if (!strncmp(argv[i], "coalesce=", 9)) {
+				uint32_t ms;
+
+				if (str2uint(argv[i] + 9, &ms) != 0 || ms > 1000) {
+					lprintf(LOG_ERR, "Given coalescing delay '%s' is invalid.",
+					        argv[i] + 9);
+					print_sol_usage();
+					return -1;
+				}
+				_sol_coalesce_usec = ms * 1000;
 			} else {
 				print_sol_usage();
 				return -1;
 			}
 		}
+		if (logfile
+		    && sol_log_open(logfile, SOL_LOG_RING_SIZE, 0, 0, 0) != 0)
+			return -1;
 		retval = ipmi_sol_activate(intf, 0, 0, instance);
+		sol_log_close();
+	} else if (!strcmp(argv[0], "capture")) {
+		/* Capture the consoles of many hosts */
+		struct sol_capture_opts opts;
+		uint32_t value;
+		uint8_t instance = 1;
+		int i;
+
+		if (argc < 2) {
+			print_sol_usage();
+			return -1;
+		}
+		opts.dir = ".";
+		opts.buffer = SOL_LOG_RING_SIZE;
+		opts.max_size = SOL_CAPTURE_MAX_SIZE;
+		opts.keep = SOL_CAPTURE_KEEP;
+		for (i = 2; i < argc; i++) {
+			if (!strcmp(argv[i], "usesolkeepalive")) {
+				_use_sol_for_keepalive = 1;
+			} else if (!strcmp(argv[i], "nokeepalive")) {
+				_disable_keepalive = 1;
+			} else if (!strncmp(argv[i], "dir=", 4) && argv[i][4]) {
+				opts.dir = argv[i] + 4;
+			} else if (!strncmp(argv[i], "size=", 5)
+			           && str2uint(argv[i] + 5, &value) == 0) {
+				opts.max_size = value;
+			} else if (!strncmp(argv[i], "keep=", 5)
+			           && str2uint(argv[i] + 5, &value) == 0
+			           && value <= 99) {
+				opts.keep = value;
+			} else if (!strncmp(argv[i], "buffer=", 7)
+			           && str2uint(argv[i] + 7, &value) == 0
+			           && value >= 4096) {
+				opts.buffer = value;
+			} else if (!strncmp(argv[i], instance_kw, instance_len)
+			           && str2uchar(argv[i] + 9, &instance) == 0) {
+				continue;
+			} else {
+				lprintf(LOG_ERR, "Invalid capture option '%s'", argv[i]);
+				print_sol_usage();
+				return -1;
+			}
+		}
+		if (instance < 1 || instance > 15) {
+			lprintf(LOG_ERR, "Error: Instance must range from 1 to 15");
+			return -1;
+		}
+		opts.instance = instance;
+		retval = ipmi_sol_capture(intf, argv[1], &opts);
 	} else if (!strcmp(argv[0], "deactivate")) {
 		/* Deactivate */
 		int i;
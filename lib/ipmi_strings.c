@@ -1754,6 +1754,8 @@ void ipmi_oem_info_free()
 		return;
 	}
 
+	valstr_index_drop(ipmi_oem_info);
+
 	/*
 	 * Proceed dynamically allocated entries until we hit the first
 	 * entry of ipmi_oem_info_tail[], which is statically allocated.
@@ -44,6 +44,7 @@
 #include <ctype.h>
 #include <sys/time.h>
 #include <limits.h>
+#include <stddef.h>
 #include <fcntl.h>
 #include <sys/select.h>
 
@@ -1867,150 +1868,200 @@ ipmi_sunoem_getval(struct ipmi_intf * intf, int argc, char *argv[])
 	return (-1);
 }
 
-static int
-send_luapi_prop_name(struct ipmi_intf * intf, int len, char *prop_name,
-		unsigned char *tid_num)
-{
-	int i = 0;
-	struct ipmi_rs *rsp;
-	struct ipmi_rq req;
-	sunoem_setval_t setval_req;
-	sunoem_setval_resp_t *setval_rsp;
+/*
+ * Chunked transfers.
+ *
+ * Property strings and files are moved through the Sun OEM commands one
+ * block at a time.  sunoem_chunked_xfer() drives such a transfer: the
+ * block callback sends block 'chunk' and reports whether it was the
+ * last one.  A callback returning > 0 asks for the same block to be
+ * sent again, so a transient failure costs one block rather than the
+ * whole transfer.
+ */
+#define SUNOEM_XFER_MAX_RETRIES 5
 
-	*tid_num = 0;
-	while (i < len) {
-		/*
-		 * Setup the request,
-		 * Upon function return, the next cmd (SUNOEM_SET_VAL)
-		 * can be requested.
-		 */
-		memset(&req, 0, sizeof(req));
-		memset(&setval_req, 0, sizeof(sunoem_setval_t));
-		req.msg.netfn = IPMI_NETFN_SUNOEM;
-		req.msg.cmd = IPMI_SUNOEM_SETVAL;
-		setval_req.cmd_code = SUNOEM_SET_VAL;
-		setval_req.param_type = SUNOEM_LUAPI_TARGET;
-		setval_req.tid = *tid_num;
-		setval_req.eof = 0;
-		/*
-		 * If the property name is > payload, only copy
-		 * the payload size and increment the string offset (i)
-		 * for the next payload
-		 */
-		if (strlen(&(prop_name[i])) > MAX_SUNOEM_VAL_COMPACT_PAYLOAD) {
-			strncpy(setval_req.luapi_data, &(prop_name[i]),
-			MAX_SUNOEM_VAL_COMPACT_PAYLOAD);
-		} else {
-			strncpy(setval_req.luapi_data, &(prop_name[i]),
-					strlen(&(prop_name[i])));
-		}
-		req.msg.data = (uint8_t *) &setval_req;
-		req.msg.data_len = sizeof(sunoem_setval_t);
-		rsp = intf->sendrecv(intf, &req);
+typedef int (*sunoem_chunk_fn)(struct ipmi_intf *intf, void *priv,
+		uint32_t chunk, int *last);
 
-		if (!rsp) {
-			lprintf(LOG_ERR, "Sun OEM setval prop name: response is NULL");
-			return (-1);
-		}
+static int
+sunoem_chunked_xfer(struct ipmi_intf *intf, const char *what,
+		sunoem_chunk_fn send_chunk, void *priv)
+{
+	uint32_t chunk = 0;
+	int retries = 0;
+	int last = 0;
+	int rc;
 
-		if (rsp->ccode) {
-			lprintf(LOG_ERR, "Sun OEM setval prop name: request failed: %d",
-					rsp->ccode);
+	while (!last) {
+		rc = send_chunk(intf, priv, chunk, &last);
+		if (rc < 0) {
 			return (-1);
 		}
-
-		setval_rsp = (sunoem_setval_resp_t *) rsp->data;
-
-		/*
-		 * If the return code is other than data received, the
-		 * request failed
-		 */
-		if (setval_rsp->status_code != SUNOEM_REQ_RECV) {
-			lprintf(LOG_ERR,
-					"Sun OEM setval prop name: invalid status code: %d",
-					setval_rsp->status_code);
-			return (-1);
+		if (rc > 0) {
+			if (++retries > SUNOEM_XFER_MAX_RETRIES) {
+				lprintf(LOG_ERR, "Sun OEM %s: block %u failed after %d retries",
+						what, chunk, SUNOEM_XFER_MAX_RETRIES);
+				return (-1);
+			}
+			lprintf(LOG_INFO, "Sun OEM %s: retrying block %u", what, chunk);
+			last = 0;
+			continue;
 		}
-		/* Use the tid returned by ILOM */
-		*tid_num = setval_rsp->tid;
-		/* Increment the string offset */
-		i += MAX_SUNOEM_VAL_COMPACT_PAYLOAD;
+		retries = 0;
+		chunk++;
 	}
 
 	return (0);
 }
 
+/* sunoem_xfer_retryable - completion codes worth resending a block for */
 static int
-send_luapi_prop_value(struct ipmi_intf * intf, int len,	char *prop_value,
-		unsigned char tid_num)
+sunoem_xfer_retryable(uint8_t ccode)
 {
-	int i = 0;
+	switch (ccode) {
+	case IPMI_CC_NODE_BUSY:
+	case IPMI_CC_TIMEOUT:
+	case IPMI_CC_RESP_COULD_NOT_BE_PRV:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+struct luapi_prop_xfer {
+	const char *what;
+	const char *data;
+	int len;
+	unsigned char param_type;
+	unsigned char tid;
+};
+
+/*
+ * send_luapi_prop_chunk - send one payload of a property name or value
+ *
+ * Chunks append to the transaction on the ILOM side, so a failed chunk
+ * is not resent: the whole setval has to be restarted.
+ */
+static int
+send_luapi_prop_chunk(struct ipmi_intf *intf, void *priv, uint32_t chunk,
+		int *last)
+{
+	struct luapi_prop_xfer *x = priv;
 	struct ipmi_rs *rsp;
 	struct ipmi_rq req;
 	sunoem_setval_t setval_req;
 	sunoem_setval_resp_t *setval_rsp;
+	int off = chunk * MAX_SUNOEM_VAL_COMPACT_PAYLOAD;
+	int n = x->len - off;
 
-	while (i < len) {
-		/*
-		 * Setup the request,
-		 * Upon function return, the next cmd (SUNOEM_GET_VAL)
-		 * can be requested.
-		 */
-		memset(&req, 0, sizeof(req));
-		memset(&setval_req, 0, sizeof(sunoem_setval_t));
-		req.msg.netfn = IPMI_NETFN_SUNOEM;
-		req.msg.cmd = IPMI_SUNOEM_SETVAL;
-		setval_req.cmd_code = SUNOEM_SET_VAL;
-		setval_req.param_type = SUNOEM_LUAPI_VALUE;
-		setval_req.tid = tid_num;
-		/*
-		 * If the property name is > payload, only copy the
-		 * the payload size and increment the string offset
-		 * for the next payload
-		 */
-		if (strlen(&(prop_value[i])) > MAX_SUNOEM_VAL_COMPACT_PAYLOAD) {
-			strncpy(setval_req.luapi_data, &(prop_value[i]),
-			MAX_SUNOEM_VAL_COMPACT_PAYLOAD);
-		} else {
-			/* Captured the entire string, mark this as the last payload */
-			strncpy(setval_req.luapi_data, &(prop_value[i]),
-					strlen(&(prop_value[i])));
+	memset(&req, 0, sizeof(req));
+	memset(&setval_req, 0, sizeof(sunoem_setval_t));
+	req.msg.netfn = IPMI_NETFN_SUNOEM;
+	req.msg.cmd = IPMI_SUNOEM_SETVAL;
+	setval_req.cmd_code = SUNOEM_SET_VAL;
+	setval_req.param_type = x->param_type;
+	setval_req.tid = x->tid;
+	/*
+	 * If the rest of the string is > payload, only copy
+	 * the payload size, the next chunk picks up from there
+	 */
+	if (n > MAX_SUNOEM_VAL_COMPACT_PAYLOAD) {
+		n = MAX_SUNOEM_VAL_COMPACT_PAYLOAD;
+	} else {
+		/* Captured the entire string, mark the last value payload */
+		if (x->param_type == SUNOEM_LUAPI_VALUE) {
 			setval_req.eof = 1;
 		}
-		req.msg.data = (uint8_t *) &setval_req;
-		req.msg.data_len = sizeof(sunoem_setval_t);
-		rsp = intf->sendrecv(intf, &req);
+		*last = 1;
+	}
+	memcpy(setval_req.luapi_data, &x->data[off], n);
+	req.msg.data = (uint8_t *) &setval_req;
+	req.msg.data_len = sizeof(sunoem_setval_t);
+	rsp = intf->sendrecv(intf, &req);
 
-		if (!rsp) {
-			lprintf(LOG_ERR, "Sun OEM setval prop value: response is NULL");
-			return (-1);
-		}
+	if (!rsp) {
+		lprintf(LOG_ERR, "Sun OEM setval %s: response is NULL", x->what);
+		return (-1);
+	}
 
-		if (rsp->ccode) {
-			lprintf(LOG_ERR, "Sun OEM setval prop value: request failed: %d",
-					rsp->ccode);
-			return (-1);
-		}
+	if (rsp->ccode) {
+		lprintf(LOG_ERR, "Sun OEM setval %s: request failed: %d",
+				x->what, rsp->ccode);
+		return (-1);
+	}
 
-		setval_rsp = (sunoem_setval_resp_t *) rsp->data;
+	setval_rsp = (sunoem_setval_resp_t *) rsp->data;
 
-		/*
-		 * If the return code is other than data received, the
-		 * request failed
-		 */
-		if (setval_rsp->status_code != SUNOEM_REQ_RECV) {
-			lprintf(LOG_ERR,
-					"Sun OEM setval prop value: invalid status code: %d",
-					setval_rsp->status_code);
-			return (-1);
-		}
+	/*
+	 * If the return code is other than data received, the
+	 * request failed
+	 */
+	if (setval_rsp->status_code != SUNOEM_REQ_RECV) {
+		lprintf(LOG_ERR, "Sun OEM setval %s: invalid status code: %d",
+				x->what, setval_rsp->status_code);
+		return (-1);
+	}
+	/* Use the tid returned by ILOM for the rest of the property name */
+	if (x->param_type == SUNOEM_LUAPI_TARGET) {
+		x->tid = setval_rsp->tid;
+	}
 
-		/* Increment the string offset */
-		i += MAX_SUNOEM_VAL_COMPACT_PAYLOAD;
+	return (0);
+}
+
+/*
+ * Upon function return, the next cmd (SUNOEM_SET_VAL)
+ * can be requested.
+ */
+static int
+send_luapi_prop_name(struct ipmi_intf * intf, int len, char *prop_name,
+		unsigned char *tid_num)
+{
+	struct luapi_prop_xfer x;
+
+	*tid_num = 0;
+	if (len <= 0) {
+		return (0);
+	}
+
+	x.what = "prop name";
+	x.data = prop_name;
+	x.len = len;
+	x.param_type = SUNOEM_LUAPI_TARGET;
+	x.tid = 0;
+	if (sunoem_chunked_xfer(intf, "setval prop name",
+				send_luapi_prop_chunk, &x) != 0) {
+		return (-1);
 	}
+	*tid_num = x.tid;
+
 	return (0);
 }
 
+/*
+ * Upon function return, the next cmd (SUNOEM_GET_VAL)
+ * can be requested.
+ */
+static int
+send_luapi_prop_value(struct ipmi_intf * intf, int len,	char *prop_value,
+		unsigned char tid_num)
+{
+	struct luapi_prop_xfer x;
+
+	if (len <= 0) {
+		return (0);
+	}
+
+	x.what = "prop value";
+	x.data = prop_value;
+	x.len = len;
+	x.param_type = SUNOEM_LUAPI_VALUE;
+	x.tid = tid_num;
+
+	return sunoem_chunked_xfer(intf, "setval prop value",
+			send_luapi_prop_chunk, &x);
+}
+
 static int
 ipmi_sunoem_setval(struct ipmi_intf * intf, int argc, char *argv[])
 {
@@ -2127,20 +2178,105 @@ typedef struct
 #pragma pack(pop)
 #endif
 
+struct getfile_xfer {
+	getfile_req_t req;
+	FILE *fp;
+};
+
+/*
+ * sunoem_getfile_block - fetch one file block and append it to the output
+ *
+ * Blocks are read-only on the SP side, so a block that gets no answer,
+ * a busy/timeout completion code, a truncated response or a stale block
+ * number is simply requested again.
+ */
 static int
-ipmi_sunoem_getfile(struct ipmi_intf * intf, int argc, char *argv[])
+sunoem_getfile_block(struct ipmi_intf *intf, void *priv, uint32_t block,
+		int *last)
 {
+	struct getfile_xfer *x = priv;
 	struct ipmi_rs *rsp;
 	struct ipmi_rq req;
-	getfile_req_t getfile_req;
 	getfile_rsp_t *getfile_rsp;
-	int block_num = 0;
-	int nbo_blk_num; /* Network Byte Order Block Num */
-	FILE *fp;
-	unsigned data_size;
+	uint32_t nbo_blk_num; /* Network Byte Order Block Num */
+	unsigned int data_size;
+	int hdr_size = offsetof(getfile_rsp_t, data);
+
+	nbo_blk_num = htonl(block);
+	/* Block Num must be in network byte order */
+	memcpy(&(x->req.block_num), &nbo_blk_num, sizeof(x->req.block_num));
+
+	memset(&req, 0, sizeof(req));
+	req.msg.netfn = IPMI_NETFN_SUNOEM;
+	req.msg.cmd = IPMI_SUNOEM_CORE_TUNNEL;
+	req.msg.data = (uint8_t *) &x->req;
+	req.msg.data_len = sizeof(getfile_req_t);
+
+	rsp = intf->sendrecv(intf, &req);
+
+	if (!rsp) {
+		lprintf(LOG_WARN, "Sun OEM getfile block %u: no response", block);
+		return 1;
+	}
+	if (rsp->ccode) {
+		if (sunoem_xfer_retryable(rsp->ccode)) {
+			lprintf(LOG_WARN, "Sun OEM getfile block %u: %s", block,
+					val2str(rsp->ccode, completion_code_vals));
+			return 1;
+		}
+		lprintf(LOG_ERR, "Sun OEM getfile command failed: %d", rsp->ccode);
+		return (-1);
+	}
+	if (rsp->data_len < hdr_size) {
+		lprintf(LOG_WARN, "Sun OEM getfile block %u: short response", block);
+		return 1;
+	}
+
+	getfile_rsp = (getfile_rsp_t *) rsp->data;
+
+	memcpy(&data_size, &(getfile_rsp->data_size),
+			sizeof(getfile_rsp->data_size));
+	data_size = ntohl(data_size);
+
+	if (data_size > MAX_FILE_DATA_SIZE) {
+		lprintf(LOG_ERR, "Sun OEM getfile invalid data size: %d",
+				data_size);
+		return (-1);
+	}
+	if (data_size > (unsigned int)(rsp->data_len - hdr_size)) {
+		lprintf(LOG_WARN, "Sun OEM getfile block %u: truncated response",
+				block);
+		return 1;
+	}
+
+	/* Check if Block Num matches */
+	if (memcmp(&(x->req.block_num), &(getfile_rsp->block_num),
+			sizeof(x->req.block_num)) != 0) {
+		lprintf(LOG_WARN, "Sun OEM getfile Incorrect Block Num Returned");
+		lprintf(LOG_WARN, "Expecting: %x Received: %x",
+				x->req.block_num, getfile_rsp->block_num);
+		return 1;
+	}
+
+	if (fwrite(getfile_rsp->data, 1, data_size, x->fp) != data_size) {
+		lprintf(LOG_ERR, "Sun OEM getfile write failed: %s",
+				strerror(errno));
+		return (-1);
+	}
+
+	*last = (getfile_rsp->eof != 0);
+
+	return (0);
+}
+
+static int
+ipmi_sunoem_getfile(struct ipmi_intf * intf, int argc, char *argv[])
+{
+	struct getfile_xfer x;
 	supported_version_t supp_ver = IPMI_SUNOEM_GETFILE_VERSION;
+	int rc;
 
-	if (argc < 1) {
+	if (argc < 2) {
 		return (-1);
 	}
 
@@ -2154,83 +2290,31 @@ ipmi_sunoem_getfile(struct ipmi_intf * intf, int argc, char *argv[])
 	 * File ID is < MAX_FILEID_LEN
 	 * Save 1 byte for null Terminated string
 	 */
-	if (strlen(argv[0]) >= MAX_FILE_DATA_SIZE) {
+	if (strlen(argv[0]) >= MAX_FILEID_LEN) {
 		lprintf(LOG_ERR, "File ID >= %d characters", MAX_FILEID_LEN);
 		return (-1);
 	}
 
-	memset(&getfile_req, 0, sizeof(getfile_req));
-	strncpy((char*) getfile_req.file_id, argv[0], MAX_FILEID_LEN - 1);
+	memset(&x, 0, sizeof(x));
+	strncpy((char*) x.req.file_id, argv[0], MAX_FILEID_LEN - 1);
+	x.req.cmd_code = CORE_TUNNEL_SUBCMD_GET_FILE;
 
 	/* Create the destination file */
-	fp = ipmi_open_file_write(argv[1]);
-	if (!fp) {
+	x.fp = ipmi_open_file_write(argv[1]);
+	if (!x.fp) {
 		lprintf(LOG_ERR, "Unable to open file: %s", argv[1]);
 		return (-1);
 	}
 
-	memset(&req, 0, sizeof(req));
-	req.msg.netfn = IPMI_NETFN_SUNOEM;
-	req.msg.cmd = IPMI_SUNOEM_CORE_TUNNEL;
-	req.msg.data = (uint8_t *) &getfile_req;
-	req.msg.data_len = sizeof(getfile_req_t);
-	getfile_req.cmd_code = CORE_TUNNEL_SUBCMD_GET_FILE;
-
-	do {
-
-		nbo_blk_num = htonl(block_num);
-		/* Block Num must be in network byte order */
-		memcpy(&(getfile_req.block_num), &nbo_blk_num,
-				sizeof(getfile_req.block_num));
-
-		rsp = intf->sendrecv(intf, &req);
-
-		if (!rsp) {
-			lprintf(LOG_ERR, "Sun OEM getfile command failed.");
-			fclose(fp);
-			return (-1);
-		}
-		if (rsp->ccode) {
-			lprintf(LOG_ERR, "Sun OEM getfile command failed: %d", rsp->ccode);
-			fclose(fp);
-			return (-1);
-		}
-
-		getfile_rsp = (getfile_rsp_t *) rsp->data;
-
-		memcpy(&data_size, &(getfile_rsp->data_size),
-				sizeof(getfile_rsp->data_size));
-		data_size = ntohl(data_size);
-
-		if (data_size > MAX_FILE_DATA_SIZE) {
-			lprintf(LOG_ERR, "Sun OEM getfile invalid data size: %d",
-					data_size);
-			fclose(fp);
-			return (-1);
-		}
+	rc = sunoem_chunked_xfer(intf, "getfile", sunoem_getfile_block, &x);
 
-		/* Check if Block Num matches */
-		if (memcmp(&(getfile_req.block_num), &(getfile_rsp->block_num),
-				sizeof(getfile_req.block_num)) != 0) {
-			lprintf(LOG_ERR, "Sun OEM getfile Incorrect Block Num Returned");
-			lprintf(LOG_ERR, "Expecting: %x Received: %x",
-					getfile_req.block_num, getfile_rsp->block_num);
-			fclose(fp);
-			return (-1);
-		}
-
-		if (fwrite(getfile_rsp->data, 1, data_size, fp) != data_size) {
-			lprintf(LOG_ERR, "Sun OEM getfile write failed: %d", rsp->ccode);
-			fclose(fp);
-			return (-1);
-		}
-
-		block_num++;
-	} while (getfile_rsp->eof == 0);
-
-	fclose(fp);
+	if (fclose(x.fp) != 0 && rc == 0) {
+		lprintf(LOG_ERR, "Sun OEM getfile write failed: %s",
+				strerror(errno));
+		rc = -1;
+	}
 
-	return (0);
+	return rc;
 }
 
 /*
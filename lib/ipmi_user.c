@@ -44,6 +44,7 @@
 #include <ipmitool/ipmi.h>
 #include <ipmitool/ipmi_intf.h>
 #include <ipmitool/ipmi_user.h>
+#include <ipmitool/ipmi_channel.h>
 #include <ipmitool/ipmi_constants.h>
 #include <ipmitool/ipmi_strings.h>
 #include <ipmitool/bswap.h>
@@ -340,6 +341,306 @@ ipmi_print_user_summary(struct ipmi_intf *intf, uint8_t channel_number)
 	return 0;
 }
 
+/* Users and their access on every LAN and serial channel */
+#define USER_MATRIX_MAX_CHAN	12	/* channels 0x0 - 0xB */
+struct user_matrix {
+	uint8_t nchan;
+	uint8_t chan[USER_MATRIX_MAX_CHAN];
+	uint8_t medium[USER_MATRIX_MAX_CHAN];
+	uint8_t max_user_ids;
+	struct user_name_t name[IPMI_UID_MAX + 1];
+	struct user_access_t access[USER_MATRIX_MAX_CHAN][IPMI_UID_MAX + 1];
+};
+
+/* user_matrix_read - collect user names and access of all LAN and
+ * serial channels in one pass
+ *
+ * User names are global, so every name is read once rather than once
+ * per channel as a 'user list' of each channel would.
+ *
+ * @intf - IPMI interface
+ *
+ * returns - matrix to be freed by the caller, NULL on error
+ */
+static struct user_matrix *
+user_matrix_read(struct ipmi_intf *intf)
+{
+	struct channel_info_t chinfo;
+	struct user_matrix *m;
+	struct user_access_t *ua;
+	uint8_t ch;
+	uint8_t uid;
+	int ccode;
+
+	m = calloc(1, sizeof(*m));
+	if (!m) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		return NULL;
+	}
+
+	for (ch = 0; ch < USER_MATRIX_MAX_CHAN; ch++) {
+		memset(&chinfo, 0, sizeof(chinfo));
+		chinfo.channel = ch;
+		if (_ipmi_get_channel_info(intf, &chinfo) != 0) {
+			continue;
+		}
+		if (chinfo.medium != IPMI_CHANNEL_MEDIUM_LAN
+		    && chinfo.medium != IPMI_CHANNEL_MEDIUM_LAN_OTHER
+		    && chinfo.medium != IPMI_CHANNEL_MEDIUM_SERIAL) {
+			continue;
+		}
+		m->chan[m->nchan] = ch;
+		m->medium[m->nchan] = chinfo.medium;
+		m->nchan++;
+	}
+	if (m->nchan == 0) {
+		lprintf(LOG_ERR, "No LAN or serial channels found");
+		free(m);
+		return NULL;
+	}
+
+	m->max_user_ids = 1;
+	for (uid = 1; uid <= m->max_user_ids && uid <= IPMI_UID_MAX; uid++) {
+		for (ch = 0; ch < m->nchan; ch++) {
+			ua = &m->access[ch][uid];
+			ua->user_id = uid;
+			ua->channel = m->chan[ch];
+			ccode = _ipmi_get_user_access(intf, ua);
+			if (eval_ccode(ccode) != 0) {
+				free(m);
+				return NULL;
+			}
+			if (uid == 1 && ch == 0) {
+				m->max_user_ids = ua->max_user_ids;
+			}
+		}
+
+		m->name[uid].user_id = uid;
+		ccode = _ipmi_get_user_name(intf, &m->name[uid]);
+		if (ccode == 0xCC) {
+			memset(m->name[uid].user_name, '\0', 17);
+		} else if (eval_ccode(ccode) != 0) {
+			free(m);
+			return NULL;
+		}
+	}
+	if (m->max_user_ids > IPMI_UID_MAX) {
+		m->max_user_ids = IPMI_UID_MAX;
+	}
+
+	return m;
+}
+
+/* user_matrix_flags - short form of the access flags of one cell */
+static const char *
+user_matrix_flags(const struct user_access_t *ua)
+{
+	static char flags[4];
+
+	flags[0] = ua->callin_callback ? '-' : 'C';
+	flags[1] = ua->link_auth ? 'L' : '-';
+	flags[2] = ua->ipmi_messaging ? 'M' : '-';
+	flags[3] = '\0';
+	return flags;
+}
+
+/* user_matrix_print - print the matrix as a table, csv or JSON */
+static void
+user_matrix_print(const struct user_matrix *m, int json)
+{
+	const struct user_access_t *ua;
+	const char *name;
+	uint8_t uid;
+	uint8_t ch;
+
+	if (json) {
+		printf("{\"channels\":[");
+		for (ch = 0; ch < m->nchan; ch++) {
+			printf("%s{\"channel\":%u,\"medium\":\"%s\"}",
+			       ch ? "," : "", m->chan[ch],
+			       val2str(m->medium[ch], ipmi_channel_medium_vals));
+		}
+		printf("],\"users\":[");
+	} else if (!csv_output) {
+		printf("ID  Name            ");
+		for (ch = 0; ch < m->nchan; ch++) {
+			printf(" Channel %-9u", m->chan[ch]);
+		}
+		printf("\n");
+	}
+
+	for (uid = 1; uid <= m->max_user_ids; uid++) {
+		name = (const char *)m->name[uid].user_name;
+		if (json) {
+			printf("%s{\"id\":%u,\"name\":\"", uid > 1 ? "," : "",
+			       uid);
+			for (; *name; name++) {
+				if (*name == '"' || *name == '\\') {
+					putchar('\\');
+				}
+				if ((unsigned char)*name < 0x20) {
+					printf("\\u%04x", *name);
+				} else {
+					putchar(*name);
+				}
+			}
+			printf("\",\"access\":[");
+		} else if (!csv_output) {
+			printf("%-4u%-16s", uid, name);
+		}
+
+		for (ch = 0; ch < m->nchan; ch++) {
+			ua = &m->access[ch][uid];
+			if (json) {
+				printf("%s{\"channel\":%u,\"privilege\":\"%s\","
+				       "\"callin\":%s,\"link_auth\":%s,"
+				       "\"ipmi_msg\":%s}",
+				       ch ? "," : "", m->chan[ch],
+				       val2str(ua->privilege_limit,
+				               ipmi_privlvl_vals),
+				       ua->callin_callback ? "false" : "true",
+				       ua->link_auth ? "true" : "false",
+				       ua->ipmi_messaging ? "true" : "false");
+			} else if (csv_output) {
+				printf("%u,%s,%u,%s,%s,%s,%s\n", uid, name,
+				       m->chan[ch],
+				       val2str(ua->privilege_limit,
+				               ipmi_privlvl_vals),
+				       ua->callin_callback ? "false" : "true",
+				       ua->link_auth ? "true" : "false",
+				       ua->ipmi_messaging ? "true" : "false");
+			} else {
+				printf(" %-14s%-3s",
+				       val2str(ua->privilege_limit,
+				               ipmi_privlvl_vals),
+				       user_matrix_flags(ua));
+			}
+		}
+
+		if (json) {
+			printf("]}");
+		} else if (!csv_output) {
+			printf("\n");
+		}
+	}
+
+	if (json) {
+		printf("]}\n");
+	} else if (!csv_output) {
+		printf("\nC=callin  L=link auth  M=IPMI messaging\n");
+	}
+}
+
+/* user_matrix_priv - parse a privilege level of a policy file */
+static int
+user_matrix_priv(const char *str, uint8_t *priv)
+{
+	static const struct valstr priv_names[] = {
+		{ IPMI_SESSION_PRIV_CALLBACK,	"callback" },
+		{ IPMI_SESSION_PRIV_USER,	"user" },
+		{ IPMI_SESSION_PRIV_OPERATOR,	"operator" },
+		{ IPMI_SESSION_PRIV_ADMIN,	"administrator" },
+		{ IPMI_SESSION_PRIV_ADMIN,	"admin" },
+		{ IPMI_SESSION_PRIV_OEM,	"oem" },
+		{ IPMI_SESSION_PRIV_NOACCESS,	"noaccess" },
+		{ IPMI_SESSION_PRIV_NOACCESS,	"none" },
+		{ UINT8_MAX, NULL },
+	};
+	int i;
+
+	for (i = 0; priv_names[i].str; i++) {
+		if (!strcasecmp(str, priv_names[i].str)) {
+			*priv = priv_names[i].val;
+			return 0;
+		}
+	}
+	return str2uchar(str, priv);
+}
+
+/* user_matrix_check - compare the matrix with a policy file
+ *
+ * Each policy line reads '<user id|name> <channel|*> <privilege>'.
+ * Every user and channel it matches must have exactly that privilege
+ * limit.  Empty lines and lines starting with '#' are ignored.
+ *
+ * returns - 0 if the BMC complies, (-1) on violations or errors
+ */
+static int
+user_matrix_check(const struct user_matrix *m, const char *file)
+{
+	const struct user_access_t *ua;
+	char line[256];
+	char *who, *chan, *priv;
+	uint8_t want, uid_want, ch_want;
+	uint8_t uid, ch;
+	int lineno = 0;
+	int violations = 0;
+	int matched;
+	FILE *fp;
+
+	fp = ipmi_open_file_read(file);
+	if (!fp) {
+		return (-1);
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		lineno++;
+		who = strtok(line, " \t\r\n");
+		if (!who || who[0] == '#') {
+			continue;
+		}
+		chan = strtok(NULL, " \t\r\n");
+		priv = strtok(NULL, " \t\r\n");
+		if (!chan || !priv || user_matrix_priv(priv, &want) != 0
+		    || (strcmp(chan, "*") && str2uchar(chan, &ch_want) != 0)) {
+			lprintf(LOG_ERR, "%s:%d: expected "
+			        "'<user id|name> <channel|*> <privilege>'",
+			        file, lineno);
+			fclose(fp);
+			return (-1);
+		}
+		if (str2uchar(who, &uid_want) != 0) {
+			uid_want = 0;
+		}
+
+		matched = 0;
+		for (uid = 1; uid <= m->max_user_ids; uid++) {
+			if (uid_want ? uid != uid_want
+			    : strcmp(who, (const char *)m->name[uid].user_name)) {
+				continue;
+			}
+			for (ch = 0; ch < m->nchan; ch++) {
+				if (strcmp(chan, "*") && m->chan[ch] != ch_want) {
+					continue;
+				}
+				matched++;
+				ua = &m->access[ch][uid];
+				if (ua->privilege_limit == want) {
+					continue;
+				}
+				printf("User %u (%s) channel %u: %s, policy %s\n",
+				       uid, m->name[uid].user_name, m->chan[ch],
+				       val2str(ua->privilege_limit,
+				               ipmi_privlvl_vals),
+				       val2str(want, ipmi_privlvl_vals));
+				violations++;
+			}
+		}
+		if (!matched) {
+			lprintf(LOG_WARN, "%s:%d: no such user or channel",
+			        file, lineno);
+		}
+	}
+	fclose(fp);
+
+	if (violations) {
+		printf("%d policy violation(s)\n", violations);
+		return (-1);
+	}
+	printf("User access complies with policy\n");
+	return 0;
+}
+
 /*
  * ipmi_user_set_username
  */
@@ -432,6 +733,10 @@ print_user_usage(void)
 	lprintf(LOG_NOTICE,
 "               list         [<channel number>]");
 	lprintf(LOG_NOTICE,
+"               matrix       [json]");
+	lprintf(LOG_NOTICE,
+"               matrix check <policy file>");
+	lprintf(LOG_NOTICE,
 "               set name     <user id> <username>");
 	lprintf(LOG_NOTICE,
 "               set password <user id> [<password> [<16|20>]]");
@@ -525,6 +830,33 @@ ipmi_user_list(struct ipmi_intf *intf, int argc, char **argv)
 	return ipmi_print_user_list(intf, channel);
 }
 
+int
+ipmi_user_matrix(struct ipmi_intf *intf, int argc, char **argv)
+{
+	/* Matrix */
+	struct user_matrix *m;
+	int json = 0;
+	int rc = 0;
+
+	if (argc == 2 && !strcmp(argv[1], "json")) {
+		json = 1;
+	} else if (argc != 1 && !(argc == 3 && !strcmp(argv[1], "check"))) {
+		print_user_usage();
+		return (-1);
+	}
+	m = user_matrix_read(intf);
+	if (!m) {
+		return (-1);
+	}
+	if (argc == 3) {
+		rc = user_matrix_check(m, argv[2]);
+	} else {
+		user_matrix_print(m, json);
+	}
+	free(m);
+	return rc;
+}
+
 int
 ipmi_user_test(struct ipmi_intf *intf, int argc, char **argv)
 {
@@ -748,6 +1080,8 @@ ipmi_user_main(struct ipmi_intf *intf, int argc, char **argv)
 		return ipmi_user_summary(intf, argc, argv);
 	} else if (!strcmp(argv[0], "list")) {
 		return ipmi_user_list(intf, argc, argv);
+	} else if (!strcmp(argv[0], "matrix")) {
+		return ipmi_user_matrix(intf, argc, argv);
 	} else if (!strcmp(argv[0], "test")) {
 		return ipmi_user_test(intf, argc, argv);
 	} else if (!strcmp(argv[0], "set")) {
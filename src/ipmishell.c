@@ -400,6 +400,16 @@ int ipmi_set_main(struct ipmi_intf * intf, int argc, char ** argv)
 	return 0;
 }
 
+static void
+ipmi_exec_usage(void)
+{
+	lprintf(LOG_ERR, "Usage: exec <filename|-> [report]");
+	lprintf(LOG_ERR, "");
+	lprintf(LOG_ERR, "   Use '-' to read commands from standard input.");
+	lprintf(LOG_ERR, "   'report' prints the exit code and latency of every");
+	lprintf(LOG_ERR, "   command and a summary at the end to stderr.");
+}
+
 int ipmi_exec_main(struct ipmi_intf * intf, int argc, char ** argv)
 {
 	FILE * fp;
@@ -408,13 +418,33 @@ int ipmi_exec_main(struct ipmi_intf * intf, int argc, char ** argv)
 	int __argc, i, r;
 	char * __argv[EXEC_ARG_SIZE];
 	int rc=0;
-
-	if (argc < 1) {
-		lprintf(LOG_ERR, "Usage: exec <filename>");
+	int report = 0;
+	unsigned int lineno = 0;
+	unsigned int ncmds = 0;
+	unsigned int nfailed = 0;
+	uint64_t start = 0;
+	uint64_t cmd_start;
+	uint64_t usec;
+
+	if (argc < 1 || argc > 2) {
+		ipmi_exec_usage();
 		return -1;
 	}
 
-	fp = ipmi_open_file_read(argv[0]);
+	if (argc == 2) {
+		if (strcmp(argv[1], "report")) {
+			ipmi_exec_usage();
+			return -1;
+		}
+		report = 1;
+		start = ipmi_time_usec();
+	}
+
+	/* The session is kept open across all commands in either case */
+	if (!strcmp(argv[0], "-"))
+		fp = stdin;
+	else
+		fp = ipmi_open_file_read(argv[0]);
 	if (!fp)
 		return -1;
 
@@ -422,6 +452,7 @@ int ipmi_exec_main(struct ipmi_intf * intf, int argc, char ** argv)
 		ret = fgets(buf, EXEC_BUF_SIZE, fp);
 		if (!ret)
 			continue;
+		lineno++;
 
 		/* clip off optional comment tail indicated by # */
 		ptr = strchr(buf, '#');
@@ -469,7 +500,7 @@ int ipmi_exec_main(struct ipmi_intf * intf, int argc, char ** argv)
 				__argv[__argc++] = strdup(tok);
 				if (!__argv[__argc-1]) {
 					lprintf(LOG_ERR, "ipmitool: malloc failure");
-					if (fp) {
+					if (fp && fp != stdin) {
 						fclose(fp);
 						fp = NULL;
 					}
@@ -498,9 +529,25 @@ int ipmi_exec_main(struct ipmi_intf * intf, int argc, char ** argv)
 		}
 
 		/* now run the command, save the result if not successful */
+		cmd_start = ipmi_time_usec();
 		r = ipmi_cmd_run(intf, __argv[0], __argc-1, &(__argv[1]));
-		if (r != 0)
+		if (r != 0) {
 			rc = r;
+			nfailed++;
+		}
+		ncmds++;
+
+		if (report) {
+			usec = ipmi_time_usec() - cmd_start;
+			/* keep the report in step with the command output */
+			fflush(stdout);
+			lprintf(LOG_NOTICE, "exec: line %u: %s%s%s: rc=%d time=%"
+				PRIu64 ".%03" PRIu64 " ms",
+				lineno, __argv[0],
+				(__argc > 1) ? " " : "",
+				(__argc > 1) ? __argv[1] : "",
+				r, usec / 1000, usec % 1000);
+		}
 
 		/* free argument list */
 		for (i=0; i<__argc; i++) {
@@ -511,6 +558,15 @@ int ipmi_exec_main(struct ipmi_intf * intf, int argc, char ** argv)
 		}
 	}
 
-	fclose(fp);
+	if (fp != stdin)
+		fclose(fp);
+
+	if (report) {
+		usec = ipmi_time_usec() - start;
+		fflush(stdout);
+		lprintf(LOG_NOTICE, "exec: %u commands, %u failed, total time=%"
+			PRIu64 ".%03" PRIu64 " ms",
+			ncmds, nfailed, usec / 1000, usec % 1000);
+	}
 	return rc;
 }
@@ -67,6 +67,7 @@
 #include <ipmitool/ipmi_dcmi.h>
 #include <ipmitool/ipmi_vita.h>
 #include <ipmitool/ipmi_quantaoem.h>
+#include <ipmitool/ipmi_config.h>
 
 #ifdef HAVE_CONFIG_H
 # include <config.h>
@@ -124,6 +125,7 @@ struct ipmi_cmd ipmitool_cmd_list[] = {
 	{ ipmi_ime_main,          "ime", "Update Intel Manageability Engine Firmware"},
 	{ ipmi_vita_main,   "vita",   "Run a VITA 46.11 extended cmd"},
 	{ ipmi_lan6_main,   "lan6",   "Configure IPv6 LAN Channels"},
+	{ ipmi_config_main, "config", "Save and apply channel, PEF and boot configuration"},
 	{ NULL },
 };
 
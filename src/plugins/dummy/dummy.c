@@ -30,6 +30,7 @@
  */
 #include <errno.h>
 #include <limits.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/socket.h>
@@ -50,6 +51,35 @@
 
 extern int verbose;
 
+/* data_wait - wait until the socket is ready for I/O
+ *
+ * @fd - socket
+ * @events - POLLIN or POLLOUT
+ *
+ * return 0 if ready, otherwise (-1)
+ */
+static int
+data_wait(int fd, short events)
+{
+	struct pollfd pfd;
+	int rc;
+
+	pfd.fd = fd;
+	pfd.events = events;
+	do {
+		rc = poll(&pfd, 1, IPMI_DUMMY_TIMEOUT * 1000);
+	} while (rc < 0 && errno == EINTR);
+
+	if (rc == 0) {
+		lprintf(LOG_ERR, "dummy timed out waiting for the socket");
+		return (-1);
+	} else if (rc < 0) {
+		lperror(LOG_ERR, "dummy failed on poll()");
+		return (-1);
+	}
+	return 0;
+}
+
 /* data_read - read data from socket
  *
  * @data_ptr - pointer to memory where to store read data
@@ -60,39 +90,31 @@ extern int verbose;
 int
 data_read(int fd, void *data_ptr, int data_len)
 {
-	int rc = 0;
-	int data_read = 0;
+	uint8_t *ptr = data_ptr;
 	int data_total = 0;
-	int try = 1;
-	int errno_save = 0;
+	ssize_t data_read;
+
 	if (data_len < 0) {
 		return (-1);
 	}
-	while (data_total < data_len && try < 4) {
-		errno = 0;
-		/* TODO - add poll() */
-		data_read = read(fd, data_ptr, data_len);
-		errno_save = errno;
-		if (data_read > 0) {
-			data_total+= data_read;
+	while (data_total < data_len) {
+		if (data_wait(fd, POLLIN) != 0) {
+			return (-1);
 		}
-		if (errno_save != 0) {
-			if (errno_save == EINTR || errno_save == EAGAIN) {
-				try++;
-				sleep(2);
+		data_read = read(fd, ptr + data_total, data_len - data_total);
+		if (data_read == 0) {
+			lprintf(LOG_ERR, "dummy connection closed by peer");
+			return (-1);
+		} else if (data_read < 0) {
+			if (errno == EINTR || errno == EAGAIN) {
 				continue;
-			} else {
-				errno = errno_save;
-				perror("dummy failed on read(): ");
-				rc = (-1);
-				break;
 			}
+			lperror(LOG_ERR, "dummy failed on read()");
+			return (-1);
 		}
+		data_total+= data_read;
 	}
-	if (try > 3 && data_total != data_len) {
-		rc = (-1);
-	}
-	return rc;
+	return 0;
 }
 
 /* data_write - write data to the socket
@@ -105,39 +127,29 @@ data_read(int fd, void *data_ptr, int data_len)
 int
 data_write(int fd, void *data_ptr, int data_len)
 {
-	int rc = 0;
-	int data_written = 0;
+	uint8_t *ptr = data_ptr;
 	int data_total = 0;
-	int try = 1;
-	int errno_save = 0;
+	ssize_t data_written;
+
 	if (data_len < 0) {
 		return (-1);
 	}
-	while (data_total < data_len && try < 4) {
-		errno = 0;
-		/* TODO - add poll() */
-		data_written = write(fd, data_ptr, data_len);
-		errno_save = errno;
-		if (data_written > 0) {
-			data_total+= data_written;
+	while (data_total < data_len) {
+		if (data_wait(fd, POLLOUT) != 0) {
+			return (-1);
 		}
-		if (errno_save != 0) {
-			if (errno_save == EINTR || errno_save == EAGAIN) {
-				try++;
-				sleep(2);
+		data_written = write(fd, ptr + data_total,
+				data_len - data_total);
+		if (data_written < 0) {
+			if (errno == EINTR || errno == EAGAIN) {
 				continue;
-			} else {
-				errno = errno_save;
-				perror("dummy failed on read(): ");
-				rc = (-1);
-				break;
 			}
+			lperror(LOG_ERR, "dummy failed on write()");
+			return (-1);
 		}
+		data_total+= data_written;
 	}
-	if (try > 3 && data_total != data_len) {
-		rc = (-1);
-	}
-	return rc;
+	return 0;
 }
 
 /* ipmi_dummyipmi_close - send "BYE" and close socket
@@ -1,6 +1,7 @@
 #pragma once
 
 #define IPMI_DUMMY_DEFAULTSOCK "/tmp/.ipmi_dummy"
+#define IPMI_DUMMY_TIMEOUT 15 /* seconds */
 
 struct dummy_rq {
 	struct {
@@ -0,0 +1,2009 @@
+/*
+ * Copyright (c) 2026 The ipmitool Project.  All Rights Reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistribution of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * Redistribution in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder, nor the names of
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ * 
+ * This software is provided "AS IS," without a warranty of any kind.
+ * ALL EXPRESS OR IMPLIED CONDITIONS, REPRESENTATIONS AND WARRANTIES,
+ * INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE OR NON-INFRINGEMENT, ARE HEREBY EXCLUDED.
+ * THE COPYRIGHT HOLDER AND ITS LICENSORS SHALL NOT BE LIABLE
+ * FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING
+ * OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.  IN NO EVENT WILL
+ * THE COPYRIGHT HOLDER OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE,
+ * PROFIT OR DATA, OR FOR DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL,
+ * INCIDENTAL OR PUNITIVE DAMAGES, HOWEVER CAUSED AND REGARDLESS OF THE
+ * THEORY OF LIABILITY, ARISING OUT OF THE USE OF OR INABILITY TO USE THIS
+ * SOFTWARE, EVEN IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGES.
+ */
+
+/*
+ * Simulated BMC serving the dummy interface protocol
+ *
+ * The daemon listens on a UNIX socket and answers the requests of any
+ * number of concurrent 'ipmitool -I dummy' clients from synthetic or
+ * loaded SDR, SEL and FRU repositories.  All connections are served from
+ * a single poll() loop.  Response latency, jitter and reservation
+ * cancellation can be injected to exercise client retry paths.
+ *
+ * The same BMC can also be offered on pseudo terminals speaking the
+ * serial terminal and basic mode framing, so that the serial-terminal
+ * and serial-basic interfaces can be exercised without hardware.
+ */
+
+#define _GNU_SOURCE	/* posix_openpt(), cfmakeraw() */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <ipmitool/ipmi.h>
+#include <ipmitool/ipmi_cc.h>
+#include <ipmitool/helper.h>
+
+#include "dummy.h"
+
+#if defined(HAVE_CONFIG_H)
+# include <config.h>
+#endif
+
+#define SIM_MAX_DATA		IPMI_BUF_SIZE
+#define SIM_DEFAULT_SENSORS	16
+#define SIM_DEFAULT_EVENTS	32
+#define SIM_SEL_ENTRY_SIZE	16
+#define SIM_SDR_HDR_SIZE	5
+#define SIM_EEPROM_SIZE		8192	/* 24C64 behind a generic locator */
+#define SIM_EEPROM_BUS		0x01	/* channel 0, bus 0, private */
+#define SIM_EEPROM_ADDR		0xa0
+#define SIM_IPMC_ADDR		0x82	/* ATCA IPMC behind an MC locator */
+
+/* Get Device ID 'additional device support': sensor, SDR, SEL, FRU */
+#define SIM_DEV_SUPPORT		0x0f
+
+/* Serial basic mode framing characters */
+#define SIM_BM_START		0xA0
+#define SIM_BM_STOP		0xA5
+#define SIM_BM_HANDSHAKE	0xA6
+#define SIM_BM_ESCAPE		0xAA
+#define SIM_BM_HDR_SIZE		7	/* IPMB header and trailing checksum */
+
+enum sim_mode {
+	SIM_MODE_DUMMY,		/* struct dummy_rq/dummy_rs on a socket */
+	SIM_MODE_TERM,		/* serial terminal mode on a pty */
+	SIM_MODE_BASIC		/* serial basic mode on a pty */
+};
+
+struct sim_repo {
+	uint8_t *buf;
+	size_t len;
+	size_t *off;	/* record offsets into buf, record ID is the index */
+	size_t count;
+};
+
+struct sim_rsp {
+	uint64_t due;	/* usec, monotonic */
+	size_t len;
+	uint8_t *buf;	/* struct dummy_rs followed by data */
+	struct sim_rsp *next;
+};
+
+struct sim_conn {
+	int fd;
+	int pty_slave;	/* held open so the master never sees a hangup */
+	enum sim_mode mode;
+	uint8_t hdr[SIM_BM_HDR_SIZE];	/* serial header of current request */
+	uint8_t in[sizeof(struct dummy_rq) + SIM_MAX_DATA];
+	size_t in_len;
+	uint8_t *out;
+	size_t out_len;
+	size_t out_off;
+	struct sim_rsp *head;
+	struct sim_rsp *tail;
+	/* each client gets its own reservations, unlike on a real BMC */
+	uint16_t sdr_res;
+	uint16_t sel_res;
+};
+
+static struct sim_repo sdr_repo;
+static struct sim_repo sel_repo;
+static uint8_t *fru_buf;
+static size_t fru_len;
+static uint8_t sim_eeprom[SIM_EEPROM_SIZE];
+
+static uint32_t sim_latency;
+static uint32_t sim_jitter;
+static uint32_t sim_cancel;
+static int sim_verbose;
+static volatile sig_atomic_t sim_exit;
+
+static const struct {
+	uint8_t character;
+	uint8_t escape;
+} sim_bm_escapes[] = {
+	{ SIM_BM_START,		0xB0 },
+	{ SIM_BM_STOP,		0xB5 },
+	{ SIM_BM_HANDSHAKE,	0xB6 },
+	{ SIM_BM_ESCAPE,	0xBA },
+	{ 0x1B,			0x3B },
+};
+
+static struct sim_conn **conns;
+static struct pollfd *pfds;
+static size_t nconns;
+static size_t max_conns;
+
+static void
+sim_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void
+sim_log(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	fprintf(stderr, "ipmi_dummy_bmc: ");
+	vfprintf(stderr, fmt, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+}
+
+static uint64_t
+sim_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void *
+sim_malloc(size_t size)
+{
+	void *p = malloc(size);
+
+	if (!p) {
+		sim_log("malloc failure");
+		exit(EXIT_FAILURE);
+	}
+	return p;
+}
+
+static void *
+sim_realloc(void *ptr, size_t size)
+{
+	void *p = realloc(ptr, size);
+
+	if (!p) {
+		sim_log("malloc failure");
+		exit(EXIT_FAILURE);
+	}
+	return p;
+}
+
+/* sim_repo_add - append a record to a repository
+ *
+ * The record ID stored in the first two bytes is replaced by the record's
+ * index so that lookups are direct.
+ */
+static void
+sim_repo_add(struct sim_repo *repo, const uint8_t *rec, size_t len)
+{
+	repo->buf = sim_realloc(repo->buf, repo->len + len);
+	repo->off = sim_realloc(repo->off,
+	                        (repo->count + 1) * sizeof(*repo->off));
+	memcpy(repo->buf + repo->len, rec, len);
+	htoipmi16(repo->count, repo->buf + repo->len);
+	repo->off[repo->count++] = repo->len;
+	repo->len += len;
+}
+
+static size_t
+sim_repo_reclen(const struct sim_repo *repo, size_t idx)
+{
+	size_t end = (idx + 1 < repo->count) ? repo->off[idx + 1] : repo->len;
+
+	return end - repo->off[idx];
+}
+
+static uint8_t *
+sim_load_file(const char *file, size_t *len)
+{
+	struct stat st;
+	uint8_t *buf;
+	FILE *fp;
+
+	fp = fopen(file, "rb");
+	if (!fp || fstat(fileno(fp), &st)) {
+		sim_log("unable to open %s: %s", file, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	*len = st.st_size;
+	buf = sim_malloc(*len ? *len : 1);
+	if (*len && fread(buf, *len, 1, fp) != 1) {
+		sim_log("unable to read %s", file);
+		exit(EXIT_FAILURE);
+	}
+	fclose(fp);
+	return buf;
+}
+
+/* Load an SDR repository written by 'ipmitool sdr dump' */
+static void
+sim_load_sdr(const char *file)
+{
+	size_t len, off = 0;
+	uint8_t *buf = sim_load_file(file, &len);
+
+	while (off + SIM_SDR_HDR_SIZE <= len) {
+		size_t reclen = SIM_SDR_HDR_SIZE + buf[off + 4];
+
+		if (off + reclen > len)
+			break;
+		sim_repo_add(&sdr_repo, buf + off, reclen);
+		off += reclen;
+	}
+	free(buf);
+}
+
+/* Load a SEL written by 'ipmitool sel writeraw' */
+static void
+sim_load_sel(const char *file)
+{
+	size_t len, off;
+	uint8_t *buf = sim_load_file(file, &len);
+
+	for (off = 0; off + SIM_SEL_ENTRY_SIZE <= len;
+	     off += SIM_SEL_ENTRY_SIZE)
+	{
+		sim_repo_add(&sel_repo, buf + off, SIM_SEL_ENTRY_SIZE);
+	}
+	free(buf);
+}
+
+/* Generate threshold based temperature sensors as full sensor records */
+static void
+sim_gen_sdr(unsigned int count)
+{
+	uint8_t rec[64];
+	unsigned int i;
+	int n;
+
+	for (i = 0; i < count; i++) {
+		memset(rec, 0, sizeof(rec));
+		rec[2] = 0x51;		/* SDR version */
+		rec[3] = 0x01;		/* full sensor record */
+		rec[5] = IPMI_BMC_SLAVE_ADDR;
+		rec[7] = i + 1;		/* sensor number */
+		rec[8] = 0x07;		/* entity: system board */
+		rec[9] = 0x01;
+		rec[10] = 0x7f;		/* sensor initialization */
+		rec[11] = 0x68;		/* sensor capabilities */
+		rec[12] = 0x01;		/* sensor type: temperature */
+		rec[13] = 0x01;		/* event/reading type: threshold */
+		rec[21] = 0x01;		/* units: degrees C */
+		rec[24] = 0x01;		/* M = 1 */
+		rec[31] = 40;		/* nominal reading */
+		rec[34] = 0xff;		/* sensor maximum */
+		rec[37] = 90;		/* upper critical */
+		rec[38] = 80;		/* upper non-critical */
+		n = snprintf((char *)&rec[48], sizeof(rec) - 48,
+		             "Temp %u", i + 1);
+		rec[47] = 0xc0 | n;	/* 8-bit ASCII id string */
+		rec[4] = 43 + n;	/* record length after header */
+		sim_repo_add(&sdr_repo, rec, SIM_SDR_HDR_SIZE + rec[4]);
+	}
+}
+
+/* Generate a generic device locator for the simulated I2C eeprom */
+static void
+sim_gen_gendev(void)
+{
+	uint8_t rec[32];
+	size_t i;
+	int n;
+
+	memset(rec, 0, sizeof(rec));
+	rec[2] = 0x51;			/* SDR version */
+	rec[3] = 0x10;			/* generic device locator */
+	rec[5] = IPMI_BMC_SLAVE_ADDR;	/* device access address */
+	rec[6] = SIM_EEPROM_ADDR;	/* device slave address */
+	rec[10] = 0x0f;			/* device type: 24C64 */
+	rec[12] = 0x07;			/* entity: system board */
+	rec[13] = 0x01;
+	n = snprintf((char *)&rec[16], sizeof(rec) - 16, "EEPROM");
+	rec[15] = 0xc0 | n;		/* 8-bit ASCII id string */
+	rec[4] = 11 + n;		/* record length after header */
+	sim_repo_add(&sdr_repo, rec, SIM_SDR_HDR_SIZE + rec[4]);
+
+	for (i = 0; i < sizeof(sim_eeprom); i++)
+		sim_eeprom[i] = i & 0xff;
+}
+
+/* Generate an MC device locator for a second, ATCA, IPMC; the quote and
+ * backslash in its name exercise the escaping of JSON output
+ */
+static void
+sim_gen_mc(void)
+{
+	uint8_t rec[32];
+	int n;
+
+	memset(rec, 0, sizeof(rec));
+	rec[2] = 0x51;			/* SDR version */
+	rec[3] = 0x12;			/* MC device locator */
+	rec[5] = SIM_IPMC_ADDR;
+	rec[8] = 0x29;			/* FRU inventory, SEL, sensors */
+	rec[12] = 0xa0;			/* entity: PICMG front board */
+	rec[13] = 0x61;
+	n = snprintf((char *)&rec[16], sizeof(rec) - 16, "Blade \"7\"\\a");
+	rec[15] = 0xc0 | n;		/* 8-bit ASCII id string */
+	rec[4] = 11 + n;		/* record length after header */
+	sim_repo_add(&sdr_repo, rec, SIM_SDR_HDR_SIZE + rec[4]);
+}
+
+static void
+sim_gen_sel(unsigned int count)
+{
+	uint8_t rec[SIM_SEL_ENTRY_SIZE];
+	uint32_t ts = (uint32_t)time(NULL) - count * 60;
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		memset(rec, 0, sizeof(rec));
+		rec[2] = 0x02;		/* system event record */
+		htoipmi32(ts + i * 60, &rec[3]);
+		rec[7] = IPMI_BMC_SLAVE_ADDR;
+		rec[9] = 0x04;		/* EvM revision */
+		rec[10] = 0x01;		/* sensor type: temperature */
+		rec[11] = (sdr_repo.count ? i % sdr_repo.count : i) + 1;
+		rec[12] = (i & 1) ? 0x81 : 0x01; /* (de)assertion, threshold */
+		rec[13] = 0x59;		/* upper critical going high */
+		rec[14] = 81;
+		rec[15] = 80;
+		sim_repo_add(&sel_repo, rec, sizeof(rec));
+	}
+}
+
+static uint8_t
+sim_csum(const uint8_t *d, size_t len)
+{
+	uint8_t s = 0;
+
+	while (len--)
+		s += *d++;
+	return -s;
+}
+
+/* Append a type/length encoded ASCII field to a FRU area */
+static size_t
+sim_fru_field(uint8_t *p, const char *str)
+{
+	size_t len = strlen(str);
+
+	p[0] = 0xc0 | len;
+	memcpy(p + 1, str, len);
+	return len + 1;
+}
+
+/* Generate a FRU image with a common header and a board info area */
+static void
+sim_gen_fru(void)
+{
+	uint8_t *board;
+	size_t len;
+
+	fru_len = 64;
+	fru_buf = sim_malloc(fru_len);
+	memset(fru_buf, 0, fru_len);
+
+	fru_buf[0] = 0x01;	/* common header format version */
+	fru_buf[3] = 0x01;	/* board area offset, in multiples of 8 */
+	fru_buf[7] = sim_csum(fru_buf, 7);
+
+	board = fru_buf + 8;
+	board[0] = 0x01;	/* board area format version */
+	len = 6;		/* version, length, language, mfg date/time */
+	len += sim_fru_field(board + len, "Simulated");
+	len += sim_fru_field(board + len, "Dummy BMC");
+	len += sim_fru_field(board + len, "SN000001");
+	len += sim_fru_field(board + len, "PN000001");
+	len += sim_fru_field(board + len, "");
+	board[len++] = 0xc1;	/* end of fields */
+	len = (len + 8) & ~7;	/* pad, leaving room for the checksum */
+	board[1] = len / 8;
+	board[len - 1] = sim_csum(board, len - 1);
+}
+
+/* sim_res_check - verify the reservation ID of a repository read
+ *
+ * Returns 0 if the reservation is valid, otherwise the completion code.
+ * Reservation loss is injected here with the configured probability.
+ */
+static uint8_t
+sim_res_check(uint16_t *reservation, const uint8_t *data)
+{
+	uint16_t res = ipmi16toh((void *)data);
+
+	/* reservation ID 0 is allowed for reads of a whole record */
+	if (res == 0 && data[4] == 0)
+		return 0;
+	if (res != *reservation)
+		return IPMI_CC_RES_CANCELED;
+	if (sim_cancel && (uint32_t)(rand() % 100) < sim_cancel) {
+		(*reservation)++;
+		return IPMI_CC_RES_CANCELED;
+	}
+	return 0;
+}
+
+/* sim_repo_info - Get SDR Repository Info / Get SEL Info */
+static int
+sim_repo_info(const struct sim_repo *repo, uint8_t *rsp)
+{
+	memset(rsp, 0, 14);
+	rsp[0] = 0x51;
+	htoipmi16(repo->count, &rsp[1]);
+	htoipmi16(0, &rsp[3]);
+	rsp[13] = 0x02;		/* reserve supported */
+	return 14;
+}
+
+/* sim_repo_get - Get SDR / Get SEL Entry */
+static int
+sim_repo_get(const struct sim_repo *repo, uint16_t *reservation,
+             const uint8_t *rq, int rq_len, uint8_t *ccode, uint8_t *rsp)
+{
+	size_t idx, reclen;
+	uint16_t id;
+	uint8_t offset, count;
+
+	if (rq_len < 6) {
+		*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+		return 0;
+	}
+	*ccode = sim_res_check(reservation, rq);
+	if (*ccode)
+		return 0;
+
+	id = ipmi16toh((void *)&rq[2]);
+	offset = rq[4];
+	count = rq[5];
+	if (!repo->count || (id != 0xffff && id >= repo->count)) {
+		*ccode = IPMI_CC_REQ_DATA_NOT_PRESENT;
+		return 0;
+	}
+	idx = (id == 0xffff) ? repo->count - 1 : id;
+	reclen = sim_repo_reclen(repo, idx);
+
+	if (offset > reclen) {
+		*ccode = IPMI_CC_PARAM_OUT_OF_RANGE;
+		return 0;
+	}
+	if (count == 0xff || offset + count > reclen)
+		count = reclen - offset;
+
+	htoipmi16((idx + 1 < repo->count) ? idx + 1 : 0xffff, rsp);
+	memcpy(rsp + 2, repo->buf + repo->off[idx] + offset, count);
+	return count + 2;
+}
+
+/* LAN configuration of channel 1, indexed by parameter */
+#define SIM_LAN_CHANNEL	1
+#define SIM_LAN_NDEST	2
+static const struct {
+	uint8_t param;
+	uint8_t len;
+	uint8_t data[16];
+} sim_lan_params[] = {
+	{ 0x00, 1, { 0x00 } },				/* set in progress */
+	{ 0x01, 1, { 0x17 } },				/* auth type support */
+	{ 0x02, 5, { 0x16, 0x16, 0x16, 0x16, 0x00 } },	/* auth type enables */
+	{ 0x03, 4, { 192, 168, 0, 120 } },		/* IP address */
+	{ 0x04, 1, { 0x01 } },				/* static */
+	{ 0x05, 6, { 0x00, 0x25, 0x90, 0x12, 0x34, 0x56 } },
+	{ 0x06, 4, { 255, 255, 255, 0 } },
+	{ 0x07, 3, { 0x40, 0x40, 0x10 } },		/* IPv4 header */
+	{ 0x0a, 1, { 0x02 } },				/* gratuitous ARP */
+	{ 0x0b, 1, { 0x04 } },
+	{ 0x0c, 4, { 192, 168, 0, 1 } },
+	{ 0x0d, 6, { 0x00, 0x25, 0x90, 0x00, 0x00, 0x01 } },
+	{ 0x0e, 4, { 0, 0, 0, 0 } },
+	{ 0x0f, 6, { 0 } },
+	{ 0x10, 6, { 'p', 'u', 'b', 'l', 'i', 'c' } },
+	{ 0x11, 1, { SIM_LAN_NDEST } },
+	{ 0x14, 2, { 0x00, 0x00 } },			/* 802.1q VLAN ID */
+	{ 0x15, 1, { 0x00 } },
+	{ 0x16, 1, { 0x02 } },				/* cipher suite entries */
+	{ 0x17, 3, { 0x00, 0x03, 0x11 } },
+	{ 0x18, 9, { 0x00, 0x44, 0x44, 0x44, 0x44 } },
+};
+
+/* users, their names and access (flags, privilege limit) on the LAN and
+ * serial channel
+ */
+#define SIM_SERIAL_CHANNEL	2
+#define SIM_MAX_USERS		4
+static struct {
+	const char *name;
+	uint8_t access[2];	/* LAN, serial */
+} sim_users[SIM_MAX_USERS] = {
+	{ "",		{ 0x0f, 0x0f } },
+	{ "admin",	{ 0x34, 0x34 } },	/* link auth, messaging */
+	{ "operator",	{ 0x33, 0x0f } },
+	{ "guest",	{ 0x32, 0x31 } },
+};
+
+/* sim_user_access - Get/Set User Access */
+static int
+sim_user_access(const uint8_t *rq, int rq_len, int set, uint8_t *ccode,
+                uint8_t *rsp)
+{
+	uint8_t *access;
+	uint8_t ch, uid;
+
+	if (rq_len < (set ? 3 : 2)) {
+		*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+		return 0;
+	}
+	ch = rq[0] & 0x0f;
+	uid = rq[1] & 0x3f;
+	if ((ch != SIM_LAN_CHANNEL && ch != SIM_SERIAL_CHANNEL)
+	    || uid == 0 || uid > SIM_MAX_USERS) {
+		*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+		return 0;
+	}
+	access = &sim_users[uid - 1].access[ch == SIM_SERIAL_CHANNEL];
+	if (set) {
+		if (rq[0] & 0x80)	/* change the flags too */
+			*access = rq[0] & 0x70;
+		*access = (*access & 0x70) | (rq[2] & 0x0f);
+		return 0;
+	}
+	rsp[0] = SIM_MAX_USERS;
+	rsp[1] = 0x40 | (SIM_MAX_USERS - 1);	/* enabled */
+	rsp[2] = 1;				/* fixed names */
+	rsp[3] = *access;
+	return 4;
+}
+
+/* channel access of the LAN and serial channel, non-volatile and volatile:
+ * alerting/auth disable bits and access mode, privilege limit
+ */
+static uint8_t sim_chan_access[2][2][2] = {
+	{ { 0x02, 0x04 }, { 0x02, 0x04 } },	/* always available, admin */
+	{ { 0x21, 0x03 }, { 0x21, 0x03 } },	/* pre-boot, no alerting */
+};
+
+/* sim_channel_access - Get/Set Channel Access */
+static int
+sim_channel_access(const uint8_t *rq, int rq_len, int set, uint8_t *ccode,
+                   uint8_t *rsp)
+{
+	uint8_t (*access)[2];
+	uint8_t ch;
+	int i;
+
+	if (rq_len < (set ? 3 : 2)) {
+		*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+		return 0;
+	}
+	ch = rq[0] & 0x0f;
+	if (ch != SIM_LAN_CHANNEL && ch != SIM_SERIAL_CHANNEL) {
+		*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+		return 0;
+	}
+	access = sim_chan_access[ch == SIM_SERIAL_CHANNEL];
+	if (set) {
+		/* bits 7:6 - 01b non-volatile, 10b volatile */
+		for (i = 0; i < 2; i++) {
+			if ((rq[1] >> 6) == i + 1)
+				access[i][0] = rq[1] & 0x3f;
+			if ((rq[2] >> 6) == i + 1)
+				access[i][1] = rq[2] & 0x0f;
+		}
+		return 0;
+	}
+	i = (rq[1] >> 6) - 1;
+	if (i < 0 || i > 1) {
+		*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+		return 0;
+	}
+	rsp[0] = access[i][0];
+	rsp[1] = access[i][1];
+	return 2;
+}
+
+/* system boot options: set in progress, service partition (1, 2), boot
+ * flag valid bit clearing (3) and boot flags (5)
+ */
+static uint8_t sim_boot_param[6][5] = {
+	[1] = { 0x00 },
+	[2] = { 0x00 },
+	[3] = { 0x00 },
+	[5] = { 0x00, 0x04, 0x00, 0x00, 0x00 },	/* PXE, not valid */
+};
+
+/* sim_boot_options - Get/Set System Boot Options */
+static int
+sim_boot_options(const uint8_t *rq, int rq_len, int set, uint8_t *ccode,
+                 uint8_t *rsp)
+{
+	uint8_t id;
+	int len;
+
+	if (rq_len < (set ? 2 : 3)) {
+		*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+		return 0;
+	}
+	id = rq[0] & 0x7f;
+	if (id >= ARRAY_SIZE(sim_boot_param) || id == 4) {
+		*ccode = 0x80;		/* parameter not supported */
+		return 0;
+	}
+	len = (id == 5) ? 5 : 1;
+	if (set) {
+		if (rq_len != 1 + len) {
+			*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+			return 0;
+		}
+		memcpy(sim_boot_param[id], rq + 1, len);
+		if (id == 0 && rq[1] == 0x02)	/* commit write */
+			sim_boot_param[0][0] = 0x00;
+		return 0;
+	}
+	rsp[0] = 0x01;		/* parameter version */
+	rsp[1] = id;
+	memcpy(rsp + 2, sim_boot_param[id], len);
+	return len + 2;
+}
+
+/* PEF event filter (20 bytes) and alert policy (3 bytes) tables */
+#define SIM_PEF_FILTERS	4
+#define SIM_PEF_POLICIES	4
+static uint8_t sim_pef_filter[SIM_PEF_FILTERS][20] = {
+	{ 0x80, 0x01, 0x01, 0x10, 0xff, 0xff, 0x01, 0xff, 0x01, 0xff, 0xff },
+	{ 0x80, 0x01, 0x01, 0x20, 0xff, 0xff, 0x02, 0xff, 0x01, 0xff, 0xff },
+	{ 0x00, 0x02, 0x00, 0x10, 0xff, 0xff, 0x04, 0xff, 0x01, 0xff, 0xff },
+};
+static uint8_t sim_pef_policy[SIM_PEF_POLICIES][3] = {
+	{ 0x18, 0x11, 0x00 },	/* set 1, enabled, channel 1 dest 1 */
+	{ 0x18, 0x12, 0x00 },
+	{ 0x20, 0x21, 0x00 },	/* disabled, serial channel */
+};
+
+/* PEF control (1-4) and system GUID (10) parameters, alert strings */
+#define SIM_PEF_STRINGS	2
+static uint8_t sim_pef_control[11][17] = {
+	[1] = { 0x0f },		/* PEF, event messages, startup delays */
+	[2] = { 0x01 },		/* alert action */
+	[3] = { 60 },
+	[4] = { 60 },
+	[10] = { 0x00 },	/* use the Get System GUID value */
+};
+static uint8_t sim_pef_string_key[SIM_PEF_STRINGS + 1][2] = {
+	{ 0x00, 0x00 },
+	{ 0x01, 0x01 },		/* filter 1, string set 1 */
+	{ 0x02, 0x02 },
+};
+static uint8_t sim_pef_string[SIM_PEF_STRINGS + 1][48] = {
+	"", "Temperature over limit", "Voltage out of range",
+};
+
+/* sim_pef_config - Get/Set PEF Configuration Parameters */
+static int
+sim_pef_config(const uint8_t *rq, int rq_len, int set, uint8_t *ccode,
+               uint8_t *rsp)
+{
+	uint8_t id;
+	int len;
+	int off;
+
+	if (rq_len < (set ? 2 : 3)) {
+		*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+		return 0;
+	}
+	id = rq[1] & 0x7f;
+	rsp[0] = 0x11;		/* parameter revision */
+	switch (rq[0] & 0x7f) {
+	case 0x00:		/* set in progress */
+		if (set)
+			return 0;
+		rsp[1] = 0;
+		return 2;
+	case 0x05:		/* event filter table size */
+		if (set)
+			break;
+		rsp[1] = SIM_PEF_FILTERS;
+		return 2;
+	case 0x06:		/* event filter table entry */
+		if (id == 0 || id > SIM_PEF_FILTERS)
+			break;
+		if (set) {
+			if (rq_len != 2 + 20) {
+				*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+				return 0;
+			}
+			memcpy(sim_pef_filter[id - 1], rq + 2, 20);
+			return 0;
+		}
+		rsp[1] = id;
+		memcpy(rsp + 2, sim_pef_filter[id - 1], 20);
+		return 22;
+	case 0x08:		/* alert policy table size */
+		if (set)
+			break;
+		rsp[1] = SIM_PEF_POLICIES;
+		return 2;
+	case 0x09:		/* alert policy table entry */
+		if (id == 0 || id > SIM_PEF_POLICIES)
+			break;
+		if (set) {
+			if (rq_len != 2 + 3) {
+				*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+				return 0;
+			}
+			memcpy(sim_pef_policy[id - 1], rq + 2, 3);
+			return 0;
+		}
+		rsp[1] = id;
+		memcpy(rsp + 2, sim_pef_policy[id - 1], 3);
+		return 5;
+	case 0x01:		/* PEF control */
+	case 0x02:		/* PEF action global control */
+	case 0x03:		/* PEF startup delay */
+	case 0x04:		/* PEF alert startup delay */
+	case 0x0a:		/* system GUID */
+		len = ((rq[0] & 0x7f) == 0x0a) ? 17 : 1;
+		if (set) {
+			if (rq_len != 1 + len) {
+				*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+				return 0;
+			}
+			memcpy(sim_pef_control[rq[0] & 0x7f], rq + 1, len);
+			return 0;
+		}
+		memcpy(rsp + 1, sim_pef_control[rq[0] & 0x7f], len);
+		return len + 1;
+	case 0x0b:		/* number of alert strings */
+		if (set)
+			break;
+		rsp[1] = SIM_PEF_STRINGS;
+		return 2;
+	case 0x0c:		/* alert string keys */
+		if (id > SIM_PEF_STRINGS)
+			break;
+		if (set) {
+			if (rq_len != 2 + 2) {
+				*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+				return 0;
+			}
+			memcpy(sim_pef_string_key[id], rq + 2, 2);
+			return 0;
+		}
+		rsp[1] = id;
+		memcpy(rsp + 2, sim_pef_string_key[id], 2);
+		return 4;
+	case 0x0d:		/* alert strings, 16 byte blocks */
+		if (id > SIM_PEF_STRINGS || rq_len < 3
+		    || rq[2] == 0 || rq[2] > 3)
+			break;
+		off = (rq[2] - 1) * 16;
+		if (set) {
+			if (rq_len != 3 + 16) {
+				*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+				return 0;
+			}
+			memcpy(sim_pef_string[id] + off, rq + 3, 16);
+			return 0;
+		}
+		rsp[1] = id;
+		rsp[2] = rq[2];
+		memcpy(rsp + 3, sim_pef_string[id] + off, 16);
+		return 19;
+	default:
+		*ccode = 0x80;	/* parameter not supported */
+		return 0;
+	}
+	*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+	return 0;
+}
+
+/* LAN alert destination types (0x12) and addresses (0x13), by selector */
+static uint8_t sim_lan_dest[2][SIM_LAN_NDEST + 1][12] = {
+	{
+		{ 0x00, 0x03, 0x02 },
+		{ 0x80, 0x03, 0x02 },	/* acknowledged PET */
+		{ 0x80, 0x03, 0x02 },
+	}, {
+		{ 0 },
+		{ 0x00, 0x00, 192, 168, 0, 11 },
+		{ 0x00, 0x00, 192, 168, 0, 12 },
+	},
+};
+
+/* values written with Set LAN Configuration Parameters, by parameter */
+static struct {
+	uint8_t len;
+	uint8_t data[32];
+} sim_lan_written[256];
+
+/* sim_lan_set - Set LAN Configuration Parameters */
+static int
+sim_lan_set(const uint8_t *rq, int rq_len, uint8_t *ccode)
+{
+	if (rq_len < 3 || rq_len - 2 > (int)sizeof(sim_lan_written[0].data)) {
+		*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+		return 0;
+	}
+	if ((rq[0] & 0x0f) != SIM_LAN_CHANNEL) {
+		*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+		return 0;
+	}
+	if (rq[1] == 0x12 || rq[1] == 0x13) {
+		if (rq[2] > SIM_LAN_NDEST) {
+			*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+			return 0;
+		} else if (rq_len != ((rq[1] == 0x12) ? 3 + 3 : 3 + 12)) {
+			*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+			return 0;
+		}
+		memcpy(sim_lan_dest[rq[1] - 0x12][rq[2]], rq + 3, rq_len - 3);
+		return 0;
+	}
+	sim_lan_written[rq[1]].len = rq_len - 2;
+	memcpy(sim_lan_written[rq[1]].data, rq + 2, rq_len - 2);
+	if (rq[1] == 0 && rq[2] == 0x02)	/* commit write */
+		sim_lan_written[0].data[0] = 0x00;
+	return 0;
+}
+
+/* sim_lan_config - Get LAN Configuration Parameters */
+static int
+sim_lan_config(const uint8_t *rq, int rq_len, uint8_t *ccode, uint8_t *rsp)
+{
+	size_t i;
+
+	if (rq_len < 4) {
+		*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+		return 0;
+	}
+	if ((rq[0] & 0x0f) != SIM_LAN_CHANNEL) {
+		*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+		return 0;
+	}
+	rsp[0] = 0x11;		/* parameter revision */
+	if (rq[0] & 0x80)
+		return 1;
+	if (sim_lan_written[rq[1]].len) {
+		memcpy(rsp + 1, sim_lan_written[rq[1]].data,
+		       sim_lan_written[rq[1]].len);
+		return sim_lan_written[rq[1]].len + 1;
+	}
+
+	switch (rq[1]) {
+	case 0x12:		/* destination type */
+	case 0x13:		/* destination address */
+		if (rq[2] > SIM_LAN_NDEST)
+			break;
+		rsp[1] = rq[2];
+		memcpy(rsp + 2, sim_lan_dest[rq[1] - 0x12][rq[2]],
+		       (rq[1] == 0x12) ? 3 : 12);
+		return (rq[1] == 0x12) ? 5 : 14;
+	default:
+		for (i = 0; i < ARRAY_SIZE(sim_lan_params); i++) {
+			if (sim_lan_params[i].param != rq[1])
+				continue;
+			memcpy(rsp + 1, sim_lan_params[i].data,
+			       sim_lan_params[i].len);
+			return sim_lan_params[i].len + 1;
+		}
+		break;
+	}
+	*ccode = 0x80;		/* parameter not supported */
+	return 0;
+}
+
+/* SOL configuration of the LAN channel, indexed by parameter */
+static struct {
+	uint8_t len;
+	uint8_t data[4];
+} sim_sol_params[9] = {
+	{ 1, { 0x00 } },		/* set in progress */
+	{ 1, { 0x01 } },		/* SOL enabled */
+	{ 1, { 0x02 } },		/* user privilege */
+	{ 2, { 0x0c, 0x60 } },		/* 60 ms, 96 characters */
+	{ 2, { 0x07, 0x32 } },		/* 7 retries, 500 ms */
+	{ 1, { 0x0a } },		/* 115.2 kbps */
+	{ 1, { 0x0a } },
+	{ 1, { SIM_LAN_CHANNEL } },	/* payload channel */
+	{ 2, { 0x6f, 0x02 } },		/* payload port 623 */
+};
+
+/* sim_sol_config - Get/Set SOL Configuration Parameters */
+static int
+sim_sol_config(const uint8_t *rq, int rq_len, int set, uint8_t *ccode,
+               uint8_t *rsp)
+{
+	if (rq_len < (set ? 3 : 4)) {
+		*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+		return 0;
+	}
+	if ((rq[0] & 0x0f) != SIM_LAN_CHANNEL) {
+		*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+		return 0;
+	}
+	if (rq[1] >= ARRAY_SIZE(sim_sol_params)) {
+		*ccode = 0x80;		/* parameter not supported */
+		return 0;
+	}
+	if (set) {
+		if (rq_len - 2 != sim_sol_params[rq[1]].len) {
+			*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+			return 0;
+		}
+		if (rq[1] == 7) {
+			*ccode = 0x82;	/* read-only */
+			return 0;
+		}
+		memcpy(sim_sol_params[rq[1]].data, rq + 2, rq_len - 2);
+		if (rq[1] == 0 && rq[2] == 0x02)	/* commit write */
+			sim_sol_params[0].data[0] = 0x00;
+		return 0;
+	}
+	rsp[0] = 0x01;		/* parameter revision */
+	if (rq[0] & 0x80)
+		return 1;
+	memcpy(rsp + 1, sim_sol_params[rq[1]].data, sim_sol_params[rq[1]].len);
+	return sim_sol_params[rq[1]].len + 1;
+}
+
+/* serial/modem alert destinations (0x11), dial strings (0x15), TAP
+ * accounts (0x19) and TAP service settings (0x1c) of the serial channel,
+ * by selector
+ */
+#define SIM_SERIAL_NDEST	2
+#define SIM_SERIAL_NDIAL	2
+#define SIM_SERIAL_NTAP	1
+static uint8_t sim_serial_dest[SIM_SERIAL_NDEST + 1][4] = {
+	{ 0 },
+	{ 0x80, 10, 0x11, 0x10 },	/* acknowledged dial page, string 1 */
+	{ 0x01, 10, 0x11, 0x01 },	/* TAP page, account 1 */
+};
+static uint8_t sim_serial_dial[SIM_SERIAL_NDIAL + 1][48] = {
+	"", "5551234", "5559876",
+};
+static uint8_t sim_serial_tap[SIM_SERIAL_NTAP + 1][1] = {
+	{ 0x00 },
+	{ 0x21 },			/* dial string 2, service 1 */
+};
+static uint8_t sim_serial_tap_svc[SIM_SERIAL_NTAP + 1][13] = {
+	{ 0 },
+	{ 0x01, 'P', 'G', '1' },	/* 211 before ETX */
+};
+
+/* sim_serial_config - Get/Set Serial/Modem Configuration Parameters */
+static int
+sim_serial_config(const uint8_t *rq, int rq_len, int set, uint8_t *ccode,
+                  uint8_t *rsp)
+{
+	uint8_t *p = NULL;
+	uint8_t sel;
+	int hdr = 1;
+	int len = 0;
+
+	if (rq_len < (set ? 3 : 4)) {
+		*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+		return 0;
+	}
+	if ((rq[0] & 0x0f) != SIM_SERIAL_CHANNEL) {
+		*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+		return 0;
+	}
+	sel = rq[2] & 0x7f;
+	rsp[0] = 0x11;		/* parameter revision */
+	switch (rq[1]) {
+	case 0x00:		/* set in progress */
+		if (set)
+			return 0;
+		rsp[1] = 0;
+		return 2;
+	case 0x10:		/* number of destinations */
+	case 0x14:		/* number of dial strings */
+	case 0x18:		/* number of TAP accounts */
+		if (set)
+			break;
+		rsp[1] = (rq[1] == 0x10) ? SIM_SERIAL_NDEST
+			: (rq[1] == 0x14) ? SIM_SERIAL_NDIAL : SIM_SERIAL_NTAP;
+		return 2;
+	case 0x11:
+		if (sel <= SIM_SERIAL_NDEST)
+			p = sim_serial_dest[sel];
+		len = sizeof(sim_serial_dest[0]);
+		break;
+	case 0x15:
+		if (sel > SIM_SERIAL_NDIAL || rq_len < 4
+		    || rq[3] == 0 || rq[3] > 3)
+			break;
+		p = sim_serial_dial[sel] + (rq[3] - 1) * 16;
+		len = 16;
+		hdr = 2;
+		break;
+	case 0x19:
+		if (sel <= SIM_SERIAL_NTAP)
+			p = sim_serial_tap[sel];
+		len = sizeof(sim_serial_tap[0]);
+		break;
+	case 0x1c:
+		if (sel <= SIM_SERIAL_NTAP)
+			p = sim_serial_tap_svc[sel];
+		len = sizeof(sim_serial_tap_svc[0]);
+		break;
+	default:
+		*ccode = 0x80;	/* parameter not supported */
+		return 0;
+	}
+	if (!p) {
+		*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+		return 0;
+	}
+	if (set) {
+		if (rq_len != 2 + hdr + len) {
+			*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+			return 0;
+		}
+		memcpy(p, rq + 2 + hdr, len);
+		return 0;
+	}
+	memcpy(rsp + 1, rq + 2, hdr);
+	memcpy(rsp + 1 + hdr, p, len);
+	return 1 + hdr + len;
+}
+
+/* sim_picmg - PICMG properties, power level, LED and port state of an
+ * ATCA IPMC with one FRU, one blue LED and one enabled base channel port
+ */
+static int
+sim_picmg(uint8_t cmd, const uint8_t *rq, int rq_len, uint8_t *ccode,
+          uint8_t *rsp)
+{
+	if (rq_len < 1 || rq[0] != 0x00) {	/* PICMG identifier */
+		*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+		return 0;
+	}
+	rsp[0] = 0x00;
+	switch (cmd) {
+	case 0x00:		/* Get PICMG Properties */
+		rsp[1] = 0x32;		/* PICMG 3.0 revision 2.3 */
+		rsp[2] = 0x00;		/* max FRU device ID */
+		rsp[3] = 0x00;		/* IPMC FRU device ID */
+		return 4;
+	case 0x05:		/* Get FRU LED Properties */
+		if (rq_len < 2 || rq[1] != 0)
+			break;
+		rsp[1] = 0x01;		/* blue LED */
+		rsp[2] = 0x00;		/* no application specific LEDs */
+		return 3;
+	case 0x08:		/* Get FRU LED State */
+		if (rq_len < 3 || rq[1] != 0 || rq[2] != 0)
+			break;
+		rsp[1] = 0x00;		/* local control */
+		rsp[2] = 0xff;		/* on */
+		rsp[3] = 0x00;
+		rsp[4] = 0x01;		/* blue */
+		return 5;
+	case 0x0f:		/* Get Port State */
+		if (rq_len < 2 || rq[1] != 0x01)	/* base channel 1 */
+			break;
+		rsp[1] = 0x01;
+		rsp[2] = 0x01;		/* port 1, base interface */
+		rsp[3] = 0x00;
+		rsp[4] = 0x00;
+		rsp[5] = 0x01;		/* enabled */
+		return 6;
+	case 0x12:		/* Get Power Level */
+		if (rq_len < 3 || rq[1] != 0)
+			break;
+		rsp[1] = 0x01;		/* level 1 */
+		rsp[2] = 0x00;		/* delay to stable power */
+		rsp[3] = 10;		/* multiplier, 0.1 W */
+		rsp[4] = 20;		/* 20.0 W */
+		return 5;
+	default:
+		*ccode = IPMI_CC_INV_CMD;
+		return 0;
+	}
+	*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+	return 0;
+}
+
+/* sim_handle - process one request
+ *
+ * Returns the response data length; the completion code is stored
+ * in @ccode.
+ */
+static int
+sim_handle(struct sim_conn *c, const struct dummy_rq *rq, const uint8_t *data,
+           uint8_t *ccode, uint8_t *rsp)
+{
+	int len = rq->msg.data_len;
+	uint16_t off;
+
+	*ccode = IPMI_CC_OK;
+
+	switch ((rq->msg.netfn << 8) | rq->msg.cmd) {
+	case (IPMI_NETFN_APP << 8) | 0x01:	/* Get Device ID */
+		memset(rsp, 0, 15);
+		rsp[0] = 0x20;
+		rsp[1] = 0x01;
+		rsp[2] = 0x01;
+		rsp[4] = 0x02;		/* IPMI 2.0 */
+		rsp[5] = SIM_DEV_SUPPORT;
+		return 15;
+	case (IPMI_NETFN_APP << 8) | 0x04:	/* Get Self Test Results */
+		rsp[0] = 0x55;
+		rsp[1] = 0x00;
+		return 2;
+	case (IPMI_NETFN_APP << 8) | 0x42:	/* Get Channel Info */
+		if (len < 1)
+			break;
+		if ((data[0] & 0x0f) != SIM_LAN_CHANNEL
+		    && (data[0] & 0x0f) != SIM_SERIAL_CHANNEL) {
+			*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+			return 0;
+		}
+		memset(rsp, 0, 9);
+		rsp[0] = data[0] & 0x0f;
+		/* 802.3 LAN or asynch serial */
+		rsp[1] = (rsp[0] == SIM_LAN_CHANNEL) ? 0x04 : 0x05;
+		rsp[2] = 0x01;		/* IPMB-1.0 protocol */
+		rsp[3] = 0x82;		/* multi-session, 2 active */
+		rsp[4] = 0xf2;		/* IANA 7154 */
+		rsp[5] = 0x1b;
+		return 9;
+	case (IPMI_NETFN_APP << 8) | 0x40:	/* Set Channel Access */
+		return sim_channel_access(data, len, 1, ccode, rsp);
+	case (IPMI_NETFN_APP << 8) | 0x41:	/* Get Channel Access */
+		return sim_channel_access(data, len, 0, ccode, rsp);
+	case (IPMI_NETFN_APP << 8) | 0x43:	/* Set User Access */
+		return sim_user_access(data, len, 1, ccode, rsp);
+	case (IPMI_NETFN_APP << 8) | 0x44:	/* Get User Access */
+		return sim_user_access(data, len, 0, ccode, rsp);
+	case (IPMI_NETFN_APP << 8) | 0x46:	/* Get User Name */
+		if (len < 1)
+			break;
+		if ((data[0] & 0x3f) == 0 || (data[0] & 0x3f) > SIM_MAX_USERS) {
+			*ccode = IPMI_CC_INV_DATA_FIELD_IN_REQ;
+			return 0;
+		}
+		memset(rsp, 0, 16);
+		strncpy((char *)rsp, sim_users[(data[0] & 0x3f) - 1].name, 16);
+		return 16;
+	case (IPMI_NETFN_CHASSIS << 8) | 0x08:	/* Set System Boot Options */
+		return sim_boot_options(data, len, 1, ccode, rsp);
+	case (IPMI_NETFN_CHASSIS << 8) | 0x09:	/* Get System Boot Options */
+		return sim_boot_options(data, len, 0, ccode, rsp);
+	case (IPMI_NETFN_TRANSPORT << 8) | 0x02:	/* Get LAN Config */
+		return sim_lan_config(data, len, ccode, rsp);
+	case (IPMI_NETFN_TRANSPORT << 8) | 0x01:	/* Set LAN Config */
+		return sim_lan_set(data, len, ccode);
+	case (IPMI_NETFN_TRANSPORT << 8) | 0x10:	/* Set Serial Config */
+		return sim_serial_config(data, len, 1, ccode, rsp);
+	case (IPMI_NETFN_TRANSPORT << 8) | 0x11:	/* Get Serial Config */
+		return sim_serial_config(data, len, 0, ccode, rsp);
+	case (IPMI_NETFN_TRANSPORT << 8) | 0x21:	/* Set SOL Config */
+		return sim_sol_config(data, len, 1, ccode, rsp);
+	case (IPMI_NETFN_TRANSPORT << 8) | 0x22:	/* Get SOL Config */
+		return sim_sol_config(data, len, 0, ccode, rsp);
+	case (IPMI_NETFN_APP << 8) | 0x52:	/* Master Write-Read */
+		/* two byte eeprom address, low byte first like 'gendev' */
+		if (len < 5)
+			break;
+		if (data[0] != SIM_EEPROM_BUS || data[1] != SIM_EEPROM_ADDR) {
+			*ccode = 0x83;	/* NAK on write */
+			return 0;
+		}
+		off = ipmi16toh((void *)&data[3]);
+		if (off + data[2] > SIM_EEPROM_SIZE
+		    || off + (len - 5) > SIM_EEPROM_SIZE)
+		{
+			*ccode = IPMI_CC_PARAM_OUT_OF_RANGE;
+			return 0;
+		}
+		memcpy(sim_eeprom + off, data + 5, len - 5);
+		memcpy(rsp, sim_eeprom + off, data[2]);
+		return data[2];
+	case (IPMI_NETFN_DCGRP << 8) | 0x02:	/* DCMI Get Power Reading */
+		if (len < 4 || data[0] != 0xdc)
+			break;
+		memset(rsp, 0, 18);
+		rsp[0] = 0xdc;
+		htoipmi16(200 + rand() % 50, rsp + 1);	/* current */
+		htoipmi16(200, rsp + 3);		/* minimum */
+		htoipmi16(249, rsp + 5);		/* maximum */
+		htoipmi16(224, rsp + 7);		/* average */
+		htoipmi32((uint32_t)time(NULL), rsp + 9);
+		htoipmi32(1000, rsp + 13);		/* period, ms */
+		rsp[17] = 0x40;				/* active */
+		return 18;
+	case (IPMI_NETFN_OEM << 8) | 0xc8:	/* NM Get Statistics */
+		if (len < 6 || data[0] != 0x57)
+			break;
+		memset(rsp, 0, 20);
+		rsp[0] = 0x57;
+		rsp[1] = 0x01;
+		htoipmi16(150 + (data[4] & 0xf) * 10 + rand() % 20, rsp + 3);
+		htoipmi16(150, rsp + 5);
+		htoipmi16(199, rsp + 7);
+		htoipmi16(175, rsp + 9);
+		htoipmi32((uint32_t)time(NULL), rsp + 11);
+		htoipmi32(60, rsp + 15);		/* period, s */
+		rsp[19] = 0x70 | (data[4] & 0xf);	/* enabled, measuring */
+		return 20;
+	case (IPMI_NETFN_PICMG << 8) | 0x00:	/* Get PICMG Properties */
+	case (IPMI_NETFN_PICMG << 8) | 0x05:	/* Get FRU LED Properties */
+	case (IPMI_NETFN_PICMG << 8) | 0x08:	/* Get FRU LED State */
+	case (IPMI_NETFN_PICMG << 8) | 0x0f:	/* Get Port State */
+	case (IPMI_NETFN_PICMG << 8) | 0x12:	/* Get Power Level */
+		return sim_picmg(rq->msg.cmd, data, len, ccode, rsp);
+	case (IPMI_NETFN_SE << 8) | 0x10:	/* Get PEF Capabilities */
+		rsp[0] = 0x51;
+		rsp[1] = 0x3f;
+		rsp[2] = SIM_PEF_FILTERS;
+		return 3;
+	case (IPMI_NETFN_SE << 8) | 0x12:	/* Set PEF Config */
+		return sim_pef_config(data, len, 1, ccode, rsp);
+	case (IPMI_NETFN_SE << 8) | 0x13:	/* Get PEF Config */
+		return sim_pef_config(data, len, 0, ccode, rsp);
+	case (IPMI_NETFN_SE << 8) | 0x2d:	/* Get Sensor Reading */
+		if (len < 1)
+			break;
+		rsp[0] = 30 + data[0] % 40;
+		rsp[1] = 0x40;		/* scanning enabled */
+		rsp[2] = 0x00;
+		rsp[3] = 0x00;
+		return 4;
+	case (IPMI_NETFN_SE << 8) | 0x27:	/* Get Sensor Thresholds */
+		memset(rsp, 0, 7);
+		rsp[0] = 0x18;		/* upper non-critical and critical */
+		rsp[4] = 80;
+		rsp[5] = 90;
+		return 7;
+	case (IPMI_NETFN_STORAGE << 8) | 0x10:	/* Get FRU Inventory Area Info */
+		if (len < 1)
+			break;
+		if (data[0] != 0) {
+			*ccode = IPMI_CC_REQ_DATA_NOT_PRESENT;
+			return 0;
+		}
+		htoipmi16(fru_len, rsp);
+		rsp[2] = 0x00;		/* byte access */
+		return 3;
+	case (IPMI_NETFN_STORAGE << 8) | 0x11:	/* Read FRU Data */
+		if (len < 4)
+			break;
+		if (data[0] != 0) {
+			*ccode = IPMI_CC_REQ_DATA_NOT_PRESENT;
+			return 0;
+		}
+		off = ipmi16toh((void *)&data[1]);
+		if (off >= fru_len) {
+			*ccode = IPMI_CC_PARAM_OUT_OF_RANGE;
+			return 0;
+		}
+		rsp[0] = __min(data[3], fru_len - off);
+		memcpy(rsp + 1, fru_buf + off, rsp[0]);
+		return rsp[0] + 1;
+	case (IPMI_NETFN_STORAGE << 8) | 0x20:	/* Get SDR Repository Info */
+		return sim_repo_info(&sdr_repo, rsp);
+	case (IPMI_NETFN_STORAGE << 8) | 0x22:	/* Reserve SDR Repository */
+		htoipmi16(++c->sdr_res, rsp);
+		return 2;
+	case (IPMI_NETFN_STORAGE << 8) | 0x23:	/* Get SDR */
+		return sim_repo_get(&sdr_repo, &c->sdr_res, data, len,
+		                    ccode, rsp);
+	case (IPMI_NETFN_STORAGE << 8) | 0x40:	/* Get SEL Info */
+		return sim_repo_info(&sel_repo, rsp);
+	case (IPMI_NETFN_STORAGE << 8) | 0x42:	/* Reserve SEL */
+		htoipmi16(++c->sel_res, rsp);
+		return 2;
+	case (IPMI_NETFN_STORAGE << 8) | 0x43:	/* Get SEL Entry */
+		return sim_repo_get(&sel_repo, &c->sel_res, data, len,
+		                    ccode, rsp);
+	case (IPMI_NETFN_STORAGE << 8) | 0x48:	/* Get SEL Time */
+		htoipmi32((uint32_t)time(NULL), rsp);
+		return 4;
+	default:
+		*ccode = IPMI_CC_INV_CMD;
+		return 0;
+	}
+
+	*ccode = IPMI_CC_REQ_DATA_INV_LENGTH;
+	return 0;
+}
+
+/* sim_term_frame - encode a response as a terminal mode line
+ *
+ * "[NetFn/LUN Seq Cmd CC Data...]" in hex, the request's bridge and
+ * sequence byte is echoed back.
+ */
+static void
+sim_term_frame(const struct sim_conn *c, const struct dummy_rs *rs,
+               const uint8_t *data, struct sim_rsp *r)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	uint8_t hdr[4];
+	char *p;
+	size_t i;
+
+	hdr[0] = c->hdr[0] | 4;
+	hdr[1] = c->hdr[1];
+	hdr[2] = c->hdr[2];
+	hdr[3] = rs->ccode;
+
+	r->buf = sim_malloc((sizeof(hdr) + rs->data_len) * 3 + 3);
+	p = (char *)r->buf;
+	*p++ = '[';
+	for (i = 0; i < sizeof(hdr) + rs->data_len; i++) {
+		uint8_t b = i < sizeof(hdr) ? hdr[i] : data[i - sizeof(hdr)];
+
+		if (i)
+			*p++ = ' ';
+		*p++ = hex[b >> 4];
+		*p++ = hex[b & 0xf];
+	}
+	*p++ = ']';
+	*p++ = '\r';
+	*p++ = '\n';
+	r->len = p - (char *)r->buf;
+}
+
+/* sim_basic_frame - encode a response as an escaped basic mode frame */
+static void
+sim_basic_frame(const struct sim_conn *c, const struct dummy_rs *rs,
+                const uint8_t *data, struct sim_rsp *r)
+{
+	uint8_t msg[SIM_BM_HDR_SIZE + 1 + SIM_MAX_DATA];
+	size_t len = 0, i, j;
+	uint8_t *p;
+
+	/* swap requester and responder, LUNs included */
+	msg[len++] = c->hdr[3];
+	msg[len++] = ((c->hdr[1] | 4) & ~3) | (c->hdr[4] & 3);
+	msg[len] = sim_csum(msg, len);
+	len++;
+	msg[len++] = c->hdr[0];
+	msg[len++] = (c->hdr[4] & ~3) | (c->hdr[1] & 3);
+	msg[len++] = c->hdr[5];
+	msg[len++] = rs->ccode;
+	memcpy(msg + len, data, rs->data_len);
+	len += rs->data_len;
+	msg[len] = sim_csum(msg + 3, len - 3);
+	len++;
+
+	r->buf = sim_malloc(len * 2 + 2);
+	p = r->buf;
+	*p++ = SIM_BM_START;
+	for (i = 0; i < len; i++) {
+		for (j = 0; j < ARRAY_SIZE(sim_bm_escapes); j++) {
+			if (sim_bm_escapes[j].character == msg[i])
+				break;
+		}
+		if (j < ARRAY_SIZE(sim_bm_escapes)) {
+			*p++ = SIM_BM_ESCAPE;
+			*p++ = sim_bm_escapes[j].escape;
+		} else {
+			*p++ = msg[i];
+		}
+	}
+	*p++ = SIM_BM_STOP;
+	r->len = p - r->buf;
+}
+
+/* sim_queue_rsp - build the response to a request and queue it for sending
+ *
+ * Responses on a connection are sent in request order, each no earlier
+ * than the configured latency plus a random jitter after its request.
+ */
+static void
+sim_queue_rsp(struct sim_conn *c, const struct dummy_rq *rq,
+              const uint8_t *data)
+{
+	uint8_t rsp_data[SIM_MAX_DATA];
+	struct dummy_rs rs;
+	struct sim_rsp *r;
+	uint64_t due;
+	int len;
+
+	memset(&rs, 0, sizeof(rs));
+	len = sim_handle(c, rq, data, &rs.ccode, rsp_data);
+	rs.msg.netfn = rq->msg.netfn + 1;
+	rs.msg.cmd = rq->msg.cmd;
+	rs.msg.lun = rq->msg.lun;
+	rs.data_len = len;
+
+	if (sim_verbose) {
+		sim_log("fd %d: netfn 0x%02x cmd 0x%02x -> ccode 0x%02x, "
+		        "%d bytes", c->fd, rq->msg.netfn, rq->msg.cmd,
+		        rs.ccode, len);
+	}
+
+	r = sim_malloc(sizeof(*r));
+	switch (c->mode) {
+	case SIM_MODE_TERM:
+		sim_term_frame(c, &rs, rsp_data, r);
+		break;
+	case SIM_MODE_BASIC:
+		sim_basic_frame(c, &rs, rsp_data, r);
+		break;
+	default:
+		r->len = sizeof(rs) + len;
+		r->buf = sim_malloc(r->len);
+		memcpy(r->buf, &rs, sizeof(rs));
+		memcpy(r->buf + sizeof(rs), rsp_data, len);
+		break;
+	}
+	r->next = NULL;
+
+	due = sim_now() + sim_latency;
+	if (sim_jitter)
+		due += (uint64_t)rand() % sim_jitter;
+	if (c->tail && c->tail->due > due)
+		due = c->tail->due;
+	r->due = due;
+
+	if (c->tail)
+		c->tail->next = r;
+	else
+		c->head = r;
+	c->tail = r;
+}
+
+/* sim_serial_rq - answer a decoded serial request
+ *
+ * Terminal mode requests start with NetFn/LUN, Seq and Cmd, basic mode
+ * ones carry a full IPMB header and checksums.
+ */
+static void
+sim_serial_rq(struct sim_conn *c, const uint8_t *msg, size_t len)
+{
+	struct dummy_rq rq;
+	size_t hdr_len;
+
+	memset(&rq, 0, sizeof(rq));
+	if (c->mode == SIM_MODE_TERM) {
+		if (len < 3)
+			return;
+		hdr_len = 3;
+		rq.msg.netfn = msg[0] >> 2;
+		rq.msg.lun = msg[0] & 3;
+		rq.msg.cmd = msg[2];
+		rq.msg.data_len = len - 3;
+	} else {
+		if (len < SIM_BM_HDR_SIZE || sim_csum(msg, 3)
+		    || sim_csum(msg + 3, len - 3))
+		{
+			if (sim_verbose)
+				sim_log("fd %d: dropping bad basic mode frame", c->fd);
+			return;
+		}
+		hdr_len = SIM_BM_HDR_SIZE - 1;
+		rq.msg.netfn = msg[1] >> 2;
+		rq.msg.lun = msg[1] & 3;
+		rq.msg.cmd = msg[5];
+		rq.msg.data_len = len - SIM_BM_HDR_SIZE;
+	}
+	memcpy(c->hdr, msg, hdr_len);
+	sim_queue_rsp(c, &rq, msg + hdr_len);
+}
+
+/* sim_serial_input - parse complete serial requests out of the input buffer
+ *
+ * Noise and malformed frames are skipped, a pty is never closed.
+ */
+static void
+sim_serial_input(struct sim_conn *c)
+{
+	uint8_t msg[SIM_MAX_DATA];
+	uint8_t *start, *end;
+	size_t len;
+
+	for (;;) {
+		if (c->mode == SIM_MODE_TERM) {
+			end = memchr(c->in, ']', c->in_len);
+		} else {
+			end = memchr(c->in, SIM_BM_STOP, c->in_len);
+		}
+		if (!end)
+			break;
+
+		/* the last start character before the stop one */
+		for (start = end; start > c->in; start--) {
+			if (start[-1] == (c->mode == SIM_MODE_TERM ? '[' : SIM_BM_START))
+				break;
+		}
+
+		len = 0;
+		if (start > c->in && c->mode == SIM_MODE_TERM) {
+			int nibbles = 0;
+
+			for (; start < end && len < sizeof(msg); start++) {
+				int v;
+
+				if (*start >= '0' && *start <= '9')
+					v = *start - '0';
+				else if ((*start | 0x20) >= 'a' && (*start | 0x20) <= 'f')
+					v = (*start | 0x20) - 'a' + 10;
+				else
+					continue;
+				if (nibbles++ & 1)
+					msg[len - 1] |= v;
+				else
+					msg[len++] = v << 4;
+			}
+			sim_serial_rq(c, msg, len);
+		} else if (start > c->in) {
+			for (; start < end && len < sizeof(msg); start++) {
+				size_t j;
+
+				if (*start == SIM_BM_HANDSHAKE)
+					continue;
+				if (*start != SIM_BM_ESCAPE) {
+					msg[len++] = *start;
+					continue;
+				}
+				if (++start == end)
+					break;
+				for (j = 0; j < ARRAY_SIZE(sim_bm_escapes); j++) {
+					if (sim_bm_escapes[j].escape == *start)
+						msg[len++] = sim_bm_escapes[j].character;
+				}
+			}
+			sim_serial_rq(c, msg, len);
+		}
+
+		end++;
+		c->in_len -= end - c->in;
+		memmove(c->in, end, c->in_len);
+	}
+
+	/* a full buffer without a complete frame is noise */
+	if (c->in_len == sizeof(c->in))
+		c->in_len = 0;
+}
+
+/* sim_conn_input - parse complete requests out of the input buffer
+ *
+ * Returns -1 if the client said goodbye or sent garbage.
+ */
+static int
+sim_conn_input(struct sim_conn *c)
+{
+	struct dummy_rq rq;
+	size_t need;
+
+	if (c->mode != SIM_MODE_DUMMY) {
+		sim_serial_input(c);
+		return 0;
+	}
+
+	while (c->in_len >= sizeof(rq)) {
+		memcpy(&rq, c->in, sizeof(rq));
+		if (rq.msg.netfn == 0x3f && rq.msg.cmd == 0xff)
+			return -1;	/* 'BYE' */
+		if (rq.msg.data_len > SIM_MAX_DATA)
+			return -1;
+
+		need = sizeof(rq) + rq.msg.data_len;
+		if (c->in_len < need)
+			break;
+
+		sim_queue_rsp(c, &rq, c->in + sizeof(rq));
+		memmove(c->in, c->in + need, c->in_len - need);
+		c->in_len -= need;
+	}
+	return 0;
+}
+
+/* Move responses that are due into the output buffer */
+static void
+sim_conn_flush(struct sim_conn *c, uint64_t now)
+{
+	while (c->head && c->head->due <= now) {
+		struct sim_rsp *r = c->head;
+
+		if (c->out_off) {
+			memmove(c->out, c->out + c->out_off,
+			        c->out_len - c->out_off);
+			c->out_len -= c->out_off;
+			c->out_off = 0;
+		}
+		c->out = sim_realloc(c->out, c->out_len + r->len);
+		memcpy(c->out + c->out_len, r->buf, r->len);
+		c->out_len += r->len;
+
+		c->head = r->next;
+		if (!c->head)
+			c->tail = NULL;
+		free(r->buf);
+		free(r);
+	}
+}
+
+static void
+sim_conn_close(size_t i)
+{
+	struct sim_conn *c = conns[i];
+
+	while (c->head) {
+		struct sim_rsp *r = c->head;
+
+		c->head = r->next;
+		free(r->buf);
+		free(r);
+	}
+	close(c->fd);
+	if (c->pty_slave >= 0)
+		close(c->pty_slave);
+	free(c->out);
+	free(c);
+
+	/* index 0 is the listening socket */
+	nconns--;
+	conns[i] = conns[nconns + 1];
+	pfds[i] = pfds[nconns + 1];
+}
+
+/* sim_conn_add - start serving a non-blocking descriptor */
+static struct sim_conn *
+sim_conn_add(int fd, enum sim_mode mode)
+{
+	struct sim_conn *c;
+
+	/* index 0 is reserved for the listening socket */
+	if (nconns + 1 >= max_conns) {
+		max_conns = max_conns ? max_conns * 2 : 64;
+		conns = sim_realloc(conns, max_conns * sizeof(*conns));
+		pfds = sim_realloc(pfds, max_conns * sizeof(*pfds));
+	}
+	c = sim_malloc(sizeof(*c));
+	memset(c, 0, sizeof(*c));
+	c->fd = fd;
+	c->pty_slave = -1;
+	c->mode = mode;
+
+	nconns++;
+	conns[nconns] = c;
+	pfds[nconns].fd = fd;
+	pfds[nconns].events = POLLIN;
+	pfds[nconns].revents = 0;
+	return c;
+}
+
+static void
+sim_accept(int lfd)
+{
+	int fd;
+
+	while ((fd = accept(lfd, NULL, NULL)) >= 0) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		sim_conn_add(fd, SIM_MODE_DUMMY);
+	}
+}
+
+/* sim_pty - serve serial framing on a new pty linked from 'link' */
+static int
+sim_pty(const char *link, enum sim_mode mode)
+{
+	struct termios ti;
+	struct sim_conn *c;
+	const char *name;
+	int fd, slave;
+
+	fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (fd < 0 || grantpt(fd) || unlockpt(fd) || !(name = ptsname(fd))) {
+		sim_log("unable to allocate a pty: %s", strerror(errno));
+		if (fd >= 0)
+			close(fd);
+		return -1;
+	}
+	slave = open(name, O_RDWR | O_NOCTTY);
+	if (slave < 0) {
+		sim_log("unable to open %s: %s", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	tcgetattr(slave, &ti);
+	cfmakeraw(&ti);
+	tcsetattr(slave, TCSANOW, &ti);
+
+	unlink(link);
+	if (symlink(name, link)) {
+		sim_log("unable to link %s to %s: %s", link, name, strerror(errno));
+		close(slave);
+		close(fd);
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	c = sim_conn_add(fd, mode);
+	c->pty_slave = slave;
+
+	sim_log("serving serial %s mode on %s (%s)",
+	        mode == SIM_MODE_TERM ? "terminal" : "basic", link, name);
+	return 0;
+}
+
+/* Service one connection, returns -1 if it must be closed */
+static int
+sim_conn_io(struct sim_conn *c, short revents)
+{
+	ssize_t n;
+
+	if (revents & POLLIN) {
+		n = read(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len);
+		if (n == 0)
+			return -1;
+		if (n < 0 && errno != EAGAIN && errno != EINTR)
+			return -1;
+		if (n > 0) {
+			c->in_len += n;
+			if (sim_conn_input(c))
+				return -1;
+		}
+	} else if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+		return -1;
+	}
+
+	if (revents & POLLOUT && c->out_off < c->out_len) {
+		n = write(c->fd, c->out + c->out_off, c->out_len - c->out_off);
+		if (n < 0 && errno != EAGAIN && errno != EINTR)
+			return -1;
+		if (n > 0)
+			c->out_off += n;
+		if (c->out_off == c->out_len)
+			c->out_off = c->out_len = 0;
+	}
+	return 0;
+}
+
+static int
+sim_listen(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		sim_log("socket path %s is too long", path);
+		return -1;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		sim_log("socket(): %s", strerror(errno));
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr))
+	    || listen(fd, SOMAXCONN))
+	{
+		sim_log("unable to listen on %s: %s", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	return fd;
+}
+
+static void
+sim_run(int lfd)
+{
+	if (!max_conns) {
+		max_conns = 64;
+		conns = sim_malloc(max_conns * sizeof(*conns));
+		pfds = sim_malloc(max_conns * sizeof(*pfds));
+	}
+	conns[0] = NULL;
+	pfds[0].fd = lfd;
+	pfds[0].events = POLLIN;
+
+	while (!sim_exit) {
+		uint64_t now = sim_now();
+		uint64_t next = UINT64_MAX;
+		int timeout = -1;
+		size_t i;
+
+		for (i = 1; i <= nconns; i++) {
+			struct sim_conn *c = conns[i];
+
+			sim_conn_flush(c, now);
+			if (c->head && c->head->due < next)
+				next = c->head->due;
+			pfds[i].events = POLLIN;
+			if (c->out_off < c->out_len)
+				pfds[i].events |= POLLOUT;
+		}
+		if (next != UINT64_MAX)
+			timeout = (next - now + 999) / 1000;
+
+		if (poll(pfds, nconns + 1, timeout) < 0) {
+			if (errno == EINTR)
+				continue;
+			sim_log("poll(): %s", strerror(errno));
+			break;
+		}
+
+		/* walk backwards, closing swaps in the last entry */
+		for (i = nconns; i >= 1; i--) {
+			if (pfds[i].revents
+			    && sim_conn_io(conns[i], pfds[i].revents))
+			{
+				sim_conn_close(i);
+			}
+		}
+		if (pfds[0].revents & POLLIN)
+			sim_accept(lfd);
+	}
+
+	while (nconns)
+		sim_conn_close(nconns);
+	free(conns);
+	free(pfds);
+}
+
+static void
+sim_sighandler(int __UNUSED__(sig))
+{
+	sim_exit = 1;
+}
+
+static void
+sim_usage(void)
+{
+	fprintf(stderr,
+"usage: ipmi_dummy_bmc [options]\n"
+"\n"
+"  -s <path>   UNIX socket to listen on [$IPMI_DUMMY_SOCK or "
+	IPMI_DUMMY_DEFAULTSOCK "]\n"
+"  -S <file>   load SDR repository written by 'sdr dump'\n"
+"  -E <file>   load SEL written by 'sel writeraw'\n"
+"  -F <file>   load FRU 0 image written by 'fru read'\n"
+"  -n <count>  number of sensors to generate [%d]\n"
+"  -e <count>  number of SEL entries to generate [%d]\n"
+"  -l <usec>   response latency\n"
+"  -j <usec>   random response jitter added to the latency\n"
+"  -c <pct>    probability of cancelling a reservation on read\n"
+"  -t <link>   also serve serial terminal mode on a pty linked from <link>\n"
+"  -b <link>   also serve serial basic mode on a pty linked from <link>\n"
+"  -v          log every request\n",
+	SIM_DEFAULT_SENSORS, SIM_DEFAULT_EVENTS);
+}
+
+static uint32_t
+sim_arg(const char *arg)
+{
+	char *end;
+	unsigned long v;
+
+	errno = 0;
+	v = strtoul(arg, &end, 0);
+	if (errno || *end || !*arg || v > UINT32_MAX) {
+		sim_log("invalid number '%s'", arg);
+		exit(EXIT_FAILURE);
+	}
+	return v;
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *path = getenv("IPMI_DUMMY_SOCK");
+	const char *sdr_file = NULL;
+	const char *sel_file = NULL;
+	const char *fru_file = NULL;
+	const char *term_link = NULL;
+	const char *basic_link = NULL;
+	uint32_t nsensors = SIM_DEFAULT_SENSORS;
+	uint32_t nevents = SIM_DEFAULT_EVENTS;
+	struct sigaction act;
+	int lfd, opt;
+
+	while ((opt = getopt(argc, argv, "s:S:E:F:n:e:l:j:c:t:b:vh")) != -1) {
+		switch (opt) {
+		case 's': path = optarg; break;
+		case 'S': sdr_file = optarg; break;
+		case 'E': sel_file = optarg; break;
+		case 'F': fru_file = optarg; break;
+		case 'n': nsensors = sim_arg(optarg); break;
+		case 'e': nevents = sim_arg(optarg); break;
+		case 'l': sim_latency = sim_arg(optarg); break;
+		case 'j': sim_jitter = sim_arg(optarg); break;
+		case 'c': sim_cancel = sim_arg(optarg); break;
+		case 't': term_link = optarg; break;
+		case 'b': basic_link = optarg; break;
+		case 'v': sim_verbose = 1; break;
+		default:
+			sim_usage();
+			return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if (!path)
+		path = IPMI_DUMMY_DEFAULTSOCK;
+
+	if (sdr_file)
+		sim_load_sdr(sdr_file);
+	else {
+		sim_gen_sdr(nsensors);
+		sim_gen_gendev();
+		sim_gen_mc();
+	}
+
+	if (sel_file)
+		sim_load_sel(sel_file);
+	else
+		sim_gen_sel(nevents);
+
+	if (fru_file)
+		fru_buf = sim_load_file(fru_file, &fru_len);
+	else
+		sim_gen_fru();
+
+	lfd = sim_listen(path);
+	if (lfd < 0)
+		return EXIT_FAILURE;
+	if ((term_link && sim_pty(term_link, SIM_MODE_TERM))
+	    || (basic_link && sim_pty(basic_link, SIM_MODE_BASIC)))
+	{
+		close(lfd);
+		unlink(path);
+		return EXIT_FAILURE;
+	}
+
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = sim_sighandler;
+	sigaction(SIGINT, &act, NULL);
+	sigaction(SIGTERM, &act, NULL);
+	signal(SIGPIPE, SIG_IGN);
+	srand(1);
+
+	sim_log("serving %zu SDRs, %zu SEL entries, %zu byte FRU on %s",
+	        sdr_repo.count, sel_repo.count, fru_len, path);
+	sim_run(lfd);
+
+	close(lfd);
+	unlink(path);
+	if (term_link)
+		unlink(term_link);
+	if (basic_link)
+		unlink(basic_link);
+	return EXIT_SUCCESS;
+}
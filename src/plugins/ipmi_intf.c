@@ -83,6 +83,9 @@ extern struct ipmi_intf ipmi_serial_bm_intf;
 #ifdef IPMI_INTF_DUMMY
 extern struct ipmi_intf ipmi_dummy_intf;
 #endif
+#ifdef IPMI_INTF_REPLAY
+extern struct ipmi_intf ipmi_replay_intf;
+#endif
 #ifdef IPMI_INTF_USB
 extern struct ipmi_intf ipmi_usb_intf;
 #endif
@@ -119,6 +122,9 @@ struct ipmi_intf * ipmi_intf_table[] = {
 #ifdef IPMI_INTF_DUMMY
 	&ipmi_dummy_intf,
 #endif
+#ifdef IPMI_INTF_REPLAY
+	&ipmi_replay_intf,
+#endif
 #ifdef IPMI_INTF_USB
 	&ipmi_usb_intf,
 #endif
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2026 The ipmitool Project.  All Rights Reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistribution of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * Redistribution in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder, nor the names of
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ * 
+ * This software is provided "AS IS," without a warranty of any kind.
+ * ALL EXPRESS OR IMPLIED CONDITIONS, REPRESENTATIONS AND WARRANTIES,
+ * INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE OR NON-INFRINGEMENT, ARE HEREBY EXCLUDED.
+ * THE COPYRIGHT HOLDER AND ITS LICENSORS SHALL NOT BE LIABLE
+ * FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING
+ * OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.  IN NO EVENT WILL
+ * THE COPYRIGHT HOLDER OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE,
+ * PROFIT OR DATA, OR FOR DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL,
+ * INCIDENTAL OR PUNITIVE DAMAGES, HOWEVER CAUSED AND REGARDLESS OF THE
+ * THEORY OF LIABILITY, ARISING OUT OF THE USE OF OR INABILITY TO USE THIS
+ * SOFTWARE, EVEN IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGES.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#include <ipmitool/ipmi.h>
+#include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_stats.h>
+#include <ipmitool/ipmi_cc.h>
+#include <ipmitool/helper.h>
+#include <ipmitool/log.h>
+
+#if defined(HAVE_CONFIG_H)
+# include <config.h>
+#endif
+
+static const uint32_t stats_limits[] = IPMI_STATS_BUCKET_LIMITS;
+static volatile sig_atomic_t stats_dump_requested;
+
+static void
+ipmi_stats_sigusr1(int __UNUSED__(sig))
+{
+	stats_dump_requested = 1;
+}
+
+static void
+ipmi_stats_account(struct ipmi_stats *stats, struct ipmi_rq *req,
+                   struct ipmi_rs *rsp, uint64_t usec)
+{
+	struct ipmi_stats_cmd *c;
+	uint8_t netfn = req->msg.netfn % IPMI_STATS_NETFNS;
+	size_t b;
+
+	if (!stats->cmds[netfn]) {
+		stats->cmds[netfn] = calloc(IPMI_STATS_CMDS, sizeof(*c));
+		if (!stats->cmds[netfn])
+			return;
+	}
+	c = &stats->cmds[netfn][req->msg.cmd];
+
+	c->count++;
+	c->tx_bytes += req->msg.data_len;
+	c->usec_total += usec;
+	if (usec > c->usec_max)
+		c->usec_max = usec;
+
+	for (b = 0; b < ARRAY_SIZE(stats_limits) && usec >= stats_limits[b]; b++)
+		;
+	stats->hist[b]++;
+
+	if (!rsp) {
+		c->noresponse++;
+		return;
+	}
+	if (rsp->data_len > 0)
+		c->rx_bytes += rsp->data_len;
+
+	switch (rsp->ccode) {
+	case IPMI_CC_OK:
+		break;
+	case IPMI_CC_RES_CANCELED:
+		c->cc_res_canceled++;
+		break;
+	case IPMI_CC_CANT_RET_NUM_REQ_BYTES:
+		c->cc_cant_ret_bytes++;
+		break;
+	case IPMI_CC_CANT_RESP_DUPLI_REQ:
+		c->cc_dupl_req++;
+		break;
+	default:
+		c->cc_other++;
+		break;
+	}
+}
+
+static struct ipmi_rs *
+ipmi_stats_sendrecv(struct ipmi_intf *intf, struct ipmi_rq *req)
+{
+	struct ipmi_stats *stats = intf->stats;
+	struct ipmi_rs *rsp;
+	uint64_t start;
+
+	start = ipmi_time_usec();
+	rsp = stats->sendrecv(intf, req);
+	ipmi_stats_account(stats, req, rsp, ipmi_time_usec() - start);
+
+	if (stats_dump_requested) {
+		stats_dump_requested = 0;
+		ipmi_stats_print(intf);
+	}
+
+	return rsp;
+}
+
+static void
+ipmi_stats_print_text(const struct ipmi_stats *stats)
+{
+	uint64_t total = 0;
+	int netfn, cmd;
+	size_t b;
+
+	fprintf(stats->fp, "%-5s %-4s %8s %7s %6s %6s %6s %6s %10s %10s\n",
+	        "netfn", "cmd", "count", "norsp", "C5", "CA", "CF", "other",
+	        "avg ms", "max ms");
+
+	for (netfn = 0; netfn < IPMI_STATS_NETFNS; netfn++) {
+		if (!stats->cmds[netfn])
+			continue;
+		for (cmd = 0; cmd < IPMI_STATS_CMDS; cmd++) {
+			const struct ipmi_stats_cmd *c;
+
+			c = &stats->cmds[netfn][cmd];
+			if (!c->count)
+				continue;
+			total += c->count;
+			fprintf(stats->fp, "0x%02x  0x%02x %8" PRIu64 " %7" PRIu64
+			        " %6" PRIu64 " %6" PRIu64 " %6" PRIu64
+			        " %6" PRIu64 " %10.3f %10.3f\n",
+			        netfn, cmd, c->count, c->noresponse,
+			        c->cc_res_canceled, c->cc_cant_ret_bytes,
+			        c->cc_dupl_req, c->cc_other,
+			        (double)c->usec_total / c->count / 1000,
+			        (double)c->usec_max / 1000);
+		}
+	}
+
+	fprintf(stats->fp, "requests: %" PRIu64 ", retries: %" PRIu64
+	        ", wire bytes sent: %" PRIu64 ", received: %" PRIu64 "\n",
+	        total, stats->retries,
+	        stats->wire_tx_bytes, stats->wire_rx_bytes);
+
+	fprintf(stats->fp, "latency histogram:\n");
+	for (b = 0; b < IPMI_STATS_BUCKETS; b++) {
+		if (b < ARRAY_SIZE(stats_limits)) {
+			fprintf(stats->fp, "  < %9.2f ms: %" PRIu64 "\n",
+			        (double)stats_limits[b] / 1000, stats->hist[b]);
+		} else {
+			fprintf(stats->fp, "  >=%9.2f ms: %" PRIu64 "\n",
+			        (double)stats_limits[b - 1] / 1000,
+			        stats->hist[b]);
+		}
+	}
+}
+
+static void
+ipmi_stats_print_json(const struct ipmi_stats *stats)
+{
+	const char *sep = "";
+	int netfn, cmd;
+	size_t b;
+
+	fprintf(stats->fp, "{\"retries\":%" PRIu64 ",\"wire_tx_bytes\":%"
+	        PRIu64 ",\"wire_rx_bytes\":%" PRIu64 ",\"histogram\":[",
+	        stats->retries, stats->wire_tx_bytes, stats->wire_rx_bytes);
+	for (b = 0; b < IPMI_STATS_BUCKETS; b++) {
+		fprintf(stats->fp, "%s{\"le_usec\":", b ? "," : "");
+		if (b < ARRAY_SIZE(stats_limits))
+			fprintf(stats->fp, "%" PRIu32, stats_limits[b]);
+		else
+			fprintf(stats->fp, "null");
+		fprintf(stats->fp, ",\"count\":%" PRIu64 "}", stats->hist[b]);
+	}
+	fprintf(stats->fp, "],\"commands\":[");
+
+	for (netfn = 0; netfn < IPMI_STATS_NETFNS; netfn++) {
+		if (!stats->cmds[netfn])
+			continue;
+		for (cmd = 0; cmd < IPMI_STATS_CMDS; cmd++) {
+			const struct ipmi_stats_cmd *c;
+
+			c = &stats->cmds[netfn][cmd];
+			if (!c->count)
+				continue;
+			fprintf(stats->fp, "%s{\"netfn\":%d,\"cmd\":%d,"
+			        "\"count\":%" PRIu64 ",\"noresponse\":%" PRIu64
+			        ",\"cc_c5\":%" PRIu64 ",\"cc_ca\":%" PRIu64
+			        ",\"cc_cf\":%" PRIu64 ",\"cc_other\":%" PRIu64
+			        ",\"tx_bytes\":%" PRIu64 ",\"rx_bytes\":%" PRIu64
+			        ",\"usec_total\":%" PRIu64
+			        ",\"usec_max\":%" PRIu64 "}",
+			        sep, netfn, cmd, c->count, c->noresponse,
+			        c->cc_res_canceled, c->cc_cant_ret_bytes,
+			        c->cc_dupl_req, c->cc_other,
+			        c->tx_bytes, c->rx_bytes,
+			        c->usec_total, c->usec_max);
+			sep = ",";
+		}
+	}
+	fprintf(stats->fp, "]}\n");
+}
+
+/* ipmi_stats_print  -  dump the statistics collected so far
+ *
+ * @intf:	interface passed to ipmi_stats_start()
+ */
+void
+ipmi_stats_print(struct ipmi_intf *intf)
+{
+	if (!intf->stats)
+		return;
+
+	if (intf->stats->json)
+		ipmi_stats_print_json(intf->stats);
+	else
+		ipmi_stats_print_text(intf->stats);
+	fflush(intf->stats->fp);
+}
+
+/* ipmi_stats_start  -  collect per command statistics on an interface
+ *
+ * Wraps intf->sendrecv to count requests, completion codes, payload
+ * bytes and latency for each netfn/cmd pair.  Transports report retries
+ * and bytes on the wire through the ipmi_stats_*() hooks.  Statistics
+ * are printed by ipmi_stats_stop() and whenever SIGUSR1 is received.
+ *
+ * @intf:	interface to instrument
+ * @format:	"text" or "json"
+ * @file:	file to append the statistics to, NULL for stderr
+ *
+ * returns 0 on success
+ * returns -1 on error
+ */
+int
+ipmi_stats_start(struct ipmi_intf *intf, const char *format,
+                 const char *file)
+{
+	struct ipmi_stats *stats;
+	struct sigaction act;
+
+	if (intf->stats || !intf->sendrecv)
+		return -1;
+
+	if (strcmp(format, "text") && strcmp(format, "json")) {
+		lprintf(LOG_ERR, "Invalid statistics format '%s', "
+		        "use 'text' or 'json'", format);
+		return -1;
+	}
+
+	stats = calloc(1, sizeof(*stats));
+	if (!stats) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		return -1;
+	}
+	stats->json = !strcmp(format, "json");
+	stats->fp = stderr;
+	if (file) {
+		stats->fp = fopen(file, "a");
+		if (!stats->fp) {
+			lperror(LOG_ERR, "Unable to open %s", file);
+			free(stats);
+			return -1;
+		}
+	}
+
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = ipmi_stats_sigusr1;
+	act.sa_flags = SA_RESTART;
+	sigaction(SIGUSR1, &act, NULL);
+
+	stats->sendrecv = intf->sendrecv;
+	intf->sendrecv = ipmi_stats_sendrecv;
+	intf->stats = stats;
+
+	return 0;
+}
+
+/* ipmi_stats_stop  -  print the statistics and restore the interface
+ *
+ * @intf:	interface passed to ipmi_stats_start()
+ */
+void
+ipmi_stats_stop(struct ipmi_intf *intf)
+{
+	struct ipmi_stats *stats = intf->stats;
+	int netfn;
+
+	if (!stats)
+		return;
+
+	ipmi_stats_print(intf);
+	signal(SIGUSR1, SIG_DFL);
+
+	intf->sendrecv = stats->sendrecv;
+	intf->stats = NULL;
+	if (stats->fp != stderr)
+		fclose(stats->fp);
+	for (netfn = 0; netfn < IPMI_STATS_NETFNS; netfn++)
+		free(stats->cmds[netfn]);
+	free(stats);
+}
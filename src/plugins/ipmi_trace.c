@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2026 The ipmitool Project.  All Rights Reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistribution of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * Redistribution in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder, nor the names of
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ * 
+ * This software is provided "AS IS," without a warranty of any kind.
+ * ALL EXPRESS OR IMPLIED CONDITIONS, REPRESENTATIONS AND WARRANTIES,
+ * INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE OR NON-INFRINGEMENT, ARE HEREBY EXCLUDED.
+ * THE COPYRIGHT HOLDER AND ITS LICENSORS SHALL NOT BE LIABLE
+ * FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING
+ * OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.  IN NO EVENT WILL
+ * THE COPYRIGHT HOLDER OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE,
+ * PROFIT OR DATA, OR FOR DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL,
+ * INCIDENTAL OR PUNITIVE DAMAGES, HOWEVER CAUSED AND REGARDLESS OF THE
+ * THEORY OF LIABILITY, ARISING OUT OF THE USE OF OR INABILITY TO USE THIS
+ * SOFTWARE, EVEN IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGES.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include <ipmitool/ipmi.h>
+#include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_trace.h>
+#include <ipmitool/helper.h>
+#include <ipmitool/log.h>
+
+#if defined(HAVE_CONFIG_H)
+# include <config.h>
+#endif
+
+static FILE *trace_fp;
+static struct ipmi_rs *(*trace_sendrecv)(struct ipmi_intf *intf,
+                                         struct ipmi_rq *req);
+
+/* ipmi_trace_write  -  append one request/response pair to the trace
+ *
+ * @req:	request that was sent
+ * @rsp:	response received or NULL
+ * @intf:	interface the request was sent through
+ * @usec:	round trip time
+ */
+static void
+ipmi_trace_write(struct ipmi_intf *intf, struct ipmi_rq *req,
+                 struct ipmi_rs *rsp, uint64_t usec)
+{
+	uint8_t hdr[IPMI_TRACE_HDR_LEN];
+	uint16_t rs_len = 0;
+
+	if (rsp && rsp->data_len > 0)
+		rs_len = rsp->data_len;
+
+	hdr[0] = rsp ? 0 : IPMI_TRACE_F_NORESPONSE;
+	hdr[1] = req->msg.netfn;
+	hdr[2] = req->msg.lun;
+	hdr[3] = req->msg.cmd;
+	hdr[4] = rsp ? rsp->ccode : 0;
+	hdr[5] = intf->target_addr & 0xff;
+	hdr[6] = intf->target_channel;
+	htoipmi32(usec > UINT32_MAX ? UINT32_MAX : (uint32_t)usec, &hdr[7]);
+	htoipmi16(req->msg.data_len, &hdr[11]);
+	htoipmi16(rs_len, &hdr[13]);
+
+	if (fwrite(hdr, sizeof(hdr), 1, trace_fp) != 1
+	    || (req->msg.data_len
+	        && fwrite(req->msg.data, req->msg.data_len, 1, trace_fp) != 1)
+	    || (rs_len && fwrite(rsp->data, rs_len, 1, trace_fp) != 1))
+	{
+		lperror(LOG_ERR, "Unable to write transaction trace");
+	}
+}
+
+static struct ipmi_rs *
+ipmi_trace_sendrecv(struct ipmi_intf *intf, struct ipmi_rq *req)
+{
+	struct ipmi_rs *rsp;
+	uint64_t start;
+
+	start = ipmi_time_usec();
+	rsp = trace_sendrecv(intf, req);
+	ipmi_trace_write(intf, req, rsp, ipmi_time_usec() - start);
+
+	return rsp;
+}
+
+/* ipmi_trace_record_start  -  log all requests sent through an interface
+ *
+ * Wraps intf->sendrecv so that every request/response pair is appended
+ * to a binary trace that can later be served by the replay interface.
+ *
+ * @intf:	interface to record
+ * @file:	trace file to create
+ *
+ * returns 0 on success
+ * returns -1 on error
+ */
+int
+ipmi_trace_record_start(struct ipmi_intf *intf, const char *file)
+{
+	if (trace_fp) {
+		lprintf(LOG_ERR, "Transaction trace is already being recorded");
+		return -1;
+	}
+	if (!intf->sendrecv) {
+		lprintf(LOG_ERR, "Interface %s can't be recorded", intf->name);
+		return -1;
+	}
+
+	trace_fp = ipmi_open_file_write(file);
+	if (!trace_fp)
+		return -1;
+
+	if (fwrite(IPMI_TRACE_MAGIC, IPMI_TRACE_MAGIC_LEN, 1, trace_fp) != 1) {
+		lperror(LOG_ERR, "Unable to write transaction trace %s", file);
+		fclose(trace_fp);
+		trace_fp = NULL;
+		return -1;
+	}
+
+	trace_sendrecv = intf->sendrecv;
+	intf->sendrecv = ipmi_trace_sendrecv;
+	lprintf(LOG_DEBUG, "Recording transactions to %s", file);
+
+	return 0;
+}
+
+/* ipmi_trace_record_stop  -  stop recording and restore the interface
+ *
+ * @intf:	interface passed to ipmi_trace_record_start()
+ */
+void
+ipmi_trace_record_stop(struct ipmi_intf *intf)
+{
+	if (!trace_fp)
+		return;
+
+	intf->sendrecv = trace_sendrecv;
+	trace_sendrecv = NULL;
+	if (fclose(trace_fp))
+		lperror(LOG_ERR, "Unable to write transaction trace");
+	trace_fp = NULL;
+}
+
+/* ipmi_trace_load  -  read a transaction trace into memory
+ *
+ * @file:	trace file written by ipmi_trace_record_start()
+ *
+ * returns pointer to the trace, free with ipmi_trace_free()
+ * returns NULL on error
+ */
+struct ipmi_trace *
+ipmi_trace_load(const char *file)
+{
+	struct ipmi_trace *trace;
+	struct stat st;
+	size_t alloc = 0;
+	size_t len, off;
+	FILE *fp;
+
+	fp = ipmi_open_file_read(file);
+	if (!fp)
+		return NULL;
+
+	trace = calloc(1, sizeof(*trace));
+	if (!trace) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		fclose(fp);
+		return NULL;
+	}
+
+	if (fstat(fileno(fp), &st) || st.st_size < IPMI_TRACE_MAGIC_LEN) {
+		lprintf(LOG_ERR, "%s is not a transaction trace", file);
+		goto error;
+	}
+	len = st.st_size;
+
+	trace->buf = malloc(len);
+	if (!trace->buf) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		goto error;
+	}
+	if (fread(trace->buf, len, 1, fp) != 1) {
+		lperror(LOG_ERR, "Unable to read %s", file);
+		goto error;
+	}
+	if (memcmp(trace->buf, IPMI_TRACE_MAGIC, IPMI_TRACE_MAGIC_LEN)) {
+		lprintf(LOG_ERR, "%s is not a transaction trace", file);
+		goto error;
+	}
+
+	off = IPMI_TRACE_MAGIC_LEN;
+	while (off < len) {
+		struct ipmi_trace_entry *e;
+		uint8_t *hdr = trace->buf + off;
+
+		if (len - off < IPMI_TRACE_HDR_LEN) {
+			lprintf(LOG_ERR, "%s: truncated record at offset %zu",
+			        file, off);
+			goto error;
+		}
+
+		if (trace->count == alloc) {
+			struct ipmi_trace_entry *tmp;
+
+			alloc = alloc ? alloc * 2 : 256;
+			tmp = realloc(trace->entries, alloc * sizeof(*tmp));
+			if (!tmp) {
+				lprintf(LOG_ERR, "ipmitool: malloc failure");
+				goto error;
+			}
+			trace->entries = tmp;
+		}
+
+		e = &trace->entries[trace->count];
+		e->flags = hdr[0];
+		e->netfn = hdr[1];
+		e->lun = hdr[2];
+		e->cmd = hdr[3];
+		e->ccode = hdr[4];
+		e->target_addr = hdr[5];
+		e->target_channel = hdr[6];
+		e->usec = ipmi32toh(&hdr[7]);
+		e->rq_len = ipmi16toh(&hdr[11]);
+		e->rs_len = ipmi16toh(&hdr[13]);
+		off += IPMI_TRACE_HDR_LEN;
+
+		if (len - off < (size_t)e->rq_len + e->rs_len) {
+			lprintf(LOG_ERR, "%s: truncated record at offset %zu",
+			        file, off - IPMI_TRACE_HDR_LEN);
+			goto error;
+		}
+		e->rq_data = trace->buf + off;
+		off += e->rq_len;
+		e->rs_data = trace->buf + off;
+		off += e->rs_len;
+		trace->count++;
+	}
+
+	fclose(fp);
+	lprintf(LOG_DEBUG, "Loaded %zu transactions from %s",
+	        trace->count, file);
+	return trace;
+
+error:
+	fclose(fp);
+	ipmi_trace_free(trace);
+	return NULL;
+}
+
+void
+ipmi_trace_free(struct ipmi_trace *trace)
+{
+	if (!trace)
+		return;
+
+	free_n(&trace->entries);
+	free_n(&trace->buf);
+	free(trace);
+}
@@ -55,6 +55,7 @@
 #include <ipmitool/ipmi_strings.h>
 #include <ipmitool/ipmi_constants.h>
 #include <ipmitool/hpm2.h>
+#include <ipmitool/ipmi_stats.h>
 
 #if HAVE_CONFIG_H
 # include <config.h>
@@ -242,6 +243,7 @@ ipmi_lan_send_packet(struct ipmi_intf * intf, uint8_t * data, int data_len)
 	if (verbose > 2)
 		printbuf(data, data_len, "send_packet");
 
+	ipmi_stats_wire_tx(intf, data_len);
 	return send(intf->fd, data, data_len, 0);
 }
 
@@ -303,6 +305,7 @@ ipmi_lan_recv_packet(struct ipmi_intf * intf)
 
 	rsp.data[ret] = '\0';
 	rsp.data_len = ret;
+	ipmi_stats_wire_rx(intf, ret);
 
 	if (verbose > 2)
 		printbuf(rsp.data, rsp.data_len, "recv_packet");
@@ -917,6 +920,8 @@ ipmi_lan_send_cmd(struct ipmi_intf * intf, struct ipmi_rq * req)
 
 	for (;;) {
 		isRetry = ( try > 0 ) ? 1 : 0;
+		if (isRetry)
+			ipmi_stats_retry(intf);
 
 		entry = ipmi_lan_build_cmd(intf, req, isRetry);
 		if (!entry) {
@@ -60,6 +60,7 @@
 #include <ipmitool/ipmi_strings.h>
 #include <ipmitool/hpm2.h>
 #include <ipmitool/bswap.h>
+#include <ipmitool/ipmi_stats.h>
 #include <openssl/rand.h>
 
 #include "lanplus.h"
@@ -395,6 +396,7 @@ ipmi_lan_send_packet(
 	if (verbose >= 5)
 		printbuf(data, data_len, ">> sending packet");
 
+	ipmi_stats_wire_tx(intf, data_len);
 	return send(intf->fd, data, data_len, 0);
 }
 
@@ -457,6 +459,7 @@ ipmi_lan_recv_packet(struct ipmi_intf * intf)
 
 	rsp.data[ret] = '\0';
 	rsp.data_len = ret;
+	ipmi_stats_wire_rx(intf, ret);
 
 	if (verbose >= 5)
 		printbuf(rsp.data, rsp.data_len, "<< received packet");
@@ -2156,6 +2159,8 @@ ipmi_lanplus_send_payload(
 
 		if (xmit) {
 			ltime = time(NULL);
+			if (try > 0)
+				ipmi_stats_retry(intf);
 
 			if (payload->payload_type == IPMI_PAYLOAD_TYPE_IPMI)
 			{
@@ -2480,8 +2485,36 @@ ipmi_lanplus_send_sol(
 
 	v2_payload->payload.sol_packet.accepted_character_count = 0; /* NA */
 
+	/* Packets received while we wait for our ACK are ACKed right away */
+	intf->session->sol_data.defer_ack = 0;
+
+	/* Carry a deferred ACK on this data packet */
+	if (intf->session->sol_data.pending_ack_sequence_number &&
+		v2_payload->payload.sol_packet.character_count)
+	{
+		v2_payload->payload.sol_packet.acked_packet_number =
+			intf->session->sol_data.pending_ack_sequence_number;
+		v2_payload->payload.sol_packet.accepted_character_count =
+			intf->session->sol_data.pending_ack_byte_count;
+		intf->session->sol_data.last_acked_sequence_number =
+			intf->session->sol_data.pending_ack_sequence_number;
+		intf->session->sol_data.last_acked_byte_count =
+			intf->session->sol_data.pending_ack_byte_count;
+		intf->session->sol_data.last_ack_usec = ipmi_time_usec();
+		intf->session->sol_data.pending_ack_sequence_number = 0;
+		intf->session->sol_data.stats.piggybacked_acks++;
+	}
+
+	intf->session->sol_data.stats.tx_packets++;
+	intf->session->sol_data.stats.tx_bytes +=
+		v2_payload->payload.sol_packet.character_count;
+
 	rs = ipmi_lanplus_send_payload(intf, v2_payload);
 
+	/* The ACK went out with the first attempt */
+	v2_payload->payload.sol_packet.acked_packet_number = 0;
+	v2_payload->payload.sol_packet.accepted_character_count = 0;
+
 	/* Determine if we need to resend some of our data */
 	chars_to_resend = is_sol_partial_ack(intf, v2_payload, rs);
 
@@ -2508,6 +2541,8 @@ ipmi_lanplus_send_sol(
 
 		v2_payload->payload_length = v2_payload->payload.sol_packet.character_count;
 
+		intf->session->sol_data.stats.tx_packets++;
+
 		rs = ipmi_lanplus_send_payload(intf, v2_payload);
 
 		chars_to_resend = is_sol_partial_ack(intf, v2_payload, rs);
@@ -2588,10 +2623,55 @@ check_sol_packet_for_new_data(
 
 
 
+/*
+ * send_sol_ack
+ *
+ * Send a stand-alone ACK for the specified packet
+ */
+static void
+send_sol_ack(
+				struct ipmi_intf * intf,
+				uint8_t sequence_number,
+				uint8_t byte_count)
+{
+	struct ipmi_v2_payload ack;
+
+	memset(&ack, 0, sizeof(struct ipmi_v2_payload));
+
+	ack.payload_type   = IPMI_PAYLOAD_TYPE_SOL;
+
+	/*
+	 * Payload length is just the length of the character
+	 * data here.
+	 */
+	ack.payload_length = 0;
+
+	/* ACK packets have sequence numbers of 0 */
+	ack.payload.sol_packet.packet_sequence_number = 0;
+
+	ack.payload.sol_packet.acked_packet_number = sequence_number;
+
+	ack.payload.sol_packet.accepted_character_count = byte_count;
+
+	intf->session->sol_data.last_acked_sequence_number = sequence_number;
+	intf->session->sol_data.last_acked_byte_count = byte_count;
+	intf->session->sol_data.last_ack_usec = ipmi_time_usec();
+	intf->session->sol_data.stats.acks++;
+
+	ipmi_lanplus_send_payload(intf, &ack);
+}
+
+
+
 /*
  * ack_sol_packet
  *
  * Provided the specified packet looks reasonable, ACK it.
+ *
+ * A retransmission that arrives right after we ACKed the same packet
+ * crossed our ACK and is not ACKed again. While the caller is holding
+ * outbound data (defer_ack), the ACK is left for that data packet to
+ * carry.
  */
 static void
 ack_sol_packet(
@@ -2603,27 +2683,36 @@ ack_sol_packet(
 		(rsp->session.payloadtype == IPMI_PAYLOAD_TYPE_SOL)           &&
 		(rsp->payload.sol_packet.packet_sequence_number))
 	{
-		struct ipmi_v2_payload ack;
-
-		memset(&ack, 0, sizeof(struct ipmi_v2_payload));
-
-		ack.payload_type   = IPMI_PAYLOAD_TYPE_SOL;
+		uint8_t sequence_number = rsp->payload.sol_packet.packet_sequence_number;
+		uint8_t byte_count = rsp->data_len;
 
-		/*
-		 * Payload length is just the length of the character
-		 * data here.
-		 */
-		ack.payload_length = 0;
-
-		/* ACK packets have sequence numbers of 0 */
-		ack.payload.sol_packet.packet_sequence_number = 0;
+		if (sequence_number == intf->session->sol_data.last_acked_sequence_number &&
+			byte_count == intf->session->sol_data.last_acked_byte_count &&
+			ipmi_time_usec() - intf->session->sol_data.last_ack_usec <
+			IPMI_SOL_DUP_ACK_WINDOW_USEC)
+		{
+			intf->session->sol_data.stats.skipped_acks++;
+			return;
+		}
 
-		ack.payload.sol_packet.acked_packet_number =
-			rsp->payload.sol_packet.packet_sequence_number;
+		/* Only one ACK can be outstanding, send an older one now */
+		if (intf->session->sol_data.pending_ack_sequence_number &&
+			intf->session->sol_data.pending_ack_sequence_number != sequence_number)
+		{
+			send_sol_ack(intf,
+				intf->session->sol_data.pending_ack_sequence_number,
+				intf->session->sol_data.pending_ack_byte_count);
+		}
+		intf->session->sol_data.pending_ack_sequence_number = 0;
 
-		ack.payload.sol_packet.accepted_character_count = rsp->data_len;
+		if (intf->session->sol_data.defer_ack)
+		{
+			intf->session->sol_data.pending_ack_sequence_number = sequence_number;
+			intf->session->sol_data.pending_ack_byte_count = byte_count;
+			return;
+		}
 
-		ipmi_lanplus_send_payload(intf, &ack);
+		send_sol_ack(intf, sequence_number, byte_count);
 	}
 }
 
@@ -2649,6 +2738,12 @@ ipmi_lanplus_recv_sol(struct ipmi_intf * intf)
 		 * include the new stuff.
 		 */
 		check_sol_packet_for_new_data(rsp);
+
+		if (is_sol_packet(rsp) && rsp->payload.sol_packet.packet_sequence_number)
+		{
+			intf->session->sol_data.stats.rx_packets++;
+			intf->session->sol_data.stats.rx_bytes += rsp->data_len;
+		}
 	}
 	return rsp;
 }
@@ -68,6 +68,12 @@
 #define IPMI_LAN_TIMEOUT	1
 #define IPMI_LAN_RETRY		4
 
+/*
+ * A retransmitted SOL packet arriving this soon after we ACKed it crossed
+ * our ACK on the wire and is not ACKed again
+ */
+#define IPMI_SOL_DUP_ACK_WINDOW_USEC	10000
+
 #define IPMI_PRIV_CALLBACK 1
 #define IPMI_PRIV_USER     2
 #define IPMI_PRIV_OPERATOR 3
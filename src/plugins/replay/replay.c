@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2026 The ipmitool Project.  All Rights Reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistribution of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * Redistribution in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * Neither the name of the copyright holder, nor the names of
+ * contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ * 
+ * This software is provided "AS IS," without a warranty of any kind.
+ * ALL EXPRESS OR IMPLIED CONDITIONS, REPRESENTATIONS AND WARRANTIES,
+ * INCLUDING ANY IMPLIED WARRANTY OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE OR NON-INFRINGEMENT, ARE HEREBY EXCLUDED.
+ * THE COPYRIGHT HOLDER AND ITS LICENSORS SHALL NOT BE LIABLE
+ * FOR ANY DAMAGES SUFFERED BY LICENSEE AS A RESULT OF USING, MODIFYING
+ * OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.  IN NO EVENT WILL
+ * THE COPYRIGHT HOLDER OR ITS LICENSORS BE LIABLE FOR ANY LOST REVENUE,
+ * PROFIT OR DATA, OR FOR DIRECT, INDIRECT, SPECIAL, CONSEQUENTIAL,
+ * INCIDENTAL OR PUNITIVE DAMAGES, HOWEVER CAUSED AND REGARDLESS OF THE
+ * THEORY OF LIABILITY, ARISING OUT OF THE USE OF OR INABILITY TO USE THIS
+ * SOFTWARE, EVEN IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGES.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ipmitool/ipmi.h>
+#include <ipmitool/ipmi_intf.h>
+#include <ipmitool/ipmi_trace.h>
+#include <ipmitool/helper.h>
+#include <ipmitool/log.h>
+
+#if defined(HAVE_CONFIG_H)
+# include <config.h>
+#endif
+
+/* Use the latency stored in the trace rather than a fixed delay */
+#define REPLAY_DELAY_RECORDED	UINT32_MAX
+
+static struct ipmi_trace *replay_trace;
+static size_t replay_pos;
+static uint32_t replay_delay;
+static unsigned int replay_loss;
+
+/* replay_parse_opts  -  parse "file[:delay=<usec>|recorded][:loss=<pct>]"
+ *
+ * @devfile is left untouched so the interface can be re-opened with the
+ * same options; the file name is returned in @file and must be freed.
+ *
+ * returns 0 on success
+ * returns -1 on error
+ */
+static int
+replay_parse_opts(const char *devfile, char **file)
+{
+	char *copy = strdup(devfile);
+	char *opt;
+
+	*file = NULL;
+	if (!copy) {
+		lprintf(LOG_ERR, "ipmitool: malloc failure");
+		return -1;
+	}
+
+	replay_delay = 0;
+	replay_loss = 0;
+
+	opt = strchr(copy, ':');
+	if (opt)
+		*opt++ = '\0';
+
+	while (opt) {
+		char *next = strchr(opt, ':');
+
+		if (next)
+			*next++ = '\0';
+
+		if (!strcmp(opt, "delay=recorded")) {
+			replay_delay = REPLAY_DELAY_RECORDED;
+		} else if (!strncmp(opt, "delay=", 6)) {
+			if (str2uint(opt + 6, &replay_delay)
+			    || replay_delay == REPLAY_DELAY_RECORDED)
+			{
+				lprintf(LOG_ERR, "Invalid replay delay '%s'",
+				        opt + 6);
+				free(copy);
+				return -1;
+			}
+		} else if (!strncmp(opt, "loss=", 5)) {
+			if (str2uint(opt + 5, &replay_loss)
+			    || replay_loss > 100)
+			{
+				lprintf(LOG_ERR, "Invalid replay loss '%s'",
+				        opt + 5);
+				free(copy);
+				return -1;
+			}
+		} else {
+			lprintf(LOG_ERR, "Unknown replay option '%s'", opt);
+			free(copy);
+			return -1;
+		}
+
+		opt = next;
+	}
+
+	/* the file name is the leading part of the copy */
+	*file = copy;
+	return 0;
+}
+
+static int
+ipmi_replay_open(struct ipmi_intf *intf)
+{
+	char *file;
+
+	if (intf->opened)
+		return 0;
+
+	if (!intf->devfile) {
+		lprintf(LOG_ERR, "Replay trace file is not specified (-D)");
+		return -1;
+	}
+	if (replay_parse_opts(intf->devfile, &file))
+		return -1;
+
+	replay_trace = ipmi_trace_load(file);
+	free(file);
+	if (!replay_trace)
+		return -1;
+
+	/* keep the injected loss reproducible between runs */
+	srand(1);
+	replay_pos = 0;
+	intf->opened = 1;
+
+	return 0;
+}
+
+static void
+ipmi_replay_close(struct ipmi_intf *intf)
+{
+	ipmi_trace_free(replay_trace);
+	replay_trace = NULL;
+	intf->opened = 0;
+}
+
+static int
+replay_match(const struct ipmi_trace_entry *e, struct ipmi_intf *intf,
+             const struct ipmi_rq *req)
+{
+	return e->netfn == req->msg.netfn
+	       && e->lun == req->msg.lun
+	       && e->cmd == req->msg.cmd
+	       && e->target_addr == (intf->target_addr & 0xff)
+	       && e->target_channel == intf->target_channel
+	       && e->rq_len == req->msg.data_len
+	       && !memcmp(e->rq_data, req->msg.data, e->rq_len);
+}
+
+/* ipmi_replay_send_cmd  -  answer a request from the loaded trace
+ *
+ * The trace is searched for the next identical request, starting after
+ * the last one served and wrapping around, so that repeated requests are
+ * answered in recorded order and requests the replaying command doesn't
+ * send (e.g. session setup) are skipped.
+ *
+ * returns pointer to the recorded response
+ * returns NULL if there is none, it was recorded as lost or loss is
+ * injected
+ */
+static struct ipmi_rs *
+ipmi_replay_send_cmd(struct ipmi_intf *intf, struct ipmi_rq *req)
+{
+	static struct ipmi_rs rsp;
+	const struct ipmi_trace_entry *e = NULL;
+	size_t i, n;
+
+	if (!intf->opened && intf->open && intf->open(intf) < 0)
+		return NULL;
+
+	for (n = 0; n < replay_trace->count; n++) {
+		i = (replay_pos + n) % replay_trace->count;
+		if (replay_match(&replay_trace->entries[i], intf, req)) {
+			e = &replay_trace->entries[i];
+			replay_pos = i + 1;
+			break;
+		}
+	}
+
+	if (!e) {
+		lprintf(LOG_INFO, "No recorded response for netfn=0x%x "
+		        "cmd=0x%x", req->msg.netfn, req->msg.cmd);
+		return NULL;
+	}
+
+	if (replay_delay == REPLAY_DELAY_RECORDED)
+		usleep(e->usec);
+	else if (replay_delay)
+		usleep(replay_delay);
+
+	if (e->flags & IPMI_TRACE_F_NORESPONSE)
+		return NULL;
+	if (replay_loss && (unsigned int)(rand() % 100) < replay_loss)
+		return NULL;
+
+	memset(&rsp, 0, sizeof(rsp));
+	rsp.ccode = e->ccode;
+	rsp.data_len = __min(e->rs_len, IPMI_BUF_SIZE);
+	memcpy(rsp.data, e->rs_data, rsp.data_len);
+	rsp.msg.netfn = req->msg.netfn + 1;
+	rsp.msg.cmd = req->msg.cmd;
+	rsp.msg.lun = req->msg.lun;
+
+	if (verbose > 2)
+		printbuf(rsp.data, rsp.data_len, "replay response");
+
+	return &rsp;
+}
+
+struct ipmi_intf ipmi_replay_intf = {
+	.name = "replay",
+	.desc = "Replay of a recorded transaction trace",
+	.open = ipmi_replay_open,
+	.close = ipmi_replay_close,
+	.sendrecv = ipmi_replay_send_cmd,
+	.my_addr = IPMI_BMC_SLAVE_ADDR,
+	.target_addr = IPMI_BMC_SLAVE_ADDR,
+};
@@ -53,6 +53,7 @@
 #include <ipmitool/ipmi_intf.h>
 #include <ipmitool/helper.h>
 #include <ipmitool/log.h>
+#include <ipmitool/ipmi_stats.h>
 
 #if defined(HAVE_CONFIG_H)
 # include <config.h>
@@ -63,7 +64,7 @@
 #define SERIAL_BM_MAX_RS_SIZE	32	/* 40 - 8 */
 #define	SERIAL_BM_TIMEOUT	5
 #define SERIAL_BM_RETRY_COUNT	5
-#define SERIAL_BM_MAX_BUFFER_SIZE 250
+#define SERIAL_BM_MAX_BUFFER_SIZE 256
 
 #define BM_START		0xA0
 #define BM_STOP			0xA5
@@ -105,6 +106,17 @@ struct ipmi_get_message_rp {
 	unsigned char data[];
 };
 
+/*
+ *	Frame scanner character classes
+ */
+enum {
+	BM_CLASS_DATA = 0,
+	BM_CLASS_START,
+	BM_CLASS_STOP,
+	BM_CLASS_HANDSHAKE,
+	BM_CLASS_ESCAPE
+};
+
 /*
  *	State for the received message
  */
@@ -126,12 +138,12 @@ struct  serial_bm_parse_ctx{
 };
 
 /*
- *	Receiving context
+ *	Receiving context, bytes between head and tail are not parsed yet
  */
 struct serial_bm_recv_ctx {
 	uint8_t buffer[SERIAL_BM_MAX_BUFFER_SIZE];
-	size_t buffer_size;
-	size_t max_buffer_size;
+	size_t head;
+	size_t tail;
 };
 
 /*
@@ -178,8 +190,38 @@ static const struct {
 	{ 0x1B, 0x3B }			/* escape */
 };
 
+/*
+ *	Lookup tables built from the special characters table
+ */
+static uint8_t bm_class[256];
+static uint8_t bm_escape[256];		/* 0 if not special */
+static uint8_t bm_unescape[256];	/* 0 if not an escape code */
+
 static int is_system;
 
+/*
+ *	Build the escape and frame scanner tables
+ */
+static void
+serial_bm_init_tables(void)
+{
+	size_t i;
+
+	if (bm_class[BM_START]) {
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(characters); i++) {
+		bm_escape[characters[i].character] = characters[i].escape;
+		bm_unescape[characters[i].escape] = characters[i].character;
+	}
+
+	bm_class[BM_START] = BM_CLASS_START;
+	bm_class[BM_STOP] = BM_CLASS_STOP;
+	bm_class[BM_HANDSHAKE] = BM_CLASS_HANDSHAKE;
+	bm_class[BM_ESCAPE] = BM_CLASS_ESCAPE;
+}
+
 /*
  *	Setup serial interface
  */
@@ -190,6 +232,8 @@ serial_bm_setup(struct ipmi_intf * intf)
 	intf->max_request_data_size = SERIAL_BM_MAX_RQ_SIZE;
 	intf->max_response_data_size = SERIAL_BM_MAX_RS_SIZE;
 
+	serial_bm_init_tables();
+
 	return 0;
 }
 
@@ -334,40 +378,6 @@ serial_bm_flush(struct ipmi_intf * intf)
 #endif
 }
 
-/*
- *	Return escaped character for the given one
- */
-static inline uint8_t
-serial_bm_get_escaped_char(uint8_t c)
-{
-	int i;
-
-	for (i = 0; i < 5; i++) {
-		if (characters[i].character == c) {
-			return characters[i].escape;
-		}
-	}
-
-	return c;
-}
-
-/*
- *	Return unescaped character for the given one
- */
-static inline uint8_t
-serial_bm_get_unescaped_char(uint8_t c)
-{
-	int i;
-
-	for (i = 0; i < 5; i++) {
-		if (characters[i].escape == c) {
-			return characters[i].character;
-		}
-	}
-
-	return c;
-}
-
 /*
  *	Send message to serial port
  */
@@ -398,7 +408,7 @@ serial_bm_send_msg(struct ipmi_intf * intf, uint8_t * msg, int msg_len)
 
 	/* calculate escaped characters number */
 	for (i = 0; i < msg_len; i++) {
-		if (serial_bm_get_escaped_char(msg[i]) != msg[i]) {
+		if (bm_escape[msg[i]]) {
 			tmp++;
 		}
 	}
@@ -415,29 +425,40 @@ serial_bm_send_msg(struct ipmi_intf * intf, uint8_t * msg, int msg_len)
 	}
 
 	/* start character */
-	*buf++ = 0xA0;
+	*buf++ = BM_START;
 
 	for (i = 0; i < msg_len; i++) {
-		tmp = serial_bm_get_escaped_char(msg[i]);
-		if (tmp != msg[i]) {
-			*buf++ = 0xAA;
+		if (bm_escape[msg[i]]) {
+			*buf++ = BM_ESCAPE;
+			*buf++ = bm_escape[msg[i]];
+		} else {
+			*buf++ = msg[i];
 		}
-
-		*buf++ = tmp;
 	}
 
 	/* stop character */
-	*buf++ = 0xA5;
+	*buf++ = BM_STOP;
 
 	if (verbose > 5) {
 		fprintf(stderr, "Sent serial data:\n %s\n", buf2str(data, size));
 	}
 
-	/* write data to serial port */
-	tmp = write(intf->fd, data, size);
-	if (tmp <= 0) {
-		lperror(LOG_ERR, "ipmitool: write error");
-		return -1;
+	/* write data to serial port, the tty may take it in pieces */
+	for (i = 0; i < size; i += tmp) {
+		tmp = write(intf->fd, data + i, size - i);
+		if (tmp < 0 && (errno == EAGAIN || errno == EINTR)) {
+			struct pollfd pfd = { .fd = intf->fd, .events = POLLOUT };
+
+			if (poll(&pfd, 1, intf->ssn_params.timeout * 1000) > 0) {
+				tmp = 0;
+				continue;
+			}
+		}
+		if (tmp <= 0) {
+			lperror(LOG_ERR, "ipmitool: write error");
+			return -1;
+		}
+		ipmi_stats_wire_tx(intf, tmp);
 	}
 
 	return 0;
@@ -468,30 +489,32 @@ serial_bm_wait_for_data(struct ipmi_intf * intf)
 
 /*
  *	This function parses incoming data in basic mode format to IPMB message
+ *
+ *	Runs of ordinary characters are copied at once, only the special
+ *	characters found through the class table are handled one by one.
  */
 static int
 serial_bm_parse_buffer(const uint8_t * data, int data_len,
 		struct serial_bm_parse_ctx * ctx)
 {
-	int i, tmp;
+	int i = 0, run, tmp;
 
-	for (i = 0; i < data_len; i++) {
-		/* check for start of new message */
-		if (data[i] == BM_START) {
-			ctx->state = MSG_IN_PROGRESS;
-			ctx->escape = 0;
-			ctx->msg_len = 0;
-		/* check if message is not started */
-		} else if (ctx->state != MSG_IN_PROGRESS) {
-			/* skip character */
-			continue;
-		/* continue escape sequence */
-		} else	if (ctx->escape) {
+	while (i < data_len) {
+		/* skip noise until the start of a message */
+		if (ctx->state != MSG_IN_PROGRESS) {
+			const uint8_t * start = memchr(data + i, BM_START, data_len - i);
+
+			if (!start) {
+				return data_len;
+			}
+			i = start - data;
+		/* continue escape sequence, escape codes are ordinary characters */
+		} else if (ctx->escape && !bm_class[data[i]]) {
 			/* get original character */
-			tmp = serial_bm_get_unescaped_char(data[i]);
+			tmp = bm_unescape[data[i++]];
 
 			/* check if not special character */
-			if (tmp == data[i]) {
+			if (!tmp) {
 				lprintf(LOG_ERR, "ipmitool: bad response");
 				/* reset message state */
 				ctx->state = MSG_NONE;
@@ -511,28 +534,48 @@ serial_bm_parse_buffer(const uint8_t * data, int data_len,
 
 			/* clear escape flag */
 			ctx->escape = 0;
-		/* check for escape character */
-		} else if (data[i] == BM_ESCAPE) {
-			ctx->escape = 1;
-			continue;
-		/* check for stop character */
-		} else if (data[i] == BM_STOP) {
-			ctx->state = MSG_DONE;
-			return i + 1;
-		/* check for packet handshake character */
-		} else if (data[i] == BM_HANDSHAKE) {
-			/* just skip it */
 			continue;
-		} else {
+		}
+
+		/* span of ordinary characters */
+		for (run = i; run < data_len && !bm_class[data[run]]; run++)
+			;
+
+		if (run > i) {
 			/* check message length */
-			if (ctx->msg_len >= ctx->max_len) {
+			if (ctx->msg_len + (run - i) > ctx->max_len) {
 				lprintf(LOG_ERR, "ipmitool: response is too long");
 				return -1;
 			}
 
-			/* add parsed character */
-			ctx->msg[ctx->msg_len++] = data[i];
+			/* add parsed characters */
+			memcpy(ctx->msg + ctx->msg_len, data + i, run - i);
+			ctx->msg_len += run - i;
+			i = run;
+			continue;
+		}
+
+		tmp = bm_class[data[i++]];
+
+		/* check for start of new message */
+		if (tmp == BM_CLASS_START) {
+			ctx->state = MSG_IN_PROGRESS;
+			ctx->escape = 0;
+			ctx->msg_len = 0;
+		/* only an escape code may follow the escape character */
+		} else if (ctx->escape) {
+			lprintf(LOG_ERR, "ipmitool: bad response");
+			/* reset message state */
+			ctx->state = MSG_NONE;
+		/* check for escape character */
+		} else if (tmp == BM_CLASS_ESCAPE) {
+			ctx->escape = 1;
+		/* check for stop character */
+		} else if (tmp == BM_CLASS_STOP) {
+			ctx->state = MSG_DONE;
+			return i;
 		}
+		/* packet handshake character is just skipped */
 	}
 
 	/* return number of parsed characters */
@@ -541,6 +584,9 @@ serial_bm_parse_buffer(const uint8_t * data, int data_len,
 
 /*
  *	Read and parse data from serial port
+ *
+ *	The receive context outlives the call, so bytes following a parsed
+ *	message are kept for the next one instead of being read again.
  */
 static int
 serial_bm_recv_msg(struct ipmi_intf * intf,
@@ -551,45 +597,52 @@ serial_bm_recv_msg(struct ipmi_intf * intf,
 	int rv;
 
 	parse_ctx.state = MSG_NONE;
+	parse_ctx.escape = 0;
+	parse_ctx.msg_len = 0;
 	parse_ctx.msg = msg_data;
 	parse_ctx.max_len = msg_len;
 
-	do {
+	while (1) {
+		/* parse what is already buffered */
+		if (recv_ctx->head < recv_ctx->tail) {
+			rv = serial_bm_parse_buffer(recv_ctx->buffer + recv_ctx->head,
+					recv_ctx->tail - recv_ctx->head, &parse_ctx);
+			if (rv < 0) {
+				recv_ctx->head = recv_ctx->tail = 0;
+				return -1;
+			}
+			recv_ctx->head += rv;
+			if (parse_ctx.state == MSG_DONE) {
+				break;
+			}
+		}
+
+		/* everything is parsed, the partial message lives in parse_ctx */
+		recv_ctx->head = recv_ctx->tail = 0;
+
 		/* wait for data in the port */
 		if (serial_bm_wait_for_data(intf)) {
 			return 0;
 		}
 
-		/* read data into buffer */
-		rv = read(intf->fd, recv_ctx->buffer + recv_ctx->buffer_size,
-				recv_ctx->max_buffer_size - recv_ctx->buffer_size);
-
+		/* read as much as is available */
+		rv = read(intf->fd, recv_ctx->buffer, sizeof(recv_ctx->buffer));
 		if (rv < 0) {
+			if (errno == EAGAIN || errno == EINTR) {
+				continue;
+			}
 			lperror(LOG_ERR, "ipmitool: read error");
 			return -1;
 		}
+		ipmi_stats_wire_rx(intf, rv);
 
 		if (verbose > 5) {
 			fprintf(stderr, "Received serial data:\n %s\n",
-					buf2str(recv_ctx->buffer + recv_ctx->buffer_size, rv));
+					buf2str(recv_ctx->buffer, rv));
 		}
 
-		/* increment buffer size */
-		recv_ctx->buffer_size += rv;
-
-		/* parse buffer */
-		rv = serial_bm_parse_buffer(recv_ctx->buffer,
-				recv_ctx->buffer_size, &parse_ctx);
-
-		if (rv < recv_ctx->buffer_size) {
-			/* move non-parsed part of the buffer to the beginning */
-			memmove(recv_ctx->buffer, recv_ctx->buffer + rv,
-					recv_ctx->buffer_size - rv);
-		}
-
-		/* decrement buffer size */
-		recv_ctx->buffer_size -= rv;
-	} while (parse_ctx.state != MSG_DONE);
+		recv_ctx->tail = rv;
+	}
 
 	if (verbose > 4) {
 		printf("Received message:\n %s\n",
@@ -894,11 +947,13 @@ serial_bm_send_request(struct ipmi_intf * intf, struct ipmi_rq * req)
 	}
 
 	/* reset receive context */
-	read_ctx.buffer_size = 0;
-	read_ctx.max_buffer_size = SERIAL_BM_MAX_BUFFER_SIZE;
+	read_ctx.head = read_ctx.tail = 0;
 
 	/* Send the message and receive the answer */
 	for (retry = 0; retry < intf->ssn_params.retry; retry++) {
+		if (retry)
+			ipmi_stats_retry(intf);
+
 		/* build output message */
 		bridging_level = serial_bm_build_msg(intf, req, msg,
 				sizeof (msg), req_ctx, &msg_len);
@@ -53,6 +53,7 @@
 #include <ipmitool/ipmi_intf.h>
 #include <ipmitool/helper.h>
 #include <ipmitool/log.h>
+#include <ipmitool/ipmi_stats.h>
 
 #if defined(HAVE_CONFIG_H)
 # include <config.h>
@@ -61,6 +62,7 @@
 #define	IPMI_SERIAL_TIMEOUT		5
 #define IPMI_SERIAL_RETRY		5
 #define IPMI_SERIAL_MAX_RESPONSE	256
+#define IPMI_SERIAL_RX_BUFFER		512
 
 /*
  *	Terminal Mode interface is required to support 40 byte transactions.
@@ -141,8 +143,42 @@ static const struct {
 #endif
 };
 
+/*
+ *	Receive buffer, bytes between head and tail are not consumed yet
+ */
+static struct {
+	char buffer[IPMI_SERIAL_RX_BUFFER];
+	size_t head;
+	size_t tail;
+} serial_rx;
+
+/*
+ *	Hex digit lookup tables
+ */
+static const char hex_digits[] = "0123456789abcdef";
+static int8_t hex_value[256];
+
 static int is_system;
 
+/*
+ *	Build the hex digit value table, -1 marks a non hex character
+ */
+static void
+serial_term_init_tables(void)
+{
+	int i;
+
+	if (hex_value['1']) {
+		return;
+	}
+
+	memset(hex_value, -1, sizeof(hex_value));
+	for (i = 0; i < 16; i++) {
+		hex_value[(uint8_t)hex_digits[i]] = i;
+		hex_value[toupper(hex_digits[i])] = i;
+	}
+}
+
 static int
 ipmi_serial_term_open(struct ipmi_intf * intf)
 {
@@ -275,6 +311,9 @@ serial_wait_for_data(struct ipmi_intf * intf)
 /*
  *	Read a line from serial port
  *	Returns > 0 if there is a line, < 0 on error or timeout
+ *
+ *	The port is read in blocks into serial_rx and lines are split from
+ *	there, so bytes past the end of line are kept for the next call.
  */
 static int
 serial_read_line(struct ipmi_intf * intf, char *str, int len)
@@ -284,26 +323,51 @@ serial_read_line(struct ipmi_intf * intf, char *str, int len)
 	*str = 0;
 	i = 0;
 	while (i < len) {
-		if (serial_wait_for_data(intf)) {
-			return -1;
+		char *start, *eol;
+		size_t n;
+
+		if (serial_rx.head == serial_rx.tail) {
+			serial_rx.head = serial_rx.tail = 0;
+			if (serial_wait_for_data(intf)) {
+				return -1;
+			}
+			rv = read(intf->fd, serial_rx.buffer, sizeof(serial_rx.buffer));
+			if (rv < 0) {
+				if (errno == EAGAIN || errno == EINTR) {
+					continue;
+				}
+				return -1;
+			} else if (!rv) {
+				lperror(LOG_ERR, "Serial read failed: %s", strerror(errno));
+				return -1;
+			}
+			ipmi_stats_wire_rx(intf, rv);
+			serial_rx.tail = rv;
 		}
-		rv = read(intf->fd, str + i, 1);
-		if (rv < 0) {
-			return -1;
-		} else if (!rv) {
-			lperror(LOG_ERR, "Serial read failed: %s", strerror(errno));
-			return -1;
+
+		/* copy up to and including the end of line */
+		start = serial_rx.buffer + serial_rx.head;
+		n = __min(serial_rx.tail - serial_rx.head, (size_t)(len - i));
+		for (eol = start; eol < start + n; eol++) {
+			if (*eol == '\n' || *eol == '\r') {
+				break;
+			}
+		}
+		if (eol < start + n) {
+			n = eol - start + 1;
 		}
-		if (str[i] == '\n' || str[i] == '\r') {
+		memcpy(str + i, start, n);
+		serial_rx.head += n;
+		i += n;
+
+		if (str[i - 1] == '\n' || str[i - 1] == '\r') {
 			if (verbose > 4) {
-				char c = str[i];
-				str[i] = '\0';
+				char c = str[i - 1];
+				str[i - 1] = '\0';
 				fprintf(stderr, "Received data: %s\n", str);
-				str[i] = c;
+				str[i - 1] = c;
 			}
-			return i + 1;
-		} else {
-			i++;
+			return i;
 		}
 	}
 
@@ -328,6 +392,7 @@ serial_write_line(struct ipmi_intf * intf, const char *str)
 		} else if (rv == 0) {
 			return -1;
 		}
+		ipmi_stats_wire_tx(intf, rv);
 		cnt += rv;
 	}
 
@@ -340,6 +405,9 @@ serial_write_line(struct ipmi_intf * intf, const char *str)
 static int
 serial_flush(struct ipmi_intf * intf)
 {
+	/* drop buffered input together with the driver's */
+	serial_rx.head = serial_rx.tail = 0;
+
 #if defined(TCFLSH)
     return ioctl(intf->fd, TCFLSH, TCIOFLUSH);
 #elif defined(TIOCFLUSH)
@@ -362,7 +430,7 @@ recv_response(struct ipmi_intf * intf, unsigned char *data, int len)
 	int i, j, resp_len = 0;
 	long rv;
 	char *p, *pp;
-	char ch, str_hex[3];
+	int hi = 0;
 
 	p = hex_rs;
 	while (1) {
@@ -411,38 +479,28 @@ recv_response(struct ipmi_intf * intf, unsigned char *data, int len)
 		}
 	}
 
-	/* this is needed for correct string to long conversion */
-	str_hex[2] = 0;
-
 	/* parse the response */
 	i = 0;
 	j = 0;
 	while (*p) {
+		int v = hex_value[(uint8_t)*p];
+
 		if (i >= len) {
 			lprintf(LOG_ERR, "Serial response is too long(%d, %d)", i, len);
 			return -1;
 		}
-		ch = *(p++);
-		if (isxdigit(ch)) {
-			str_hex[j++] = ch;
-		} else {
-			if (j == 1 || !isspace(ch)) {
-				lprintf(LOG_ERR, "Serial response is invalid");
-				return -1;
-			}
-		}
-		if (j == 2) {
-			unsigned long tmp;
-			errno = 0;
-			/* parse the hex number */
-			tmp = strtoul(str_hex, NULL, 16);
-			if ( tmp > 0xFF || ( !tmp && errno ) ) {
-				lprintf(LOG_ERR, "Serial response is invalid");
-				return -1;
+		if (v >= 0) {
+			if (j++) {
+				data[i++] = (hi << 4) | v;
+				j = 0;
+			} else {
+				hi = v;
 			}
-			data[i++] = tmp;
-			j = 0;
+		} else if (j == 1 || !isspace((unsigned char)*p)) {
+			lprintf(LOG_ERR, "Serial response is invalid");
+			return -1;
 		}
+		p++;
 	}
 
 	return i;
@@ -624,7 +682,8 @@ serial_term_send_msg(struct ipmi_intf * intf, uint8_t * msg, int msg_len)
 
 	/* body */
 	for (i = 0; i < msg_len; i++) {
-		buf += sprintf((char*) buf, "%02x", msg[i]);
+		*buf++ = hex_digits[msg[i] >> 4];
+		*buf++ = hex_digits[msg[i] & 0xf];
 	}
 
 	/* stop character */
@@ -642,6 +701,7 @@ serial_term_send_msg(struct ipmi_intf * intf, uint8_t * msg, int msg_len)
 		lperror(LOG_ERR, "ipmitool: write error");
 		return -1;
 	}
+	ipmi_stats_wire_tx(intf, tmp);
 
 	return 0;
 }
@@ -783,6 +843,9 @@ ipmi_serial_term_send_cmd(struct ipmi_intf * intf, struct ipmi_rq * req)
 
 	/* Send the message and receive the answer */
 	for (retry = 0; retry < intf->ssn_params.retry; retry++) {
+		if (retry)
+			ipmi_stats_retry(intf);
+
 		/* build output message */
 		bridging_level = serial_term_build_msg(intf, req, msg,
 				sizeof (msg), req_ctx, &msg_len);
@@ -881,6 +944,8 @@ ipmi_serial_term_setup(struct ipmi_intf * intf)
 	intf->max_request_data_size = IPMI_SERIAL_MAX_RQ_SIZE;
 	intf->max_response_data_size = IPMI_SERIAL_MAX_RS_SIZE;
 
+	serial_term_init_tables();
+
 	return 0;
 }
 
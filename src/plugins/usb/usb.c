@@ -38,6 +38,7 @@
 #include <ipmitool/ipmi_oem.h>
 #include <ipmitool/ipmi_strings.h>
 #include <ipmitool/ipmi_constants.h>
+#include <ipmitool/ipmi_stats.h>
 #include <scsi/sg.h>
 #include <sys/ioctl.h>
 #include <scsi/scsi_ioctl.h>
@@ -64,6 +65,10 @@
 #define ERR_UNSUPPORTED             3       /* Unsupported Command */
 #define IN_PROCESS                  0x8000  /* Bit 15 of Status */
 #define SCSI_AMICMD_ID              0xEE
+#define USB_MAX_RQ_DATA_SIZE        255     /* one byte count fields */
+#define USB_MAX_RS_DATA_SIZE        255
+#define USB_POLL_MIN_USEC           100     /* completion poll backoff */
+#define USB_POLL_MAX_USEC           2000
 
 /* SCSI Command Packets */
 typedef struct {
@@ -294,6 +299,13 @@ ipmi_usb_setup(struct ipmi_intf *intf)
 		lprintf(LOG_ERR, "Error in USB session setup \n");
 		return (-1);
 	}
+
+	/* the whole message goes in one data sector transfer, so bulk
+	 * readers may ask for as much as a single command can return;
+	 * they shrink their requests on 0xC7/0xCA/0xFF as usual */
+	intf->max_request_data_size = USB_MAX_RQ_DATA_SIZE;
+	intf->max_response_data_size = USB_MAX_RS_DATA_SIZE;
+
 	intf->opened = 1;
 	return 0;
 }
@@ -412,6 +424,7 @@ WriteSplitData(struct ipmi_intf *intf, char *Buffer, char Sector,
 						timeout, NumBytes)) != 0) {
 			return retVal;
 		}
+		ipmi_stats_wire_tx(intf, NumBytes);
 
 		BytesWritten += NumBytes;
 	}
@@ -434,17 +447,26 @@ ReadSplitData(struct ipmi_intf *intf, char *Buffer, char Sector,
 					NumBytes) == (-1)) {
 			return 1;
 		}
+		ipmi_stats_wire_rx(intf, NumBytes);
 		BytesRead += NumBytes;
 	}
 
 	return 0;
 }
 
+/* WaitForCommandCompletion - poll the command sector until the BMC is done
+ *
+ * The device offers no completion notification, so the status is polled,
+ * starting right away and backing off up to USB_POLL_MAX_USEC between
+ * polls.  Quick commands complete within the first few polls while slow
+ * ones do not flood the bus.  Timeout is in milliseconds, 0 waits forever.
+ */
 int
 WaitForCommandCompletion(struct ipmi_intf *intf, CONFIG_CMD *pG2CDCmdHeader,
 		uint32_t timeout, uint32_t DataLen)
 {
-	uint32_t TimeCounter = 0;
+	uint64_t deadline = ipmi_time_usec() + (uint64_t)timeout * 1000;
+	useconds_t delay = USB_POLL_MIN_USEC;
 
 	do {
 		if (ReadCD(intf->fd, SCSI_AMIDEF_CMD_SECTOR,
@@ -452,19 +474,18 @@ WaitForCommandCompletion(struct ipmi_intf *intf, CONFIG_CMD *pG2CDCmdHeader,
 			lprintf(LOG_ERR, "ReadCD returned ERROR");
 			return 1;
 		}
+		ipmi_stats_wire_rx(intf, DataLen);
 
-		if (pG2CDCmdHeader->Status & IN_PROCESS) {
-			usleep(1000);
-			if (timeout > 0) {
-				TimeCounter++;
-				if (TimeCounter == (timeout + 1)) {
-					return 2;
-				}
-			}
-		} else {
+		if (!(pG2CDCmdHeader->Status & IN_PROCESS)) {
 			lprintf(LOG_DEBUG, "Command completed");
 			break;
 		}
+
+		if (timeout > 0 && ipmi_time_usec() >= deadline) {
+			return 2;
+		}
+		usleep(delay);
+		delay = __min(delay * 2, USB_POLL_MAX_USEC);
 	} while (1);
 
 	return 0;
@@ -505,6 +526,7 @@ SendDataToUSBDriver(struct ipmi_intf *intf, char *ReqBuffer,
 				"Error in Write CD of SCSI_AMIDEF_CMD_SECTOR");
 		return (-1);
 	}
+	ipmi_stats_wire_tx(intf, DataLen);
 
 	/* Write the data to hard disk */
 	if ((retVal = WriteSplitData(intf, ReqBuffer,
@@ -531,6 +553,11 @@ SendDataToUSBDriver(struct ipmi_intf *intf, char *ReqBuffer,
 
 	switch (pG2CDCmdHeader->Status) {
 		case ERR_SUCCESS:
+			if (pG2CDCmdHeader->DataOutLen > IPMI_BUF_SIZE) {
+				lprintf(LOG_ERR, "Response of %u bytes is too long",
+						pG2CDCmdHeader->DataOutLen);
+				return (-1);
+			}
 			*ResBuffLen = pG2CDCmdHeader->DataOutLen;
 			lprintf(LOG_DEBUG, "Before ReadSplitData %x", *ResBuffLen);
 			if (ReadSplitData(intf, (char *)ResBuffer,
@@ -546,6 +573,7 @@ SendDataToUSBDriver(struct ipmi_intf *intf, char *ReqBuffer,
 			DataLen = sizeof(CONFIG_CMD);
 			ReadCD(intf->fd, SCSI_AMIDEF_CMD_SECTOR,
 					(char *)(pG2CDCmdHeader), DataLen);
+			ipmi_stats_wire_rx(intf, DataLen);
 			break;
 		case ERR_BIG_DATA:
 			lprintf(LOG_ERR, "Too much data");
@@ -567,10 +595,11 @@ static struct ipmi_rs *
 ipmi_usb_send_cmd(struct ipmi_intf *intf, struct ipmi_rq *req)
 {
 	static struct ipmi_rs rsp;
+	/* only the header and data_len bytes are sent, no need to clear it */
+	static IPMIUSBRequest_T ReqPkt;
 	long timeout = 20000;
 	uint8_t byRet = 0;
-	char ReqBuff[MAX_REQUEST_SIZE] = {0};
-	IPMIUSBRequest_T *pReqPkt = (IPMIUSBRequest_T *)ReqBuff;
+	IPMIUSBRequest_T *pReqPkt = &ReqPkt;
 	int retries = 0;
 	/********** FORM IPMI PACKET *****************/
 	pReqPkt->byNetFnLUN = req->msg.netfn << 2;
@@ -582,8 +611,10 @@ ipmi_usb_send_cmd(struct ipmi_intf *intf, struct ipmi_rq *req)
 
 	/********** SEND DATA TO USB ******************/
 	while (retries < 3) {
-		retries++;
-		byRet = SendDataToUSBDriver(intf, ReqBuff,
+		if (retries++) {
+			ipmi_stats_retry(intf);
+		}
+		byRet = SendDataToUSBDriver(intf, (char *)pReqPkt,
 				2 + req->msg.data_len, rsp.data,
 				&rsp.data_len,timeout);
 
@@ -592,9 +623,9 @@ ipmi_usb_send_cmd(struct ipmi_intf *intf, struct ipmi_rq *req)
 		}
 	}
 
-	if (retries == 3) {
+	if (byRet != 0) {
 		lprintf(LOG_ERR,
-				"Error while sending command using",
+				"Error while sending command using %s",
 				"SendDataToUSBDriver");
 		rsp.ccode = byRet;
 		return &rsp;